@@ -1,5 +1,12 @@
 #define __EINK__
 #include "eink.hpp"
+#include "esp.hpp"
+#include "esp_heap_caps.h"
+#include "raw_image.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 // PIN_LUT built from the following:
 //
@@ -45,6 +52,351 @@ const uint32_t EInk::PIN_LUT[256] = {
   0x0e880000, 0x0e880010, 0x0e880020, 0x0e880030, 0x0e8c0000, 0x0e8c0010, 0x0e8c0020, 0x0e8c0030
 };
 
+bool
+EInk::set_phase_tables(bool enable)
+{
+  if (enable == (phase_data != nullptr)) return true;
+
+  if (enable) {
+    phase_data = (uint8_t *) ESP::ps_malloc(get_phase_image_size() * get_phase_image_count());
+    return phase_data != nullptr;
+  }
+
+  heap_caps_free(phase_data);
+  phase_data = nullptr;
+  return true;
+}
+
+// Phase images are built from the end of the frame buffer, the panel being
+// mounted upside down. Each frame buffer byte gives two bytes of 4 pixels
+// codes, the high order nibble first. With i2s_order, the 16 bits halves of
+// each 32 bits word are swapped, as expected by the I2S FIFO in LCD mode.
+
+static void
+swap_halves(uint8_t * dst, int32_t size)
+{
+  for (int32_t i = 0; i < size; i += 4) {
+    std::swap(dst[i    ], dst[i + 2]);
+    std::swap(dst[i + 1], dst[i + 3]);
+  }
+}
+
+void
+EInk::build_phase_1bit(uint8_t * dst, const uint8_t * data, int32_t size,
+                       const uint8_t lut[16], bool invert, bool i2s_order)
+{
+  const uint8_t * ptr  = &data[size - 1];
+  uint8_t       * p    = dst;
+  uint8_t         mask = invert ? 0xFF : 0x00;
+
+  for (int32_t i = 0; i < size; i++) {
+    uint8_t dram = *ptr-- ^ mask;
+    *p++ = lut[dram >> 4];
+    *p++ = lut[dram & 0x0F];
+  }
+
+  if (i2s_order) swap_halves(dst, size * 2);
+}
+
+// waveform is a [8][phase_count] array giving the pixel code of each gray
+// level for each phase.
+
+void
+EInk::build_phase_3bit(uint8_t * dst, const uint8_t * data, int32_t size,
+                       const uint8_t * waveform, int phase_count, int phase, bool i2s_order)
+{
+  uint8_t codes[256];
+
+  for (int i = 0; i < 256; i++) {
+    codes[i] = (waveform[(i & 0x07) * phase_count + phase] << 2) | 
+                waveform[((i >> 4) & 0x07) * phase_count + phase];
+  }
+
+  const uint8_t * dp = &data[size - 2];
+  uint8_t       * p  = dst;
+
+  for (int32_t i = 0; i < size; i += 2) {
+    *p++ = (codes[dp[1]] << 4) | codes[dp[0]];
+    dp -= 2;
+  }
+
+  if (i2s_order) swap_halves(dst, size / 2);
+}
+
+// Sends a phase image through the GPIO data bus. With repeat_last, the last
+// code of each row is clocked a second time, as done by the drivers 1 bit
+// update loops. Rows outside of first_row..last_row are skipped.
+
+void
+EInk::send_phase(const uint8_t * image, bool repeat_last, int16_t first_row, int16_t last_row)
+{
+  const int16_t line_size      = get_width() / 4;
+  const int16_t height         = get_height();
+  bool          neutral_loaded = false;
+
+  vscan_start();
+
+  for (int i = 0; i < height; i++, image += line_size) {
+    if ((i < first_row) || (i > last_row)) {
+      skip_row(neutral_loaded);
+      continue;
+    }
+    neutral_loaded = false;
+
+    const uint8_t * p    = image;
+    uint32_t        send = PIN_LUT[*p++];
+    hscan_start(send);
+
+    for (int j = 1; j < line_size; j++) {
+      send          = PIN_LUT[*p++];
+      GPIO.out_w1ts = CL | send;
+      GPIO.out_w1tc = CL | DATA;
+    }
+
+    GPIO.out_w1ts = CL | (repeat_last ? send : 0);
+    GPIO.out_w1tc = CL | DATA;
+    vscan_end();
+  }
+
+  ESP::delay_microseconds(230);
+}
+
+// Same as the drivers clean() method, limited to rows first_row..last_row.
+
+void
+EInk::clean_rows(PixelState pixel_state, uint8_t repeat_count, int16_t first_row, int16_t last_row)
+{
+  if (!turn_on()) return;
+
+  const int16_t line_size = get_width() / 4;
+  const int16_t height    = get_height();
+  uint32_t      send      = PIN_LUT[static_cast<uint8_t>(pixel_state)];
+
+  for (int8_t k = 0; k < repeat_count; k++) {
+
+    bool neutral_loaded = false;
+
+    vscan_start();
+
+    for (int i = 0; i < height; i++) {
+      if ((i < first_row) || (i > last_row)) {
+        skip_row(neutral_loaded);
+        continue;
+      }
+      neutral_loaded = false;
+
+      hscan_start(send);
+
+      GPIO.out_w1ts = CL | send;
+      GPIO.out_w1tc = CL;
+
+      for (int j = 0; j < line_size - 2; j++) {
+        GPIO.out_w1ts = CL;
+        GPIO.out_w1tc = CL;
+      }
+      GPIO.out_w1ts = CL | send;
+      GPIO.out_w1tc = CL | DATA;
+
+      vscan_end();
+    }
+
+    ESP::delay_microseconds(230);
+  }
+}
+
+// Row not driven by a partial update. A neutral (SKIP) source line is
+// shifted once, then only the gate is clocked, the LE pulse latching the
+// same neutral line again.
+
+void
+EInk::skip_row(bool & neutral_loaded)
+{
+  if (neutral_loaded) {
+    ckv_set();
+    ESP::delay_microseconds(3);
+    vscan_end();
+    return;
+  }
+
+  const int16_t line_size = get_width() / 4;
+  uint32_t      send      = PIN_LUT[static_cast<uint8_t>(PixelState::SKIP)];
+
+  hscan_start(send);
+
+  GPIO.out_w1ts = CL | send;
+  GPIO.out_w1tc = CL;
+
+  for (int j = 0; j < line_size - 1; j++) {
+    GPIO.out_w1ts = CL;
+    GPIO.out_w1tc = CL;
+  }
+  GPIO.out_w1tc = DATA;
+
+  vscan_end();
+  neutral_loaded = true;
+}
+
+// Diffs the region of frame_buffer with the last displayed image and builds
+// the partial update image in p_buffer (same layout as the phase images).
+// Only the rows of the region are built. Returns false if nothing changed.
+
+bool
+EInk::build_partial_image(FrameBuffer1Bit & frame_buffer, const uint8_t lutw[16], const uint8_t lutb[16],
+                          int16_t x, int16_t y, int16_t w, int16_t h, PartialRegion & region,
+                          bool i2s_order)
+{
+  const int16_t width     = get_width();
+  const int16_t height    = get_height();
+  const int16_t line_size = frame_buffer.get_line_size();
+
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if ((x + w) > width ) w = width  - x;
+  if ((y + h) > height) h = height - y;
+  if ((w <= 0) || (h <= 0)) return false;
+
+  region.y0        = y;
+  region.y1        = y + h - 1;
+  region.bx0       = x >> 3;
+  region.bx1       = (x + w - 1) >> 3;
+  region.first_row = INT16_MAX;
+  region.last_row  = -1;
+
+  const uint8_t * idata = frame_buffer.get_data();
+  const uint8_t * odata = d_memory_new->get_data();
+
+  for (int16_t fy = region.y0; fy <= region.y1; fy++) {
+    int16_t   row     = height - 1 - fy;
+    uint8_t * p       = &p_buffer[(int32_t) row * (width / 4)];
+    bool      changed = false;
+
+    if ((region.bx0 > 0) || (region.bx1 < (line_size - 1))) memset(p, 0xFF, width / 4);
+
+    for (int16_t bx = region.bx0; bx <= region.bx1; bx++) {
+      int32_t pos   = (int32_t) fy * line_size + bx;
+      uint8_t diffw =  odata[pos] & ~idata[pos];
+      uint8_t diffb = ~odata[pos] &  idata[pos];
+      uint8_t * q   = &p[(line_size - 1 - bx) * 2];
+
+      q[0] = lutw[diffw >>   4] & lutb[diffb >>   4];
+      q[1] = lutw[diffw & 0x0F] & lutb[diffb & 0x0F];
+
+      changed |= (diffw | diffb) != 0;
+    }
+
+    if (changed) {
+      if (row < region.first_row) region.first_row = row;
+      if (row > region.last_row ) region.last_row  = row;
+    }
+
+    if (i2s_order) swap_halves(p, width / 4);
+  }
+
+  return region.last_row >= 0;
+}
+
+void
+EInk::save_partial_region(FrameBuffer1Bit & frame_buffer, const PartialRegion & region)
+{
+  const int16_t line_size = frame_buffer.get_line_size();
+
+  for (int16_t fy = region.y0; fy <= region.y1; fy++) {
+    int32_t pos = (int32_t) fy * line_size + region.bx0;
+    memcpy(&d_memory_new->get_data()[pos], &frame_buffer.get_data()[pos], region.bx1 - region.bx0 + 1);
+  }
+}
+
+// The panel state is a 1 bit raw picture of d_memory_new, RLE compressed.
+
+bool
+EInk::state_header(RawImageHeader & header)
+{
+  if (!is_partial_allowed()) {
+    ESP_LOGE(TAG, "No 1 bit image on the panel: state not saved.");
+    return false;
+  }
+  header = { (uint16_t) get_width(), (uint16_t) get_height(), 1, RawImageHeader::RLE, 0 };
+  return true;
+}
+
+bool
+EInk::save_state(FILE * f)
+{
+  RawImageHeader header;
+
+  return state_header(header) && raw_save(f, header, d_memory_new->get_data());
+}
+
+int32_t
+EInk::save_state(uint8_t * buf, int32_t size)
+{
+  RawImageHeader header;
+  int32_t        used;
+
+  if (!state_header(header)) return 0;
+  if ((used = raw_save(buf, size, header, d_memory_new->get_data())) == 0) {
+    ESP_LOGE(TAG, "State larger than %d bytes.", (int) size);
+  }
+  return used;
+}
+
+// The state is restored in d_memory_new. Partial updates are allowed again
+// only when it has been completely read.
+
+bool
+EInk::restore_state(Reader read)
+{
+  uint8_t        head[RawImageHeader::SIZE];
+  RawImageHeader header;
+
+  block_partial();
+
+  if ((read(head, sizeof(head)) != sizeof(head)) || !header.parse(head) || (header.bits != 1) ||
+      (header.width != get_width()) || (header.height != get_height()) ||
+      (RawImageHeader::data_size(header.width, header.height, 1) != d_memory_new->get_data_size())) {
+    ESP_LOGE(TAG, "Not a panel state.");
+    return false;
+  }
+
+  uint8_t * data = d_memory_new->get_data();
+  uint8_t * end  = data + d_memory_new->get_data_size();
+
+  if (header.compression == RawImageHeader::NONE) {
+    if ((header.size != (uint32_t) (end - data)) || (read(data, end - data) != (end - data))) return false;
+  }
+  else {
+    uint8_t       buf[512];
+    RawRleDecoder decoder;
+    for (uint32_t left = header.size; (data < end) && (left > 0);) {
+      int32_t len = read(buf, std::min<uint32_t>(sizeof(buf), left));
+      if (len <= 0) break;
+      left -= len;
+      data  = decoder.expand(buf, len, data, end);
+    }
+    if (data < end) return false;
+  }
+
+  allow_partial();
+  return true;
+}
+
+bool
+EInk::restore_state(FILE * f)
+{
+  return restore_state([f](uint8_t * buf, int32_t len) -> int32_t { return fread(buf, 1, len, f); });
+}
+
+bool
+EInk::restore_state(const uint8_t * buf, int32_t size)
+{
+  return restore_state([&buf, &size](uint8_t * dst, int32_t len) -> int32_t {
+    len = std::min(len, size);
+    memcpy(dst, buf, len);
+    buf += len, size -= len;
+    return len;
+  });
+}
+
 // Turn off epaper power supply and put all digital IO pins in high Z state
 void 
 EInk::turn_off()
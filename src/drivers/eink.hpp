@@ -4,6 +4,9 @@
 #include "wire.hpp"
 #include "soc/gpio_struct.h"
 
+#include <cstdio>
+#include <functional>
+
 #if INKPLATE_6 || INKPLATE_6V2 || INKPLATE_6FLICK
   #include "i2s_comms.hpp"
   #include "soc/gpio_sig_map.h"
@@ -49,6 +52,61 @@ class EInk
 
     virtual void partial_update(FrameBuffer1Bit & frame_buffer, bool force = false) = 0;
 
+    /**
+     * @brief Region limited partial update
+     *
+     * Only the pixels located in the given region (panel coordinates, extended
+     * to byte boundaries horizontally) are compared and refreshed. Rows that
+     * contain no change are not driven: the gate is clocked over them with a
+     * neutral source line. Nothing is sent to the panel if no pixel changed.
+     * The whole screen version of partial_update() uses the same mechanism,
+     * limited to the band of rows that changed.
+     */
+    virtual void partial_update(FrameBuffer1Bit & frame_buffer, 
+                                int16_t x, int16_t y, int16_t w, int16_t h, 
+                                bool force = false) = 0;
+
+    /**
+     * @brief Precomputed waveform phase images
+     *
+     * When enabled, update() converts the frame buffer, before powering the
+     * panel, into one image per waveform phase (one byte per 4 pixels, in the
+     * order they are sent to the panel). Each phase is then a straight stream
+     * of these bytes. Up to get_phase_image_count() * width * height / 4 bytes
+     * of PSRAM are used.
+     *
+     * @param enable true to allocate the phase images, false to release them.
+     * @return false if the memory could not be allocated.
+     */
+    bool set_phase_tables(bool enable);
+    inline bool get_phase_tables() { return phase_data != nullptr; }
+
+    /**
+     * @brief Save or restore the panel state, to keep it across deep sleep
+     *
+     * The state is the 1 bit image last sent to the panel, that partial
+     * updates compare with. It is saved as an RLE compressed raw picture
+     * (see raw_image.hpp). Restored after a wake up, it allows partial
+     * updates right away, instead of a full update of the screen.
+     *
+     * The state can only be saved after a 1 bit update. When it can't be
+     * restored, the next partial update is a full update.
+     *
+     * @param f File opened for writing (save) or reading (restore), left
+     *          open, positioned after the state.
+     */
+    bool    save_state(FILE * f);
+    bool restore_state(FILE * f);
+
+    /**
+     * @brief Same, in memory (e.g. RTC slow memory)
+     *
+     * @return save_state(): the size of the state, 0 if it doesn't fit in
+     *         size bytes.
+     */
+    int32_t save_state(uint8_t * buf, int32_t size);
+    bool restore_state(const uint8_t * buf, int32_t size);
+
     int8_t read_temperature();
 
     void    turn_off();
@@ -58,6 +116,11 @@ class EInk
   private:
     static constexpr char const * TAG = "EInk";
 
+    typedef std::function<int32_t(uint8_t * buf, int32_t len)> Reader;
+
+    bool   state_header(struct RawImageHeader & header);
+    bool  restore_state(Reader read);
+
   protected:                     
     
     #if INKPLATE_6 || INKPLATE_6V2 || INKPLATE_6FLICK
@@ -117,6 +180,35 @@ class EInk
     FrameBuffer1Bit * d_memory_new;
     uint32_t        * GLUT;
     uint32_t        * GLUT2;
+    uint8_t         * phase_data{nullptr};
+
+    /// Number of phase images needed by the longest waveform (3 bit mode).
+    virtual uint8_t get_phase_image_count() = 0;
+
+    inline int32_t get_phase_image_size() { return (int32_t) get_width() * get_height() / 4; }
+
+    static void build_phase_1bit(uint8_t * dst, const uint8_t * data, int32_t size,
+                                 const uint8_t lut[16], bool invert, bool i2s_order = false);
+    static void build_phase_3bit(uint8_t * dst, const uint8_t * data, int32_t size,
+                                 const uint8_t * waveform, int phase_count, int phase,
+                                 bool i2s_order = false);
+
+    /// Panel area of a partial update. Rows are in the order they are sent
+    /// to the panel (first_row..last_row), bytes in frame buffer order.
+    struct PartialRegion {
+      int16_t first_row, last_row;
+      int16_t y0, y1, bx0, bx1;
+    };
+
+    bool build_partial_image(FrameBuffer1Bit & frame_buffer, const uint8_t lutw[16], const uint8_t lutb[16],
+                             int16_t x, int16_t y, int16_t w, int16_t h, PartialRegion & region,
+                             bool i2s_order = false);
+    void     save_partial_region(FrameBuffer1Bit & frame_buffer, const PartialRegion & region);
+
+    void send_phase(const uint8_t * image, bool repeat_last, 
+                    int16_t first_row = 0, int16_t last_row = INT16_MAX);
+    void clean_rows(PixelState pixel_state, uint8_t repeat_count, int16_t first_row, int16_t last_row);
+    void   skip_row(bool & neutral_loaded);
 
     const IOExpander::Pin OE             = IOExpander::Pin::IOPIN_0;
     const IOExpander::Pin GMOD           = IOExpander::Pin::IOPIN_1;
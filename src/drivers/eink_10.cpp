@@ -80,14 +80,23 @@ EInk10::setup()
  
   //ESP_LOGD(TAG, "Power Mgr Init..."); fflush(stdout);
 
+  wire_device = new WireDevice(PWRMGR_ADDRESS);
+  if ((wire_device == nullptr) || !wire_device->is_initialized()) {
+    ESP_LOGE(TAG, "Setup error: %s", wire_device == nullptr ? "NULL Device!" : "Not initialized!");
+    Wire::leave();
+    return false;
+  }
+
+  uint8_t pgm[] = {
+    0x09,       // cmd
+    0b00011011, // Power up seq.
+    0b00000000, // Power up delay (3mS per rail)
+    0b00011011, // Power down seq.
+    0b00000000  // Power down delay (6mS per rail)
+  };
+
   ESP::delay_microseconds(1800);
-  wire.begin_transmission(PWRMGR_ADDRESS);
-  wire.write(0x09);
-  wire.write(0b00011011); // Power up seq.
-  wire.write(0b00000000); // Power up delay (3mS per rail)
-  wire.write(0b00011011); // Power down seq.
-  wire.write(0b00000000); // Power down delay (6mS per rail)
-  wire.end_transmission();
+  wire_device->write(pgm, sizeof(pgm));
   ESP::delay(1);
 
   //ESP_LOGD(TAG, "Power init completed");
@@ -174,6 +183,12 @@ EInk10::update(FrameBuffer1Bit & frame_buffer)
   const uint8_t * ptr;
   uint8_t         dram;
 
+  uint8_t * data = frame_buffer.get_data();
+
+  if (phase_data != nullptr) {
+    build_phase_1bit(phase_data, data, BITMAP_SIZE_1BIT, LUTW, true);
+  }
+
   Wire::enter();
   if (!turn_on()) {
     Wire::leave();
@@ -185,35 +200,38 @@ EInk10::update(FrameBuffer1Bit & frame_buffer)
   clean(PixelState::WHITE, 10);
   clean(PixelState::BLACK, 10);
 
-  uint8_t * data = frame_buffer.get_data();
-
-  for (int k = 0; k < 5; k++) {
-
-    ptr = &data[BITMAP_SIZE_1BIT - 1];
-
-    vscan_start();
+  if (phase_data != nullptr) {
+    for (int k = 0; k < 5; k++) send_phase(phase_data, false);
+  }
+  else {
+    for (int k = 0; k < 5; k++) {
 
-    for (int i = 0; i < HEIGHT; i++) {
+      ptr = &data[BITMAP_SIZE_1BIT - 1];
 
-      dram = ~(*ptr--);
+      vscan_start();
 
-      hscan_start(PIN_LUT[LUTW[(dram >> 4) & 0x0F]]);
-      GPIO.out_w1ts = CL | PIN_LUT[LUTW[dram & 0x0F]];
-      GPIO.out_w1tc = CL | DATA;
+      for (int i = 0; i < HEIGHT; i++) {
 
-      for (int j = 0; j < (LINE_SIZE_1BIT - 1); j++) {
         dram = ~(*ptr--);
-        GPIO.out_w1ts = CL | PIN_LUT[LUTW[(dram >> 4) & 0x0F]];
-        GPIO.out_w1tc = CL | DATA;
+
+        hscan_start(PIN_LUT[LUTW[(dram >> 4) & 0x0F]]);
         GPIO.out_w1ts = CL | PIN_LUT[LUTW[dram & 0x0F]];
         GPIO.out_w1tc = CL | DATA;
-      }
 
-      GPIO.out_w1ts = CL;
-      GPIO.out_w1tc = CL| DATA;
-      vscan_end();
+        for (int j = 0; j < (LINE_SIZE_1BIT - 1); j++) {
+          dram = ~(*ptr--);
+          GPIO.out_w1ts = CL | PIN_LUT[LUTW[(dram >> 4) & 0x0F]];
+          GPIO.out_w1tc = CL | DATA;
+          GPIO.out_w1ts = CL | PIN_LUT[LUTW[dram & 0x0F]];
+          GPIO.out_w1tc = CL | DATA;
+        }
+
+        GPIO.out_w1ts = CL;
+        GPIO.out_w1tc = CL| DATA;
+        vscan_end();
+      }
+      ESP::delay_microseconds(230);
     }
-    ESP::delay_microseconds(230);
   }
 
   clean(PixelState::DISCHARGE, 2);
@@ -233,6 +251,15 @@ EInk10::update(FrameBuffer3Bit & frame_buffer)
 {
   ESP_LOGD(TAG, "3bit Update...");
 
+  uint8_t * data = frame_buffer.get_data();
+
+  if (phase_data != nullptr) {
+    for (int k = 0; k < 8; k++) {
+      build_phase_3bit(phase_data + k * get_phase_image_size(), data, BITMAP_SIZE_3BIT,
+                       &WAVEFORM_3BIT[0][0], 8, k);
+    }
+  }
+
   Wire::enter();
   if (!turn_on()) {
     Wire::leave();
@@ -244,39 +271,42 @@ EInk10::update(FrameBuffer3Bit & frame_buffer)
   clean(PixelState::WHITE, 10);
   clean(PixelState::BLACK, 10);
 
-  uint8_t * data = frame_buffer.get_data();
+  if (phase_data != nullptr) {
+    for (int k = 0; k < 8; k++) send_phase(phase_data + k * get_phase_image_size(), false);
+  }
+  else {
+    for (int k = 0, kk = 0; k < 8; k++, kk += 256) {
 
-  for (int k = 0, kk = 0; k < 8; k++, kk += 256) {
+      const uint8_t * dp = &data[BITMAP_SIZE_3BIT - 2];
 
-    const uint8_t * dp = &data[BITMAP_SIZE_3BIT - 2];
+      vscan_start();
 
-    vscan_start();
+      for (int i = 0; i < HEIGHT; i++) {
 
-    for (int i = 0; i < HEIGHT; i++) {
+        hscan_start((GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]));
+        dp -= 2;
 
-      hscan_start((GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]));
-      dp -= 2;
+        GPIO.out_w1ts = CL | (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]);
+        GPIO.out_w1tc = CL | DATA;
+        dp -= 2;
 
-      GPIO.out_w1ts = CL | (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]);
-      GPIO.out_w1tc = CL | DATA;
-      dp -= 2;
+        for (int j = 0; j < ((WIDTH / 8) - 1); j++) {
+            GPIO.out_w1ts = CL | (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]);
+            GPIO.out_w1tc = CL | DATA;
+            dp -= 2;
+            GPIO.out_w1ts = CL | (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]);
+            GPIO.out_w1tc = CL | DATA;
+            dp -= 2;
+        }
 
-      for (int j = 0; j < ((WIDTH / 8) - 1); j++) {
-          GPIO.out_w1ts = CL | (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]);
-          GPIO.out_w1tc = CL | DATA;
-          dp -= 2;
-          GPIO.out_w1ts = CL | (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]);
-          GPIO.out_w1tc = CL | DATA;
-          dp -= 2;
-      }
+        GPIO.out_w1ts = CL;
+        GPIO.out_w1tc = CL | DATA;
 
-      GPIO.out_w1ts = CL;
-      GPIO.out_w1tc = CL | DATA;
+        vscan_end();
+      }
 
-      vscan_end();
+      ESP::delay_microseconds(230);
     }
-
-    ESP::delay_microseconds(230);
   }
 
   clean(PixelState::SKIP, 1);
@@ -289,66 +319,46 @@ EInk10::update(FrameBuffer3Bit & frame_buffer)
 
 void
 EInk10::partial_update(FrameBuffer1Bit & frame_buffer, bool force)
+{
+  partial_update(frame_buffer, 0, 0, WIDTH, HEIGHT, force);
+}
+
+void
+EInk10::partial_update(FrameBuffer1Bit & frame_buffer, 
+                      int16_t x, int16_t y, int16_t w, int16_t h, bool force)
 {
   if (!is_partial_allowed() && !force) {
     update(frame_buffer);
     return;
   }
 
-  Wire::enter();
-
   ESP_LOGD(TAG, "Partial update...");
 
-  uint8_t * idata = frame_buffer.get_data();
-  uint8_t * odata = d_memory_new->get_data();
+  PartialRegion region;
 
-  uint32_t n   = BITMAP_SIZE_1BIT * 2 - 1;
-  uint32_t pos = BITMAP_SIZE_1BIT - 1;
-  
-  for (int i = 0; i < HEIGHT; i++) {
-    for (int j = 0; j < LINE_SIZE_1BIT; j++) {
-      uint8_t diffw =  odata[pos] & ~idata[pos];
-      uint8_t diffb = ~odata[pos] &  idata[pos];
-      pos--;
-      p_buffer[n--] = LUTW[diffw >>   4] & (LUTB[diffb >>   4]);
-      p_buffer[n--] = LUTW[diffw & 0x0F] & (LUTB[diffb & 0x0F]);
-    }
+  if (!build_partial_image(frame_buffer, LUTW, LUTB, x, y, w, h, region)) {
+    ESP_LOGD(TAG, "Nothing to update.");
+    return;
   }
 
+  Wire::enter();
   if (!turn_on()) {
     Wire::leave();
     return;
   }
 
   for (int k = 0; k < 5; k++) {
-    vscan_start();
-    n = BITMAP_SIZE_1BIT * 2 - 1;
-
-    for (int i = 0; i < HEIGHT; i++) {
-      uint32_t send = PIN_LUT[p_buffer[n--]];
-      hscan_start(send);
-
-      for (int j = 0; j < ((WIDTH / 4) - 1); j++) {
-        send = PIN_LUT[p_buffer[n--]];
-        GPIO.out_w1ts = CL | send;
-        GPIO.out_w1tc = CL | DATA;
-      }
-
-      GPIO.out_w1ts = CL | send;
-      GPIO.out_w1tc = CL | DATA;
-      vscan_end();
-    }
-    ESP::delay_microseconds(230);
+    send_phase(p_buffer, true, region.first_row, region.last_row);
   }
 
-  clean(PixelState::DISCHARGE, 2);
-  clean(PixelState::SKIP,      1);
+  clean_rows(PixelState::DISCHARGE, 2, region.first_row, region.last_row);
+  clean_rows(PixelState::SKIP,      1, region.first_row, region.last_row);
   
   vscan_start();
   turn_off();
 
   Wire::leave();
-  memcpy(d_memory_new->get_data(), frame_buffer.get_data(), BITMAP_SIZE_1BIT);
+  save_partial_region(frame_buffer, region);
 }
 
 void
@@ -83,6 +83,8 @@ public:
   void update(FrameBuffer3Bit &frame_buffer);
 
   void partial_update(FrameBuffer1Bit &frame_buffer, bool force = false);
+  void partial_update(FrameBuffer1Bit &frame_buffer, 
+                      int16_t x, int16_t y, int16_t w, int16_t h, bool force = false);
 
 private:
   static constexpr char const *TAG = "EInk6";
@@ -109,6 +111,8 @@ private:
 
   void clean(PixelState pixel_state, uint8_t repeat_count);
 
+  inline uint8_t get_phase_image_count() { return 8; }
+
   static const uint8_t WAVEFORM_3BIT[8][8];
   static const uint32_t WAVEFORM[50];
   static const uint8_t LUT2[16];
@@ -168,6 +168,13 @@ EInk6FLICK::update(FrameBuffer1Bit & frame_buffer)
  
   const uint8_t * ptr;
 
+  uint8_t * data = frame_buffer.get_data();
+
+  if (phase_data != nullptr) {
+    build_phase_1bit(phase_data, data, BITMAP_SIZE_1BIT, LUTB, false, true);
+    build_phase_1bit(phase_data + get_phase_image_size(), data, BITMAP_SIZE_1BIT, LUT2, false, true);
+  }
+
   Wire::enter();
 
   if (!turn_on()) {
@@ -187,75 +194,78 @@ EInk6FLICK::update(FrameBuffer1Bit & frame_buffer)
 
   // ESP::delay(5000);
 
-  uint8_t * data = frame_buffer.get_data();
+  if (phase_data != nullptr) {
+    for (int k = 0; k < 4; k++) stream_phase(phase_data);
+    stream_phase(phase_data + get_phase_image_size());
+    ESP::delay_microseconds(230);
+  }
+  else {
+    // Each row is prepared in the next line buffer while the previous one is
+    // being sent by the DMA engine.
 
-  volatile uint8_t * line_buffer = i2s_comms.get_line_buffer();
+    // Write only black pixels.
+    for (int k = 0; k < 4; k++) {
 
-  // Write only black pixels.
-  for (int k = 0; k < 4; k++) {
+      ptr = &data[BITMAP_SIZE_1BIT - 1];
 
-    ptr = &data[BITMAP_SIZE_1BIT - 1];
+      vscan_start();
 
-    vscan_start();
+      for (int i = 0; i < HEIGHT; i++) {
 
-    for (int i = 0; i < HEIGHT; i++) {
+        volatile uint8_t * line_buffer = i2s_comms.get_line_buffer();
 
-      for (int n = 0; n < (WIDTH / 4); n += 4) {
-        uint8_t dram1 = *ptr--;
-        uint8_t dram2 = *ptr--;
-        line_buffer[n    ] = LUTB[(dram2 >> 4) & 0x0F]; // i + 2;
-        line_buffer[n + 1] = LUTB[ dram2       & 0x0F]; // i + 3;
-        line_buffer[n + 2] = LUTB[(dram1 >> 4) & 0x0F]; // i;
-        line_buffer[n + 3] = LUTB[ dram1       & 0x0F]; // i + 1;
-      }
+        for (int n = 0; n < (WIDTH / 4); n += 4) {
+          uint8_t dram1 = *ptr--;
+          uint8_t dram2 = *ptr--;
+          line_buffer[n    ] = LUTB[(dram2 >> 4) & 0x0F]; // i + 2;
+          line_buffer[n + 1] = LUTB[ dram2       & 0x0F]; // i + 3;
+          line_buffer[n + 2] = LUTB[(dram1 >> 4) & 0x0F]; // i;
+          line_buffer[n + 3] = LUTB[ dram1       & 0x0F]; // i + 1;
+        }
 
-      i2s_comms.send_data();
-      vscan_end();
+        send_row(i);
+      }
+      end_rows();
     }
-  }
 
-  // Now write both black and white pixels.
-  for (int k = 0; k < 1; k++) {
+    // Now write both black and white pixels.
+    for (int k = 0; k < 1; k++) {
 
-    ptr = &data[BITMAP_SIZE_1BIT - 1];
+      ptr = &data[BITMAP_SIZE_1BIT - 1];
 
-    vscan_start();
+      vscan_start();
 
-    for (int i = 0; i < HEIGHT; i++) {
+      for (int i = 0; i < HEIGHT; i++) {
 
-      for (int n = 0; n < (WIDTH / 4); n += 4) {
-        uint8_t dram1 = *ptr--;
-        uint8_t dram2 = *ptr--;
-        line_buffer[n    ] = LUT2[(dram2 >> 4) & 0x0F]; // i + 2;
-        line_buffer[n + 1] = LUT2[ dram2       & 0x0F]; // i + 3;
-        line_buffer[n + 2] = LUT2[(dram1 >> 4) & 0x0F]; // i;
-        line_buffer[n + 3] = LUT2[ dram1       & 0x0F]; // i + 1;
-      }
+        volatile uint8_t * line_buffer = i2s_comms.get_line_buffer();
 
-      i2s_comms.send_data();
-      vscan_end();
+        for (int n = 0; n < (WIDTH / 4); n += 4) {
+          uint8_t dram1 = *ptr--;
+          uint8_t dram2 = *ptr--;
+          line_buffer[n    ] = LUT2[(dram2 >> 4) & 0x0F]; // i + 2;
+          line_buffer[n + 1] = LUT2[ dram2       & 0x0F]; // i + 3;
+          line_buffer[n + 2] = LUT2[(dram1 >> 4) & 0x0F]; // i;
+          line_buffer[n + 3] = LUT2[ dram1       & 0x0F]; // i + 1;
+        }
+
+        send_row(i);
+      }
+      end_rows();
+      ESP::delay_microseconds(230);
     }
-    ESP::delay_microseconds(230);
   }
 
   // Discharge sequence
+  i2s_comms.fill_line_buffers(0, WIDTH / 4);
+
   for (int k = 0; k < 1; k++) {
 
     vscan_start();
 
     for (int i = 0; i < HEIGHT; i++) {
-
-      for (int n = 0; n < (WIDTH / 4); n += 4)
-      {
-        line_buffer[n    ] = 0; // i + 2;
-        line_buffer[n + 1] = 0; // i + 3;
-        line_buffer[n + 2] = 0; // i;
-        line_buffer[n + 3] = 0; // i + 1;
-      }
-
-      i2s_comms.send_data();
-      vscan_end();
+      send_row(i);
     }
+    end_rows();
   }
 
   turn_off();
@@ -271,6 +281,15 @@ EInk6FLICK::update(FrameBuffer3Bit & frame_buffer)
 {
   ESP_LOGD(TAG, "3bit Update...");
 
+  uint8_t * data = frame_buffer.get_data();
+
+  if (phase_data != nullptr) {
+    for (int k = 0; k < 9; k++) {
+      build_phase_3bit(phase_data + k * get_phase_image_size(), data, BITMAP_SIZE_3BIT,
+                       &WAVEFORM_3BIT[0][0], 9, k, true);
+    }
+  }
+
   Wire::enter();
   if (!turn_on()) {
     Wire::leave();
@@ -287,27 +306,29 @@ EInk6FLICK::update(FrameBuffer3Bit & frame_buffer)
   clean(PixelState::WHITE,     15);
   clean(PixelState::DISCHARGE,  1);
 
-  uint8_t * data = frame_buffer.get_data();
+  if (phase_data != nullptr) {
+    for (int k = 0; k < 9; k++) stream_phase(phase_data + k * get_phase_image_size());
+  }
+  else {
+    for (int k = 0, kk = 0; k < 9; k++, kk += 256) {
+      uint8_t * dp = &data[BITMAP_SIZE_3BIT] - 2;
 
-  volatile uint8_t * line_buffer = i2s_comms.get_line_buffer();
+      vscan_start();
 
-  for (int k = 0, kk = 0; k < 9; k++, kk += 256) {
-    uint8_t * dp = &data[BITMAP_SIZE_3BIT] - 2;
+      for (int i = 0; i < HEIGHT; i++) {
 
-    vscan_start();
+        volatile uint8_t * line_buffer = i2s_comms.get_line_buffer();
 
-    for (int i = 0; i < HEIGHT; i++) {
+        for (int j = 0; j < (WIDTH / 4); j += 4) {
+          line_buffer[j + 2] = (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]); dp -= 2;
+          line_buffer[j + 3] = (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]); dp -= 2;
+          line_buffer[j    ] = (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]); dp -= 2;
+          line_buffer[j + 1] = (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]); dp -= 2;
+        }
 
-      for (int j = 0; j < (WIDTH / 4); j += 4) {
-        line_buffer[j + 2] = (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]); dp -= 2;
-        line_buffer[j + 3] = (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]); dp -= 2;
-        line_buffer[j    ] = (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]); dp -= 2;
-        line_buffer[j + 1] = (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]); dp -= 2;
+        send_row(i);
       }
-
-      i2s_comms.send_data();
-
-      vscan_end();
+      end_rows();
     }
   }
 
@@ -321,6 +342,13 @@ EInk6FLICK::update(FrameBuffer3Bit & frame_buffer)
 
 void
 EInk6FLICK::partial_update(FrameBuffer1Bit & frame_buffer, bool force)
+{
+  partial_update(frame_buffer, 0, 0, WIDTH, HEIGHT, force);
+}
+
+void
+EInk6FLICK::partial_update(FrameBuffer1Bit & frame_buffer, 
+                           int16_t x, int16_t y, int16_t w, int16_t h, bool force)
 {
   if (!is_partial_allowed() && !force) {
     update(frame_buffer);
@@ -329,20 +357,11 @@ EInk6FLICK::partial_update(FrameBuffer1Bit & frame_buffer, bool force)
 
   ESP_LOGD(TAG, "Partial update...");
 
-  uint8_t * idata = frame_buffer.get_data();
-  uint8_t * odata = d_memory_new->get_data();
+  PartialRegion region;
 
-  uint32_t n   = BITMAP_SIZE_1BIT * 2 - 1;
-  uint32_t pos = BITMAP_SIZE_1BIT - 1;
- 
-  for (int i = 0; i < HEIGHT; i++) {
-    for (int j = 0; j < LINE_SIZE_1BIT; j++) {
-      uint8_t diffw =  odata[pos] & ~idata[pos];
-      uint8_t diffb = ~odata[pos] &  idata[pos];
-      pos--;
-      p_buffer[n--] = LUTW[diffw >>   4] & (LUTB[diffb >>   4]);
-      p_buffer[n--] = LUTW[diffw & 0x0F] & (LUTB[diffb & 0x0F]);
-    }
+  if (!build_partial_image(frame_buffer, LUTW, LUTB, x, y, w, h, region, true)) {
+    ESP_LOGD(TAG, "Nothing to update.");
+    return;
   }
 
   Wire::enter();
@@ -351,40 +370,25 @@ EInk6FLICK::partial_update(FrameBuffer1Bit & frame_buffer, bool force)
     return;
   }
 
-  volatile uint8_t *line_buffer = i2s_comms.get_line_buffer();
   i2s_comms.init_lldesc();
-  
-  if (line_buffer == nullptr) return;
 
   for (int k = 0; k < 5; k++) {
+    stream_rows(p_buffer, WIDTH / 4, region.first_row, region.last_row);
+  }
 
-    vscan_start();
-    n = (BITMAP_SIZE_1BIT * 2) - 1;
-
-    for (int i = 0; i < HEIGHT; i++) {
-
-      for (int j = 0; j < (WIDTH / 4); j += 4) {
-        line_buffer[j + 2] = p_buffer[n    ];
-        line_buffer[j + 3] = p_buffer[n - 1];
-        line_buffer[j    ] = p_buffer[n - 2];
-        line_buffer[j + 1] = p_buffer[n - 3];
-        n -= 4;
-      }
-
-      i2s_comms.send_data();
+  uint8_t line[WIDTH / 4];
 
-      vscan_end();
-    }
-  }
+  memset(line, static_cast<uint8_t>(PixelState::DISCHARGE), sizeof(line));
+  for (int k = 0; k < 2; k++) stream_rows(line, 0, region.first_row, region.last_row);
 
-  clean(PixelState::DISCHARGE, 2);
-  clean(PixelState::SKIP,      1);
+  memset(line, static_cast<uint8_t>(PixelState::SKIP), sizeof(line));
+  stream_rows(line, 0, region.first_row, region.last_row);
   
   vscan_start();
   turn_off();
 
   Wire::leave();
-  memcpy(d_memory_new->get_data(), frame_buffer.get_data(), BITMAP_SIZE_1BIT);
+  save_partial_region(frame_buffer, region);
 }
 
 void
@@ -392,11 +396,7 @@ EInk6FLICK::clean(PixelState pixel_state, uint8_t repeat_count)
 {
   if (!turn_on()) return;
 
-  volatile uint8_t *line_buffer = i2s_comms.get_line_buffer();
-  for (int i = 0; i < (WIDTH / 4); i++) {
-    line_buffer[i] = static_cast<uint8_t>(pixel_state);
-  }
-
+  i2s_comms.fill_line_buffers(static_cast<uint8_t>(pixel_state), WIDTH / 4);
   i2s_comms.init_lldesc();
 
   for (int8_t k = 0; k < repeat_count; k++) {
@@ -404,10 +404,89 @@ EInk6FLICK::clean(PixelState pixel_state, uint8_t repeat_count)
     vscan_start();
 
     for (int i = 0; i < HEIGHT; i++) {
-      i2s_comms.send_data();
+      send_row(i);
+    }
+    end_rows();
+  }
+}
+
+// Starts sending the current line buffer once the previous row, if any, is
+// completed and latched.
+void
+EInk6FLICK::send_row(int row)
+{
+  if (row > 0) {
+    i2s_comms.wait_data();
+    vscan_end();
+  }
+  i2s_comms.start_data();
+}
+
+// Sends a phase image built in I2S order, one row per line buffer.
+void
+EInk6FLICK::stream_phase(const uint8_t * image)
+{
+  vscan_start();
+
+  for (int i = 0; i < HEIGHT; i++) {
+    memcpy((uint8_t *) i2s_comms.get_line_buffer(), image, WIDTH / 4);
+    image += WIDTH / 4;
+    send_row(i);
+  }
+  end_rows();
+}
+
+// Sends rows first_row..last_row of an image, line_step bytes apart. The
+// other rows are skipped: a neutral line is sent once, then only the gate
+// is clocked. The DMA pipeline is drained before a gate only row.
+void
+EInk6FLICK::stream_rows(const uint8_t * image, int line_step, int16_t first_row, int16_t last_row)
+{
+  bool pending        = false;
+  bool neutral_loaded = false;
+
+  vscan_start();
+
+  for (int i = 0; i < HEIGHT; i++, image += line_step) {
+    bool skip = (i < first_row) || (i > last_row);
+
+    if (skip && neutral_loaded) {
+      ckv_set();
+      ESP::delay_microseconds(3);
       vscan_end();
+      continue;
+    }
+
+    uint8_t * line_buffer = (uint8_t *) i2s_comms.get_line_buffer();
+    if (skip) memset(line_buffer, static_cast<uint8_t>(PixelState::SKIP), WIDTH / 4);
+    else      memcpy(line_buffer, image, WIDTH / 4);
+
+    if (pending) {
+      i2s_comms.wait_data();
+      vscan_end();
+    }
+    i2s_comms.start_data();
+    pending = true;
+
+    if (skip) {
+      end_rows();
+      pending        = false;
+      neutral_loaded = true;
+    }
+    else {
+      neutral_loaded = false;
     }
   }
+  
+  if (pending) end_rows();
+}
+
+// Completes and latches the last row sent.
+void
+EInk6FLICK::end_rows()
+{
+  i2s_comms.wait_data();
+  vscan_end();
 }
 
 #endif
\ No newline at end of file
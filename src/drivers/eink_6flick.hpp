@@ -84,6 +84,8 @@ class EInk6FLICK : public EInk, NonCopyable
     void update(FrameBuffer3Bit & frame_buffer);
 
     void partial_update(FrameBuffer1Bit & frame_buffer, bool force = false);
+    void partial_update(FrameBuffer1Bit & frame_buffer, 
+                        int16_t x, int16_t y, int16_t w, int16_t h, bool force = false);
     
   private:
     static constexpr char const * TAG = "EInk6FLICK";
@@ -110,6 +112,13 @@ class EInk6FLICK : public EInk, NonCopyable
 
     void clean(PixelState pixel_state, uint8_t repeat_count);
 
+    void send_row(int row);
+    void end_rows();
+    void stream_phase(const uint8_t * image);
+    void  stream_rows(const uint8_t * image, int line_step, int16_t first_row, int16_t last_row);
+
+    inline uint8_t get_phase_image_count() { return 9; }
+
     static const uint8_t  WAVEFORM_3BIT[8][9]; 
     static const uint8_t  LUT2[16];
     static const uint8_t  LUTW[16];
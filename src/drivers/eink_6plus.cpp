@@ -187,6 +187,13 @@ EInk6PLUS::update(FrameBuffer1Bit & frame_buffer)
   const uint8_t * ptr;
   uint8_t         dram;
 
+  uint8_t * data = frame_buffer.get_data();
+
+  if (phase_data != nullptr) {
+    build_phase_1bit(phase_data, data, BITMAP_SIZE_1BIT, LUTW, true);
+    build_phase_1bit(phase_data + get_phase_image_size(), data, BITMAP_SIZE_1BIT, LUTB, false);
+  }
+
   Wire::enter();
 
   if (!turn_on()) {
@@ -201,63 +208,67 @@ EInk6PLUS::update(FrameBuffer1Bit & frame_buffer)
   clean(PixelState::DISCHARGE,  1);
   clean(PixelState::BLACK,     15);
 
-  uint8_t * data = frame_buffer.get_data();
+  if (phase_data != nullptr) {
+    for (int k = 0; k < 4; k++) send_phase(phase_data, false);
+    send_phase(phase_data + get_phase_image_size(), false);
+  }
+  else {
+    for (int k = 0; k < 4; k++) {
 
-  for (int k = 0; k < 4; k++) {
+      ptr = &data[BITMAP_SIZE_1BIT - 1];
 
-    ptr = &data[BITMAP_SIZE_1BIT - 1];
+      vscan_start();
+
+      for (int i = 0; i < HEIGHT; i++) {
+
+        dram = ~(*ptr--);
+
+        hscan_start(PIN_LUT[LUTW[(dram >> 4) & 0x0F]]);
+        GPIO.out_w1ts = CL | PIN_LUT[LUTW[dram & 0x0F]];
+        GPIO.out_w1tc = CL | DATA;
+
+        for (int j = 0; j < (LINE_SIZE_1BIT - 1); j++) {
+          dram = ~(*ptr--);
+          GPIO.out_w1ts = CL | PIN_LUT[LUTW[(dram >> 4) & 0x0F]];
+          GPIO.out_w1tc = CL | DATA;
+          GPIO.out_w1ts = CL | PIN_LUT[LUTW[dram & 0x0F]];
+          GPIO.out_w1tc = CL | DATA;
+        }
+
+        GPIO.out_w1ts = CL;
+        GPIO.out_w1tc = CL| DATA;
+        vscan_end();
+      }
+      ESP::delay_microseconds(230);
+    }
 
     vscan_start();
 
+    ptr = &data[BITMAP_SIZE_1BIT - 1];
+
     for (int i = 0; i < HEIGHT; i++) {
 
-      dram = ~(*ptr--);
+      dram = *ptr--;
 
-      hscan_start(PIN_LUT[LUTW[(dram >> 4) & 0x0F]]);
-      GPIO.out_w1ts = CL | PIN_LUT[LUTW[dram & 0x0F]];
+      hscan_start(PIN_LUT[LUTB[(dram >> 4) & 0x0F]]);
+      GPIO.out_w1ts = CL | PIN_LUT[LUTB[dram & 0x0F]];
       GPIO.out_w1tc = CL | DATA;
 
       for (int j = 0; j < (LINE_SIZE_1BIT - 1); j++) {
-        dram = ~(*ptr--);
-        GPIO.out_w1ts = CL | PIN_LUT[LUTW[(dram >> 4) & 0x0F]];
+        dram = *ptr--;
+        GPIO.out_w1ts = CL | PIN_LUT[LUTB[(dram >> 4) & 0x0F]];
         GPIO.out_w1tc = CL | DATA;
-        GPIO.out_w1ts = CL | PIN_LUT[LUTW[dram & 0x0F]];
+        GPIO.out_w1ts = CL | PIN_LUT[LUTB[dram & 0x0F]];
         GPIO.out_w1tc = CL | DATA;
       }
 
       GPIO.out_w1ts = CL;
-      GPIO.out_w1tc = CL| DATA;
+      GPIO.out_w1tc = CL | DATA;
       vscan_end();
     }
     ESP::delay_microseconds(230);
   }
 
-  vscan_start();
-
-  ptr = &data[BITMAP_SIZE_1BIT - 1];
-
-  for (int i = 0; i < HEIGHT; i++) {
-
-    dram = *ptr--;
-
-    hscan_start(PIN_LUT[LUTB[(dram >> 4) & 0x0F]]);
-    GPIO.out_w1ts = CL | PIN_LUT[LUTB[dram & 0x0F]];
-    GPIO.out_w1tc = CL | DATA;
-
-    for (int j = 0; j < (LINE_SIZE_1BIT - 1); j++) {
-      dram = *ptr--;
-      GPIO.out_w1ts = CL | PIN_LUT[LUTB[(dram >> 4) & 0x0F]];
-      GPIO.out_w1tc = CL | DATA;
-      GPIO.out_w1ts = CL | PIN_LUT[LUTB[dram & 0x0F]];
-      GPIO.out_w1tc = CL | DATA;
-    }
-
-    GPIO.out_w1ts = CL;
-    GPIO.out_w1tc = CL | DATA;
-    vscan_end();
-  }
-  ESP::delay_microseconds(230);
-
   clean(PixelState::DISCHARGE, 2);
   clean(PixelState::SKIP,      1);
 
@@ -275,6 +286,15 @@ EInk6PLUS::update(FrameBuffer3Bit & frame_buffer)
 {
   ESP_LOGD(TAG, "3bit Update...");
 
+  uint8_t * data = frame_buffer.get_data();
+
+  if (phase_data != nullptr) {
+    for (int k = 0; k < 9; k++) {
+      build_phase_3bit(phase_data + k * get_phase_image_size(), data, BITMAP_SIZE_3BIT,
+                       &WAVEFORM_3BIT[0][0], 9, k);
+    }
+  }
+
   Wire::enter();
   if (!turn_on()) {
     Wire::leave();
@@ -288,39 +308,42 @@ EInk6PLUS::update(FrameBuffer3Bit & frame_buffer)
   clean(PixelState::DISCHARGE,  1);
   clean(PixelState::BLACK,     15);
 
-  uint8_t * data = frame_buffer.get_data();
+  if (phase_data != nullptr) {
+    for (int k = 0; k < 9; k++) send_phase(phase_data + k * get_phase_image_size(), false);
+  }
+  else {
+    for (int k = 0, kk = 0; k < 9; k++, kk += 256) {
 
-  for (int k = 0, kk = 0; k < 9; k++, kk += 256) {
+      const uint8_t * dp = &data[BITMAP_SIZE_3BIT - 2];
 
-    const uint8_t * dp = &data[BITMAP_SIZE_3BIT - 2];
+      vscan_start();
 
-    vscan_start();
+      for (int i = 0; i < HEIGHT; i++) {
 
-    for (int i = 0; i < HEIGHT; i++) {
+        hscan_start((GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]));
+        dp -= 2;
 
-      hscan_start((GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]));
-      dp -= 2;
+        GPIO.out_w1ts = CL | (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]);
+        GPIO.out_w1tc = CL | DATA;
+        dp -= 2;
 
-      GPIO.out_w1ts = CL | (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]);
-      GPIO.out_w1tc = CL | DATA;
-      dp -= 2;
+        for (int j = 0; j < ((WIDTH / 8) - 1); j++) {
+            GPIO.out_w1ts = CL | (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]);
+            GPIO.out_w1tc = CL | DATA;
+            dp -= 2;
+            GPIO.out_w1ts = CL | (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]);
+            GPIO.out_w1tc = CL | DATA;
+            dp -= 2;
+        }
 
-      for (int j = 0; j < ((WIDTH / 8) - 1); j++) {
-          GPIO.out_w1ts = CL | (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]);
-          GPIO.out_w1tc = CL | DATA;
-          dp -= 2;
-          GPIO.out_w1ts = CL | (GLUT2[kk + dp[1]] | GLUT[kk + dp[0]]);
-          GPIO.out_w1tc = CL | DATA;
-          dp -= 2;
-      }
+        GPIO.out_w1ts = CL;
+        GPIO.out_w1tc = CL | DATA;
 
-      GPIO.out_w1ts = CL;
-      GPIO.out_w1tc = CL | DATA;
+        vscan_end();
+      }
 
-      vscan_end();
+      ESP::delay_microseconds(230);
     }
-
-    ESP::delay_microseconds(230);
   }
 
   clean(PixelState::SKIP, 1);
@@ -333,64 +356,46 @@ EInk6PLUS::update(FrameBuffer3Bit & frame_buffer)
 
 void
 EInk6PLUS::partial_update(FrameBuffer1Bit & frame_buffer, bool force)
+{
+  partial_update(frame_buffer, 0, 0, WIDTH, HEIGHT, force);
+}
+
+void
+EInk6PLUS::partial_update(FrameBuffer1Bit & frame_buffer, 
+                      int16_t x, int16_t y, int16_t w, int16_t h, bool force)
 {
   if (!is_partial_allowed() && !force) {
     update(frame_buffer);
     return;
   }
 
-  Wire::enter();
-
   ESP_LOGD(TAG, "Partial update...");
 
-  uint8_t * idata = frame_buffer.get_data();
-  uint8_t * odata = d_memory_new->get_data();
+  PartialRegion region;
 
-  uint32_t n   = BITMAP_SIZE_1BIT * 2 - 1;
-  uint32_t pos = BITMAP_SIZE_1BIT - 1;
- 
-  for (int i = 0; i < HEIGHT; i++) {
-    for (int j = 0; j < LINE_SIZE_1BIT; j++) {
-      uint8_t diffw =  odata[pos] & ~idata[pos];
-      uint8_t diffb = ~odata[pos] &  idata[pos];
-      pos--;
-      p_buffer[n--] = LUTW[diffw >>   4] & (LUTB[diffb >>   4]);
-      p_buffer[n--] = LUTW[diffw & 0x0F] & (LUTB[diffb & 0x0F]);
-    }
+  if (!build_partial_image(frame_buffer, LUTW, LUTB, x, y, w, h, region)) {
+    ESP_LOGD(TAG, "Nothing to update.");
+    return;
   }
 
+  Wire::enter();
   if (!turn_on()) {
     Wire::leave();
     return;
   }
 
   for (int k = 0; k < 5; k++) {
-    vscan_start();
-    n = (BITMAP_SIZE_1BIT * 2) - 1;
-
-    for (int i = 0; i < HEIGHT; i++) {
-      hscan_start(PIN_LUT[p_buffer[n--]]);
-
-      for (int j = 0; j < ((WIDTH / 4) - 1); j++) {
-        GPIO.out_w1ts = CL | PIN_LUT[p_buffer[n--]];
-        GPIO.out_w1tc = CL | DATA;
-      }
-
-      GPIO.out_w1ts = CL;
-      GPIO.out_w1tc = CL | DATA;
-      vscan_end();
-    }
-    ESP::delay_microseconds(230);
+    send_phase(p_buffer, false, region.first_row, region.last_row);
   }
 
-  clean(PixelState::DISCHARGE, 2);
-  clean(PixelState::SKIP,      1);
+  clean_rows(PixelState::DISCHARGE, 2, region.first_row, region.last_row);
+  clean_rows(PixelState::SKIP,      1, region.first_row, region.last_row);
   
   vscan_start();
   turn_off();
 
   Wire::leave();
-  memcpy(d_memory_new->get_data(), frame_buffer.get_data(), BITMAP_SIZE_1BIT);
+  save_partial_region(frame_buffer, region);
 }
 
 void
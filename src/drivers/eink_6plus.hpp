@@ -80,6 +80,8 @@ class EInk6PLUS : public EInk, NonCopyable
     void update(FrameBuffer3Bit & frame_buffer);
 
     void partial_update(FrameBuffer1Bit & frame_buffer, bool force = false);
+    void partial_update(FrameBuffer1Bit & frame_buffer, 
+                        int16_t x, int16_t y, int16_t w, int16_t h, bool force = false);
     
   private:
     static constexpr char const * TAG = "EInk6PLUS";
@@ -106,6 +108,8 @@ class EInk6PLUS : public EInk, NonCopyable
 
     void clean(PixelState pixel_state, uint8_t repeat_count);
 
+    inline uint8_t get_phase_image_count() { return 9; }
+
     static const uint8_t  WAVEFORM_3BIT[8][9]; 
     static const uint8_t  LUTW[16];
     static const uint8_t  LUTB[16];
@@ -28,4 +28,14 @@ typedef struct
 	uint8_t    yAdvance;   ///< Newline distance (y axis)
 } GFXfont;
 
+/// Anti-aliased font: same glyph metrics as GFXfont, the bitmap holding
+/// bpp bits of ink coverage per pixel (0: none, (1 << bpp) - 1: full),
+/// concatenated as a continuous bit stream per glyph, most significant
+/// bits first. Built by tools/fontconvert_gray.
+typedef struct
+{
+	GFXfont    font;       ///< Glyph metrics, bitmap of coverage values
+	uint8_t    bpp;        ///< Bits per pixel: 2 or 3
+} GFXfontGray;
+
 #endif // __GFX_FONT_HPP__
@@ -0,0 +1,187 @@
+/*
+glyph_cache.cpp
+Inkplate 6 ESP-IDF
+
+Pre-rasterized GFXfont glyphs, kept in PSRAM.
+
+This code is released under the GNU Lesser General Public License v3.0: https://www.gnu.org/licenses/lgpl-3.0.en.html
+*/
+
+#include "glyph_cache.hpp"
+#include "esp.hpp"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#include <cstring>
+
+GlyphCache::GlyphCache(uint32_t max_bytes) : lru_head(nullptr), lru_tail(nullptr)
+{
+  memset(&stats, 0, sizeof(stats));
+  stats.max_bytes = max_bytes;
+
+  buckets = (Glyph **) ESP::ps_malloc(BUCKET_COUNT * sizeof(Glyph *));
+  if (buckets != nullptr) memset(buckets, 0, BUCKET_COUNT * sizeof(Glyph *));
+}
+
+GlyphCache::~GlyphCache()
+{
+  clear();
+  if (buckets != nullptr) heap_caps_free(buckets);
+}
+
+void
+GlyphCache::clear()
+{
+  while (lru_tail != nullptr) evict();
+}
+
+const GlyphCache::Glyph *
+GlyphCache::get(const GFXfont * font, uint8_t c, uint8_t rotation, uint8_t size_x, uint8_t size_y)
+{
+  if (buckets == nullptr) return nullptr;
+
+  Glyph ** bucket = &buckets[hash(font, c, rotation, size_x, size_y)];
+
+  for (Glyph * glyph = *bucket; glyph != nullptr; glyph = glyph->chain) {
+    if ((glyph->font == font) && (glyph->c == c) && (glyph->rotation == rotation) &&
+        (glyph->size_x == size_x) && (glyph->size_y == size_y)) {
+      stats.hits++;
+      if (glyph != lru_head) {
+        unlink_lru(glyph);
+        push_lru(glyph);
+      }
+      return glyph;
+    }
+  }
+
+  stats.misses++;
+
+  Glyph * glyph = build(font, c, rotation, size_x, size_y);
+  if (glyph == nullptr) return nullptr;
+
+  glyph->chain = *bucket;
+  *bucket      = glyph;
+  push_lru(glyph);
+
+  stats.entries++;
+  stats.bytes += glyph->bytes;
+
+  return glyph;
+}
+
+// Rasterizes a glyph, scaled by size_x and size_y, in panel orientation.
+// A glyph pixel at [a, b] from the cursor (current rotation coordinates) is
+// at panel offset M(a, b) from the panel location of the cursor, M being
+// the linear part of the rotation.
+
+GlyphCache::Glyph *
+GlyphCache::build(const GFXfont * font, uint8_t c, uint8_t rotation, uint8_t size_x, uint8_t size_y)
+{
+  const GFXglyph * g = &font->glyph[(uint8_t)(c - font->first)];
+
+  int16_t w  = g->width  * size_x;
+  int16_t h  = g->height * size_y;
+  int16_t a0 = g->xOffset * size_x;
+  int16_t b0 = g->yOffset * size_y;
+
+  int16_t pw = (rotation & 1) ? h : w;
+  int16_t ph = (rotation & 1) ? w : h;
+
+  if ((pw == 0) || (pw > MAX_WIDTH) || (ph > MAX_HEIGHT)) return nullptr;
+
+  uint32_t bytes = sizeof(Glyph) + ph * sizeof(uint64_t);
+  if (bytes > stats.max_bytes) return nullptr;
+
+  while ((lru_tail != nullptr) && ((stats.bytes + bytes) > stats.max_bytes)) evict();
+
+  Glyph * glyph = (Glyph *) ESP::ps_malloc(bytes);
+  if (glyph == nullptr) return nullptr;
+
+  glyph->font     = font;
+  glyph->c        = c;
+  glyph->rotation = rotation;
+  glyph->size_x   = size_x;
+  glyph->size_y   = size_y;
+  glyph->width    = pw;
+  glyph->height   = ph;
+  glyph->bytes    = bytes;
+
+  // Panel offset of the upper left corner of the rotated glyph box
+
+  switch (rotation) {
+    case 1:  glyph->dx = -(b0 + h - 1); glyph->dy =   a0;          break;
+    case 2:  glyph->dx = -(a0 + w - 1); glyph->dy = -(b0 + h - 1); break;
+    case 3:  glyph->dx =   b0;          glyph->dy = -(a0 + w - 1); break;
+    default: glyph->dx =   a0;          glyph->dy =   b0;          break;
+  }
+
+  memset(glyph->rows, 0, ph * sizeof(uint64_t));
+
+  const uint8_t * bitmap = &font->bitmap[g->bitmapOffset];
+  uint32_t        bit    = 0;
+
+  for (int16_t yy = 0; yy < g->height; yy++) {
+    for (int16_t xx = 0; xx < g->width; xx++, bit++) {
+      if (!(bitmap[bit >> 3] & (0x80 >> (bit & 7)))) continue;
+
+      for (int16_t j = 0; j < size_y; j++) {
+        for (int16_t i = 0; i < size_x; i++) {
+          int16_t a = a0 + xx * size_x + i;
+          int16_t b = b0 + yy * size_y + j;
+          int16_t x, y;
+
+          switch (rotation) {
+            case 1:  x = -b; y =  a; break;
+            case 2:  x = -a; y = -b; break;
+            case 3:  x =  b; y = -a; break;
+            default: x =  a; y =  b; break;
+          }
+
+          glyph->rows[y - glyph->dy] |= 1ULL << (x - glyph->dx);
+        }
+      }
+    }
+  }
+
+  return glyph;
+}
+
+void
+GlyphCache::evict()
+{
+  Glyph * glyph = lru_tail;
+
+  unlink_lru(glyph);
+
+  Glyph ** p = &buckets[hash(glyph->font, glyph->c, glyph->rotation, glyph->size_x, glyph->size_y)];
+  while (*p != glyph) p = &(*p)->chain;
+  *p = glyph->chain;
+
+  stats.evictions++;
+  stats.entries--;
+  stats.bytes -= glyph->bytes;
+
+  heap_caps_free(glyph);
+}
+
+void
+GlyphCache::unlink_lru(Glyph * glyph)
+{
+  if (glyph->lru_prev != nullptr) glyph->lru_prev->lru_next = glyph->lru_next;
+  else lru_head = glyph->lru_next;
+
+  if (glyph->lru_next != nullptr) glyph->lru_next->lru_prev = glyph->lru_prev;
+  else lru_tail = glyph->lru_prev;
+}
+
+void
+GlyphCache::push_lru(Glyph * glyph)
+{
+  glyph->lru_prev = nullptr;
+  glyph->lru_next = lru_head;
+
+  if (lru_head != nullptr) lru_head->lru_prev = glyph;
+  else lru_tail = glyph;
+
+  lru_head = glyph;
+}
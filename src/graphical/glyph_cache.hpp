@@ -0,0 +1,94 @@
+/*
+glyph_cache.hpp
+Inkplate 6 ESP-IDF
+
+Pre-rasterized GFXfont glyphs, kept in PSRAM.
+
+This code is released under the GNU Lesser General Public License v3.0: https://www.gnu.org/licenses/lgpl-3.0.en.html
+*/
+
+#ifndef __GLYPH_CACHE_HPP__
+#define __GLYPH_CACHE_HPP__
+
+#include <cstdint>
+
+#include "gfx_font.hpp"
+
+/**
+ * @brief Cache of pre-rasterized glyphs
+ *
+ * A glyph is rasterized once per font, character, rotation and text size,
+ * in panel orientation: one 64 bits word per panel row, bit k being the
+ * pixel at panel X + k. Drawing a cached glyph is then a shift and a few
+ * byte writes per row. Glyphs more than MAX_WIDTH pixels wide or MAX_HEIGHT
+ * pixels high on the panel are not cached.
+ *
+ * The entries are allocated in PSRAM. When the cache reaches its size
+ * limit, the least recently used entries are evicted.
+ */
+class GlyphCache
+{
+  public:
+    static const uint8_t MAX_WIDTH  = 57;
+    static const uint8_t MAX_HEIGHT = 255;  ///< Glyph::height range
+
+    struct Glyph {
+      Glyph   * lru_prev;
+      Glyph   * lru_next;
+      Glyph   * chain;
+      const GFXfont * font;
+      uint8_t   c, rotation, size_x, size_y;
+      int16_t   dx, dy;          ///< Panel offset of the rows from the glyph origin
+      uint8_t   width, height;   ///< In panel orientation
+      uint32_t  bytes;
+      uint64_t  rows[0];
+    } __attribute__((aligned(8)));
+
+    struct Stats {
+      uint32_t hits;
+      uint32_t misses;
+      uint32_t evictions;
+      uint32_t entries;
+      uint32_t bytes;
+      uint32_t max_bytes;
+    };
+
+    GlyphCache(uint32_t max_bytes);
+   ~GlyphCache();
+
+    inline bool is_ready() { return buckets != nullptr; }
+
+    /**
+     * @brief Returns the rasterized glyph, building it on first use
+     *
+     * @return nullptr if the glyph cannot be cached (too large, no memory).
+     */
+    const Glyph * get(const GFXfont * font, uint8_t c, uint8_t rotation, uint8_t size_x, uint8_t size_y);
+
+    void clear();
+
+    inline const Stats & get_stats() { return stats; }
+    inline void        reset_stats() { stats.hits = stats.misses = stats.evictions = 0; }
+
+  private:
+    static constexpr char const * TAG = "GlyphCache";
+
+    static const uint16_t BUCKET_COUNT = 256;
+
+    Glyph ** buckets;
+    Glyph  * lru_head;  ///< Most recently used
+    Glyph  * lru_tail;  ///< Least recently used
+    Stats    stats;
+
+    static inline uint16_t hash(const GFXfont * font, uint8_t c, uint8_t rotation, uint8_t size_x, uint8_t size_y) {
+      uint32_t h = (uint32_t)(uintptr_t) font ^ (c * 0x9E37u) ^ (rotation << 8) ^ (size_x << 11) ^ (size_y << 14);
+      return (h ^ (h >> 8) ^ (h >> 16)) & (BUCKET_COUNT - 1);
+    }
+
+    Glyph * build(const GFXfont * font, uint8_t c, uint8_t rotation, uint8_t size_x, uint8_t size_y);
+    void    evict();
+    void    unlink_lru(Glyph * glyph);
+    void    push_lru(Glyph * glyph);
+};
+
+#endif
@@ -15,10 +15,12 @@ Distributed as-is; no warranty is given.
 */
 
 #include "graphics.hpp"
+#include "raw_image.hpp"
 #include "inkplate_platform.hpp"
 #include "esp_log.h"
 
 #include <algorithm>
+#include <cstring>
 
 Graphics::Graphics(int16_t w, int16_t h) : 
   Adafruit_GFX(w, h), Shapes(w, h), Image(w, h) 
@@ -33,6 +35,7 @@ Graphics::Graphics(int16_t w, int16_t h) :
     _partial->clear();
     DMemory4Bit->clear();
   }
+  markAllDirty();
 };
 
 void Graphics::setRotation(uint8_t x)
@@ -60,7 +63,7 @@ uint8_t Graphics::getRotation()
 
 void Graphics::drawPixel(int16_t x0, int16_t y0, uint16_t color)
 {
-    writePixel(x0, y0, color); // Specified in boards folder
+    writePixel(x0, y0, color);
 }
 
 void Graphics::startWrite()
@@ -69,24 +72,153 @@ void Graphics::startWrite()
 
 void Graphics::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
 {
-    for (int i = 0; i < h; ++i)
-        for (int j = 0; j < w; ++j)
-            writePixel(x + j, y + i, color);
+    int16_t x0, y0, x1, y1;
+
+    if (toPanelRect(x, y, w, h, x0, y0, x1, y1))
+        fillPanelRect(x0, y0, x1, y1, color);
 }
 
 void Graphics::writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
 {
-    for (int i = 0; i < h; ++i)
-        writePixel(x, y + i, color);
+    writeFillRect(x, y, 1, h, color);
 }
 
 void Graphics::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
 {
-    for (int j = 0; j < w; ++j)
-        writePixel(x + j, y, color);
+    writeFillRect(x, y, w, 1, color);
+}
+
+void Graphics::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    writeFillRect(x, y, w, h, color);
+}
+
+void Graphics::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    writeFillRect(x, y, 1, h, color);
+}
+
+void Graphics::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    writeFillRect(x, y, w, 1, color);
+}
+
+void Graphics::fillScreen(uint16_t color)
+{
+    if (getDisplayMode() == DisplayMode::INKPLATE_1BIT)
+    {
+        memset(_partial->get_data(), color ? 0xFF : 0x00, _partial->get_data_size());
+        markAllDirty();
+    }
+    else
+    {
+        color &= 7;
+        memset(DMemory4Bit->get_data(), (color << 4) | color, DMemory4Bit->get_data_size());
+    }
+}
+
+// Clips a rectangle given in the current rotation coordinates and maps it to
+// panel coordinates, the same way writePixel() does for each pixel. Returns
+// false if nothing is left after clipping.
+
+bool Graphics::toPanelRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                           int16_t & x0, int16_t & y0, int16_t & x1, int16_t & y1)
+{
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if ((x + w) > width() ) w = width()  - x;
+    if ((y + h) > height()) h = height() - y;
+    if ((w <= 0) || (h <= 0)) return false;
+
+    x0 = x; y0 = y; x1 = x + w - 1; y1 = y + h - 1;
+
+    switch (rotation)
+    {
+    case 1:
+        std::swap(x0, y0); x0 = height() - x0 - 1;
+        std::swap(x1, y1); x1 = height() - x1 - 1;
+        break;
+    case 2:
+        x0 = width() - x0 - 1; y0 = height() - y0 - 1;
+        x1 = width() - x1 - 1; y1 = height() - y1 - 1;
+        break;
+    case 3:
+        std::swap(x0, y0); y0 = width() - y0 - 1;
+        std::swap(x1, y1); y1 = width() - y1 - 1;
+        break;
+    }
+
+    if (x0 > x1) std::swap(x0, x1);
+    if (y0 > y1) std::swap(y0, y1);
+
+    return true;
+}
+
+// Fills an already clipped rectangle in panel coordinates, a row span at a
+// time: whole bytes are set with memset, the partial bytes at both ends are
+// masked.
+
+void Graphics::fillPanelRect(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+    withMode([&](auto m) { fillPanelRectTo<decltype(m)::value>(x0, y0, x1, y1, color); });
+}
+
+template <DisplayMode M>
+void Graphics::fillPanelRectTo(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+    if constexpr (M == DisplayMode::INKPLATE_1BIT)
+    {
+        int16_t  line_size  = _partial->get_line_size();
+        int16_t  first      = x0 >> 3;
+        int16_t  last       = x1 >> 3;
+        uint8_t  first_mask = 0xFF << (x0 & 7);
+        uint8_t  last_mask  = 0xFF >> (7 - (x1 & 7));
+        uint8_t  value      = color ? 0xFF : 0x00;
+
+        if (first == last) first_mask &= last_mask;
+
+        uint8_t * p = &_partial->get_data()[line_size * y0];
+        for (int16_t y = y0; y <= y1; y++, p += line_size)
+        {
+            p[first] = (p[first] & ~first_mask) | (value & first_mask);
+            if (first != last)
+            {
+                memset(&p[first + 1], value, last - first - 1);
+                p[last] = (p[last] & ~last_mask) | (value & last_mask);
+            }
+        }
+
+        markDirty(x0, y0);
+        markDirty(x1, y1);
+    }
+    else
+    {
+        color &= 7;
+
+        int16_t  line_size = DMemory4Bit->get_line_size();
+        int16_t  first     = (x0 + 1) >> 1;          // First byte fully covered
+        int16_t  last      = (x1 + 1) >> 1;          // Byte after the last fully covered
+        uint8_t  value     = (color << 4) | color;
+
+        uint8_t * p = &DMemory4Bit->get_data()[line_size * y0];
+        for (int16_t y = y0; y <= y1; y++, p += line_size)
+        {
+            if (x0 & 1) p[x0 >> 1] = (p[x0 >> 1] & pixelMaskGLUT[1]) | color;
+            if (last > first) memset(&p[first], value, last - first);
+            if (!(x1 & 1)) p[x1 >> 1] = (p[x1 >> 1] & pixelMaskGLUT[0]) | (color << 4);
+        }
+    }
 }
 
 void Graphics::writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+    withModeAndRotation([&](auto m, auto r) {
+        writeLineTo<decltype(m)::value, decltype(r)::value>(x0, y0, x1, y1, color);
+    });
+}
+
+template <DisplayMode M, uint8_t R>
+void Graphics::writeLineTo(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
 {
     int16_t steep = abs(y1 - y0) > abs(x1 - x0);
     if (steep)
@@ -116,9 +248,9 @@ void Graphics::writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_
     for (; x0 <= x1; x0++)
     {
         if (steep)
-            writePixel(y0, x0, color);
+            writePixelTo<M, R>(y0, x0, color);
         else
-            writePixel(x0, y0, color);
+            writePixelTo<M, R>(x0, y0, color);
         err -= dy;
         if (err < 0)
         {
@@ -128,6 +260,129 @@ void Graphics::writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_
     }
 }
 
+// The Adafruit_GFX circles and bitmaps, with the pixel writer resolved once
+// per shape instead of once per pixel.
+
+void Graphics::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+{
+    withModeAndRotation([&](auto m, auto rot) {
+        constexpr DisplayMode M = decltype(m)::value;
+        constexpr uint8_t     R = decltype(rot)::value;
+        writePixelTo<M, R>(x0, y0 + r, color);
+        writePixelTo<M, R>(x0, y0 - r, color);
+        writePixelTo<M, R>(x0 + r, y0, color);
+        writePixelTo<M, R>(x0 - r, y0, color);
+        drawCircleTo<M, R>(x0, y0, r, 0xF, color);
+    });
+}
+
+void Graphics::drawCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t cornername, uint16_t color)
+{
+    withModeAndRotation([&](auto m, auto rot) {
+        drawCircleTo<decltype(m)::value, decltype(rot)::value>(x0, y0, r, cornername, color);
+    });
+}
+
+template <DisplayMode M, uint8_t R>
+void Graphics::drawCircleTo(int16_t x0, int16_t y0, int16_t r, uint8_t corners, uint16_t color)
+{
+    int16_t f = 1 - r;
+    int16_t ddF_x = 1;
+    int16_t ddF_y = -2 * r;
+    int16_t x = 0;
+    int16_t y = r;
+
+    while (x < y)
+    {
+        if (f >= 0)
+        {
+            y--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        x++;
+        ddF_x += 2;
+        f += ddF_x;
+
+        if (corners & 0x4)
+        {
+            writePixelTo<M, R>(x0 + x, y0 + y, color);
+            writePixelTo<M, R>(x0 + y, y0 + x, color);
+        }
+        if (corners & 0x2)
+        {
+            writePixelTo<M, R>(x0 + x, y0 - y, color);
+            writePixelTo<M, R>(x0 + y, y0 - x, color);
+        }
+        if (corners & 0x8)
+        {
+            writePixelTo<M, R>(x0 - y, y0 + x, color);
+            writePixelTo<M, R>(x0 - x, y0 + y, color);
+        }
+        if (corners & 0x1)
+        {
+            writePixelTo<M, R>(x0 - y, y0 - x, color);
+            writePixelTo<M, R>(x0 - x, y0 - y, color);
+        }
+    }
+}
+
+void Graphics::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color)
+{
+    withModeAndRotation([&](auto m, auto r) {
+        drawBitmapTo<decltype(m)::value, decltype(r)::value>(x, y, bitmap, w, h, color, color, false, false);
+    });
+}
+
+void Graphics::drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color,
+                          uint16_t bg)
+{
+    withModeAndRotation([&](auto m, auto r) {
+        drawBitmapTo<decltype(m)::value, decltype(r)::value>(x, y, bitmap, w, h, color, bg, true, false);
+    });
+}
+
+void Graphics::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color)
+{
+    drawBitmap(x, y, (const uint8_t *) bitmap, w, h, color);
+}
+
+void Graphics::drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg)
+{
+    drawBitmap(x, y, (const uint8_t *) bitmap, w, h, color, bg);
+}
+
+void Graphics::drawXBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color)
+{
+    withModeAndRotation([&](auto m, auto r) {
+        drawBitmapTo<decltype(m)::value, decltype(r)::value>(x, y, bitmap, w, h, color, color, false, true);
+    });
+}
+
+// 1 bit bitmap, rows padded to a whole byte. Unset bits are drawn with bg
+// when opaque, left untouched otherwise. XBM bitmaps (xbm) have their pixels
+// from the least significant bit of each byte.
+
+template <DisplayMode M, uint8_t R>
+void Graphics::drawBitmapTo(int16_t x, int16_t y, const uint8_t * bitmap, int16_t w, int16_t h,
+                            uint16_t color, uint16_t bg, bool opaque, bool xbm)
+{
+    int16_t byteWidth = (w + 7) / 8;
+
+    for (int16_t j = 0; j < h; j++, y++)
+    {
+        const uint8_t * row = &bitmap[j * byteWidth];
+        for (int16_t i = 0; i < w; i++)
+        {
+            uint8_t bit = xbm ? (row[i >> 3] >> (i & 7)) & 1 : (row[i >> 3] >> (7 - (i & 7))) & 1;
+            if (bit)
+                writePixelTo<M, R>(x + i, y, color);
+            else if (opaque)
+                writePixelTo<M, R>(x + i, y, bg);
+        }
+    }
+}
+
 void Graphics::endWrite()
 {
 }
@@ -138,8 +393,10 @@ void Graphics::selectDisplayMode(DisplayMode mode)
     {
         display_mode = mode;
 
-        if (display_mode == DisplayMode::INKPLATE_1BIT)
+        if (display_mode == DisplayMode::INKPLATE_1BIT) {
           _partial->clear();
+          markAllDirty();
+        }
         else
           DMemory4Bit->clear();
     }
@@ -147,8 +404,10 @@ void Graphics::selectDisplayMode(DisplayMode mode)
 
 void Graphics::clearDisplay()
 {
-  if (display_mode == DisplayMode::INKPLATE_1BIT)
+  if (display_mode == DisplayMode::INKPLATE_1BIT) {
     _partial->clear();
+    markAllDirty();
+  }
   else
     DMemory4Bit->clear();
 }
@@ -158,6 +417,7 @@ void Graphics::display()
   if (display_mode == DisplayMode::INKPLATE_1BIT) {
     ESP_LOGD(TAG, "Update 1Bit frame buffer");
     e_ink.update(*_partial);
+    clearDirty();
   }
   else {
     ESP_LOGD(TAG, "Update 3Bit frame buffer");
@@ -169,14 +429,74 @@ void Graphics::preloadScreen()
 {
   if (display_mode == DisplayMode::INKPLATE_1BIT) {
     e_ink.preload_screen(*_partial);
+    clearDirty();
   }
 }
 
+// Only the area written since the last update is compared with the
+// displayed image. If nothing was drawn, the driver has nothing to send.
+
 void Graphics::partialUpdate(bool _forced)
 {
   if (display_mode == DisplayMode::INKPLATE_1BIT) {
-    e_ink.partial_update(*_partial, _forced);
+    e_ink.partial_update(*_partial, dirty_x0, dirty_y0, 
+                         dirty_x1 - dirty_x0 + 1, dirty_y1 - dirty_y0 + 1, _forced);
+    clearDirty();
+  }
+}
+
+// Partial update limited to a rectangle expressed in the current rotation
+// coordinates. The rectangle is mapped to panel coordinates the same way
+// writePixel() does. Not available in 3 bit mode.
+
+void Graphics::partialUpdate(int16_t x, int16_t y, int16_t w, int16_t h, bool _forced)
+{
+  if (display_mode != DisplayMode::INKPLATE_1BIT) {
+    ESP_LOGW(TAG, "Partial update not available in 3 bit mode.");
+    return;
+  }
+
+  int16_t x0, y0, x1, y1;
+
+  if (toPanelRect(x, y, w, h, x0, y0, x1, y1)) {
+    e_ink.partial_update(*_partial, x0, y0, x1 - x0 + 1, y1 - y0 + 1, _forced);
+  }
+}
+
+bool Graphics::setGlyphCache(uint32_t maxBytes)
+{
+  delete glyphCache;
+  glyphCache = nullptr;
+
+  if (maxBytes == 0) return true;
+
+  glyphCache = new GlyphCache(maxBytes);
+  if ((glyphCache == nullptr) || !glyphCache->is_ready()) {
+    ESP_LOGE(TAG, "Unable to allocate the glyph cache.");
+    delete glyphCache;
+    glyphCache = nullptr;
+    return false;
   }
+  return true;
+}
+
+GlyphCache::Stats Graphics::getGlyphCacheStats()
+{
+  GlyphCache::Stats stats = {};
+
+  if (glyphCache != nullptr) stats = glyphCache->get_stats();
+  return stats;
+}
+
+void Graphics::clearGlyphCache()
+{
+  if (glyphCache != nullptr) glyphCache->clear();
+}
+
+void Graphics::markAllDirty()
+{
+  dirty_x0 = 0; dirty_x1 = e_ink.get_width()  - 1;
+  dirty_y0 = 0; dirty_y1 = e_ink.get_height() - 1;
 }
 
 int16_t Graphics::width()
@@ -189,33 +509,40 @@ int16_t Graphics::height()
     return _height;
 };
 
-void Graphics::writePixel(int16_t x0, int16_t y0, uint16_t color)
+// Pixel writer for a given display mode and rotation. The mode and rotation
+// being template parameters, each variant is free of branches other than
+// the bounds check. The loops drawing many pixels are specialized the same
+// way and write the frame buffer directly.
+
+template <DisplayMode M, uint8_t R>
+void Graphics::writePixelTo(int16_t x0, int16_t y0, uint16_t color)
 {
-    if (x0 > width() - 1 || y0 > height() - 1 || x0 < 0 || y0 < 0)
+    if (x0 > _width - 1 || y0 > _height - 1 || x0 < 0 || y0 < 0)
         return;
 
-    switch (rotation)
+    if (R == 1)
     {
-    case 1:
         std::swap(x0, y0);
-        x0 = height() - x0 - 1;
-        break;
-    case 2:
-        x0 = width() - x0 - 1;
-        y0 = height() - y0 - 1;
-        break;
-    case 3:
+        x0 = _height - x0 - 1;
+    }
+    else if (R == 2)
+    {
+        x0 = _width - x0 - 1;
+        y0 = _height - y0 - 1;
+    }
+    else if (R == 3)
+    {
         std::swap(x0, y0);
-        y0 = width() - y0 - 1;
-        break;
+        y0 = _width - y0 - 1;
     }
 
-    if (getDisplayMode() == DisplayMode::INKPLATE_1BIT)
+    if (M == DisplayMode::INKPLATE_1BIT)
     {
         int x = x0 >> 3;
         int x_sub = x0 & 7;
         uint8_t * p = &_partial->get_data()[_partial->get_line_size() * y0 + x];
         *p = (~pixelMaskLUT[x_sub] & *p) | (color ? pixelMaskLUT[x_sub] : 0);
+        markDirty(x0, y0);
     }
     else
     {
@@ -226,3 +553,316 @@ void Graphics::writePixel(int16_t x0, int16_t y0, uint16_t color)
         *p = (pixelMaskGLUT[x_sub] & *p) | (x_sub ? color : color << 4);
     }
 }
+
+void Graphics::writePixel(int16_t x0, int16_t y0, uint16_t color)
+{
+    withModeAndRotation([&](auto m, auto r) {
+        writePixelTo<decltype(m)::value, decltype(r)::value>(x0, y0, color);
+    });
+}
+
+// Writes a block of pixel values (0/1 in 1 bit mode, 0..7 in 3 bit mode), w
+// by h, row-major, clipped to the screen. The frame buffer address is
+// computed once per block row and stepped along it. When the block rows are
+// panel rows (rotation 0 or 2), aligned pixels are packed and written a
+// whole byte at a time.
+
+void Graphics::writeBlock(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t * levels)
+{
+    withModeAndRotation([&](auto m, auto r) {
+        writeBlockTo<decltype(m)::value, decltype(r)::value>(x, y, w, h, levels);
+    });
+}
+
+template <DisplayMode M, uint8_t R>
+void Graphics::writeBlockTo(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t * levels)
+{
+    int16_t xs = std::max<int16_t>(0, -x), xe = std::min<int16_t>(w, _width  - x);
+    int16_t ys = std::max<int16_t>(0, -y), ye = std::min<int16_t>(h, _height - y);
+
+    if ((xs >= xe) || (ys >= ye))
+        return;
+
+    PanelSteps steps;
+    panelSteps(x, y, steps);
+
+    constexpr int16_t dxc = RotationSteps<R>::dxc, dyc = RotationSteps<R>::dyc;
+    constexpr int16_t dxr = RotationSteps<R>::dxr, dyr = RotationSteps<R>::dyr;
+
+    if constexpr (M == DisplayMode::INKPLATE_1BIT)
+    {
+        uint8_t * data      = _partial->get_data();
+        int16_t   line_size = _partial->get_line_size();
+
+        for (int16_t yy = ys; yy < ye; yy++)
+        {
+            const uint8_t * src = &levels[yy * w + xs];
+            int16_t         X   = steps.px + yy * dxr + xs * dxc;
+            int16_t         Y   = steps.py + yy * dyr + xs * dyc;
+            int16_t         n   = xe - xs;
+
+            if constexpr (dyc == 0)
+            {
+                uint8_t * line = &data[(int32_t) Y * line_size];
+
+                // Rotation 0: bit k of a byte is the k-th pixel; rotation 2: the (7 - k)-th
+
+                constexpr int16_t aligned = (dxc > 0) ? 0 : 7;
+                for (; (n > 0) && ((X & 7) != aligned); n--, X += dxc, src++)
+                {
+                    uint8_t mask = 1 << (X & 7);
+                    line[X >> 3] = *src ? (line[X >> 3] | mask) : (line[X >> 3] & ~mask);
+                }
+                for (; n >= 8; n -= 8, X += 8 * dxc, src += 8)
+                {
+                    uint8_t b = 0;
+                    if constexpr (dxc > 0)
+                        for (int k = 0; k < 8; k++) b |= (src[k] & 1) << k;
+                    else
+                        for (int k = 0; k < 8; k++) b |= (src[k] & 1) << (7 - k);
+                    line[X >> 3] = b;
+                }
+                for (; n > 0; n--, X += dxc, src++)
+                {
+                    uint8_t mask = 1 << (X & 7);
+                    line[X >> 3] = *src ? (line[X >> 3] | mask) : (line[X >> 3] & ~mask);
+                }
+            }
+            else
+            {
+                uint8_t   mask = 1 << (X & 7);
+                uint8_t * p    = &data[(int32_t) Y * line_size + (X >> 3)];
+                int32_t   step = dyc * line_size;
+
+                for (; n > 0; n--, p += step)
+                    *p = *src++ ? (*p | mask) : (*p & ~mask);
+            }
+        }
+
+        markDirty(steps.px + ys * dxr + xs * dxc, steps.py + ys * dyr + xs * dyc);
+        markDirty(steps.px + (ye - 1) * dxr + (xe - 1) * dxc, steps.py + (ye - 1) * dyr + (xe - 1) * dyc);
+    }
+    else
+    {
+        uint8_t * data      = DMemory4Bit->get_data();
+        int16_t   line_size = DMemory4Bit->get_line_size();
+
+        for (int16_t yy = ys; yy < ye; yy++)
+        {
+            const uint8_t * src = &levels[yy * w + xs];
+            int16_t         X   = steps.px + yy * dxr + xs * dxc;
+            int16_t         Y   = steps.py + yy * dyr + xs * dyc;
+            int16_t         n   = xe - xs;
+
+            if constexpr (dyc == 0)
+            {
+                uint8_t * line = &data[(int32_t) Y * line_size];
+
+                // Even panel X: high nibble
+
+                constexpr int16_t aligned = (dxc > 0) ? 0 : 1;
+                if ((n > 0) && ((X & 1) != aligned))
+                {
+                    uint8_t & b = line[X >> 1];
+                    b = (X & 1) ? ((b & 0xF0) | (*src & 7)) : ((b & 0x0F) | ((*src & 7) << 4));
+                    n--; X += dxc; src++;
+                }
+                for (; n >= 2; n -= 2, X += 2 * dxc, src += 2)
+                {
+                    line[X >> 1] = (dxc > 0) ? (((src[0] & 7) << 4) | (src[1] & 7))
+                                             : (((src[1] & 7) << 4) | (src[0] & 7));
+                }
+                if (n > 0)
+                {
+                    uint8_t & b = line[X >> 1];
+                    b = (X & 1) ? ((b & 0xF0) | (*src & 7)) : ((b & 0x0F) | ((*src & 7) << 4));
+                }
+            }
+            else
+            {
+                uint8_t * p     = &data[(int32_t) Y * line_size + (X >> 1)];
+                int32_t   step  = dyc * line_size;
+                uint8_t   keep  = pixelMaskGLUT[X & 1];
+                uint8_t   shift = (X & 1) ? 0 : 4;
+
+                for (; n > 0; n--, p += step)
+                    *p = (*p & keep) | ((*src++ & 7) << shift);
+            }
+        }
+    }
+}
+
+// Writes a row of w packed samples (1, 2 or 4 bits each, the first one in the
+// most significant bits, as in PNG scanlines), lut giving the pixel value of
+// each sample value. In rotation 0, the frame buffer bits for all the samples
+// of a source byte come from a 256 entries table, built again only when the
+// depth, lut or display mode change. The samples not filling a source byte,
+// and the other rotations, go through writeBlock().
+
+void Graphics::writePackedRow(int16_t x, int16_t y, int16_t w, const uint8_t * row, uint8_t depth, const uint8_t * lut)
+{
+    int16_t xs = std::max<int16_t>(0, -x), xe = std::min<int16_t>(w, _width - x);
+
+    if ((y < 0) || (y >= _height) || (xs >= xe))
+        return;
+
+    uint8_t perByte = 8 / depth;
+    uint8_t mask    = (1 << depth) - 1;
+
+    auto unpack = [&](int16_t from, int16_t to)
+    {
+        uint8_t levels[64];
+        while (from < to)
+        {
+            int16_t n = std::min<int16_t>(to - from, sizeof(levels));
+            for (int16_t i = 0; i < n; i++)
+            {
+                int32_t bit = (int32_t)(from + i) * depth;
+                levels[i]   = lut[(row[bit >> 3] >> (8 - depth - (bit & 7))) & mask];
+            }
+            writeBlock(x + from, y, n, 1, levels);
+            from += n;
+        }
+    };
+
+    PanelSteps steps;
+    panelSteps(x, y, steps);
+
+    int16_t bs = (xs + perByte - 1) / perByte * perByte; // Whole source bytes: samples bs .. be - 1
+    int16_t be = xe / perByte * perByte;
+
+    if ((steps.dxc != 1) || (steps.dyc != 0) || (bs >= be))
+    {
+        unpack(xs, xe);
+        return;
+    }
+    unpack(xs, bs);
+    unpack(be, xe);
+
+    if ((depth != packedDepth) || (display_mode != packedMode) || (memcmp(lut, packedLut, mask + 1) != 0))
+    {
+        // 1 bit mode: k-th sample in bit k; 3 bit mode: first sample in the most significant nibble
+
+        for (int b = 0; b < 256; b++)
+        {
+            uint32_t t = 0;
+            for (int k = 0; k < perByte; k++)
+            {
+                uint8_t v = lut[(b >> (8 - depth * (k + 1))) & mask];
+                t = (display_mode == DisplayMode::INKPLATE_1BIT) ? (t | ((uint32_t)(v & 1) << k)) : ((t << 4) | (v & 7));
+            }
+            packedTable[b] = t;
+        }
+        memcpy(packedLut, lut, mask + 1);
+        packedDepth = depth;
+        packedMode  = display_mode;
+    }
+
+    const uint8_t * src = &row[bs / perByte];
+    int16_t         X   = steps.px + bs;
+    int16_t         n   = (be - bs) / perByte;
+
+    if (display_mode == DisplayMode::INKPLATE_1BIT)
+    {
+        uint8_t * line = &_partial->get_data()[(int32_t) steps.py * _partial->get_line_size()];
+
+        for (; n > 0; n--, X += perByte)
+        {
+            uint8_t * p     = &line[X >> 3];
+            uint8_t   shift = X & 7;
+            uint16_t  m     = ((1 << perByte) - 1) << shift;
+            uint16_t  v     = packedTable[*src++] << shift;
+
+            p[0] = (p[0] & ~m) | v;
+            if (shift + perByte > 8)
+                p[1] = (p[1] & ~(m >> 8)) | (v >> 8);
+        }
+
+        markDirty(steps.px + bs, steps.py);
+        markDirty(steps.px + be - 1, steps.py);
+    }
+    else
+    {
+        uint8_t * line  = &DMemory4Bit->get_data()[(int32_t) steps.py * DMemory4Bit->get_line_size()];
+        uint8_t   bytes = perByte / 2;
+
+        if ((X & 1) == 0)
+        {
+            for (uint8_t * p = &line[X >> 1]; n > 0; n--)
+            {
+                uint32_t t = packedTable[*src++];
+                for (int k = bytes - 1; k >= 0; k--)
+                    *p++ = t >> (8 * k);
+            }
+        }
+        else
+        {
+            // Odd panel X: the samples straddle bytes + 1 frame buffer bytes,
+            // keeping the high nibble of the first one and the low nibble of
+            // the last one
+
+            for (uint8_t * p = &line[X >> 1]; n > 0; n--, p += bytes)
+            {
+                uint64_t t = (uint64_t) packedTable[*src++] << 4;
+                p[0]       = (p[0] & 0xF0) | (t >> (8 * bytes));
+                for (int k = 1; k < bytes; k++)
+                    p[k] = t >> (8 * (bytes - k));
+                p[bytes] = (p[bytes] & 0x0F) | (t & 0xF0);
+            }
+        }
+    }
+}
+
+uint8_t * Graphics::rawFrameBuffer(uint8_t bits, uint16_t w, uint16_t h)
+{
+    bool          oneBit = display_mode == DisplayMode::INKPLATE_1BIT;
+    FrameBuffer * fb     = oneBit ? (FrameBuffer *) _partial : (FrameBuffer *) DMemory4Bit;
+
+    if ((bits != (oneBit ? 1 : 3)) || (fb->get_width() != w) || (fb->get_height() != h) ||
+        (RawImageHeader::data_size(w, h, bits) != fb->get_data_size()))
+    {
+        ESP_LOGE(TAG, "Raw picture %dx%d, %d bits, doesn't fit the frame buffer.", w, h, bits);
+        return nullptr;
+    }
+
+    if (oneBit)
+        markAllDirty();
+    return fb->get_data();
+}
+
+// The frame buffer of the current display mode, as a raw picture
+
+bool Graphics::rawHeader(RawImageHeader &header, FrameBuffer *&fb)
+{
+    bool oneBit = display_mode == DisplayMode::INKPLATE_1BIT;
+
+    fb     = oneBit ? (FrameBuffer *) _partial : (FrameBuffer *) DMemory4Bit;
+    header = { (uint16_t) fb->get_width(), (uint16_t) fb->get_height(), (uint8_t) (oneBit ? 1 : 3), RawImageHeader::RLE, 0 };
+    return RawImageHeader::data_size(header.width, header.height, header.bits) == fb->get_data_size();
+}
+
+bool Graphics::saveRawToFile(const char *fileName)
+{
+    FILE *dat = fopen(fileName, "w");
+    if (dat)
+        return saveRawToFile(dat);
+    return 0;
+}
+
+bool Graphics::saveRawToFile(FILE *p)
+{
+    RawImageHeader header;
+    FrameBuffer *fb;
+
+    bool ret = rawHeader(header, fb) && raw_save(p, header, fb->get_data());
+
+    return (fclose(p) == 0) && ret;
+}
+
+int32_t Graphics::saveRawToBuffer(uint8_t *buf, int32_t size)
+{
+    RawImageHeader header;
+    FrameBuffer *fb;
+
+    return rawHeader(header, fb) ? raw_save(buf, size, header, fb->get_data()) : 0;
+}
@@ -20,6 +20,9 @@ Distributed as-is; no warranty is given.
 #include "image.hpp"
 #include "shapes.hpp"
 #include "frame_buffer.hpp"
+#include "glyph_cache.hpp"
+
+#include <type_traits>
 
 #ifndef pgm_read_byte
 #define pgm_read_byte(addr) (*(const unsigned char *)(addr))
@@ -42,7 +45,45 @@ class Graphics : public Shapes, public Image
   private:
     static constexpr char const * TAG = "Graphics";
 
-    DisplayMode display_mode;  
+    DisplayMode display_mode{DisplayMode::INKPLATE_1BIT};
+
+    // The drawing loops are compiled for each display mode (M) and rotation
+    // (R). withMode(), withRotation() and withModeAndRotation() call f with
+    // the current ones, as std::integral_constant values, once per primitive:
+    // the loops in f are then free of mode and rotation tests.
+
+    typedef std::integral_constant<DisplayMode, DisplayMode::INKPLATE_1BIT> OneBitMode;
+    typedef std::integral_constant<DisplayMode, DisplayMode::INKPLATE_3BIT> ThreeBitMode;
+    template <uint8_t R> using Rotation = std::integral_constant<uint8_t, R>;
+
+    template <typename F> inline void withMode(F f) {
+      if (display_mode == DisplayMode::INKPLATE_1BIT) f(OneBitMode());
+      else                                            f(ThreeBitMode());
+    }
+    template <typename F> inline void withRotation(F f) {
+      switch (rotation & 3) {
+        case 0:  f(Rotation<0>()); break;
+        case 1:  f(Rotation<1>()); break;
+        case 2:  f(Rotation<2>()); break;
+        default: f(Rotation<3>()); break;
+      }
+    }
+    template <typename F> inline void withModeAndRotation(F f) {
+      withMode([&](auto m) { withRotation([&](auto r) { f(m, r); }); });
+    }
+
+    // Panel steps for the next column (dxc, dyc) and row (dxr, dyr) of the
+    // current rotation coordinates
+
+    template <uint8_t R> struct RotationSteps {
+      static constexpr int16_t dxc = (R == 0) ? 1 : (R == 2) ? -1 : 0;
+      static constexpr int16_t dyc = (R == 1) ? 1 : (R == 3) ? -1 : 0;
+      static constexpr int16_t dxr = (R == 3) ? 1 : (R == 1) ? -1 : 0;
+      static constexpr int16_t dyr = (R == 0) ? 1 : (R == 2) ? -1 : 0;
+    };
+
+    template <DisplayMode M, uint8_t R>
+    void writePixelTo(int16_t x, int16_t y, uint16_t color);
 
   public:
 
@@ -59,6 +100,60 @@ class Graphics : public Shapes, public Image
     void               display();
     void         preloadScreen();
     void         partialUpdate(bool _forced = false);
+    void         partialUpdate(int16_t x, int16_t y, int16_t w, int16_t h, bool _forced = false);
+
+    void        fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void   drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void   drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void      fillScreen(uint16_t color) override;
+    void        drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, 
+                         uint8_t size_x, uint8_t size_y) override;
+    using Adafruit_GFX::drawChar;
+
+    void      drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) override;
+    void drawCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t cornername, uint16_t color) override;
+    void      drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color) override;
+    void      drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, 
+                         uint16_t bg) override;
+    void      drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color) override;
+    void      drawBitmap(int16_t x, int16_t y, uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, 
+                         uint16_t bg) override;
+    void     drawXBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color) override;
+
+    /**
+     * @brief Select an anti-aliased font
+     *
+     * In 3 bit mode, the glyph pixels are blended with the background
+     * according to their coverage. setFont() returns to 1 bit fonts.
+     */
+    void     setGrayFont(const GFXfontGray * f);
+
+    /**
+     * @brief Enable the pre-rasterized glyph cache
+     *
+     * Custom font glyphs are rasterized on first use in PSRAM, per
+     * rotation and text size, and drawn from there afterward.
+     *
+     * @param maxBytes PSRAM size limit of the cache. 0 disables the cache.
+     * @return false if the cache could not be allocated.
+     */
+    bool                 setGlyphCache(uint32_t maxBytes);
+    GlyphCache::Stats getGlyphCacheStats();
+    void               clearGlyphCache();
+
+    /**
+     * @brief Save the frame buffer of the current display mode
+     *
+     * It is saved as an RLE compressed raw picture, to be loaded back with
+     * drawRawFromFile() or drawRawFromBuffer(), e.g. after a deep sleep
+     * along with EInk::save_state(). The file is closed.
+     *
+     * @return saveRawToBuffer(): the size of the picture, 0 if it doesn't
+     *         fit in size bytes.
+     */
+    bool      saveRawToFile(const char *fileName);
+    bool      saveRawToFile(FILE *p);
+    int32_t saveRawToBuffer(uint8_t *buf, int32_t size);
 
     int16_t  width() override;
     int16_t height() override;
@@ -73,6 +168,68 @@ class Graphics : public Shapes, public Image
                                    0x3F, 0x3C, 0x33, 0x30, 0xF,  0xC,  0x3,  0x0};
 
   private:
+    // Bounding box, in panel coordinates, of the 1 bit frame buffer pixels
+    // written since the last update. Empty when dirty_x1 < dirty_x0.
+
+    int16_t dirty_x0, dirty_y0, dirty_x1, dirty_y1;
+
+    inline void markDirty(int16_t x, int16_t y) {
+      if (x < dirty_x0) dirty_x0 = x;
+      if (x > dirty_x1) dirty_x1 = x;
+      if (y < dirty_y0) dirty_y0 = y;
+      if (y > dirty_y1) dirty_y1 = y;
+    }
+    void markAllDirty();
+    inline void clearDirty() {
+      dirty_x0 = INT16_MAX; dirty_x1 = -1;
+      dirty_y0 = INT16_MAX; dirty_y1 = -1;
+    }
+
+    bool   toPanelRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                       int16_t & x0, int16_t & y0, int16_t & x1, int16_t & y1);
+    void fillPanelRect(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+    void     blitGlyph(int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t * bitmap, uint16_t color);
+    void blitCachedGlyph(int16_t x, int16_t y, const GlyphCache::Glyph * glyph, uint16_t color);
+    void   blitGrayGlyph(int16_t x, int16_t y, const GFXglyph * glyph, uint16_t color, 
+                         uint8_t size_x, uint8_t size_y);
+
+    template <DisplayMode M>
+    void fillPanelRectTo(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+    template <DisplayMode M, uint8_t R>
+    void     writeLineTo(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+    template <DisplayMode M, uint8_t R>
+    void    drawCircleTo(int16_t x0, int16_t y0, int16_t r, uint8_t corners, uint16_t color);
+    template <DisplayMode M, uint8_t R>
+    void    drawBitmapTo(int16_t x, int16_t y, const uint8_t * bitmap, int16_t w, int16_t h,
+                         uint16_t color, uint16_t bg, bool opaque, bool xbm);
+    template <DisplayMode M, uint8_t R>
+    void    writeBlockTo(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t * levels);
+    template <DisplayMode M, uint8_t R>
+    void     blitGlyphTo(int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t * bitmap, uint16_t color);
+    template <DisplayMode M>
+    void blitCachedGlyphTo(int16_t x0, int16_t y0, int16_t xs, int16_t xe, int16_t ys, int16_t ye,
+                           const GlyphCache::Glyph * glyph, uint16_t color);
+    template <uint8_t R>
+    void blitGrayGlyphTo(int16_t x, int16_t y, int16_t xs, int16_t xe, int16_t ys, int16_t ye,
+                         const GFXglyph * glyph, uint8_t size_x, uint8_t size_y);
+
+    struct PanelSteps { int16_t px, py, dxc, dyc, dxr, dyr; };
+    void      panelSteps(int16_t x, int16_t y, PanelSteps & steps);
+
+    const GFXfontGray * grayFont{nullptr};
+    uint8_t             grayBlend[8][8];
+    uint16_t            grayBlendColor{0xFFFF};
+    uint8_t             grayBlendBpp{0};
+
+    GlyphCache * glyphCache{nullptr};
+
+    // Frame buffer bits of each source byte, for writePackedRow()
+
+    uint32_t            packedTable[256];
+    uint8_t             packedLut[16];
+    uint8_t             packedDepth{0};
+    DisplayMode         packedMode{DisplayMode::INKPLATE_1BIT};
+
     void     startWrite(void) override;
     void     writePixel(int16_t  x, int16_t  y, uint16_t color) override;
     void  writeFillRect(int16_t  x, int16_t  y, int16_t  w,  int16_t  h, uint16_t color) override;
@@ -80,6 +237,10 @@ class Graphics : public Shapes, public Image
     void writeFastHLine(int16_t  x, int16_t  y, int16_t  w,  uint16_t color) override;
     void      writeLine(int16_t x0, int16_t y0, int16_t  x1, int16_t  y1, uint16_t color) override;
     void       endWrite(void) override;
+    void     writeBlock(int16_t  x, int16_t  y, int16_t  w,  int16_t  h, const uint8_t * levels) override;
+    void writePackedRow(int16_t  x, int16_t  y, int16_t  w, const uint8_t * row, uint8_t depth, const uint8_t * lut) override;
+    uint8_t * rawFrameBuffer(uint8_t bits, uint16_t w, uint16_t h) override;
+    bool           rawHeader(struct RawImageHeader &header, FrameBuffer *&fb);
 };
 
 #endif
\ No newline at end of file
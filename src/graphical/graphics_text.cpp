@@ -0,0 +1,429 @@
+/*
+graphics_text.cpp
+Inkplate 6 Arduino library
+David Zovko, Borna Biro, Denis Vajak, Zvonimir Haramustek @ e-radionica.com
+September 24, 2020
+https://github.com/e-radionicacom/Inkplate-6-Arduino-library
+
+For support, please reach over forums: forum.e-radionica.com/en
+For more info about the product, please check: www.inkplate.io
+
+This code is released under the GNU Lesser General Public License v3.0: https://www.gnu.org/licenses/lgpl-3.0.en.html
+Please review the LICENSE file included with this example.
+If you have any questions about licensing, please contact techsupport@e-radionica.com
+Distributed as-is; no warranty is given.
+*/
+
+#include "graphics.hpp"
+
+#include <algorithm>
+
+// Glyph rows are handled as 64 bits values, leftmost pixel in the most
+// significant bit. Wider glyphs are drawn by Adafruit_GFX.
+
+static const uint8_t MAX_BLIT_WIDTH = 56;
+
+// Returns the w bits of a glyph row starting at bit position 'bit' of the
+// packed font bitmap.
+
+static inline uint64_t glyphRow(const uint8_t * bitmap, uint32_t bit, uint8_t w)
+{
+    const uint8_t * p = &bitmap[bit >> 3];
+    int             n = ((bit & 7) + w + 7) >> 3;
+    uint64_t        v = 0;
+
+    for (int i = 0; i < n; i++)
+        v |= (uint64_t) p[i] << (56 - (i << 3));
+
+    return (v << (bit & 7)) & (~0ULL << (64 - w));
+}
+
+static inline uint64_t reverse64(uint64_t v)
+{
+    v = ((v >> 1) & 0x5555555555555555ULL) | ((v & 0x5555555555555555ULL) << 1);
+    v = ((v >> 2) & 0x3333333333333333ULL) | ((v & 0x3333333333333333ULL) << 2);
+    v = ((v >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((v & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return __builtin_bswap64(v);
+}
+
+void Graphics::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg,
+                        uint8_t size_x, uint8_t size_y)
+{
+    if ((grayFont != nullptr) && (gfxFont == &grayFont->font))
+    {
+        const GFXglyph * glyph = &gfxFont->glyph[(uint8_t)(c - gfxFont->first)];
+        if ((glyph->width > 0) && (glyph->height > 0))
+            blitGrayGlyph(x + glyph->xOffset * size_x, y + glyph->yOffset * size_y, glyph, color, size_x, size_y);
+        return;
+    }
+
+    if ((gfxFont != nullptr) && (glyphCache != nullptr))
+    {
+        const GFXglyph * glyph = &gfxFont->glyph[(uint8_t)(c - gfxFont->first)];
+        if ((glyph->width == 0) || (glyph->height == 0))
+            return;
+
+        const GlyphCache::Glyph * cached = glyphCache->get(gfxFont, c, rotation, size_x, size_y);
+        if (cached != nullptr)
+        {
+            blitCachedGlyph(x, y, cached, color);
+            return;
+        }
+    }
+
+    if ((gfxFont == nullptr) || (size_x != 1) || (size_y != 1))
+    {
+        Adafruit_GFX::drawChar(x, y, c, color, bg, size_x, size_y);
+        return;
+    }
+
+    const GFXglyph * glyph = &gfxFont->glyph[(uint8_t)(c - gfxFont->first)];
+
+    if (glyph->width > MAX_BLIT_WIDTH)
+    {
+        Adafruit_GFX::drawChar(x, y, c, color, bg, size_x, size_y);
+        return;
+    }
+
+    if ((glyph->width > 0) && (glyph->height > 0))
+        blitGlyph(x + glyph->xOffset, y + glyph->yOffset, glyph->width, glyph->height,
+                  &gfxFont->bitmap[glyph->bitmapOffset], color);
+}
+
+// Panel coordinates of the point [x, y] (current rotation coordinates), and
+// panel steps for the next glyph column (dxc, dyc) and row (dxr, dyr).
+
+void Graphics::panelSteps(int16_t x, int16_t y, PanelSteps & steps)
+{
+    switch (rotation)
+    {
+    case 1:
+        steps = { (int16_t)(_height - 1 - y), x, 0, 1, -1, 0 };
+        break;
+    case 2:
+        steps = { (int16_t)(_width - 1 - x), (int16_t)(_height - 1 - y), -1, 0, 0, -1 };
+        break;
+    case 3:
+        steps = { y, (int16_t)(_width - 1 - x), 0, -1, 1, 0 };
+        break;
+    default:
+        steps = { x, y, 1, 0, 0, 1 };
+        break;
+    }
+}
+
+// Draws the set pixels of a packed glyph bitmap with its upper left corner at
+// [x, y] (current rotation coordinates), clipped to the screen. In 1 bit mode
+// with rotation 0 or 2, each glyph row is shifted into place and ORed (or
+// cleared) a byte at a time in the frame buffer line. Otherwise, the set
+// pixels are located with their panel address computed incrementally, without
+// going through writePixel().
+
+void Graphics::blitGlyph(int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t * bitmap, uint16_t color)
+{
+    withModeAndRotation([&](auto m, auto r) {
+        blitGlyphTo<decltype(m)::value, decltype(r)::value>(x, y, w, h, bitmap, color);
+    });
+}
+
+template <DisplayMode M, uint8_t R>
+void Graphics::blitGlyphTo(int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t * bitmap, uint16_t color)
+{
+    int16_t xs = std::max<int16_t>(0, -x), xe = std::min<int16_t>(w, _width  - x);
+    int16_t ys = std::max<int16_t>(0, -y), ye = std::min<int16_t>(h, _height - y);
+
+    if ((xs >= xe) || (ys >= ye))
+        return;
+
+    uint64_t clip = (~0ULL << (64 - (xe - xs))) >> xs;
+    uint32_t bit  = (uint32_t) ys * w;
+
+    PanelSteps steps;
+    panelSteps(x, y, steps);
+
+    int16_t px  = steps.px,  py  = steps.py;
+
+    constexpr int16_t dxc = RotationSteps<R>::dxc, dyc = RotationSteps<R>::dyc;
+    constexpr int16_t dxr = RotationSteps<R>::dxr, dyr = RotationSteps<R>::dyr;
+
+    if constexpr (M == DisplayMode::INKPLATE_1BIT)
+    {
+        uint8_t * data      = _partial->get_data();
+        int16_t   line_size = _partial->get_line_size();
+
+        if constexpr ((R & 1) == 0)
+        {
+            // Panel X of the first visible column and of the byte it belongs to
+
+            int16_t first = (R == 0) ? (px + xs) : (px - (xe - 1));
+            int16_t base  = first & ~7;
+
+            for (int16_t yy = ys; yy < ye; yy++, bit += w)
+            {
+                uint64_t row = glyphRow(bitmap, bit, w) & clip;
+                if (row == 0)
+                    continue;
+
+                // Glyph column i at bit (X - base) of the line, LSB first
+
+                uint64_t v;
+                if constexpr (R == 0)
+                {
+                    int16_t shift = px - base;
+                    v = reverse64(row);
+                    v = (shift >= 0) ? (v << shift) : (v >> -shift);
+                }
+                else
+                {
+                    v = row >> (63 - (px - base));
+                }
+
+                uint8_t * p = &data[(int32_t)(py + yy * dyr) * line_size + (base >> 3)];
+                if (color)
+                {
+                    for (; v; v >>= 8) *p++ |= v;
+                }
+                else
+                {
+                    for (; v; v >>= 8) *p++ &= ~v;
+                }
+            }
+        }
+        else
+        {
+            for (int16_t yy = ys; yy < ye; yy++, bit += w)
+            {
+                uint64_t row = glyphRow(bitmap, bit, w) & clip;
+                int16_t  X   = px + yy * dxr;
+                uint8_t  m   = pixelMaskLUT[X & 7];
+                uint8_t *p   = &data[(int32_t) py * line_size + (X >> 3)];
+                int32_t  dp  = (int32_t) dyc * line_size;
+
+                for (; row; row &= row - 1)
+                {
+                    int i = 63 - __builtin_ctzll(row);
+                    uint8_t * q = p + i * dp;
+                    *q = color ? (*q | m) : (*q & ~m);
+                }
+            }
+        }
+
+        markDirty(px + xs * dxc + ys * dxr, py + xs * dyc + ys * dyr);
+        markDirty(px + (xe - 1) * dxc + (ye - 1) * dxr, py + (xe - 1) * dyc + (ye - 1) * dyr);
+    }
+    else
+    {
+        uint8_t * data      = DMemory4Bit->get_data();
+        int16_t   line_size = DMemory4Bit->get_line_size();
+
+        color &= 7;
+
+        for (int16_t yy = ys; yy < ye; yy++, bit += w)
+        {
+            uint64_t row = glyphRow(bitmap, bit, w) & clip;
+            int16_t  X0  = px + yy * dxr;
+            int16_t  Y0  = py + yy * dyr;
+
+            for (; row; row &= row - 1)
+            {
+                int       i = 63 - __builtin_ctzll(row);
+                int16_t   X = X0 + i * dxc;
+                uint8_t * p = &data[(int32_t)(Y0 + i * dyc) * line_size + (X >> 1)];
+                *p = (pixelMaskGLUT[X & 1] & *p) | ((X & 1) ? color : color << 4);
+            }
+        }
+    }
+}
+
+// Draws a glyph rasterized by the glyph cache, the cursor being at [x, y]
+// (current rotation coordinates). The rows are already in panel orientation:
+// clipping is done on the panel, each row being a shift and a few byte
+// writes in 1 bit mode.
+
+void Graphics::blitCachedGlyph(int16_t x, int16_t y, const GlyphCache::Glyph * glyph, uint16_t color)
+{
+    int16_t panel_width  = _partial->get_width();
+    int16_t panel_height = _partial->get_height();
+    int16_t px, py;
+
+    switch (rotation)
+    {
+    case 1:  px = _height - 1 - y; py = x;               break;
+    case 2:  px = _width  - 1 - x; py = _height - 1 - y; break;
+    case 3:  px = y;               py = _width  - 1 - x; break;
+    default: px = x;               py = y;               break;
+    }
+
+    int16_t x0 = px + glyph->dx;
+    int16_t y0 = py + glyph->dy;
+    int16_t ys = std::max<int16_t>(0, -y0);
+    int16_t ye = std::min<int16_t>(glyph->height, panel_height - y0);
+    int16_t xs = std::max<int16_t>(0, -x0);
+    int16_t xe = std::min<int16_t>(glyph->width, panel_width - x0);
+
+    if ((xs >= xe) || (ys >= ye))
+        return;
+
+    withMode([&](auto m) { blitCachedGlyphTo<decltype(m)::value>(x0, y0, xs, xe, ys, ye, glyph, color); });
+}
+
+// The rows of a cached glyph, clipped to columns xs .. xe - 1 and rows
+// ys .. ye - 1, at panel position [x0, y0]
+
+template <DisplayMode M>
+void Graphics::blitCachedGlyphTo(int16_t x0, int16_t y0, int16_t xs, int16_t xe, int16_t ys, int16_t ye,
+                                 const GlyphCache::Glyph * glyph, uint16_t color)
+{
+    uint64_t clip = (~0ULL >> (64 - (xe - xs))) << xs;
+
+    if constexpr (M == DisplayMode::INKPLATE_1BIT)
+    {
+        int16_t   line_size = _partial->get_line_size();
+        int16_t   base      = (x0 + xs) & ~7;
+        int16_t   shift     = x0 - base;
+        uint8_t * p         = &_partial->get_data()[(int32_t)(y0 + ys) * line_size + (base >> 3)];
+
+        for (int16_t r = ys; r < ye; r++, p += line_size)
+        {
+            uint64_t v = glyph->rows[r] & clip;
+            v = (shift >= 0) ? (v << shift) : (v >> -shift);
+
+            uint8_t * q = p;
+            if (color)
+            {
+                for (; v; v >>= 8) *q++ |= v;
+            }
+            else
+            {
+                for (; v; v >>= 8) *q++ &= ~v;
+            }
+        }
+
+        markDirty(x0 + xs, y0 + ys);
+        markDirty(x0 + xe - 1, y0 + ye - 1);
+    }
+    else
+    {
+        int16_t line_size = DMemory4Bit->get_line_size();
+
+        color &= 7;
+
+        for (int16_t r = ys; r < ye; r++)
+        {
+            uint8_t * line = &DMemory4Bit->get_data()[(int32_t)(y0 + r) * line_size];
+
+            for (uint64_t v = glyph->rows[r] & clip; v; v &= v - 1)
+            {
+                int16_t   X = x0 + __builtin_ctzll(v);
+                uint8_t * p = &line[X >> 1];
+                *p = (pixelMaskGLUT[X & 1] & *p) | ((X & 1) ? color : color << 4);
+            }
+        }
+    }
+}
+
+void Graphics::setGrayFont(const GFXfontGray * f)
+{
+    grayFont = f;
+    Adafruit_GFX::setFont(f ? &f->font : nullptr);
+}
+
+// Draws an anti-aliased glyph, its upper left corner at [x, y]. In 3 bit
+// mode, each pixel is blended between its current gray level and the text
+// color according to its coverage, through a table rebuilt when the color
+// changes. In 1 bit mode, pixels with at least half coverage are drawn.
+
+void Graphics::blitGrayGlyph(int16_t x, int16_t y, const GFXglyph * glyph, uint16_t color,
+                             uint8_t size_x, uint8_t size_y)
+{
+    const uint8_t * bitmap = &grayFont->font.bitmap[glyph->bitmapOffset];
+    uint8_t         bpp    = grayFont->bpp;
+    uint8_t         full   = (1 << bpp) - 1;
+    int16_t         w      = glyph->width;
+    int16_t         h      = glyph->height;
+
+    if (getDisplayMode() == DisplayMode::INKPLATE_1BIT)
+    {
+        uint32_t bit = 0;
+        for (int16_t yy = 0; yy < h; yy++)
+        {
+            for (int16_t xx = 0; xx < w; xx++, bit += bpp)
+            {
+                uint16_t v = (bitmap[bit >> 3] << 8) | bitmap[(bit >> 3) + 1];
+                uint8_t  c = (v >> (16 - bpp - (bit & 7))) & full;
+                if (c > (full >> 1))
+                    writeFillRect(x + xx * size_x, y + yy * size_y, size_x, size_y, color);
+            }
+        }
+        return;
+    }
+
+    color &= 7;
+
+    if ((grayBlendColor != color) || (grayBlendBpp != bpp))
+    {
+        for (int cov = 0; cov <= full; cov++)
+            for (int cur = 0; cur < 8; cur++)
+                grayBlend[cov][cur] = (cur * (full - cov) + color * cov + (full >> 1)) / full;
+        grayBlendColor = color;
+        grayBlendBpp   = bpp;
+    }
+
+    int16_t sw = w * size_x;
+    int16_t sh = h * size_y;
+    int16_t xs = std::max<int16_t>(0, -x), xe = std::min<int16_t>(sw, _width  - x);
+    int16_t ys = std::max<int16_t>(0, -y), ye = std::min<int16_t>(sh, _height - y);
+
+    if ((xs >= xe) || (ys >= ye))
+        return;
+
+    withRotation([&](auto r) { blitGrayGlyphTo<decltype(r)::value>(x, y, xs, xe, ys, ye, glyph, size_x, size_y); });
+}
+
+// 3 bit mode part of blitGrayGlyph(): the pixels of the glyph scaled by
+// size_x and size_y, clipped to columns xs .. xe - 1 and rows ys .. ye - 1,
+// blended through grayBlend
+
+template <uint8_t R>
+void Graphics::blitGrayGlyphTo(int16_t x, int16_t y, int16_t xs, int16_t xe, int16_t ys, int16_t ye,
+                               const GFXglyph * glyph, uint8_t size_x, uint8_t size_y)
+{
+    const uint8_t * bitmap = &grayFont->font.bitmap[glyph->bitmapOffset];
+    uint8_t         bpp    = grayFont->bpp;
+    uint8_t         full   = (1 << bpp) - 1;
+    int16_t         w      = glyph->width;
+
+    constexpr int16_t dxc = RotationSteps<R>::dxc, dyc = RotationSteps<R>::dyc;
+    constexpr int16_t dxr = RotationSteps<R>::dxr, dyr = RotationSteps<R>::dyr;
+
+    PanelSteps steps;
+    panelSteps(x, y, steps);
+
+    uint8_t * data      = DMemory4Bit->get_data();
+    int16_t   line_size = DMemory4Bit->get_line_size();
+
+    for (int16_t yy = ys; yy < ye; yy++)
+    {
+        uint32_t bit = (uint32_t)((yy / size_y) * w) * bpp;
+        int16_t  X0  = steps.px + yy * dxr;
+        int16_t  Y0  = steps.py + yy * dyr;
+
+        for (int16_t xx = xs; xx < xe; xx++)
+        {
+            uint32_t b = bit + (xx / size_x) * bpp;
+            uint16_t v = (bitmap[b >> 3] << 8) | bitmap[(b >> 3) + 1];
+            uint8_t  c = (v >> (16 - bpp - (b & 7))) & full;
+
+            if (c == 0)
+                continue;
+
+            int16_t   X = X0 + xx * dxc;
+            uint8_t * p = &data[(int32_t)(Y0 + xx * dyc) * line_size + (X >> 1)];
+
+            if (X & 1)
+                *p = (*p & 0xF0) |  grayBlend[c][*p & 0x07];
+            else
+                *p = (*p & 0x0F) | (grayBlend[c][(*p >> 4) & 0x07] << 4);
+        }
+    }
+}
@@ -17,6 +17,7 @@ Distributed as-is; no warranty is given.
 #include "image.hpp"
 
 #include "tjpg_decoder.hpp"
+#include "network_client.hpp"
 
 Image *_imagePtrJpeg = nullptr;
 Image *_imagePtrPng  = nullptr;
@@ -45,19 +46,49 @@ bool Image::drawImage(const char * path, int x, int y, bool dither, bool invert)
             return drawJpegFromWeb(path, x, y, dither, invert);
         if (strstr(path, ".png") != NULL)
             return drawPngFromWeb(path, x, y, dither, invert);
+        if (strstr(path, ".raw") != NULL)
+            return drawRawFromWeb(path);
+        return 0;
     }
-    else
-    {
-        if (strstr(path, ".bmp") != NULL || strstr(path, ".dib") != NULL)
-            return drawBitmapFromFile(path, x, y, dither, invert);
-        if (strstr(path, ".jpg") != NULL || strstr(path, ".jpeg") != NULL)
-            return drawJpegFromFile(path, x, y, dither, invert);
-        if (strstr(path, ".png") != NULL)
-            return drawPngFromFile(path, x, y, dither, invert);
-    }
-    return 0;
+    return drawImageFromFile(path, x, y, dither, invert, ditherMode);
 };
 
+// A picture file, of the format given by the path extension, dithered with mode
+
+bool Image::drawImageFromFile(const char *path, int x, int y, bool dither, bool invert, Dither mode)
+{
+    bool bmp = strstr(path, ".bmp") != NULL || strstr(path, ".dib") != NULL;
+    bool jpeg = strstr(path, ".jpg") != NULL || strstr(path, ".jpeg") != NULL;
+    bool png = strstr(path, ".png") != NULL;
+
+    if (!bmp && !jpeg && !png)
+        return strstr(path, ".raw") != NULL && drawRawFromFile(path);
+
+    FILE *p = fopen(path, "r");
+    if (!p)
+        return 0;
+    if (bmp)
+        return drawBitmapFromFile(p, x, y, dither, invert, mode);
+    if (jpeg)
+        return drawJpegFromFile(p, x, y, dither, invert, mode);
+    return drawPngFromFile(p, x, y, dither, invert, mode);
+}
+
+bool Image::drawImageIfChanged(const char *url, int x, int y, bool *changed, bool dither, bool invert)
+{
+    // drawImage() may fail before any request: no 304 left from a previous call
+
+    network_client.clearNotModified();
+    network_client.setSkipNotModified(true);
+    bool ok = drawImage(url, x, y, dither, invert);
+    network_client.setSkipNotModified(false);
+
+    bool unchanged = !ok && network_client.isNotModified();
+    if (changed != nullptr)
+        *changed = ok;
+    return ok || unchanged;
+}
+
 bool Image::drawImage(const uint8_t *buf, int x, int y, int16_t w, int16_t h, uint8_t c, uint8_t bg)
 {
     if (getDisplayMode() == DisplayMode::INKPLATE_1BIT && bg == 0xFF)
@@ -84,6 +115,8 @@ bool Image::drawImage(const char *path, const Format& format, const int x, const
             return drawJpegFromWeb(path, x, y, dither, invert);
         if (format == PNG)
             return drawPngFromWeb(path, x, y, dither, invert);
+        if (format == RAW)
+            return drawRawFromWeb(path);
     }
     else
     {
@@ -93,6 +126,8 @@ bool Image::drawImage(const char *path, const Format& format, const int x, const
             return drawJpegFromFile(path, x, y, dither, invert);
         if (format == PNG)
             return drawPngFromFile(path, x, y, dither, invert);
+        if (format == RAW)
+            return drawRawFromFile(path);
     }
     return 0;
 }
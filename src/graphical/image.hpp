@@ -18,11 +18,15 @@ Distributed as-is; no warranty is given.
 #define __IMAGE_HPP__
 
 #include <cstdio>
+#include <functional>
 #include <string>
+#include <vector>
 
 #include "defines.hpp"
 #include "adafruit_gfx.hpp"
 
+typedef struct _pngle_t pngle_t;
+
 class Image : virtual public Adafruit_GFX
 {
   private:
@@ -45,7 +49,8 @@ class Image : virtual public Adafruit_GFX
     {
         BMP,
         JPG,
-        PNG
+        PNG,
+        RAW
     } Format;
 
     typedef enum
@@ -56,6 +61,13 @@ class Image : virtual public Adafruit_GFX
         TopRight,
         BottomRight
     } Position;
+
+    typedef enum
+    {
+        FloydSteinberg,
+        Bayer,
+        BlueNoise
+    } Dither;
 	
     Image(int16_t w, int16_t h);
 
@@ -73,6 +85,61 @@ class Image : virtual public Adafruit_GFX
     bool drawImage(const std::string path, const Format& format, const int x, const int y, const bool dither = 1, const bool invert = 0);
     bool drawImage(const char* path, const Format& format, const Position& position, const bool dither = 1, const bool invert = 0);	
 
+    /**
+     * @brief Draw a web picture only if it changed since the last download
+     *
+     * Needs the NetworkClient cache (network_client.setCache()). When the
+     * server answers 304 (not modified), nothing is drawn and *changed is set
+     * to false: the display doesn't need to be updated.
+     *
+     * @return true if the picture was drawn or is unchanged.
+     */
+    bool drawImageIfChanged(const char *url, int x, int y, bool *changed, bool dither = 1, bool invert = 0);
+
+    // A picture of drawImagesAsync(): URL or file, and drawImage() parameters.
+    // ditherMode is set by drawImagesAsync() to the setDither() one.
+
+    struct ImageRequest
+    {
+        std::string path;
+        int x, y;
+        bool dither = 1;
+        bool invert = 0;
+        Dither ditherMode = FloydSteinberg;
+    };
+
+    typedef std::function<void(const std::vector<bool> &drawn)> ImagesDone;
+
+    /**
+     * @brief Draw a list of pictures, downloads overlapped with decoding
+     *
+     * A task on core 0, the Wi-Fi one, downloads the web pictures in memory
+     * while a task on core 1 decodes and draws the ones received, in the
+     * list order. The downloaded pictures waiting to be drawn, with the one
+     * being downloaded, never use more than memoryBudget bytes: a download
+     * waits for enough memory to be freed. A picture larger than
+     * memoryBudget is not drawn.
+     *
+     * Returns at once. done() is called from the drawing task when every
+     * picture is handled, with the result of each. Until then, the display
+     * and network_client must not be used by the caller.
+     *
+     * @return false if a list is already being drawn or the tasks can't be started.
+     */
+    bool drawImagesAsync(const std::vector<ImageRequest> &list, ImagesDone done, int32_t memoryBudget = 256 * 1024);
+
+    /**
+     * @brief Draw a JPEG picture (file or URL) reduced to fit in a box
+     *
+     * The picture keeps its aspect ratio and is centered in the box. It is
+     * decoded at the largest tjpgd scale (1/2, 1/4, 1/8) that still covers
+     * the box, then box filtered to the final size. Pictures smaller than the
+     * box are not enlarged.
+     *
+     * @param w, h The box size. 0 extends the box up to the screen edge.
+     */
+    bool drawImageToFit(const char *path, int x = 0, int y = 0, int w = 0, int h = 0, bool dither = 1, bool invert = 0);
+
     bool drawBitmapFromFile(const char *fileName, int x, int y, bool dither = 0, bool invert = 0);
     bool   drawJpegFromFile(const char *fileName, int x, int y, bool dither = 0, bool invert = 0);
     bool    drawPngFromFile(const char *fileName, int x, int y, bool dither = 0, bool invert = 0);
@@ -85,6 +152,19 @@ class Image : virtual public Adafruit_GFX
     bool    drawJpegFromWeb(const char *url, int x, int y, bool dither = 0, bool invert = 0);
     bool     drawPngFromWeb(const char *url, int x, int y, bool dither = 0, bool invert = 0);
 
+    /**
+     * @brief Load a raw picture (see raw_image.hpp) over the whole screen
+     *
+     * The picture data is read straight into the frame buffer of the current
+     * display mode, whatever the rotation. Its size and depth must be the
+     * ones of this frame buffer. When the data is incomplete, false is
+     * returned with the frame buffer partly loaded.
+     */
+    bool    drawRawFromFile(const char *fileName);
+    bool    drawRawFromFile(FILE *p);
+    bool     drawRawFromWeb(const char *url);
+    bool  drawRawFromBuffer(const uint8_t *buf, int32_t size);
+
     // Defined in Adafruit-GFX-Library, but should fit here
     // void drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color);
     // void drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color,
@@ -96,11 +176,35 @@ class Image : virtual public Adafruit_GFX
 
     bool drawJpegFromBuffer(uint8_t *buf, int32_t len, int x, int y, bool dither, bool invert);
 
+    bool drawPngFromBuffer(const uint8_t *buf, int32_t len, int x, int y, bool dither = 0, bool invert = 0);
+
+    /**
+     * @brief Select the dithering done by the next draw calls with dither set
+     *
+     * FloydSteinberg (error diffusion) is the default. Bayer (8x8 tile) and
+     * BlueNoise (16x16 tile) are ordered dithers: a pixel is only compared
+     * with the threshold of its screen position. They are faster, and a
+     * picture gives the same pixels whatever the order its parts are drawn
+     * in, so unchanged areas stay unchanged for partialUpdate().
+     * drawImagesAsync() keeps the one selected when it is called.
+     */
+    void     setDither(Dither d);
+    Dither   getDither() { return ditherMode; }
+
     // Should be private, but needed in a png callback :(
     void           ditherSwap(int w);
     uint8_t ditherGetPixelBmp(uint8_t px, int i, int w, bool paletted);
 
-    static inline int16_t rowSize(int16_t w, int8_t c) { return ((c * w + 31) >> 5) << 2; }
+    // Ordered dithering (ditherTable set) of the 8 bit gray px drawn at [x, y]:
+    // 0 to 7, as ditherGetPixelBmp() returns it
+
+    inline uint8_t ditherGetPixelOrdered(uint8_t px, int16_t x, int16_t y)
+    {
+        uint8_t t = ditherTable[((y & ditherMask) << ditherShift) | (x & ditherMask)];
+        return ((px * ditherLevels + t) / 255) * ditherScale;
+    }
+
+    static inline int32_t rowSize(int32_t w, int8_t c) { return ((c * w + 31) >> 5) << 2; }
 
     static inline uint32_t read32(uint8_t * c) { return (uint32_t)(c[0] | (c[1] << 8) | (c[2] << 16) | (c[3] << 24)); }
     static inline uint16_t read16(uint8_t * c) { return (uint16_t)(c[0] | (c[1] << 8));                               }
@@ -121,7 +225,27 @@ class Image : virtual public Adafruit_GFX
     virtual void      writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t  y1, uint16_t color) = 0;
     virtual void       endWrite(void) = 0;
 
-    static bool   drawJpegChunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap, bool dither, bool invert);
+    // w * h pixel values (0..7, or 0/1 in 1 bit mode), row-major
+    virtual void     writeBlock(int16_t  x, int16_t  y, int16_t  w, int16_t  h, const uint8_t * levels) = 0;
+
+    // One row of w samples of depth bits (1, 2 or 4), packed as in PNG
+    // scanlines; lut gives the pixel value of each sample value
+    virtual void writePackedRow(int16_t  x, int16_t  y, int16_t  w, const uint8_t * row, uint8_t depth, const uint8_t * lut) = 0;
+
+    // Frame buffer data of the current display mode if it has the layout of
+    // a raw picture of w x h pixels at bits per pixel, nullptr otherwise. The
+    // whole screen is then considered drawn.
+    virtual uint8_t * rawFrameBuffer(uint8_t bits, uint16_t w, uint16_t h) = 0;
+
+    template <typename Reader> bool drawRaw(Reader read);
+
+    static bool   drawJpegChunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t *bitmap, bool dither, bool invert);
+    static int32_t readJpegStream(uint8_t *buf, int32_t len);
+    static bool   placeJpeg(uint16_t w, uint16_t h);
+    static bool   fitJpeg(uint16_t w, uint16_t h);
+    static bool   drawJpegFitChunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t *bitmap, bool dither, bool invert);
+    static void   drawPngRow(pngle_t *pngle, uint32_t y, const uint8_t *row, size_t len);
+    static void   drawPngBlock(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t rgba[4]);
 
     // uint8_t pixelBuffer[e_ink_width * 4 + 5];
     // uint8_t ditherBuffer[2][e_ink_width + 20];
@@ -132,9 +256,43 @@ class Image : virtual public Adafruit_GFX
     int16_t ditherBufferSize;
     int16_t pixelBufferSize;
 
+    Dither ditherMode = FloydSteinberg;   // setDither() one, for the next draw calls
+    const uint8_t *ditherTable = nullptr; // Thresholds of the ordered dither, nullptr for error diffusion
+    uint8_t ditherMask, ditherShift;      // Tile size - 1, log2(tile size)
+    uint8_t ditherLevels, ditherScale;    // 1 and 7 in 1 bit mode, 7 and 1 in 3 bit mode
+
+    void ditherStart(Dither mode);
+
+    // The draw calls with the dithering given by mode instead of setDither()
+
+    bool drawImageFromFile(const char *path, int x, int y, bool dither, bool invert, Dither mode);
+    bool drawBitmapFromFile(FILE *p, int x, int y, bool dither, bool invert, Dither mode);
+    bool drawBitmapFromBuffer(uint8_t *buf, int x, int y, bool dither, bool invert, Dither mode);
+    bool drawJpegFromFile(FILE *p, int x, int y, bool dither, bool invert, Dither mode);
+    bool drawJpegFromBuffer(uint8_t *buf, int32_t len, int x, int y, bool dither, bool invert, Dither mode);
+    bool drawPngFromFile(FILE *p, int x, int y, bool dither, bool invert, Dither mode);
+    bool drawPngFromBuffer(const uint8_t *buf, int32_t len, int x, int y, bool dither, bool invert, Dither mode);
+
     uint8_t jpegDitherBuffer[18][18];
     int16_t blockW = 0, blockH = 0;
     int16_t lastY = -1;
+    Position jpegPosition = Center;
+
+    // drawImageToFit() state: decoded (source) pixels are summed per output
+    // pixel in a ring of output rows, drawn when complete.
+    struct JpegFit {
+        int16_t boxX, boxY, boxW, boxH;
+        int16_t x, y;             // Output position
+        uint16_t w, h;            // Output size
+        uint16_t srcW, srcH;      // Decoded size
+        uint16_t rows;            // Ring size
+        uint16_t nextRow;         // First output row not drawn yet
+        uint32_t *sums;           // [rows][w]
+        uint16_t *colMap;         // Source column to output column
+        uint16_t *colCount;       // Source columns per output column
+    } jpegFit;
+
+    void drawJpegFitRow(uint16_t row, bool dither, bool invert);
 
     uint8_t ditherPalette[256]; // 8 bit colors
     uint8_t palette[128];       // 2 3 bit colors per byte, _###_###
@@ -145,18 +303,33 @@ class Image : virtual public Adafruit_GFX
     void ditherSwapBlockJpeg(int x);
 
     void readBmpHeader(uint8_t *buf, bitmapHeader *_h);
-    void readBmpHeaderFromFile(FILE *_f, bitmapHeader *_h);
+    bool readBmpHeaderFromFile(FILE *_f, bitmapHeader *_h);
 
-    inline void displayBmpLine(int16_t x, int16_t y, bitmapHeader *bmpHeader, bool dither, bool invert);
+    void prepareBmp(bitmapHeader *bmpHeader, bool dither, bool invert, Dither mode);
+    void drawBmpRow(int16_t x, int16_t y, bitmapHeader *bmpHeader, const uint8_t *row, bool dither);
+    template <typename Reader>
+    bool drawBmpRows(Reader read, bitmapHeader *bmpHeader, int x, int y, int32_t first, int32_t count, bool dither);
 
     void getPointsForPosition(const Position& position, const uint16_t imageWidth, const uint16_t imageHeight, 
 		const uint16_t screenWidth, const uint16_t screenHeight, uint16_t *posX, uint16_t *posY);
 
     bool drawJpegFromWebAtPosition(const char* url, const Position& position, const bool dither = 0, const bool invert = 0);
 
-    // FUTURE COMPATIBILITY FUNCTIONS; DO NOT USE!
+    // drawImagesAsync() tasks, see image_async.cpp
 
-    void drawXBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color);
+    struct AsyncDraw;
+    volatile bool asyncBusy = false;
+
+    static void fetchTask(void *param);
+    static void drawTask(void *param);
+    static void deleteAsyncDraw(AsyncDraw *draw);
+    static bool reserveMemory(AsyncDraw *draw, int32_t size, int32_t total);
+    static void releaseMemory(AsyncDraw *draw, int32_t size);
+    static uint8_t *fetchPicture(AsyncDraw *draw, const char *path, int32_t *size);
+    bool drawImageFromBuffer(const char *path, uint8_t *buf, int32_t len, int x, int y, bool dither, bool invert,
+                             Dither mode);
+
+    // FUTURE COMPATIBILITY FUNCTIONS; DO NOT USE!
 
     void drawGrayscaleBitmap(int16_t x, int16_t y, uint8_t * bitmap, int16_t w, int16_t h);
     void drawGrayscaleBitmap(int16_t x, int16_t y, uint8_t * bitmap, uint8_t * mask, int16_t w, int16_t h);
@@ -0,0 +1,372 @@
+/*
+image_async.cpp
+Inkplate 6 ESP-IDF
+
+drawImagesAsync(): web pictures downloaded on one core while the previous
+ones are decoded and drawn on the other.
+
+This code is released under the GNU Lesser General Public License v3.0: https://www.gnu.org/licenses/lgpl-3.0.en.html
+*/
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+
+#include "image.hpp"
+#include "network_client.hpp"
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+static constexpr char const * TAG = "ImageAsync";
+
+// The fetch task runs with the Wi-Fi stack, on core 0. Without a second
+// core, both tasks share the only one.
+
+#if CONFIG_FREERTOS_UNICORE
+static const BaseType_t FETCH_CORE = tskNO_AFFINITY;
+static const BaseType_t DRAW_CORE  = tskNO_AFFINITY;
+#else
+static const BaseType_t FETCH_CORE = 0;
+static const BaseType_t DRAW_CORE  = 1;
+#endif
+
+static const uint32_t FETCH_STACK_SIZE = 6 * 1024;
+static const uint32_t  DRAW_STACK_SIZE = 8 * 1024;
+
+// First buffer size of a picture of unknown length (chunked), doubled as needed
+
+static const int32_t CHUNKED_START_SIZE = 16 * 1024;
+
+// A picture handed over to the drawing task: its file content, or nullptr
+// for the ones not coming from the web
+
+struct Fetched
+{
+    size_t index;
+    uint8_t *data;
+    int32_t size;
+    bool ok;
+};
+
+struct Image::AsyncDraw
+{
+    Image *image;
+    std::vector<ImageRequest> list;
+    ImagesDone done;
+    int32_t budget;
+
+    SemaphoreHandle_t mutex;    // Protects ready and used
+    SemaphoreHandle_t received; // Counts the pictures in ready
+    SemaphoreHandle_t freed;    // Given when a picture memory is freed
+    SemaphoreHandle_t fetched;  // Given when the fetch task is done
+
+    std::deque<Fetched> ready;
+    int32_t used = 0;           // Memory of the pictures in ready and of the one downloaded
+};
+
+void Image::deleteAsyncDraw(AsyncDraw *draw)
+{
+    if (draw->mutex)
+        vSemaphoreDelete(draw->mutex);
+    if (draw->received)
+        vSemaphoreDelete(draw->received);
+    if (draw->freed)
+        vSemaphoreDelete(draw->freed);
+    if (draw->fetched)
+        vSemaphoreDelete(draw->fetched);
+    delete draw;
+}
+
+static bool isWeb(const char *path)
+{
+    return strncmp(path, "http://", 7) == 0 || strncmp(path, "https://", 8) == 0;
+}
+
+bool Image::drawImagesAsync(const std::vector<ImageRequest> &list, ImagesDone done, int32_t memoryBudget)
+{
+    if (asyncBusy)
+        return 0;
+
+    AsyncDraw *draw = new AsyncDraw;
+    draw->image = this;
+    draw->list = list;
+    for (ImageRequest &request : draw->list)
+        request.ditherMode = ditherMode;
+    draw->done = done;
+    draw->budget = memoryBudget;
+    draw->mutex = xSemaphoreCreateMutex();
+    draw->received = xSemaphoreCreateCounting(list.size() + 1, 0);
+    draw->freed = xSemaphoreCreateBinary();
+    draw->fetched = xSemaphoreCreateBinary();
+
+    if (!draw->mutex || !draw->received || !draw->freed || !draw->fetched)
+    {
+        ESP_LOGE(TAG, "Unable to create the semaphores");
+        deleteAsyncDraw(draw);
+        return 0;
+    }
+
+    asyncBusy = true;
+
+    if (xTaskCreatePinnedToCore(drawTask, "imageDraw", DRAW_STACK_SIZE, draw, tskIDLE_PRIORITY + 5, nullptr, DRAW_CORE) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Unable to start the drawing task");
+        deleteAsyncDraw(draw);
+        asyncBusy = false;
+        return 0;
+    }
+
+    // Without the fetch task, the drawing one gets every picture as failed
+
+    if (xTaskCreatePinnedToCore(fetchTask, "imageFetch", FETCH_STACK_SIZE, draw, tskIDLE_PRIORITY + 5, nullptr, FETCH_CORE) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Unable to start the download task");
+        xSemaphoreTake(draw->mutex, portMAX_DELAY);
+        for (size_t i = 0; i < list.size(); i++)
+            draw->ready.push_back({i, nullptr, 0, false});
+        xSemaphoreGive(draw->mutex);
+        for (size_t i = 0; i < list.size(); i++)
+            xSemaphoreGive(draw->received);
+        xSemaphoreGive(draw->fetched);
+    }
+
+    return 1;
+}
+
+// Adds size bytes to the memory in use, waiting for the drawing task to free
+// enough of it. The memory of the picture being downloaded, already counted,
+// is part of total: once every received picture is freed, total bytes fit.
+
+bool Image::reserveMemory(AsyncDraw *draw, int32_t size, int32_t total)
+{
+    if (total > draw->budget)
+        return false;
+
+    for (;;)
+    {
+        xSemaphoreTake(draw->mutex, portMAX_DELAY);
+        bool room = draw->used + size <= draw->budget;
+        if (room)
+            draw->used += size;
+        xSemaphoreGive(draw->mutex);
+        if (room)
+            return true;
+        xSemaphoreTake(draw->freed, portMAX_DELAY);
+    }
+}
+
+void Image::releaseMemory(AsyncDraw *draw, int32_t size)
+{
+    xSemaphoreTake(draw->mutex, portMAX_DELAY);
+    draw->used -= size;
+    xSemaphoreGive(draw->mutex);
+}
+
+// Downloads a picture in a buffer of the memory budget. With a Content-Length,
+// the whole buffer is reserved before reading the body. Otherwise, it grows
+// with the body, each part being reserved before use.
+
+uint8_t *Image::fetchPicture(AsyncDraw *draw, const char *path, int32_t *size)
+{
+    int32_t length;
+
+    if (!network_client.openStream(path, &length))
+        return nullptr;
+
+    int32_t bufSize = (length >= 0) ? length : std::min(CHUNKED_START_SIZE, draw->budget);
+    int32_t used = 0;
+    int32_t reserved = 0;
+    uint8_t *buffer = nullptr;
+
+    if (reserveMemory(draw, bufSize, bufSize))
+        buffer = (uint8_t *)malloc(std::max<int32_t>(reserved = bufSize, 1));
+    else
+        ESP_LOGE(TAG, "%s is larger than the memory budget (%" PRIi32 " bytes)", path, draw->budget);
+
+    while (buffer != nullptr)
+    {
+        if ((used == bufSize) && (length < 0))
+        {
+            // At the budget: the body may end right there
+
+            int32_t bigger = std::min(bufSize * 2, draw->budget);
+            uint8_t probe;
+            if ((bigger == bufSize) && (network_client.readStream(&probe, 1) == 0))
+                break;
+
+            uint8_t *p = nullptr;
+            if ((bigger > bufSize) && reserveMemory(draw, bigger - bufSize, bigger))
+            {
+                reserved = bigger;
+                p = (uint8_t *)realloc(buffer, bigger);
+            }
+            if (p == nullptr)
+            {
+                ESP_LOGE(TAG, "%s is larger than the memory budget (%" PRIi32 " bytes)", path, draw->budget);
+                free(buffer);
+                buffer = nullptr;
+                break;
+            }
+            buffer = p;
+            bufSize = bigger;
+        }
+        int32_t len = network_client.readStream(buffer + used, bufSize - used);
+        if (len < 0)
+        {
+            free(buffer);
+            buffer = nullptr;
+        }
+        else if ((len == 0) || ((used += len) == length))
+        {
+            break;
+        }
+    }
+
+    network_client.closeStream();
+
+    if ((buffer != nullptr) && (length >= 0) && (used != length))
+    {
+        ESP_LOGE(TAG, "Truncated file: %" PRIi32 " bytes of %" PRIi32, used, length);
+        free(buffer);
+        buffer = nullptr;
+    }
+
+    // Only the memory of the picture stays counted
+
+    if (buffer == nullptr)
+    {
+        releaseMemory(draw, reserved);
+        return nullptr;
+    }
+    if (used < reserved)
+    {
+        uint8_t *p = (uint8_t *)realloc(buffer, std::max<int32_t>(used, 1));
+        if (p != nullptr)
+            buffer = p;
+        releaseMemory(draw, reserved - used);
+    }
+
+    *size = used;
+    return buffer;
+}
+
+// Downloads the web pictures in the list order, each one waiting for the
+// drawing task to free enough memory to fit in the budget.
+
+void Image::fetchTask(void *param)
+{
+    AsyncDraw *draw = (AsyncDraw *)param;
+
+    for (size_t i = 0; i < draw->list.size(); i++)
+    {
+        const char *path = draw->list[i].path.c_str();
+        Fetched item = {i, nullptr, 0, true};
+
+        if (isWeb(path))
+        {
+            item.data = fetchPicture(draw, path, &item.size);
+            item.ok = item.data != nullptr;
+            if (!item.ok)
+            {
+                ESP_LOGE(TAG, "Unable to download %s", path);
+                item.size = 0;
+            }
+        }
+
+        // The memory of the picture is already counted in used
+
+        xSemaphoreTake(draw->mutex, portMAX_DELAY);
+        draw->ready.push_back(item);
+        xSemaphoreGive(draw->mutex);
+        xSemaphoreGive(draw->received);
+    }
+
+    xSemaphoreGive(draw->fetched);
+    vTaskDelete(nullptr);
+}
+
+// Draws the pictures as they are received, then reports
+
+void Image::drawTask(void *param)
+{
+    AsyncDraw *draw = (AsyncDraw *)param;
+    Image *image = draw->image;
+    std::vector<bool> drawn(draw->list.size(), false);
+
+    for (size_t count = 0; count < draw->list.size(); count++)
+    {
+        xSemaphoreTake(draw->received, portMAX_DELAY);
+
+        xSemaphoreTake(draw->mutex, portMAX_DELAY);
+        Fetched item = draw->ready.front();
+        draw->ready.pop_front();
+        xSemaphoreGive(draw->mutex);
+
+        const ImageRequest &request = draw->list[item.index];
+
+        if (!item.ok)
+            drawn[item.index] = false;
+        else if (item.data == nullptr)
+            drawn[item.index] = image->drawImageFromFile(request.path.c_str(), request.x, request.y, request.dither,
+                                                         request.invert, request.ditherMode);
+        else
+            drawn[item.index] = image->drawImageFromBuffer(request.path.c_str(), item.data, item.size, request.x,
+                                                           request.y, request.dither, request.invert, request.ditherMode);
+
+        if (item.data != nullptr)
+        {
+            free(item.data);
+            xSemaphoreTake(draw->mutex, portMAX_DELAY);
+            draw->used -= item.size;
+            xSemaphoreGive(draw->mutex);
+            xSemaphoreGive(draw->freed);
+        }
+    }
+
+    xSemaphoreTake(draw->fetched, portMAX_DELAY);
+
+    ImagesDone done = draw->done;
+    deleteAsyncDraw(draw);
+
+    image->asyncBusy = false;
+    if (done)
+        done(drawn);
+
+    vTaskDelete(nullptr);
+}
+
+// A downloaded picture, of the format given by the path extension, dithered with mode
+
+bool Image::drawImageFromBuffer(const char *path, uint8_t *buf, int32_t len, int x, int y, bool dither, bool invert,
+                                Dither mode)
+{
+    if (strstr(path, ".bmp") != NULL || strstr(path, ".dib") != NULL)
+    {
+        if (len < 54)
+            return 0;
+
+        bitmapHeader bmpHeader;
+        readBmpHeader(buf, &bmpHeader);
+
+        int32_t h = (int32_t)bmpHeader.height;
+        if (h < 0)
+            h = -h;
+        if (!legalBmp(&bmpHeader) || bmpHeader.startRAW + (int64_t)rowSize(bmpHeader.width, bmpHeader.color) * h > len)
+            return 0;
+
+        return drawBitmapFromBuffer(buf, x, y, dither, invert, mode);
+    }
+    if (strstr(path, ".jpg") != NULL || strstr(path, ".jpeg") != NULL)
+        return drawJpegFromBuffer(buf, len, x, y, dither, invert, mode);
+    if (strstr(path, ".png") != NULL)
+        return drawPngFromBuffer(buf, len, x, y, dither, invert, mode);
+    if (strstr(path, ".raw") != NULL)
+        return drawRawFromBuffer(buf, len);
+    return 0;
+}
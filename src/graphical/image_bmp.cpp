@@ -18,41 +18,44 @@ Distributed as-is; no warranty is given.
 #include "network_client.hpp"
 
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "esp_heap_caps.h"
+
+// Size of the buffer receiving the pixel rows from the file. The SD card
+// gives much better throughput with large sequential reads than with one
+// read per row.
+
+static const int32_t bmpBatchSize = 16 * 1024;
+
+static uint8_t _bmpLevelMap[8]; // Luminance (0..7) to pixel value
+static uint8_t _bmpLut[256];    // Palette index to pixel value
 
 bool Image::legalBmp(bitmapHeader *bmpHeader)
 {
     return bmpHeader->signature == 0x4D42 && bmpHeader->compression == 0 &&
+           (int32_t)bmpHeader->width > 0 && bmpHeader->height != 0 &&
            (bmpHeader->color == 1 || bmpHeader->color == 4 || bmpHeader->color == 8 || bmpHeader->color == 16 ||
             bmpHeader->color == 24 || bmpHeader->color == 32);
 }
 
-void Image::readBmpHeaderFromFile(FILE * f, bitmapHeader * h)
+// The file header, the DIB header and the palette are read at once
+
+bool Image::readBmpHeaderFromFile(FILE * f, bitmapHeader * h)
 {
-    uint8_t header[55];
+    uint8_t * header = pixelBuffer;
+    size_t    size   = std::min<size_t>(pixelBufferSize, 14 + 124 + 256 * 4); // Up to a BITMAPV5HEADER
 
     rewind(f);
-    fread(header, 55, 1, f);
-
-    uint16_t color       = read16(header + 28);
-    uint32_t totalColors = read32(header + 46);
-
-    if (color <= 8)
-    {
-        if (!totalColors)
-            totalColors = (1ULL << color);
-
-        uint8_t * buff = new uint8_t[totalColors * 4 + 100];
-
-        rewind(f);
-        fread(buff, totalColors * 4 + 100, 1, f);
+    size_t len = fread(header, 1, size, f);
+    if (len < 54)
+        return 0;
 
-        readBmpHeader(buff, h);
-        delete[] buff;
-    }
-    else
-    {
-        readBmpHeader(header, h);
-    }
+    memset(header + len, 0, size - len);
+    readBmpHeader(header, h);
+    return 1;
 }
 
 void Image::readBmpHeader(uint8_t *buf, bitmapHeader *_h)
@@ -68,23 +71,21 @@ void Image::readBmpHeader(uint8_t *buf, bitmapHeader *_h)
 
     uint32_t totalColors = read32(buf + 46);
 
-    uint8_t paletteRGB[1024];
-
     if (_h->color <= 8)
     {
-        if (!totalColors)
-            totalColors = (1ULL << _h->color);
+        if (!totalColors || totalColors > (1UL << _h->color))
+            totalColors = (1UL << _h->color);
+
+        // Entries of 4 bytes (blue, green, red, 0) following the DIB header
 
-        memcpy(paletteRGB, buf + 53, totalColors * 4);
+        const uint8_t *entry = buf + 14 + std::min<uint32_t>(_h->dibHeaderSize, 124);
         memset(palette, 0, sizeof palette);
 
-        for (int i = 0; i < totalColors; ++i)
+        for (int i = 0; i < totalColors; ++i, entry += 4)
         {
-            uint32_t c = read32(paletteRGB + (i << 2));
-
-            uint8_t r = (c & 0xFF000000) >> 24;
-            uint8_t g = (c & 0x00FF0000) >> 16;
-            uint8_t b = (c & 0x0000FF00) >> 8;
+            uint8_t r = entry[2];
+            uint8_t g = entry[1];
+            uint8_t b = entry[0];
 
             palette[i >> 1] |= rgb3Bit(r, g, b) << (i & 1 ? 0 : 4);
             ditherPalette[i] = rgb8Bit(r, g, b);
@@ -92,6 +93,25 @@ void Image::readBmpHeader(uint8_t *buf, bitmapHeader *_h)
     }
 };
 
+// Pixel value tables for the picture about to be drawn
+
+void Image::prepareBmp(bitmapHeader *bmpHeader, bool dither, bool invert, Dither mode)
+{
+    bool oneBit = getDisplayMode() == DisplayMode::INKPLATE_1BIT;
+    for (int v = 0; v < 8; v++)
+    {
+        uint8_t val = invert ? 7 - v : v;
+        _bmpLevelMap[v] = oneBit ? (~val >> 2) & 1 : val;
+    }
+
+    if (bmpHeader->color <= 8)
+        for (int i = 0; i < (1 << bmpHeader->color); i++)
+            _bmpLut[i] = _bmpLevelMap[(palette[i >> 1] >> (i & 1 ? 0 : 4)) & 7];
+
+    if (dither)
+        ditherStart(mode);
+}
+
 bool Image::drawBitmapFromFile(const char *fileName, int x, int y, bool dither, bool invert)
 {
     FILE * dat = fopen(fileName, "r");
@@ -101,45 +121,173 @@ bool Image::drawBitmapFromFile(const char *fileName, int x, int y, bool dither,
         return 0;
 }
 
-bool Image::drawBitmapFromFile(FILE * p, int x, int y, bool dither, bool invert)
+// Rows first .. first + count - 1, in file order, are read by batches and
+// drawn. The source is positioned on the first one.
+
+template <typename Reader>
+bool Image::drawBmpRows(Reader read, bitmapHeader *bmpHeader, int x, int y, int32_t first, int32_t count, bool dither)
 {
-    bitmapHeader bmpHeader;
+    int32_t h = (int32_t)bmpHeader->height;
+    bool topDown = h < 0;
+    if (topDown)
+        h = -h;
 
-    readBmpHeaderFromFile(p, &bmpHeader);
+    int32_t rowBytes = rowSize(bmpHeader->width, bmpHeader->color);
+    int32_t batchRows = std::min(count, std::max<int32_t>(1, bmpBatchSize / rowBytes));
 
-    if (!legalBmp(&bmpHeader))
+    // In internal RAM (word aligned, DMA capable): the SD driver transfers
+    // whole sectors straight into it instead of going through its own buffer
+
+    uint8_t *batch = (uint8_t *)heap_caps_malloc(batchRows * rowBytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!batch)
+        batch = (uint8_t *)malloc(batchRows * rowBytes);
+    if (!batch)
         return 0;
 
-    int16_t w = bmpHeader.width, h = bmpHeader.height;
-    int8_t c = bmpHeader.color;
+    bool ret = 1;
+    for (int32_t i = 0; i < count;)
+    {
+        int32_t n = read(batch, rowBytes, std::min(batchRows, count - i));
+        if (n <= 0)
+        {
+            ret = 0; // Truncated file
+            break;
+        }
+        for (int32_t r = 0; r < n; r++, i++)
+        {
+            int32_t row = first + i;
+            drawBmpRow(x, y + (topDown ? row : h - 1 - row), bmpHeader, batch + r * rowBytes, dither);
+        }
+    }
+
+    heap_caps_free(batch);
+    return ret;
+}
 
-    fseek(p, bmpHeader.startRAW, SEEK_SET);
-    if (dither)
-        memset(ditherBuffer, 0, ditherBufferSize);
-        
-    for (int i = 0; i < h; ++i)
+// Picture rows, in file order, landing on the screen. false if none.
+
+static bool bmpVisibleRows(int32_t height, int y, int16_t screenHeight, int32_t &first, int32_t &count)
+{
+    bool topDown = height < 0;
+    int32_t h = topDown ? -height : height;
+
+    // Picture rows top .. bottom - 1 are on the screen
+
+    int32_t top = std::max<int32_t>(0, -y);
+    int32_t bottom = std::min<int32_t>(h, screenHeight - y);
+
+    first = topDown ? top : h - bottom;
+    count = bottom - top;
+    return count > 0;
+}
+
+// Only the rows landing on the screen are read: a single seek to the first
+// one in file order (the bottom one, unless the picture is stored top-down),
+// then reads of as many rows as the batch buffer can hold.
+
+bool Image::drawBitmapFromFile(FILE * p, int x, int y, bool dither, bool invert, Dither mode)
+{
+    bitmapHeader bmpHeader;
+    int32_t first, count;
+
+    if (!readBmpHeaderFromFile(p, &bmpHeader) || !legalBmp(&bmpHeader))
     {
-        int16_t n = rowSize(w, c);
-        fread(pixelBuffer, n, 1, p);
-        displayBmpLine(x, y + bmpHeader.height - i - 1, &bmpHeader, dither, invert);
+        fclose(p);
+        return 0;
     }
-    return 1;
+
+    if (!bmpVisibleRows(bmpHeader.height, y, height(), first, count))
+    {
+        fclose(p);
+        return 1;
+    }
+
+    int32_t rowBytes = rowSize(bmpHeader.width, bmpHeader.color);
+    if (fseek(p, bmpHeader.startRAW + first * rowBytes, SEEK_SET) != 0)
+    {
+        fclose(p);
+        return 0;
+    }
+
+    prepareBmp(&bmpHeader, dither, invert, mode);
+
+    bool ret = drawBmpRows([p](uint8_t *buf, int32_t size, int32_t rows) -> int32_t {
+        return fread(buf, size, rows, p);
+    }, &bmpHeader, x, y, first, count, dither);
+
+    fclose(p);
+    return ret;
+}
+
+bool Image::drawBitmapFromFile(FILE * p, int x, int y, bool dither, bool invert)
+{
+    return drawBitmapFromFile(p, x, y, dither, invert, ditherMode);
 }
 
+// The body is read as it arrives, up to the last row landing on the screen:
+// the headers, the rows before the first visible one (skipped), then the
+// visible rows by batches.
+
 bool Image::drawBitmapFromWeb(const char *url, int x, int y, bool dither, bool invert)
 {
+    if (!network_client.openStream(url))
+        return 0;
+
+    bitmapHeader bmpHeader;
+    int32_t first, count;
     bool ret = 0;
-    int32_t defaultLen = e_ink_width * e_ink_height * 4 + 150;
-    uint8_t *buf = network_client.downloadFile(url, &defaultLen);
 
-    ret = drawBitmapFromBuffer(buf, x, y, dither, invert);
-    free(buf);
+    // The file header, the DIB header and the palette, up to the pixels
+
+    uint8_t *header = pixelBuffer;
+    int32_t size = std::min<int32_t>(pixelBufferSize, 14 + 124 + 256 * 4);
+
+    memset(header, 0, size);
+    if (network_client.readStream(header, 14) == 14)
+    {
+        int32_t len = std::min<int32_t>(read32(header + 10), size) - 14;
+        if ((len >= 40) && (network_client.readStream(header + 14, len) == len))
+        {
+            readBmpHeader(header, &bmpHeader);
+            ret = legalBmp(&bmpHeader);
+            size = 14 + len;
+        }
+    }
+
+    if (ret && bmpVisibleRows(bmpHeader.height, y, height(), first, count))
+    {
+        int32_t rowBytes = rowSize(bmpHeader.width, bmpHeader.color);
+
+        prepareBmp(&bmpHeader, dither, invert, ditherMode);
+
+        // Skipped: the rest of an oversized header and the rows out of the screen
+
+        for (int64_t skip = (int64_t)bmpHeader.startRAW - size + (int64_t)first * rowBytes; ret && (skip > 0);)
+        {
+            int32_t len = network_client.readStream(pixelBuffer, std::min<int64_t>(skip, pixelBufferSize));
+            ret = len > 0;
+            skip -= len;
+        }
+
+        ret = ret && drawBmpRows([](uint8_t *buf, int32_t size, int32_t rows) -> int32_t {
+            return network_client.readStream(buf, size * rows) / size;
+        }, &bmpHeader, x, y, first, count, dither);
+    }
 
+    network_client.closeStream();
     return ret;
 }
 
 bool Image::drawBitmapFromBuffer(uint8_t *buf, int x, int y, bool dither, bool invert)
 {
+    return drawBitmapFromBuffer(buf, x, y, dither, invert, ditherMode);
+}
+
+bool Image::drawBitmapFromBuffer(uint8_t *buf, int x, int y, bool dither, bool invert, Dither mode)
+{
+    if (!buf)
+        return 0;
+
     bitmapHeader bmpHeader;
 
     readBmpHeader(buf, &bmpHeader);
@@ -147,127 +295,100 @@ bool Image::drawBitmapFromBuffer(uint8_t *buf, int x, int y, bool dither, bool i
     if (!legalBmp(&bmpHeader))
         return 0;
 
-    if (dither)
-        memset(ditherBuffer, 0, ditherBufferSize);
+    int32_t h = (int32_t)bmpHeader.height;
+    bool topDown = h < 0;
+    if (topDown)
+        h = -h;
+
+    int32_t rowBytes = rowSize(bmpHeader.width, bmpHeader.color);
+
+    prepareBmp(&bmpHeader, dither, invert, mode);
 
     uint8_t *bufferPtr = buf + bmpHeader.startRAW;
-    for (int i = 0; i < bmpHeader.height; ++i)
-    {
-        memcpy(pixelBuffer, bufferPtr, rowSize(bmpHeader.width, bmpHeader.color));
-        displayBmpLine(x, y + bmpHeader.height - i - 1, &bmpHeader, dither, invert);
-        bufferPtr += rowSize(bmpHeader.width, bmpHeader.color);
-    }
+    for (int32_t i = 0; i < h; ++i, bufferPtr += rowBytes)
+        drawBmpRow(x, y + (topDown ? i : h - 1 - i), &bmpHeader, bufferPtr, dither);
 
     return 1;
 }
 
-void Image::displayBmpLine(int16_t x, int16_t y, bitmapHeader *bmpHeader, bool dither, bool invert)
+// Converts the visible part of a pixel row and writes it to the frame buffer.
+// 1 and 4 bit rows are packed as the frame buffer writer expects them: unless
+// dithered, their palette indices are mapped there, a source byte at a time.
+
+void Image::drawBmpRow(int16_t x, int16_t y, bitmapHeader *bmpHeader, const uint8_t *row, bool dither)
 {
-    int16_t w = bmpHeader->width;
-    int8_t c = bmpHeader->color;
+    if (y < 0 || y >= height())
+        return;
+
+    int32_t w = bmpHeader->width;
+    int32_t x0 = std::max(0, -x);
+    int32_t x1 = std::min<int32_t>(w, width() - x);
+    if (x1 <= x0)
+        return;
+
+    int16_t n = x1 - x0;
+    uint8_t c = bmpHeader->color;
 
     startWrite();
-    for (int j = 0; j < w; ++j)
+
+    if (!dither && (c == 1 || c == 4))
+    {
+        writePackedRow(x, y, w, row, c, _bmpLut);
+        endWrite();
+        return;
+    }
+
+    uint8_t *levels = pixelBuffer;
+    bool ordered = dither && ditherTable;
+
+    switch (c)
     {
-        switch (c)
+    case 1:
+    case 4:
+    case 8:
+        for (int i = 0; i < n; i++)
         {
-        case 1:
-            writePixel(x + j, y, (invert ^ (palette[0] > palette[1])) ^ !!(pixelBuffer[j >> 3] & (1 << (7 - (j & 7)))));
-            break;
-        // as for 2 bit, literally cannot find an example online or in PS, so skipped
-        case 4: {
-            uint8_t px = (pixelBuffer[j >> 1] & (j & 1 ? 0x0F : 0xF0)) >> (j & 1 ? 0 : 4);
-            uint8_t val;
-
-            if (dither)
-                val = ditherGetPixelBmp(px, j, w, 1);
-            else
-                val = (palette[px >> 1] & (px & 1 ? 0x0F : 0xF0)) >> (px & 1 ? 0 : 4);
-            if (invert)
-                val = 7 - val;
-            if (getDisplayMode() == DisplayMode::INKPLATE_1BIT)
-                val = (~val >> 2) & 1;
-
-            writePixel(x + j, y, val);
-            break;
+            int32_t j = x0 + i;
+            uint8_t px = (c == 8) ? row[j]
+                       : (c == 4) ? (row[j >> 1] >> (j & 1 ? 0 : 4)) & 0x0F
+                                  : (row[j >> 3] >> (7 - (j & 7))) & 1;
+            levels[i] = !dither ? _bmpLut[px]
+                      : _bmpLevelMap[ordered ? ditherGetPixelOrdered(ditherPalette[px], x + j, y)
+                                             : ditherGetPixelBmp(px, i, n, 1)];
         }
-        case 8: {
-            uint8_t px = pixelBuffer[j];
-            uint8_t val;
-
-            if (dither)
-                val = ditherGetPixelBmp(px, j, w, 1);
-            else
-                val = (palette[px >> 1] & (px & 1 ? 0x0F : 0xF0)) >> (px & 1 ? 0 : 4);
-            if (invert)
-                val = 7 - val;
-            if (getDisplayMode() == DisplayMode::INKPLATE_1BIT)
-                val = (~val >> 2) & 1;
-
-            writePixel(x + j, y, val);
-            break;
-        }
-        case 16: {
-            uint16_t px = ((uint16_t)pixelBuffer[(j << 1) | 1] << 8) | pixelBuffer[(j << 1)];
+        break;
+
+    case 16:
+        for (int i = 0; i < n; i++)
+        {
+            const uint8_t *src = &row[(x0 + i) << 1];
+            uint16_t px = ((uint16_t)src[1] << 8) | src[0];
 
             uint8_t r = (px & 0x7C00) >> 7;
             uint8_t g = (px & 0x3E0) >> 2;
             uint8_t b = (px & 0x1F) << 3;
 
-            uint8_t val;
-
-            if (dither)
-                val = ditherGetPixelBmp(rgb8Bit(r, g, b), j, w, 0);
-            else
-                val = rgb3Bit(r, g, b);
-            if (invert)
-                val = 7 - val;
-            if (getDisplayMode() == DisplayMode::INKPLATE_1BIT)
-                val = (~val >> 2) & 1;
-
-            writePixel(x + j, y, val);
-            break;
-        }
-        case 24: {
-            uint8_t r = pixelBuffer[j * 3];
-            uint8_t g = pixelBuffer[j * 3 + 1];
-            uint8_t b = pixelBuffer[j * 3 + 2];
-
-            uint8_t val;
-
-            if (dither)
-                val = ditherGetPixelBmp(rgb8Bit(r, g, b), j, w, 0);
-            else
-                val = rgb3Bit(r, g, b);
-            if (invert)
-                val = 7 - val;
-            if (getDisplayMode() == DisplayMode::INKPLATE_1BIT)
-                val = (~val >> 2) & 1;
-
-            writePixel(x + j, y, val);
-            break;
-        }
-        case 32:
-            uint8_t r = pixelBuffer[j * 4];
-            uint8_t g = pixelBuffer[j * 4 + 1];
-            uint8_t b = pixelBuffer[j * 4 + 2];
-
-            uint8_t val;
-
-            if (dither)
-                val = ditherGetPixelBmp(rgb8Bit(r, g, b), j, w, 0);
-            else
-                val = rgb3Bit(r, g, b);
-            if (invert)
-                val = 7 - val;
-            if (getDisplayMode() == DisplayMode::INKPLATE_1BIT)
-                val = (~val >> 2) & 1;
-
-            writePixel(x + j, y, val);
-            break;
+            levels[i] = _bmpLevelMap[ordered  ? ditherGetPixelOrdered(rgb8Bit(r, g, b), x + x0 + i, y)
+                                   : dither ? ditherGetPixelBmp(rgb8Bit(r, g, b), i, n, 0)
+                                            : rgb3Bit(r, g, b)];
         }
+        break;
+
+    default: // 24 and 32 bit: blue, green, red (, unused)
+    {
+        uint8_t bytes = c >> 3;
+        const uint8_t *src = &row[x0 * bytes];
+        for (int i = 0; i < n; i++, src += bytes)
+            levels[i] = _bmpLevelMap[ordered  ? ditherGetPixelOrdered(rgb8Bit(src[2], src[1], src[0]), x + x0 + i, y)
+                                   : dither ? ditherGetPixelBmp(rgb8Bit(src[2], src[1], src[0]), i, n, 0)
+                                            : rgb3Bit(src[2], src[1], src[0])];
+        break;
+    }
     }
 
-    ditherSwap(w);
+    writeBlock(x + x0, y, n, 1, levels);
     endWrite();
+
+    if (dither && !ordered)
+        ditherSwap(n);
 }
@@ -16,6 +16,7 @@ Distributed as-is; no warranty is given.
 
 #include "image.hpp"
 #include <algorithm>
+#include <cstring>
 
 uint8_t Image::ditherGetPixelBmp(uint8_t px, int i, int w, bool paletted)
 {
@@ -95,4 +96,71 @@ void Image::ditherSwapBlockJpeg(int x)
                 jpegDitherBuffer[j][i] = 0;
 
     jpegDitherBuffer[17][1] = 0;
-}
\ No newline at end of file
+}
+
+// Ordered dithering thresholds, 0 to 254. Bayer: the classic recursive matrix.
+// Blue noise: ranks of a void-and-cluster pattern (sigma 1.5), scaled, tiling
+// without visible seams.
+
+static const uint8_t bayer8[8 * 8] = {
+      2, 130,  34, 162,  10, 138,  42, 170,
+    194,  66, 226,  98, 202,  74, 234, 106,
+     50, 178,  18, 146,  58, 186,  26, 154,
+    242, 114, 210,  82, 250, 122, 218,  90,
+     14, 142,  46, 174,   6, 134,  38, 166,
+    206,  78, 238, 110, 198,  70, 230, 102,
+     62, 190,  30, 158,  54, 182,  22, 150,
+    254, 126, 222,  94, 246, 118, 214,  86,
+};
+
+static const uint8_t blueNoise16[16 * 16] = {
+    233,  49, 187,  18,  57, 170, 120,  46, 162,   0, 246, 103,  21, 131,  13,  64,
+    208,   7, 117,  96, 239, 204,  22, 227, 137,  63, 122, 169,  71, 223,  98, 148,
+     84, 138, 228, 164,  77, 145, 110,  83, 175, 215,  29, 230, 152, 200,  41, 179,
+     24,  61, 194,  28,  42, 184,   6, 248,  40,  99, 190,  47,  86,   4, 127, 242,
+    220, 151, 100, 252, 129, 219,  58, 199, 155,  11, 135, 111, 254, 173,  68, 108,
+     45, 188,   0,  72, 171,  89, 141, 115,  79, 236, 209,  60, 146,  32, 205, 159,
+     80, 123, 216, 112, 207,  14, 240,  26, 167,  44, 177,  19, 192,  95, 224,  17,
+    241, 163,  59,  34, 156,  52, 180,  67, 222, 104, 124,  82, 235, 130,  54, 140,
+    196,   9, 226, 133, 245,  94, 125, 197, 147,   2, 243, 160,  70,   8, 181, 105,
+     39,  92, 178,  74, 191,   5, 217,  35,  90,  56, 201,  33, 214, 154, 232,  73,
+    251, 119, 149,  23, 109,  62, 165, 118, 231, 182, 132, 102,  48, 116,  30, 166,
+     15, 211,  50, 237, 206, 136, 253,  20,  75, 150,  12, 249, 189,  87, 202, 134,
+    101, 183,  81, 168,  37,  88, 186,  51, 203,  97, 172,  66, 128,   3, 221,  55,
+    229, 143,   1, 126, 225,  10, 153, 113, 238,  38, 218,  27, 234, 144, 174,  76,
+    195,  36, 247,  69, 106, 198,  65, 176,  16, 142, 114, 158,  85,  43, 107,  25,
+    121,  91, 157, 213, 139,  31, 244,  93, 212,  78, 193,  53, 210, 185, 250, 161,
+};
+
+void Image::setDither(Dither d)
+{
+    ditherMode = d;
+}
+
+// Dithering state for a new picture, dithered with mode
+
+void Image::ditherStart(Dither mode)
+{
+    switch (mode)
+    {
+    case Bayer:
+        ditherTable = bayer8;
+        ditherMask = 7;
+        ditherShift = 3;
+        break;
+    case BlueNoise:
+        ditherTable = blueNoise16;
+        ditherMask = 15;
+        ditherShift = 4;
+        break;
+    default:
+        ditherTable = nullptr;
+    }
+
+    bool oneBit = getDisplayMode() == DisplayMode::INKPLATE_1BIT;
+    ditherLevels = oneBit ? 1 : 7;
+    ditherScale = oneBit ? 7 : 1;
+
+    if (!ditherTable)
+        memset(ditherBuffer, 0, ditherBufferSize);
+}
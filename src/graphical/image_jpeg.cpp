@@ -14,8 +14,10 @@ If you have any questions about licensing, please contact techsupport@e-radionic
 Distributed as-is; no warranty is given.
 */
 
+#include <algorithm>
 #include <cstdio>
-#include <sys/stat.h>
+#include <cstdlib>
+#include <cstring>
 
 #include "image.hpp"
 
@@ -34,45 +36,67 @@ bool Image::drawJpegFromFile(const char * fileName, int x, int y, bool dither, b
 }
 
 bool Image::drawJpegFromFile(FILE * p, int x, int y, bool dither, bool invert)
+{
+    return drawJpegFromFile(p, x, y, dither, invert, ditherMode);
+}
+
+bool Image::drawJpegFromFile(FILE * p, int x, int y, bool dither, bool invert, Dither mode)
 {
     uint8_t ret = 0;
 
     blockW = -1;
     blockH = -1;
     lastY = -1;
-    memset(ditherBuffer, 0, ditherBufferSize);
+    ditherStart(mode);
+    memset(jpegDitherBuffer, 0, sizeof(jpegDitherBuffer));
 
     TJpgDec.setJpgScale(1);
-    TJpgDec.setCallback(drawJpegChunk);
-
-    struct stat stat_buf;
-    fstat(fileno(p), &stat_buf);
-    uint32_t total = stat_buf.st_size;
+    TJpgDec.setGrayCallback(drawJpegChunk);
 
-    uint8_t *buff = (uint8_t *)malloc(total);
+    // The file is read as the decoding progresses, JD_SZBUF bytes at a time
 
-    if (buff == NULL) return 0;
-
-    if (fread(buff, total, 1, p) != 1) return 0;
+    if (TJpgDec.drawFsJpg(x, y, p, dither, invert) == 0) ret = 1;
 
     fclose(p);
 
-    if (TJpgDec.drawJpg(x, y, buff, total, dither, invert) == 0) ret = 1;
+    return ret;
+}
 
-    free(buff);
+int32_t Image::readJpegStream(uint8_t *buf, int32_t len)
+{
+    return network_client.readStream(buf, len);
+}
 
-    return ret;
+bool Image::placeJpeg(uint16_t w, uint16_t h)
+{
+    uint16_t posX, posY;
+    _imagePtrJpeg->getPointsForPosition(_imagePtrJpeg->jpegPosition, w, h,
+                                        _imagePtrJpeg->width(), _imagePtrJpeg->height(), &posX, &posY);
+    TJpgDec.jpeg_x = posX;
+    TJpgDec.jpeg_y = posY;
+    return true;
 }
 
 bool Image::drawJpegFromWeb(const char *url, int x, int y, bool dither, bool invert)
 {
     bool ret = 0;
 
-    int32_t defaultLen = e_ink_width * e_ink_height * 4;
-    uint8_t *buff = network_client.downloadFile(url, &defaultLen);
+    if (!network_client.openStream(url)) return 0;
+
+    blockW = -1;
+    blockH = -1;
+    lastY = -1;
+    ditherStart(ditherMode);
+    memset(jpegDitherBuffer, 0, sizeof(jpegDitherBuffer));
+
+    TJpgDec.setJpgScale(1);
+    TJpgDec.setGrayCallback(drawJpegChunk);
+
+    // Decoding starts with the first bytes received, the body is never held in memory
+
+    if (TJpgDec.drawStreamJpg(x, y, readJpegStream, dither, invert) == 0) ret = 1;
 
-    ret = drawJpegFromBuffer(buff, defaultLen, x, y, dither, invert);
-    free(buff);
+    network_client.closeStream();
 
     return ret;
 }
@@ -81,37 +105,213 @@ bool Image::drawJpegFromWebAtPosition(const char *url, const Position& position,
 {
     bool ret = 0;
 
-    int32_t defaultLen = 800 * 600 * 4;
-    uint8_t *buff = network_client.downloadFile(url, &defaultLen);
+    if (!network_client.openStream(url)) return 0;
+
+    blockW = -1;
+    blockH = -1;
+    lastY = -1;
+    ditherStart(ditherMode);
+    memset(jpegDitherBuffer, 0, sizeof(jpegDitherBuffer));
+
+    TJpgDec.setJpgScale(1);
+    TJpgDec.setGrayCallback(drawJpegChunk);
+
+    // The position is computed once the header gives the picture size
+
+    jpegPosition = position;
+    TJpgDec.setPrepareCallback(placeJpeg);
+
+    if (TJpgDec.drawStreamJpg(0, 0, readJpegStream, dither, invert) == 0) ret = 1;
+
+    TJpgDec.setPrepareCallback(nullptr);
+    network_client.closeStream();
+
+    return ret;
+}
+
+bool Image::drawImageToFit(const char *path, int x, int y, int w, int h, bool dither, bool invert)
+{
+    bool web = strncmp(path, "http://", 7) == 0 || strncmp(path, "https://", 8) == 0;
+
+    if (strstr(path, ".jpg") == NULL && strstr(path, ".jpeg") == NULL)
+        return 0;
+
+    jpegFit.boxX = x;
+    jpegFit.boxY = y;
+    jpegFit.boxW = w ? w : width() - x;
+    jpegFit.boxH = h ? h : height() - y;
+    jpegFit.sums = nullptr;
+    jpegFit.colMap = jpegFit.colCount = nullptr;
+
+    if (jpegFit.boxW <= 0 || jpegFit.boxH <= 0)
+        return 0;
+
+    FILE *f = nullptr;
+    if (web ? !network_client.openStream(path) : (f = fopen(path, "r")) == nullptr)
+        return 0;
+
+    ditherStart(ditherMode);
+
+    TJpgDec.setGrayCallback(drawJpegFitChunk);
+    TJpgDec.setPrepareCallback(fitJpeg);
 
-    uint16_t w = 0;
-    uint16_t h = 0;
+    JRESULT r = web ? TJpgDec.drawStreamJpg(0, 0, readJpegStream, dither, invert)
+                    : TJpgDec.drawFsJpg(0, 0, f, dither, invert);
+
+    TJpgDec.setPrepareCallback(nullptr);
     TJpgDec.setJpgScale(1);
-    JRESULT r = TJpgDec.getJpgSize(&w, &h, buff, defaultLen);
-    if(r != JDR_OK) {
-        free(buff);
+
+    if (web)
+        network_client.closeStream();
+    else
+        fclose(f);
+
+    free(jpegFit.sums);
+    free(jpegFit.colMap);
+    free(jpegFit.colCount);
+
+    return r == JDR_OK;
+}
+
+// Output size and decoding scale, from the picture size
+
+bool Image::fitJpeg(uint16_t w, uint16_t h)
+{
+    JpegFit &fit = _imagePtrJpeg->jpegFit;
+
+    if ((uint32_t)w * fit.boxH <= (uint32_t)h * fit.boxW)
+    {
+        fit.h = std::min<int>(h, fit.boxH);
+        fit.w = std::max<int>(1, (uint32_t)w * fit.h / h);
+    }
+    else
+    {
+        fit.w = std::min<int>(w, fit.boxW);
+        fit.h = std::max<int>(1, (uint32_t)h * fit.w / w);
+    }
+
+    uint8_t scale = 0;
+    while (scale < 3 && (w >> (scale + 1)) >= fit.w && (h >> (scale + 1)) >= fit.h)
+        scale++;
+
+    TJpgDec.setJpgScale(1 << scale);
+
+    fit.srcW = w >> scale;
+    fit.srcH = h >> scale;
+    fit.x = fit.boxX + ((fit.boxW - fit.w) >> 1);
+    fit.y = fit.boxY + ((fit.boxH - fit.h) >> 1);
+    fit.nextRow = 0;
+
+    // Output rows touched by one MCU row, plus the one shared with the next MCU row
+
+    fit.rows = (16 >> scale) * fit.h / fit.srcH + 2;
+
+    fit.sums = (uint32_t *)malloc(fit.rows * fit.w * sizeof(uint32_t));
+    fit.colMap = (uint16_t *)malloc(fit.srcW * sizeof(uint16_t));
+    fit.colCount = (uint16_t *)malloc(fit.w * sizeof(uint16_t));
+
+    if (fit.sums == nullptr || fit.colMap == nullptr || fit.colCount == nullptr)
         return false;
+
+    memset(fit.sums, 0, fit.rows * fit.w * sizeof(uint32_t));
+    memset(fit.colCount, 0, fit.w * sizeof(uint16_t));
+    for (uint16_t i = 0; i < fit.srcW; i++)
+    {
+        fit.colMap[i] = (uint32_t)i * fit.w / fit.srcW;
+        fit.colCount[fit.colMap[i]]++;
     }
 
-    uint16_t posX, posY;
-    getPointsForPosition(position, w, h, 800, 600, &posX, &posY);
+    return true;
+}
 
-    ret = drawJpegFromBuffer(buff, defaultLen, posX, posY, dither, invert);
-    free(buff);
+bool Image::drawJpegFitChunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t *bitmap, bool dither, bool invert)
+{
+    if (!_imagePtrJpeg)
+        return 0;
 
-    return ret;
+    JpegFit &fit = _imagePtrJpeg->jpegFit;
+
+    for (int j = 0; j < h; ++j)
+    {
+        uint32_t *sums = &fit.sums[((uint32_t)(y + j) * fit.h / fit.srcH % fit.rows) * fit.w];
+        for (int i = 0; i < w; ++i)
+        {
+            sums[fit.colMap[x + i]] += bitmap[j * w + i];
+        }
+    }
+
+    // At the end of an MCU row, draw the output rows that are complete
+
+    if (x + w >= fit.srcW)
+    {
+        uint16_t last = (y + h >= fit.srcH) ? fit.h : (uint32_t)(y + h) * fit.h / fit.srcH;
+
+        _imagePtrJpeg->startWrite();
+        while (fit.nextRow < last)
+            _imagePtrJpeg->drawJpegFitRow(fit.nextRow++, dither, invert);
+        _imagePtrJpeg->endWrite();
+    }
+
+    return 1;
+}
+
+void Image::drawJpegFitRow(uint16_t row, bool dither, bool invert)
+{
+    JpegFit &fit = jpegFit;
+
+    uint32_t *sums = &fit.sums[(row % fit.rows) * fit.w];
+    uint8_t *levels = pixelBuffer;
+
+    // Source rows summed in this output row
+
+    uint16_t rowCount = ((uint32_t)(row + 1) * fit.srcH + fit.h - 1) / fit.h - ((uint32_t)row * fit.srcH + fit.h - 1) / fit.h;
+
+    // Final value of each 3 bit level: inverted, and reduced to 1 bit in 1 bit mode
+
+    bool oneBit = getDisplayMode() == DisplayMode::INKPLATE_1BIT;
+    uint8_t levelMap[8];
+    for (int v = 0; v < 8; v++)
+    {
+        uint8_t val = invert ? 7 - v : v;
+        levelMap[v] = oneBit ? (~val >> 2) & 1 : val;
+    }
+
+    bool ordered = dither && ditherTable;
+
+    for (int i = 0; i < fit.w; ++i)
+    {
+        uint32_t count = (uint32_t)fit.colCount[i] * rowCount;
+        uint8_t gray = (sums[i] + (count >> 1)) / count;
+
+        levels[i] = levelMap[ordered  ? ditherGetPixelOrdered(gray, fit.x + i, fit.y + row)
+                           : dither ? ditherGetPixelBmp(gray, i, fit.w, 0)
+                                    : gray >> 5];
+        sums[i] = 0;
+    }
+
+    writeBlock(fit.x, fit.y + row, fit.w, 1, levels);
+
+    if (dither && !ordered)
+        ditherSwap(fit.w);
 }
 
 bool Image::drawJpegFromBuffer(uint8_t *buff, int32_t len, int x, int y, bool dither, bool invert)
+{
+    return drawJpegFromBuffer(buff, len, x, y, dither, invert, ditherMode);
+}
+
+bool Image::drawJpegFromBuffer(uint8_t *buff, int32_t len, int x, int y, bool dither, bool invert, Dither mode)
 {
     bool ret = 0;
 
     blockW = -1;
     blockH = -1;
     lastY = -1;
+    ditherStart(mode);
+    memset(jpegDitherBuffer, 0, sizeof(jpegDitherBuffer));
 
     TJpgDec.setJpgScale(1);
-    TJpgDec.setCallback(drawJpegChunk);
+    TJpgDec.setGrayCallback(drawJpegChunk);
 
     int err = TJpgDec.drawJpg(x, y, buff, len, dither, invert);
     if (err == 0)
@@ -120,38 +320,65 @@ bool Image::drawJpegFromBuffer(uint8_t *buff, int32_t len, int x, int y, bool di
     return ret;
 };
 
-bool Image::drawJpegChunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap, bool dither, bool invert)
+// Converts a whole decoded block (one MCU at most, 16x16, of 8 bit gray
+// values) to pixel values, written to the frame buffer in one clipped copy.
+
+bool Image::drawJpegChunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t *bitmap, bool dither, bool invert)
 {
-    if (!_imagePtrJpeg)
+    Image *image = _imagePtrJpeg;
+
+    if (!image)
+        return 0;
+
+    uint8_t levels[16 * 16];
+    if (w * h > (int)sizeof(levels))
         return 0;
 
-    if (dither && y != _imagePtrJpeg->lastY)
+    // Error diffusion carries state from block to block, ordered dithering doesn't
+
+    bool diffuse = dither && !image->ditherTable;
+
+    if (diffuse && y != image->lastY)
     {
-        _imagePtrJpeg->ditherSwap(e_ink.get_width());
-        _imagePtrJpeg->lastY = y;
+        image->ditherSwap(e_ink.get_width());
+        image->lastY = y;
     }
 
-    _imagePtrJpeg->startWrite();
-    for (int j = 0; j < h; ++j)
+    // Final value of each 3 bit level: inverted, and reduced to 1 bit in 1 bit mode
+
+    bool oneBit = image->getDisplayMode() == DisplayMode::INKPLATE_1BIT;
+    uint8_t levelMap[8];
+    for (int v = 0; v < 8; v++)
     {
-        for (int i = 0; i < w; ++i)
-        {
-            uint16_t rgb = bitmap[j * w + i];
-            uint8_t val;
-            if (dither)
-                val = _imagePtrJpeg->ditherGetPixelJpeg(rgb8Bit(red(rgb), green(rgb), blue(rgb)), i, j, x, y, w, h);
-            else
-                val = rgb3Bit(red(rgb), green(rgb), blue(rgb));
-            if (invert)
-                val = 7 - val;
-            if (_imagePtrJpeg->getDisplayMode() == DisplayMode::INKPLATE_1BIT)
-                val = (~val >> 2) & 1;
-            _imagePtrJpeg->writePixel(x + i, y + j, val);
-        }
+        uint8_t val = invert ? 7 - v : v;
+        levelMap[v] = oneBit ? (~val >> 2) & 1 : val;
     }
-    if (dither)
-        _imagePtrJpeg->ditherSwapBlockJpeg(x);
-    _imagePtrJpeg->endWrite();
+
+    uint8_t *out = levels;
+    if (dither && !diffuse)
+    {
+        for (int j = 0; j < h; ++j)
+            for (int i = 0; i < w; ++i)
+                *out++ = levelMap[image->ditherGetPixelOrdered(*bitmap++, x + i, y + j)];
+    }
+    else if (dither)
+    {
+        for (int j = 0; j < h; ++j)
+            for (int i = 0; i < w; ++i)
+                *out++ = levelMap[image->ditherGetPixelJpeg(*bitmap++, i, j, x, y, w, h)];
+    }
+    else
+    {
+        for (int n = w * h; n > 0; n--)
+            *out++ = levelMap[*bitmap++ >> 5];
+    }
+
+    image->startWrite();
+    image->writeBlock(x, y, w, h, levels);
+    image->endWrite();
+
+    if (diffuse)
+        image->ditherSwapBlockJpeg(x);
 
     return 1;
 }
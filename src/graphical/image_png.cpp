@@ -13,6 +13,7 @@ Distributed as-is; no warranty is given.
 */
 
 #include <cstdio>
+#include <cstring>
 #include <algorithm>
 
 #include "image.hpp"
@@ -20,113 +21,288 @@ Distributed as-is; no warranty is given.
 #include "pngle.hpp"
 #include "network_client.hpp"
 
-#include <sys/stat.h>
-
 extern Image *_imagePtrPng;
 
 static bool _pngInvert = 0;
 static bool _pngDither = 0;
-static int16_t lastY = -1;
+static bool _pngOrdered = 0;
+static bool _pngDone = 0;
+static int8_t _pngPacked = -1;
+static uint8_t _pngLut[16];
+static int16_t _pngLastY = -1;
 static int16_t _pngX = 0;
 static int16_t _pngY = 0;
 
-void pngle_on_draw(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t rgba[4])
+// Interlaced pictures only: the other ones are drawn a row at a time by drawPngRow().
+// Each pixel of a pass fills the block, up to 8 x 8, left for the next passes.
+// The block is written by a single writeBlock().
+
+void Image::drawPngBlock(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t rgba[4])
 {
-    if (rgba[3])
+    if (rgba[3] && w <= 8 && h <= 8)
+    {
+        bool oneBit = _imagePtrPng->getDisplayMode() == DisplayMode::INKPLATE_1BIT;
+        uint8_t levels[8 * 8];
         for (int j = 0; j < h; ++j)
             for (int i = 0; i < w; ++i)
             {
                 uint8_t px = Image::rgb3Bit(rgba[0], rgba[1], rgba[2]);
-                if (_pngDither)
+                if (_pngDither && _pngOrdered)
+                    px = _imagePtrPng->ditherGetPixelOrdered(Image::rgb8Bit(rgba[0], rgba[1], rgba[2]), _pngX + x + i,
+                                                             _pngY + y + j);
+                else if (_pngDither)
                     px = _imagePtrPng->ditherGetPixelBmp(Image::rgb8Bit(rgba[0], rgba[1], rgba[2]), x + i,
                                                          _imagePtrPng->width(), 0);
                 if (_pngInvert)
                     px = 7 - px;
-                if (_imagePtrPng->getDisplayMode() == DisplayMode::INKPLATE_1BIT)
+                if (oneBit)
                     px = (~px >> 2) & 1;
-                _imagePtrPng->drawPixel(_pngX + x + i, _pngY + y + j, px);
+                levels[j * w + i] = px;
             }
-    if (lastY != y)
+        _imagePtrPng->startWrite();
+        _imagePtrPng->writeBlock(_pngX + x, _pngY + y, w, h, levels);
+        _imagePtrPng->endWrite();
+    }
+    if (_pngLastY != y && !_pngOrdered)
     {
-        lastY = y;
+        _pngLastY = y;
         _imagePtrPng->ditherSwap(_imagePtrPng->width());
     }
 }
 
-bool Image::drawPngFromFile(const char * fileName, int x, int y, bool dither, bool invert)
+static void pngle_on_done(pngle_t *pngle)
 {
-    FILE * dat = fopen(fileName, "r");
-    if (dat) {
-        return drawPngFromFile(dat, x, y, dither, invert);
+    _pngDone = 1;
+}
+
+// 1, 2 and 4 bit gray or palette pictures without transparency, not dithered,
+// have their scanlines written as they come out of the decoder: the pixel
+// value of each possible sample is computed once, in lut.
+
+static bool pngPackedLut(pngle_t *pngle, const uint8_t levelMap[8], uint8_t lut[16])
+{
+    pngle_ihdr_t *ihdr = pngle_get_ihdr(pngle);
+    if (_pngDither || !ihdr || ihdr->depth > 4 || (ihdr->color_type != 0 && ihdr->color_type != 3))
+        return 0;
+
+    for (int v = 0; v < (1 << ihdr->depth); v++)
+    {
+        uint8_t sample = v << (8 - ihdr->depth), rgba[4];
+        if (pngle_row_to_rgba(pngle, &sample, 0, 1, rgba) < 0)
+        {
+            lut[v] = 0; // Past the end of a short palette: not used by a valid picture
+            continue;
+        }
+        if (!rgba[3])
+            return 0;
+        lut[v] = levelMap[Image::rgb3Bit(rgba[0], rgba[1], rgba[2])];
     }
-    return 0;
+    return 1;
 }
 
-bool Image::drawPngFromFile(FILE * p, int x, int y, bool dither, bool invert)
+// Converts the visible part of a complete scanline and writes it to the frame
+// buffer, in runs of opaque pixels.
+
+void Image::drawPngRow(pngle_t *pngle, uint32_t y, const uint8_t *row, size_t len)
 {
-    _pngDither = dither;
-    _pngInvert = invert;
-    lastY = y;
+    Image *image = _imagePtrPng;
 
-    bool ret = 1;
+    int16_t py = _pngY + y;
+    if (py < 0 || py >= image->height())
+        return;
 
-    if (dither) memset(ditherBuffer, 0, ditherBufferSize);
+    int32_t x0 = std::max(0, -_pngX);
+    int32_t x1 = std::min<int32_t>(pngle_get_width(pngle), image->width() - _pngX);
+    if (x1 <= x0)
+        return;
 
-    pngle_t *pngle = pngle_new();
+    int16_t n = x1 - x0;
+
+    bool oneBit = image->getDisplayMode() == DisplayMode::INKPLATE_1BIT;
+    uint8_t levelMap[8];
+    for (int v = 0; v < 8; v++)
+    {
+        uint8_t val = _pngInvert ? 7 - v : v;
+        levelMap[v] = oneBit ? (~val >> 2) & 1 : val;
+    }
+
+    if (_pngPacked < 0)
+        _pngPacked = pngPackedLut(pngle, levelMap, _pngLut);
+    if (_pngPacked)
+    {
+        image->startWrite();
+        image->writePackedRow(_pngX, py, pngle_get_width(pngle), row, pngle_get_ihdr(pngle)->depth, _pngLut);
+        image->endWrite();
+        return;
+    }
+
+    // The RGBA values are replaced in place by the pixel values, 0xFF when transparent
+
+    uint8_t *levels = image->pixelBuffer;
+    if (pngle_row_to_rgba(pngle, row, x0, n, levels) < 0)
+        return;
+
+    const uint8_t *rgba = levels;
+    for (int i = 0; i < n; i++, rgba += 4)
+    {
+        if (!rgba[3])
+            levels[i] = 0xFF;
+        else if (_pngDither && _pngOrdered)
+            levels[i] = levelMap[image->ditherGetPixelOrdered(rgb8Bit(rgba[0], rgba[1], rgba[2]), _pngX + x0 + i, py)];
+        else if (_pngDither)
+            levels[i] = levelMap[image->ditherGetPixelBmp(rgb8Bit(rgba[0], rgba[1], rgba[2]), i, n, 0)];
+        else
+            levels[i] = levelMap[rgb3Bit(rgba[0], rgba[1], rgba[2])];
+    }
+
+    image->startWrite();
+    for (int i = 0; i < n;)
+    {
+        while (i < n && levels[i] == 0xFF)
+            i++;
+        int start = i;
+        while (i < n && levels[i] != 0xFF)
+            i++;
+        if (i > start)
+            image->writeBlock(_pngX + x0 + start, py, i - start, 1, &levels[start]);
+    }
+    image->endWrite();
+
+    if (_pngDither && !_pngOrdered)
+        image->ditherSwap(n);
+}
+
+// Feeds the decoder as the data is read, keeping the bytes it can't use yet
+// (e.g. a chunk header split between two reads) for the next round.
+
+template <typename Reader> static bool feedPng(pngle_t *pngle, Reader read)
+{
+    uint8_t buff[2048];
+    size_t kept = 0;
+
+    for (;;)
+    {
+        int32_t len = read(buff + kept, sizeof(buff) - kept);
+        if (len <= 0)
+            return len == 0 && _pngDone;
+
+        kept += len;
+        int fed = pngle_feed(pngle, buff, kept);
+        if (fed < 0)
+            return 0;
+
+        kept -= fed;
+        memmove(buff, buff + fed, kept);
+    }
+}
+
+static pngle_t *newPng(int x, int y, bool dither, bool invert, Image::Dither mode)
+{
+    _pngDither = dither;
+    _pngOrdered = dither && mode != Image::FloydSteinberg;
+    _pngInvert = invert;
+    _pngDone = 0;
+    _pngPacked = -1;
     _pngX = x;
     _pngY = y;
-    pngle_set_draw_callback(pngle, pngle_on_draw);
+    _pngLastY = y;
 
-    struct stat stat_buf;
-    fstat(fileno(p), &stat_buf);
-    uint32_t total = stat_buf.st_size;
+    pngle_t *pngle = pngle_new();
+    if (pngle)
+    {
+        pngle_set_done_callback(pngle, pngle_on_done);
+    }
+    return pngle;
+}
 
-    uint8_t buff[2048];
-        
-    uint32_t toread = total;
+bool Image::drawPngFromFile(const char * fileName, int x, int y, bool dither, bool invert)
+{
+    FILE * dat = fopen(fileName, "r");
+    if (dat) {
+        return drawPngFromFile(dat, x, y, dither, invert);
+    }
+    return 0;
+}
+
+bool Image::drawPngFromFile(FILE * p, int x, int y, bool dither, bool invert)
+{
+    return drawPngFromFile(p, x, y, dither, invert, ditherMode);
+}
+
+bool Image::drawPngFromFile(FILE * p, int x, int y, bool dither, bool invert, Dither mode)
+{
+    if (dither) ditherStart(mode);
 
-    while (toread > 0)
+    pngle_t *pngle = newPng(x, y, dither, invert, mode);
+    if (!pngle)
     {
-      int len = fread(buff, std::min((uint32_t)2048, toread), 1, p);
-      if (pngle_feed(pngle, buff, len) < 0) {
-          ret = 0;
-          break;
-      }
-      toread -= len;
+        fclose(p);
+        return 0;
     }
+    pngle_set_draw_callback(pngle, drawPngBlock);
+    pngle_set_row_callback(pngle, drawPngRow);
+
+    bool ret = feedPng(pngle, [p](uint8_t *buf, int32_t len) -> int32_t {
+        size_t size = fread(buf, 1, len, p);
+        return (size == 0 && ferror(p)) ? -1 : size;
+    });
 
     fclose(p);
     pngle_destroy(pngle);
     return ret;
 }
 
-bool Image::drawPngFromWeb(const char *url, int x, int y, bool dither, bool invert)
+bool Image::drawPngFromBuffer(const uint8_t *buf, int32_t len, int x, int y, bool dither, bool invert)
 {
-    _pngDither = dither;
-    _pngInvert = invert;
-    lastY = y;
-
-    bool ret = 1;
+    return drawPngFromBuffer(buf, len, x, y, dither, invert, ditherMode);
+}
 
+bool Image::drawPngFromBuffer(const uint8_t *buf, int32_t len, int x, int y, bool dither, bool invert, Dither mode)
+{
     if (dither)
-        memset(ditherBuffer, 0, ditherBufferSize);
+        ditherStart(mode);
 
-    pngle_t *pngle = pngle_new();
-    _pngX = x;
-    _pngY = y;
-    pngle_set_draw_callback(pngle, pngle_on_draw);
+    pngle_t *pngle = newPng(x, y, dither, invert, mode);
+    if (!pngle)
+        return 0;
+    pngle_set_draw_callback(pngle, drawPngBlock);
+    pngle_set_row_callback(pngle, drawPngRow);
 
-    int32_t defaultLen = e_ink_width * e_ink_height * 4 + 100;
-    uint8_t *buff = network_client.downloadFile(url, &defaultLen);
+    bool ret = feedPng(pngle, [&buf, &len](uint8_t *dst, int32_t size) -> int32_t {
+        size = std::min(size, len);
+        memcpy(dst, buf, size);
+        buf += size;
+        len -= size;
+        return size;
+    });
 
-    if (!buff)
+    pngle_destroy(pngle);
+    return ret;
+}
+
+bool Image::drawPngFromWeb(const char *url, int x, int y, bool dither, bool invert)
+{
+    if (!network_client.openStream(url))
         return 0;
 
-    if (pngle_feed(pngle, buff, defaultLen) < 0)
-        ret = 0;
+    if (dither)
+        ditherStart(ditherMode);
+
+    pngle_t *pngle = newPng(x, y, dither, invert, ditherMode);
+    if (!pngle)
+    {
+        network_client.closeStream();
+        return 0;
+    }
+    pngle_set_draw_callback(pngle, drawPngBlock);
+    pngle_set_row_callback(pngle, drawPngRow);
+
+    // Rows are drawn as the body is received, the file is never held in memory
+
+    bool ret = feedPng(pngle, [](uint8_t *buf, int32_t len) { return network_client.readStream(buf, len); });
 
+    network_client.closeStream();
     pngle_destroy(pngle);
-    free(buff);
     return ret;
 }
 
@@ -0,0 +1,112 @@
+/*
+image_raw.cpp
+Inkplate 6 ESP-IDF
+
+Raw pictures (see raw_image.hpp), loaded straight into the frame buffer.
+
+This code is released under the GNU Lesser General Public License v3.0: https://www.gnu.org/licenses/lgpl-3.0.en.html
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include "image.hpp"
+#include "raw_image.hpp"
+#include "network_client.hpp"
+
+// Reads exactly len bytes
+
+template <typename Reader> static bool readAll(Reader read, uint8_t *buf, int32_t len)
+{
+    while (len > 0)
+    {
+        int32_t got = read(buf, len);
+        if (got <= 0)
+            return 0;
+        buf += got;
+        len -= got;
+    }
+    return 1;
+}
+
+// Reads the picture data into the frame buffer. Uncompressed data is read in
+// place, in as few reads as the source allows. RLE data is expanded as it is
+// received.
+
+template <typename Reader> static bool readRaw(Reader read, const RawImageHeader &header, uint8_t *data, int32_t size)
+{
+    if (header.compression == RawImageHeader::NONE)
+        return (header.size == (uint32_t)size) && readAll(read, data, size);
+
+    uint8_t buff[2048];
+    int32_t left = header.size; // Compressed bytes not read yet
+    uint8_t *end = data + size;
+    RawRleDecoder decoder;
+
+    while (data < end)
+    {
+        int32_t len = (left > 0) ? read(buff, std::min<int32_t>(sizeof(buff), left)) : 0;
+        if (len <= 0)
+            return 0;
+        left -= len;
+        data = decoder.expand(buff, len, data, end);
+    }
+    return 1;
+}
+
+template <typename Reader> bool Image::drawRaw(Reader read)
+{
+    uint8_t buf[RawImageHeader::SIZE];
+    RawImageHeader header;
+
+    if (!readAll(read, buf, sizeof(buf)) || !header.parse(buf))
+        return 0;
+
+    uint8_t *data = rawFrameBuffer(header.bits, header.width, header.height);
+    if (!data)
+        return 0;
+
+    return readRaw(read, header, data, RawImageHeader::data_size(header.width, header.height, header.bits));
+}
+
+bool Image::drawRawFromFile(const char *fileName)
+{
+    FILE *dat = fopen(fileName, "r");
+    if (dat)
+        return drawRawFromFile(dat);
+    return 0;
+}
+
+bool Image::drawRawFromFile(FILE *p)
+{
+    bool ret = drawRaw([p](uint8_t *buf, int32_t len) -> int32_t {
+        size_t size = fread(buf, 1, len, p);
+        return (size == 0 && ferror(p)) ? -1 : size;
+    });
+
+    fclose(p);
+    return ret;
+}
+
+bool Image::drawRawFromBuffer(const uint8_t *buf, int32_t size)
+{
+    return drawRaw([&buf, &size](uint8_t *dst, int32_t len) -> int32_t {
+        len = std::min(len, size);
+        memcpy(dst, buf, len);
+        buf += len;
+        size -= len;
+        return len;
+    });
+}
+
+bool Image::drawRawFromWeb(const char *url)
+{
+    if (!network_client.openStream(url))
+        return 0;
+
+    bool ret = drawRaw([](uint8_t *buf, int32_t len) { return network_client.readStream(buf, len); });
+
+    network_client.closeStream();
+    return ret;
+}
@@ -105,6 +105,12 @@ struct _pngle_t {
 	uint32_t drawing_x;
 	uint32_t drawing_y;
 
+	// row decoder (non interlaced images with a row callback)
+	uint8_t *row_buf; // previous and current rows, each preceded by bytes_per_pixel zeros
+	size_t row_stride;
+	size_t row_pos;
+	uint_fast8_t row_current;
+
 	// interlace
 	uint_fast8_t interlace_pass;
 
@@ -118,6 +124,7 @@ struct _pngle_t {
 	pngle_init_callback_t init_callback;
 	pngle_draw_callback_t draw_callback;
 	pngle_done_callback_t done_callback;
+	pngle_row_callback_t row_callback;
 
 	void *user_data;
 };
@@ -161,6 +168,7 @@ void pngle_reset(pngle_t *pngle)
 	pngle->error = "No error";
 
 	if (pngle->scanline_ringbuf) free(pngle->scanline_ringbuf);
+	if (pngle->row_buf) free(pngle->row_buf);
 	if (pngle->palette) free(pngle->palette);
 	if (pngle->trans_palette) free(pngle->trans_palette);
 #ifndef PNGLE_NO_GAMMA_CORRECTION
@@ -168,6 +176,7 @@ void pngle_reset(pngle_t *pngle)
 #endif
 
 	pngle->scanline_ringbuf = NULL;
+	pngle->row_buf = NULL;
 	pngle->palette = NULL;
 	pngle->trans_palette = NULL;
 #ifndef PNGLE_NO_GAMMA_CORRECTION
@@ -288,12 +297,68 @@ static inline uint16_t get_value(pngle_t *pngle, size_t *ridx, int *bitcount, in
 	return v;
 }
 
+// Samples of a pixel (v, one per channel) to 8 bit R, G, B, A
+static int pngle_to_rgba(pngle_t *pngle, uint16_t v[4], uint8_t rgba[4])
+{
+	uint8_t pixel_depth = (pngle->hdr.color_type & 1) ? 8 : pngle->hdr.depth;
+	uint16_t maxval = (1UL << pixel_depth) - 1;
+
+	// color type: 0000 0111
+	//                     ^-- indexed color (palette)
+	//                    ^--- Color
+	//                   ^---- Alpha channel
+
+	if (pngle->hdr.color_type & 2) {
+		// color
+		if (pngle->hdr.color_type & 1) {
+			// indexed color: type 3
+
+			// lookup palette info
+			uint16_t pidx = v[0];
+			if (pidx >= pngle->n_palettes) return PNGLE_ERROR("Color index is out of range");
+
+			v[0] = pngle->palette[pidx * 3 + 0];
+			v[1] = pngle->palette[pidx * 3 + 1];
+			v[2] = pngle->palette[pidx * 3 + 2];
+
+			// tRNS as an indexed alpha value table (for color type 3)
+			v[3] = pidx < pngle->n_trans_palettes ? pngle->trans_palette[pidx] : maxval;
+		} else {
+			// true color: 2, and 6
+			v[3] = (pngle->hdr.color_type & 4) ? v[3] : is_trans_color(pngle, v, 3) ? 0 : maxval;
+		}
+	} else {
+		// alpha, tRNS, or opaque
+		v[3] = (pngle->hdr.color_type & 4) ? v[1] : is_trans_color(pngle, v, 1) ? 0 : maxval;
+
+		// monochrome
+		v[1] = v[2] = v[0];
+	}
+
+	if (maxval == 255) {
+		rgba[0] = v[0]; rgba[1] = v[1]; rgba[2] = v[2]; rgba[3] = v[3];
+	} else {
+		rgba[0] = (uint8_t)((v[0] * 255 + maxval / 2) / maxval);
+		rgba[1] = (uint8_t)((v[1] * 255 + maxval / 2) / maxval);
+		rgba[2] = (uint8_t)((v[2] * 255 + maxval / 2) / maxval);
+		rgba[3] = (uint8_t)((v[3] * 255 + maxval / 2) / maxval);
+	}
+
+#ifndef PNGLE_NO_GAMMA_CORRECTION
+	if (pngle->gamma_table) {
+		for (int i = 0; i < 3; i++) {
+			rgba[i] = pngle->gamma_table[v[i]];
+		}
+	}
+#endif
+
+	return 0;
+}
+
 static int pngle_draw_pixels(pngle_t *pngle, size_t scanline_ringbuf_xidx)
 {
 	uint16_t v[4]; // MAX_CHANNELS
 	int bitcount = 0;
-	uint8_t pixel_depth = (pngle->hdr.color_type & 1) ? 8 : pngle->hdr.depth;
-	uint16_t maxval = (1UL << pixel_depth) - 1;
 
 	int n_pixels = pngle->hdr.depth == 16 ? 1 : (8 / pngle->hdr.depth);
 
@@ -302,53 +367,10 @@ static int pngle_draw_pixels(pngle_t *pngle, size_t scanline_ringbuf_xidx)
 			v[c] = get_value(pngle, &scanline_ringbuf_xidx, &bitcount, pngle->hdr.depth);
 		}
 
-		// color type: 0000 0111
-		//                     ^-- indexed color (palette)
-		//                    ^--- Color
-		//                   ^---- Alpha channel
-
-		if (pngle->hdr.color_type & 2) {
-			// color
-			if (pngle->hdr.color_type & 1) {
-				// indexed color: type 3
-
-				// lookup palette info
-				uint16_t pidx = v[0];
-				if (pidx >= pngle->n_palettes) return PNGLE_ERROR("Color index is out of range");
-
-				v[0] = pngle->palette[pidx * 3 + 0];
-				v[1] = pngle->palette[pidx * 3 + 1];
-				v[2] = pngle->palette[pidx * 3 + 2];
-
-				// tRNS as an indexed alpha value table (for color type 3)
-				v[3] = pidx < pngle->n_trans_palettes ? pngle->trans_palette[pidx] : maxval;
-			} else {
-				// true color: 2, and 6
-				v[3] = (pngle->hdr.color_type & 4) ? v[3] : is_trans_color(pngle, v, 3) ? 0 : maxval;
-			}
-		} else {
-			// alpha, tRNS, or opaque
-			v[3] = (pngle->hdr.color_type & 4) ? v[1] : is_trans_color(pngle, v, 1) ? 0 : maxval;
-
-			// monochrome
-			v[1] = v[2] = v[0];
-		}
-
 		if (pngle->draw_callback) {
-			uint8_t rgba[4] = {
-				(uint8_t)((v[0] * 255 + maxval / 2) / maxval),
-				(uint8_t)((v[1] * 255 + maxval / 2) / maxval),
-				(uint8_t)((v[2] * 255 + maxval / 2) / maxval),
-				(uint8_t)((v[3] * 255 + maxval / 2) / maxval)
-			};
+			uint8_t rgba[4];
 
-#ifndef PNGLE_NO_GAMMA_CORRECTION
-			if (pngle->gamma_table) {
-				for (int i = 0; i < 3; i++) {
-					rgba[i] = pngle->gamma_table[v[i]];
-				}
-			}
-#endif
+			if (pngle_to_rgba(pngle, v, rgba) < 0) return -1;
 
 			pngle->draw_callback(pngle, pngle->drawing_x, pngle->drawing_y
 				, std::min(interlace_div_x[pngle->interlace_pass] - interlace_off_x[pngle->interlace_pass], pngle->hdr.width  - pngle->drawing_x)
@@ -361,6 +383,28 @@ static int pngle_draw_pixels(pngle_t *pngle, size_t scanline_ringbuf_xidx)
 	return 0;
 }
 
+int pngle_row_to_rgba(pngle_t *pngle, const uint8_t *row, uint32_t x, uint32_t n, uint8_t *rgba)
+{
+	uint16_t v[4]; // MAX_CHANNELS
+	uint8_t depth = pngle->hdr.depth;
+	uint8_t mask = (1UL << depth) - 1;
+	uint32_t bit = x * pngle->channels * depth;
+
+	for (; n-- > 0; rgba += 4) {
+		for (uint_fast8_t c = 0; c < pngle->channels; c++, bit += depth) {
+			const uint8_t *p = row + (bit >> 3);
+			switch (depth) {
+			case 16: v[c] = p[0] * 0x100 + p[1]; break;
+			case 8:  v[c] = p[0]; break;
+			default: v[c] = (p[0] >> (8 - depth - (bit & 7))) & mask; break; // 1, 2, 4
+			}
+		}
+		if (pngle_to_rgba(pngle, v, rgba) < 0) return -1;
+	}
+
+	return 0;
+}
+
 static inline int paeth(int a, int b, int c)
 {
 	int p = a + b - c;
@@ -381,11 +425,21 @@ static int set_interlace_pass(pngle_t *pngle, uint_fast8_t pass)
 	size_t scanline_pixels = (pngle->hdr.width - interlace_off_x[pngle->interlace_pass] + interlace_div_x[pngle->interlace_pass] - 1) / interlace_div_x[pngle->interlace_pass];
 	size_t scanline_stride = (scanline_pixels * pngle->channels * pngle->hdr.depth + 7) / 8;
 
-	pngle->scanline_ringbuf_size = scanline_stride + bytes_per_pixel * 2; // 2 rooms for c/x and a
-
-	if (pngle->scanline_ringbuf) free(pngle->scanline_ringbuf);
-  pngle->scanline_ringbuf = PNGLE_CALLOC(pngle->scanline_ringbuf_size, 1, "scanline ringbuf");
-	if (!pngle->scanline_ringbuf) return PNGLE_ERROR("Insufficient memory");
+	if (pass == 0 && pngle->row_callback) {
+		// Whole rows: the previous one is the "up" row of the current one
+		pngle->row_stride = scanline_stride;
+		pngle->row_pos = 0;
+		pngle->row_current = 0;
+		if (pngle->row_buf) free(pngle->row_buf);
+		pngle->row_buf = PNGLE_CALLOC(2, scanline_stride + bytes_per_pixel, "row buffers");
+		if (!pngle->row_buf) return PNGLE_ERROR("Insufficient memory");
+	} else {
+		pngle->scanline_ringbuf_size = scanline_stride + bytes_per_pixel * 2; // 2 rooms for c/x and a
+
+		if (pngle->scanline_ringbuf) free(pngle->scanline_ringbuf);
+		pngle->scanline_ringbuf = PNGLE_CALLOC(pngle->scanline_ringbuf_size, 1, "scanline ringbuf");
+		if (!pngle->scanline_ringbuf) return PNGLE_ERROR("Insufficient memory");
+	}
 
 	pngle->drawing_x = interlace_off_x[pngle->interlace_pass];
 	pngle->drawing_y = interlace_off_y[pngle->interlace_pass];
@@ -423,8 +477,62 @@ static int setup_gamma_table(pngle_t *pngle, uint32_t png_gamma)
 }
 
 
+// Non interlaced image with a row callback: the filters are reversed on runs of
+// bytes of the current row, which is handed over once complete.
+static int pngle_on_rows(pngle_t *pngle, const uint8_t *p, int len)
+{
+	const uint8_t *ep = p + len;
+
+	size_t bpp = (pngle->channels * pngle->hdr.depth + 7) / 8; // 1 if depth <= 8
+	size_t size = pngle->row_stride + bpp;
+
+	while (p < ep) {
+		if (pngle->drawing_y >= pngle->hdr.height) return len; // Do nothing further
+
+		if (pngle->filter_type < 0) {
+			if (*p > 4) {
+				debug_printf("[pngle] Invalid filter type is found; 0x%02x\n", *p);
+				return PNGLE_ERROR("Invalid filter type is found");
+			}
+			pngle->filter_type = (int_fast8_t)*p++; // 0 - 4
+			pngle->row_pos = 0;
+			continue;
+		}
+
+		uint8_t *cur = pngle->row_buf + pngle->row_current * size + bpp + pngle->row_pos;
+		uint8_t *up  = pngle->row_buf + (pngle->row_current ^ 1) * size + bpp + pngle->row_pos;
+		size_t n = std::min((size_t)(ep - p), pngle->row_stride - pngle->row_pos);
+		size_t i;
+
+		// Reverse the filter (the bpp bytes before a row are zeros)
+		switch (pngle->filter_type) {
+		case 0: memcpy(cur, p, n); break; // None
+		case 1: for (i = 0; i < n; i++) cur[i] = p[i] + cur[i - bpp]; break; // Sub
+		case 2: for (i = 0; i < n; i++) cur[i] = p[i] + up[i]; break; // Up
+		case 3: for (i = 0; i < n; i++) cur[i] = p[i] + ((cur[i - bpp] + up[i]) >> 1); break; // Average
+		case 4: for (i = 0; i < n; i++) cur[i] = p[i] + paeth(cur[i - bpp], up[i], up[i - bpp]); break; // Paeth
+		}
+
+		p += n;
+		pngle->row_pos += n;
+
+		if (pngle->row_pos == pngle->row_stride) {
+			pngle->row_callback(pngle, pngle->drawing_y, cur + n - pngle->row_stride, pngle->row_stride);
+			if (pngle->state == PNGLE_STATE_ERROR) return -1;
+
+			pngle->row_current ^= 1;
+			pngle->drawing_y++;
+			pngle->filter_type = -1; // Indicate new line
+		}
+	}
+
+	return len;
+}
+
 static int pngle_on_data(pngle_t *pngle, const uint8_t *p, int len)
 {
+	if (pngle->row_buf) return pngle_on_rows(pngle, p, len);
+
 	const uint8_t *ep = p + len;
 
 	uint_fast8_t bytes_per_pixel = (pngle->channels * pngle->hdr.depth + 7) / 8; // 1 if depth <= 8
@@ -745,7 +853,7 @@ static int pngle_feed_internal(pngle_t *pngle, const uint8_t *buf, size_t len)
 			if (pngle->chunk_remain % 3) return PNGLE_ERROR("Invalid PLTE chunk size");
 			if (pngle->chunk_remain / 3 > std::min((long unsigned int)256, (1UL << pngle->hdr.depth))) return PNGLE_ERROR("Too many palettes in PLTE");
       pngle->palette = PNGLE_CALLOC(pngle->chunk_remain / 3, 3, "palette");
-			if (pngle->palette) return PNGLE_ERROR("Insufficient memory");
+			if (!pngle->palette) return PNGLE_ERROR("Insufficient memory");
 			pngle->n_palettes = 0;
 			break;
 
@@ -774,7 +882,7 @@ static int pngle_feed_internal(pngle_t *pngle, const uint8_t *buf, size_t len)
 				return PNGLE_ERROR("tRNS chunk is prohibited on the color type");
 			}
       pngle->trans_palette = PNGLE_CALLOC(pngle->chunk_remain, 1, "trans palette");
-			if (pngle->trans_palette) return PNGLE_ERROR("Insufficient memory");
+			if (!pngle->trans_palette) return PNGLE_ERROR("Insufficient memory");
 			pngle->n_trans_palettes = 0;
 			break;
 
@@ -875,6 +983,12 @@ void pngle_set_done_callback(pngle_t *pngle, pngle_done_callback_t callback)
 	pngle->done_callback = callback;
 }
 
+void pngle_set_row_callback(pngle_t *pngle, pngle_row_callback_t callback)
+{
+	if (!pngle) return ;
+	pngle->row_callback = callback;
+}
+
 void pngle_set_user_data(pngle_t *pngle, void *user_data)
 {
 	if (!pngle) return ;
@@ -39,6 +39,11 @@ typedef void (*pngle_init_callback_t)(pngle_t *pngle, uint32_t w, uint32_t h);
 typedef void (*pngle_draw_callback_t)(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t rgba[4]);
 typedef void (*pngle_done_callback_t)(pngle_t *pngle);
 
+// Called with each complete scanline of a non interlaced image, once unfiltered.
+// row holds the len bytes of raw samples, as described by pngle_get_ihdr(); the
+// draw callback is not called for those images.
+typedef void (*pngle_row_callback_t)(pngle_t *pngle, uint32_t y, const uint8_t *row, size_t len);
+
 // ----------------
 // Basic interfaces
 // ----------------
@@ -54,6 +59,11 @@ uint32_t pngle_get_height(pngle_t *pngle);
 void pngle_set_init_callback(pngle_t *png, pngle_init_callback_t callback);
 void pngle_set_draw_callback(pngle_t *png, pngle_draw_callback_t callback);
 void pngle_set_done_callback(pngle_t *png, pngle_done_callback_t callback);
+void pngle_set_row_callback(pngle_t *png, pngle_row_callback_t callback);
+
+// Converts n pixels of a scanline given to the row callback, from pixel x, to
+// 8 bit R, G, B, A values (as given to the draw callback). Returns -1 on error.
+int pngle_row_to_rgba(pngle_t *pngle, const uint8_t *row, uint32_t x, uint32_t n, uint8_t *rgba);
 
 void pngle_set_display_gamma(pngle_t *pngle, double display_gamma); // enables gamma correction by specifying display gamma, typically 2.2. No effect when gAMA chunk is missing
 
@@ -74,6 +74,26 @@ void TJpg_Decoder::setJpgScale(uint8_t scaleFactor)
 void TJpg_Decoder::setCallback(SketchCallback sketchCallback)
 {
     tft_output = sketchCallback;
+    gray_output = nullptr;
+}
+
+/***************************************************************************************
+** Function name:           setGrayCallback
+** Description:             Set the sketch callback function to render 8 bit gray blocks
+***************************************************************************************/
+void TJpg_Decoder::setGrayCallback(GrayCallback grayCallback)
+{
+    gray_output = grayCallback;
+    tft_output = nullptr;
+}
+
+/***************************************************************************************
+** Function name:           setPrepareCallback
+** Description:             Set the function called once the JPEG header is known
+***************************************************************************************/
+void TJpg_Decoder::setPrepareCallback(PrepareCallback prepareCallback)
+{
+    prepare = prepareCallback;
 }
 
 /***************************************************************************************
@@ -102,6 +122,38 @@ uint16_t TJpg_Decoder::jd_input(JDEC *jdec, uint8_t *buf, uint16_t len)
         thisPtr->array_index += len;
     }
 
+    // Handle a stdio file input
+    else if (thisPtr->jpg_source == TJPG_FS_FILE)
+    {
+        if (buf)
+            return fread(buf, 1, len, thisPtr->jpg_file);
+
+        // A null buffer asks to skip bytes
+        if (fseek(thisPtr->jpg_file, len, SEEK_CUR) != 0)
+            return 0;
+    }
+
+    // Handle a stream input, that can only be read forward
+    else if (thisPtr->jpg_source == TJPG_STREAM)
+    {
+        if (buf)
+        {
+            int32_t size = thisPtr->stream_reader(buf, len);
+            return (size > 0) ? size : 0;
+        }
+
+        uint8_t skip[64];
+        uint16_t left = len;
+        while (left > 0)
+        {
+            int32_t size = thisPtr->stream_reader(skip, (left < sizeof(skip)) ? left : sizeof(skip));
+            if (size <= 0)
+                break;
+            left -= size;
+        }
+        return len - left;
+    }
+
     return len;
 }
 
@@ -115,8 +167,6 @@ uint16_t TJpg_Decoder::jd_output(JDEC *jdec, void *bitmap, JRECT *jrect)
     // This is a static function so create a pointer to access other members of the class
     TJpg_Decoder *thisPtr = TJpgDec.thisPtr;
 
-    jdec = jdec; // Supress warning as ID is not used
-
     // Retrieve rendering parameters and add any offset
     int16_t x = jrect->left + thisPtr->jpeg_x;
     int16_t y = jrect->top + thisPtr->jpeg_y;
@@ -124,6 +174,9 @@ uint16_t TJpg_Decoder::jd_output(JDEC *jdec, void *bitmap, JRECT *jrect)
     uint16_t h = jrect->bottom + 1 - jrect->top;
 
     // Pass the image block and rendering parameters in a callback to the sketch
+    if (jdec->gray)
+        return thisPtr->gray_output(x, y, w, h, (uint8_t *)bitmap, jdec->_dither, jdec->_invert);
+
     return thisPtr->tft_output(x, y, w, h, (uint16_t *)bitmap, jdec->_dither, jdec->_invert);
 }
 
@@ -134,22 +187,73 @@ uint16_t TJpg_Decoder::jd_output(JDEC *jdec, void *bitmap, JRECT *jrect)
 JRESULT TJpg_Decoder::drawJpg(int32_t x, int32_t y, const uint8_t jpeg_data[], uint32_t data_size, bool dither,
                               bool invert)
 {
-    JDEC jdec;
-    JRESULT jresult = JDR_OK;
-
     jpg_source = TJPG_ARRAY;
     array_index = 0;
     array_data = jpeg_data;
     array_size = data_size;
 
+    return decodeJpg(x, y, dither, invert);
+}
+
+/***************************************************************************************
+** Function name:           drawFsJpg
+** Description:             Draw a jpg from an opened stdio file, read as decoded
+***************************************************************************************/
+JRESULT TJpg_Decoder::drawFsJpg(int32_t x, int32_t y, FILE *file, bool dither, bool invert)
+{
+    if (file == nullptr)
+        return JDR_INP;
+
+    jpg_source = TJPG_FS_FILE;
+    jpg_file = file;
+
+    JRESULT jresult = decodeJpg(x, y, dither, invert);
+
+    jpg_file = nullptr;
+    return jresult;
+}
+
+/***************************************************************************************
+** Function name:           drawStreamJpg
+** Description:             Draw a jpg pulled from a stream (e.g. an HTTP body), read as decoded
+***************************************************************************************/
+JRESULT TJpg_Decoder::drawStreamJpg(int32_t x, int32_t y, StreamReader reader, bool dither, bool invert)
+{
+    if (reader == nullptr)
+        return JDR_INP;
+
+    jpg_source = TJPG_STREAM;
+    stream_reader = reader;
+
+    JRESULT jresult = decodeJpg(x, y, dither, invert);
+
+    stream_reader = nullptr;
+    return jresult;
+}
+
+/***************************************************************************************
+** Function name:           decodeJpg
+** Description:             Decode and render from the current input source
+***************************************************************************************/
+JRESULT TJpg_Decoder::decodeJpg(int32_t x, int32_t y, bool dither, bool invert)
+{
+    JDEC jdec;
+    JRESULT jresult = JDR_OK;
+
     jpeg_x = x;
     jpeg_y = y;
 
     jdec.swap = _swap;
+    jdec.gray = gray_output != nullptr;
 
     // Analyse input data
     jresult = jd_prepare(&jdec, jd_input, workspace, TJPGD_WORKSPACE_SIZE, 0);
 
+    if ((jresult == JDR_OK) && (prepare != nullptr) && !prepare(jdec.width, jdec.height))
+    {
+        jresult = JDR_INTR;
+    }
+
     // Extract image and render
     if (jresult == JDR_OK)
     {
@@ -171,6 +275,8 @@ JRESULT TJpg_Decoder::getJpgSize(uint16_t *w, uint16_t *h, const uint8_t jpeg_da
     *w = 0;
     *h = 0;
 
+    jdec.gray = 0;
+
     jpg_source = TJPG_ARRAY;
     array_index = 0;
     array_data = jpeg_data;
@@ -15,6 +15,8 @@ https://github.com/Bodmer/TJpg_Decoder
 
 #include "tjpgd.hpp"
 
+#include <cstdio>
+
 #if defined(ESP8266) || defined(ESP32)
 #include <pgmspace.h>
 #endif
@@ -25,13 +27,25 @@ enum
 {
     TJPG_ARRAY = 0,
     TJPG_FS_FILE,
-    TJPG_SD_FILE
+    TJPG_SD_FILE,
+    TJPG_STREAM
 };
 
 //------------------------------------------------------------------------------
 
 typedef bool (*SketchCallback)(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *data, bool dither, bool invert);
 
+// Luminance only output: data holds w * h 8 bit gray values. The chroma of the
+// picture is not decoded, nor converted to RGB.
+typedef bool (*GrayCallback)(int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t *data, bool dither, bool invert);
+
+// Stream input: returns the number of bytes read into buf (less than len at the end of the stream)
+typedef int32_t (*StreamReader)(uint8_t *buf, int32_t len);
+
+// Called once the JPEG header has been read, before decoding. May change the
+// position (jpeg_x, jpeg_y) or the scale. Returning false stops the decoding.
+typedef bool (*PrepareCallback)(uint16_t w, uint16_t h);
+
 class TJpg_Decoder
 {
 
@@ -45,8 +59,15 @@ class TJpg_Decoder
 
     void setJpgScale(uint8_t scale);
     void setCallback(SketchCallback sketchCallback);
+    void setGrayCallback(GrayCallback grayCallback);
+    void setPrepareCallback(PrepareCallback prepareCallback);
 
     JRESULT drawJpg(int32_t x, int32_t y, const uint8_t array[], uint32_t array_size, bool dither, bool invert);
+
+    // Streamed decoding: the data is read JD_SZBUF bytes at a time as the decoding progresses
+    JRESULT drawFsJpg(int32_t x, int32_t y, FILE *file, bool dither, bool invert);
+    JRESULT drawStreamJpg(int32_t x, int32_t y, StreamReader reader, bool dither, bool invert);
+
     JRESULT getJpgSize(uint16_t *w, uint16_t *h, const uint8_t array[], uint32_t array_size);
 
     void setSwapBytes(bool swap);
@@ -57,6 +78,9 @@ class TJpg_Decoder
     uint32_t array_index = 0;
     uint32_t array_size = 0;
 
+    FILE *jpg_file = nullptr;
+    StreamReader stream_reader = nullptr;
+
     // Must align workspace to a 32 bit boundary
     uint8_t workspace[TJPGD_WORKSPACE_SIZE] __attribute__((aligned(4)));
 
@@ -68,8 +92,13 @@ class TJpg_Decoder
     uint8_t jpgScale = 0;
 
     SketchCallback tft_output = nullptr;
+    GrayCallback gray_output = nullptr;
+    PrepareCallback prepare = nullptr;
 
     TJpg_Decoder *thisPtr = nullptr;
+
+  private:
+    JRESULT decodeJpg(int32_t x, int32_t y, bool dither, bool invert);
 };
 
 extern TJpg_Decoder TJpgDec;
@@ -1465,7 +1465,7 @@ static JRESULT mcu_load (
 
 
   nby = jd->msx * jd->msy;  /* Number of Y blocks (1, 2 or 4) */
-  nbc = 2;          /* Number of C blocks (2) */
+  nbc = jd->ncomp - 1;    /* Number of C blocks (2, or 0 for a grayscale image) */
   bp = jd->mcubuf;      /* Pointer to the first block */
 
   for (blk = 0; blk < nby + nbc; blk++) {
@@ -1515,6 +1515,8 @@ static JRESULT mcu_load (
       }
     } while (++i < 64);   /* Next AC element */
 
+    if (cmp && jd->gray) continue;  /* Y only output: the C blocks are only read through */
+
     if (JD_USE_SCALE && jd->scale == 3) {
       *bp = (uint8_t)((*tmp / 256) + 128);  /* If scale ratio is 1/8, IDCT can be ommited and only DC element is used */
     } else {
@@ -1560,6 +1562,38 @@ static JRESULT mcu_output (
   rect.top = y; rect.bottom = y + ry - 1;
 
 
+  if (jd->gray) {   /* Y only output: 8 bit luminance taken from the Y blocks, no colour conversion */
+    uint8_t *op = (uint8_t*)jd->workbuf;
+
+    if (JD_USE_SCALE && jd->scale == 3) { /* Only the DC value of each block */
+      for (iy = 0; iy < ry; iy++) {
+        for (ix = 0; ix < rx; ix++) *op++ = jd->mcubuf[(iy * jd->msx + ix) * 64];
+      }
+    } else if (!JD_USE_SCALE || !jd->scale) {
+      for (iy = 0; iy < ry; iy++) {
+        py = jd->mcubuf + (iy >> 3) * jd->msx * 64 + (iy & 7) * 8;
+        for (ix = 0; ix < rx; ix++) *op++ = py[(ix >> 3) * 64 + (ix & 7)];
+      }
+    } else {  /* Averaged square of each output pixel, always in a single block */
+      uint16_t sx, sy, i, j, v, s, w;
+
+      s = jd->scale * 2;
+      w = 1 << jd->scale;
+      for (iy = 0; iy < ry; iy++) {
+        for (ix = 0; ix < rx; ix++) {
+          sx = ix << jd->scale; sy = iy << jd->scale;
+          py = jd->mcubuf + ((sy >> 3) * jd->msx + (sx >> 3)) * 64 + (sy & 7) * 8 + (sx & 7);
+          for (v = 0, j = 0; j < w; j++, py += 8) {
+            for (i = 0; i < w; i++) v += py[i];
+          }
+          *op++ = (uint8_t)(v >> s);
+        }
+      }
+    }
+
+    return outfunc(jd, jd->workbuf, &rect) ? JDR_OK : JDR_INTR;
+  }
+
   if (!JD_USE_SCALE || jd->scale != 3) {  /* Not for 1/8 scaling */
 
     /* Build an RGB MCU from discrete comopnents */
@@ -1799,12 +1833,15 @@ JRESULT jd_prepare (
 
       jd->width = LDB_WORD(seg+3);    /* Image width in unit of pixel */
       jd->height = LDB_WORD(seg+1);   /* Image height in unit of pixel */
-      if (seg[5] != 3) return JDR_FMT3; /* Err: Supports only Y/Cb/Cr format */
+      jd->ncomp = seg[5];
+      if (jd->ncomp != 3 && jd->ncomp != 1) return JDR_FMT3; /* Err: Supports only Y/Cb/Cr or Y format */
 
-      /* Check three image components */
-      for (i = 0; i < 3; i++) {
+      /* Check image components */
+      for (i = 0; i < jd->ncomp; i++) {
         b = seg[7 + 3 * i];             /* Get sampling factor */
-        if (!i) { /* Y component */
+        if (jd->ncomp == 1) {  /* Single component: the MCU is always one block */
+          jd->msx = jd->msy = 1;
+        } else if (!i) { /* Y component */
           if (b != 0x11 && b != 0x22 && b != 0x21) {  /* Check sampling factor */
             return JDR_FMT3;          /* Err: Supports only 4:4:4, 4:2:0 or 4:2:2 */
           }
@@ -1854,10 +1891,10 @@ JRESULT jd_prepare (
 
       if (!jd->width || !jd->height) return JDR_FMT1; /* Err: Invalid image size */
 
-      if (seg[0] != 3) return JDR_FMT3;       /* Err: Supports only three color components format */
+      if (seg[0] != jd->ncomp) return JDR_FMT3;   /* Err: Supports only scans of all the components */
 
       /* Check if all tables corresponding to each components have been loaded */
-      for (i = 0; i < 3; i++) {
+      for (i = 0; i < jd->ncomp; i++) {
         b = seg[2 + 2 * i]; /* Get huffman table ID */
         if (b != 0x00 && b != 0x11) return JDR_FMT3;  /* Err: Different table number for DC/AC element */
         b = i ? 1 : 0;
@@ -1872,12 +1909,16 @@ JRESULT jd_prepare (
       /* Allocate working buffer for MCU and RGB */
       n = jd->msy * jd->msx;            /* Number of Y blocks in the MCU */
       if (!n) return JDR_FMT1;          /* Err: SOF0 has not been loaded */
-      len = n * 64 * 2 + 64;            /* Allocate buffer for IDCT and RGB output */
+      len = jd->gray ? n * 64 : n * 64 * 2 + 64;  /* Allocate buffer for IDCT and RGB (or Y) output */
       if (len < 256) len = 256;         /* but at least 256 byte is required for IDCT */
       jd->workbuf = alloc_pool(jd, len);      /* and it may occupy a part of following MCU working buffer for RGB output */
       if (!jd->workbuf) return JDR_MEM1;      /* Err: not enough memory */
-      jd->mcubuf = (uint8_t*)alloc_pool(jd, (uint16_t)((n + 2) * 64));  /* Allocate MCU working buffer */
+      len = jd->gray ? n * 64 : (n + 2) * 64;   /* The C blocks are not kept for a Y only output */
+      jd->mcubuf = (uint8_t*)alloc_pool(jd, len); /* Allocate MCU working buffer */
       if (!jd->mcubuf) return JDR_MEM1;     /* Err: not enough memory */
+      if (jd->ncomp == 1 && !jd->gray) {    /* Grayscale image to RGB output: neutral C blocks */
+        for (i = 0; i < 64 * 2; i++) jd->mcubuf[64 + i] = 128;
+      }
 
       /* Pre-load the JPEG data to extract it from the bit stream */
       jd->dptr = seg; jd->dctr = 0; jd->dmsk = 0; /* Prepare to read bit stream */
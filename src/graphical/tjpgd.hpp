@@ -8,6 +8,7 @@
 
 #define JD_SZBUF     512 /* Size of stream input buffer */
 #define JD_FORMAT    1   /* Output pixel format 0:RGB888 (3 BYTE/pix), 1:RGB565 (1 WORD/pix) */
+                         /* (unless jd->gray is set: 8 bit luminance, 1 BYTE/pix) */
 #define JD_USE_SCALE 1   /* Use descaling feature for output */
 #ifdef ESP32             // Table gives no speed mprovement for ESP32
 #define JD_TBLCLIP 0     /* Use table for saturation (might be a bit faster but increases 1K bytes of code size) */
@@ -63,6 +64,7 @@ extern "C"
         uint8_t dmsk;                                    /* Current bit in the current read byte */
         uint8_t scale;                                   /* Output scaling ratio */
         uint8_t msx, msy;                                /* MCU size in unit of block (width, height) */
+        uint8_t ncomp;                                   /* Number of components (1:Y, 3:Y/Cb/Cr) */
         uint8_t qtid[3];                                 /* Quantization table ID of each component */
         int16_t dcv[3];                                  /* Previous DC element of each component */
         uint16_t nrst;                                   /* Restart inverval */
@@ -80,6 +82,7 @@ extern "C"
         uint8_t swap;                                    /* Added by Bodmer to control byte swapping */
         uint8_t _dither;
         uint8_t _invert;
+        uint8_t gray;                                    /* Output Y only (1 BYTE/pix), chroma is skipped */
     };
 
     /* TJpgDec API functions */
@@ -0,0 +1,165 @@
+/*
+http_cache.cpp
+Inkplate 6 ESP-IDF
+
+HTTP cache of downloaded files, on the SD card.
+
+This code is released under the GNU Lesser General Public License v3.0: https://www.gnu.org/licenses/lgpl-3.0.en.html
+*/
+
+#include "http_cache.hpp"
+#include "esp_log.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstring>
+#include <sys/stat.h>
+
+bool
+HttpCache::setup(const char * dir)
+{
+  abort();
+  directory.clear();
+
+  if (dir == nullptr) return true;
+
+  if ((mkdir(dir, 0755) != 0) && (errno != EEXIST)) {
+    ESP_LOGE(TAG, "Unable to create %s", dir);
+    return false;
+  }
+  directory = dir;
+  return true;
+}
+
+// FNV-1a hash of the URL
+
+std::string
+HttpCache::path(const char * url, const char * extension)
+{
+  uint32_t hash = 2166136261u;
+  for (const char * c = url; *c; c++) hash = (hash ^ (uint8_t) *c) * 16777619u;
+
+  char name[16];
+  snprintf(name, sizeof(name), "/%08" PRIX32 ".%s", hash, extension);
+  return directory + name;
+}
+
+static bool
+readLine(FILE * f, std::string & line)
+{
+  char buf[512];
+
+  if (fgets(buf, sizeof(buf), f) == nullptr) return false;
+  buf[strcspn(buf, "\r\n")] = 0;
+  line = buf;
+  return true;
+}
+
+bool
+HttpCache::validators(const char * url, std::string & etag, std::string & lastModified)
+{
+  if (!isEnabled()) return false;
+
+  FILE * f = fopen(path(url, "HDR").c_str(), "r");
+  if (f == nullptr) return false;
+
+  std::string cached;
+  bool ok = readLine(f, cached) && (cached == url) && readLine(f, etag) && readLine(f, lastModified);
+  fclose(f);
+
+  return ok && (!etag.empty() || !lastModified.empty());
+}
+
+FILE *
+HttpCache::open(const char * url, int32_t * size)
+{
+  std::string etag, lastModified;
+
+  if (!validators(url, etag, lastModified)) return nullptr;
+
+  FILE * f = fopen(path(url, "BIN").c_str(), "r");
+  if ((f != nullptr) && (size != nullptr)) {
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+  }
+  return f;
+}
+
+bool
+HttpCache::begin(const char * url)
+{
+  abort();
+  if (!isEnabled()) return false;
+
+  pendingFile = fopen(path(url, "TMP").c_str(), "w");
+  if (pendingFile == nullptr) {
+    ESP_LOGE(TAG, "Unable to create the cache file of %s", url);
+    return false;
+  }
+  pending = url;
+  return true;
+}
+
+bool
+HttpCache::write(const uint8_t * data, int32_t len)
+{
+  if (pendingFile == nullptr) return false;
+  if (fwrite(data, 1, len, pendingFile) == (size_t) len) return true;
+
+  ESP_LOGE(TAG, "Unable to write the cache file of %s", pending.c_str());
+  abort();
+  return false;
+}
+
+// The header file goes last: a body without one is never used
+
+bool
+HttpCache::commit(const std::string & etag, const std::string & lastModified)
+{
+  if (pendingFile == nullptr) return false;
+
+  std::string url = pending;
+  std::string tmp = path(url.c_str(), "TMP"), bin = path(url.c_str(), "BIN"), hdr = path(url.c_str(), "HDR");
+
+  bool ok = fclose(pendingFile) == 0;
+  pendingFile = nullptr;
+  pending.clear();
+
+  ::remove(hdr.c_str());
+  ::remove(bin.c_str());
+
+  FILE * f;
+  ok = ok && (rename(tmp.c_str(), bin.c_str()) == 0) && ((f = fopen(hdr.c_str(), "w")) != nullptr);
+  if (ok) {
+    fprintf(f, "%s\n%s\n%s\n", url.c_str(), etag.c_str(), lastModified.c_str());
+    ok = fclose(f) == 0;
+  }
+
+  if (!ok) {
+    ESP_LOGE(TAG, "Unable to keep %s in the cache", url.c_str());
+    remove(url.c_str());
+    ::remove(tmp.c_str());
+  }
+  return ok;
+}
+
+void
+HttpCache::abort()
+{
+  if (pendingFile != nullptr) {
+    fclose(pendingFile);
+    pendingFile = nullptr;
+    ::remove(path(pending.c_str(), "TMP").c_str());
+    pending.clear();
+  }
+}
+
+void
+HttpCache::remove(const char * url)
+{
+  if (!isEnabled()) return;
+
+  ::remove(path(url, "HDR").c_str());
+  ::remove(path(url, "BIN").c_str());
+}
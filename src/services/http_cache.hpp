@@ -0,0 +1,65 @@
+/*
+http_cache.hpp
+Inkplate 6 ESP-IDF
+
+HTTP cache of downloaded files, on the SD card.
+
+This code is released under the GNU Lesser General Public License v3.0: https://www.gnu.org/licenses/lgpl-3.0.en.html
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/**
+ * @brief Files kept with their ETag and Last-Modified validators
+ *
+ * Each URL gets two files in the cache directory, named after a hash of the
+ * URL (8.3 names, for FAT volumes without long file names): XXXXXXXX.BIN,
+ * the body, and XXXXXXXX.HDR, three text lines: the URL, the ETag and the
+ * Last-Modified values. A new body is written to XXXXXXXX.TMP and only
+ * replaces the cached one when complete.
+ */
+class HttpCache
+{
+  public:
+    HttpCache() {}
+
+    /**
+     * @brief Select the cache directory, created if needed
+     *
+     * @param dir Directory, e.g. "/sdcard/cache" (the SD card must be set up).
+     *            nullptr disables the cache.
+     */
+    bool setup(const char * dir);
+
+    inline bool isEnabled() { return !directory.empty(); }
+
+    // Validators of the cached copy of url, false if there is none
+
+    bool validators(const char * url, std::string & etag, std::string & lastModified);
+
+    // The cached body of url, nullptr if there is none
+
+    FILE * open(const char * url, int32_t * size);
+
+    // A new body for url, received in pieces, kept by commit()
+
+    bool   begin(const char * url);
+    bool   write(const uint8_t * data, int32_t len);
+    bool  commit(const std::string & etag, const std::string & lastModified);
+    void   abort();
+
+    void  remove(const char * url);
+
+  private:
+    static constexpr char const * TAG = "HttpCache";
+
+    std::string directory;
+    std::string pending;          // URL of the body being received
+    FILE *      pendingFile{nullptr};
+
+    std::string path(const char * url, const char * extension);
+};
@@ -132,6 +132,28 @@ void IRAM_ATTR my_I2SInit(i2s_dev_t *_i2sDev, uint8_t _clockDivider) {
  * descriptor must be already configured!
  */
 void IRAM_ATTR my_sendDataI2S(i2s_dev_t *_i2sDev, volatile lldesc_s *_dmaDecs) {
+  my_startDataI2S(_i2sDev, _dmaDecs);
+
+  while (!_i2sDev->int_raw.out_total_eof)
+    ;
+
+  my_endDataI2S(_i2sDev);
+}
+
+/**
+ * @brief       Function starts sending data with I2S DMA driver, without waiting for the end of
+ *              the transfer.
+ *
+ * @param       i2s_dev_t *_i2sDev
+ *              Pointer of the selected I2S driver
+ *
+ *              lldesc_s *_dmaDecs
+ *              Pointer to the DMA descriptor.
+ *
+ * @note        The transfer must be completed with my_endDataI2S() once the out_total_eof
+ *              interrupt is raised.
+ */
+void IRAM_ATTR my_startDataI2S(i2s_dev_t *_i2sDev, volatile lldesc_s *_dmaDecs) {
   // Stop any on-going transmission (just in case).
   _i2sDev->out_link.stop  = 1;
   _i2sDev->out_link.start = 0;
@@ -151,7 +173,7 @@ void IRAM_ATTR my_sendDataI2S(i2s_dev_t *_i2sDev, volatile lldesc_s *_dmaDecs) {
 
   // Setup a DMA descriptor.
   _i2sDev->lc_conf.val   = I2S_OUT_DATA_BURST_EN | I2S_OUTDSCR_BURST_EN;
-  _i2sDev->out_link.addr = (uint32_t)(_dmaDecs) & 0x000FFFFF;
+  _i2sDev->out_link.addr = (uint32_t)(uintptr_t)(_dmaDecs) & 0x000FFFFF;
 
   // Start sending the data
   _i2sDev->out_link.start = 1;
@@ -164,10 +186,15 @@ void IRAM_ATTR my_sendDataI2S(i2s_dev_t *_i2sDev, volatile lldesc_s *_dmaDecs) {
 
   // Start sending I2S data out.
   _i2sDev->conf.tx_start = 1;
+}
 
-  while (!_i2sDev->int_raw.out_total_eof)
-    ;
-
+/**
+ * @brief       Function ends a transfer started with my_startDataI2S().
+ *
+ * @param       i2s_dev_t *_i2sDev
+ *              Pointer of the selected I2S driver
+ */
+void IRAM_ATTR my_endDataI2S(i2s_dev_t *_i2sDev) {
   SPH_SET;
 
   // Clear the interrupt flags and stop the transmission.
@@ -239,23 +266,93 @@ void IRAM_ATTR my_setI2S1pin(uint32_t _pin, uint32_t _function, uint32_t _inv) {
     GPIO.enable1_w1ts.data = ((uint32_t)1 << (32 - _pin));
   }
 
-#define ESP_REG(addr) *((volatile uint32_t *)(addr))
+#define ESP_REG(addr) *((volatile uint32_t *)(uintptr_t)(addr))
 
   // Set the highest drive strength.
   ESP_REG(io_mux[_pin]) = 0;
   ESP_REG(io_mux[_pin]) = ((3 << FUN_DRV_S) | (2 << MCU_SEL_S));
 }
 
+void IRAM_ATTR I2SComms::eof_isr(void *arg) {
+  I2SComms *comms = (I2SComms *)arg;
+
+  uint32_t status = I2S1.int_st.val;
+  if (status == 0) return;
+
+  I2S1.int_clr.val = status;
+
+  if (status & I2S_OUT_TOTAL_EOF_INT_ENA) {
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(comms->eof_semaphore, &woken);
+    if (woken) portYIELD_FROM_ISR();
+  }
+}
+
+void I2SComms::init(uint8_t clock_divider) {
+  my_I2SInit(&I2S1, clock_divider);
+
+  if (eof_semaphore == nullptr) {
+    eof_semaphore = xSemaphoreCreateBinary();
+  }
+
+  if ((intr_handle == nullptr) && (eof_semaphore != nullptr)) {
+    if (esp_intr_alloc(ETS_I2S1_INTR_SOURCE, ESP_INTR_FLAG_IRAM, eof_isr, this, &intr_handle) != ESP_OK) {
+      ESP_LOGE(TAG, "Unable to allocate the I2S1 interrupt, polling will be used.");
+      intr_handle = nullptr;
+    }
+  }
+
+  I2S1.int_clr.val = 0xFFFFFFFF;
+  I2S1.int_ena.val = (intr_handle != nullptr) ? I2S_OUT_TOTAL_EOF_INT_ENA : 0;
+
+  init_lldesc();
+}
+
+void IRAM_ATTR I2SComms::start_data() {
+  if (busy) wait_data();
+
+  my_startDataI2S(&I2S1, lldescs[current]);
+  busy = true;
+
+  if (++current >= LINE_BUFFER_COUNT) current = 0;
+}
+
+void IRAM_ATTR I2SComms::wait_data() {
+  if (!busy) return;
+
+  if (intr_handle != nullptr) {
+    xSemaphoreTake(eof_semaphore, portMAX_DELAY);
+  } else {
+    while (!I2S1.int_raw.out_total_eof)
+      ;
+  }
+
+  my_endDataI2S(&I2S1);
+  busy = false;
+}
+
+void I2SComms::fill_line_buffers(uint8_t value, uint32_t size) {
+  if (size > line_buffer_size) size = line_buffer_size;
+  for (int i = 0; i < LINE_BUFFER_COUNT; i++) {
+    for (uint32_t j = 0; j < size; j++) {
+      line_buffers[i][j] = value;
+    }
+  }
+}
+
 void I2SComms::init_lldesc() {
-  if (lldesc != nullptr) {
-    lldesc->size         = line_buffer_size; // Buffer size
-    lldesc->length       = line_buffer_size; // Number of bytes to transfer
-    lldesc->offset       = 0;                // Start transfer with first buffer byte
-    lldesc->sosf         = 1;
-    lldesc->eof          = 1;           // Only one block at a time (end of list)
-    lldesc->owner        = 1;           // The allowed operator is the DMA controller
-    lldesc->buf          = line_buffer; // Buffer address
-    lldesc->qe.stqe_next = 0;           // Next descriptor (none)
+  for (int i = 0; i < LINE_BUFFER_COUNT; i++) {
+    volatile lldesc_s *lldesc = lldescs[i];
+    if (lldesc != nullptr) {
+      lldesc->size         = line_buffer_size; // Buffer size
+      lldesc->length       = line_buffer_size; // Number of bytes to transfer
+      lldesc->offset       = 0;                // Start transfer with first buffer byte
+      lldesc->sosf         = 1;
+      lldesc->eof          = 1;               // Only one block at a time (end of list)
+      lldesc->owner        = 1;               // The allowed operator is the DMA controller
+      lldesc->buf          = line_buffers[i]; // Buffer address
+      lldesc->qe.stqe_next = 0;               // Next descriptor (none)
+    }
   }
 }
 
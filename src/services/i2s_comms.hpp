@@ -24,8 +24,12 @@
 #include "soc/rtc.h"
 #include "soc/soc.h"
 
+#include "esp_intr_alloc.h"
 #include "esp_log.h"
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
 #if __I2S_COMMS__
 #define PUBLIC
 #else
@@ -34,32 +38,68 @@
 
 PUBLIC void IRAM_ATTR my_I2SInit(i2s_dev_t *_i2sDev, uint8_t _clockDivider);
 PUBLIC void IRAM_ATTR my_sendDataI2S(i2s_dev_t *_i2sDev, volatile lldesc_s *_dmaDecs);
+PUBLIC void IRAM_ATTR my_startDataI2S(i2s_dev_t *_i2sDev, volatile lldesc_s *_dmaDecs);
+PUBLIC void IRAM_ATTR my_endDataI2S(i2s_dev_t *_i2sDev);
 PUBLIC void IRAM_ATTR my_setI2S1pin(uint32_t _pin, uint32_t _function, uint32_t _inv);
 
+/**
+ * @brief I2S1 DMA line streaming
+ *
+ * The class owns LINE_BUFFER_COUNT line buffers, each with its own DMA
+ * descriptor, used in turn. A row is sent with start_data(), that returns as
+ * soon as the DMA engine is started and makes the next line buffer the
+ * current one, so that the next row can be prepared while the current one is
+ * shifted out. wait_data() returns when the transfer is completed, as
+ * signaled by the I2S1 out_total_eof interrupt. The expected sequence for a
+ * row is then:
+ *
+ *   - fill get_line_buffer() with row i
+ *   - if i > 0: wait_data() and latch row i - 1
+ *   - start_data()
+ *
+ * with a final wait_data() and latch after the last row. send_data() is the
+ * blocking equivalent of start_data() followed by wait_data().
+ */
 class I2SComms {
 
 private:
 public:
-  I2SComms(const uint32_t buffer_size) : line_buffer_size(buffer_size) {
-    line_buffer = (uint8_t *)heap_caps_malloc(buffer_size, MALLOC_CAP_DMA);
-    lldesc      = (lldesc_s *)heap_caps_malloc(sizeof(lldesc_s), MALLOC_CAP_DMA);
+  static const uint8_t LINE_BUFFER_COUNT = 2;
 
-    ready = (line_buffer != nullptr) && (lldesc != nullptr);
+  I2SComms(const uint32_t buffer_size) : line_buffer_size(buffer_size) {
+    ready = true;
+    for (int i = 0; i < LINE_BUFFER_COUNT; i++) {
+      line_buffers[i] = (uint8_t *)heap_caps_calloc(1, buffer_size, MALLOC_CAP_DMA);
+      lldescs[i]      = (lldesc_s *)heap_caps_malloc(sizeof(lldesc_s), MALLOC_CAP_DMA);
+      ready           = ready && (line_buffers[i] != nullptr) && (lldescs[i] != nullptr);
+    }
 
     if (ready) {
       ESP_LOGI(TAG, "Ready...");
     }
   }
 
-  inline void init(uint8_t clock_divider = 5) { my_I2SInit(&I2S1, clock_divider); }
-  inline void send_data() { my_sendDataI2S(&I2S1, lldesc); }
+  void init(uint8_t clock_divider = 5);
+
+  inline void send_data() {
+    start_data();
+    wait_data();
+  }
+
+  void start_data();
+  void wait_data();
+
   inline void set_pin(uint32_t pin, uint32_t function, uint32_t inverted) {
     my_setI2S1pin(pin, function, inverted);
   }
 
   void init_lldesc();
 
-  volatile inline uint8_t *get_line_buffer() { return line_buffer; }
+  /// Sets the first size bytes of every line buffer to value.
+  void fill_line_buffers(uint8_t value, uint32_t size);
+
+  /// The line buffer to be filled before the next start_data() call.
+  volatile inline uint8_t *get_line_buffer() { return line_buffers[current]; }
 
   inline bool is_ready() { return ready; }
   inline void stop_clock() { I2S1.conf1.tx_stop_en = 0; }
@@ -68,11 +108,19 @@ public:
 private:
   static constexpr char const *TAG = "I2SComms";
 
-  volatile lldesc_s *lldesc;
-  volatile uint8_t *line_buffer{nullptr};
+  volatile lldesc_s *lldescs[LINE_BUFFER_COUNT];
+  volatile uint8_t *line_buffers[LINE_BUFFER_COUNT];
+
+  uint8_t current{0};
+  bool busy{false};
+
+  SemaphoreHandle_t eof_semaphore{nullptr};
+  intr_handle_t intr_handle{nullptr};
 
   const uint32_t line_buffer_size{0};
   bool ready{false};
+
+  static void IRAM_ATTR eof_isr(void *arg);
 };
 
 #undef PUBLIC
@@ -18,6 +18,7 @@ Distributed as-is; no warranty is given.
 #include "network_client.hpp"
 #include "esp_log.h"
 
+#include <algorithm>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -25,6 +26,8 @@ Distributed as-is; no warranty is given.
 #include "esp_system.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_attr.h"
 #include "nvs_flash.h"
 
 #include "lwip/err.h"
@@ -32,6 +35,8 @@ Distributed as-is; no warranty is given.
 
 #include "esp_http_client.h"
 
+#include <strings.h>
+
 #if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
 #include "esp_crt_bundle.h"
 #endif
@@ -55,24 +60,93 @@ static bool wifi_first_start = true;
 
 static int s_retry_num = 0;
 
+// Delay before the next connection retry: doubled after each failure, up to
+// retry_max_ms
+
+static uint32_t retry_first_ms = 500;
+static uint32_t retry_max_ms   = 10000;
+static uint32_t retry_delay_ms = 500;
+
+static uint32_t next_retry_delay()
+{
+  uint32_t delay = retry_delay_ms;
+  retry_delay_ms = std::min(retry_delay_ms * 2, retry_max_ms);
+  return delay;
+}
+
+// The access point of the last connection and the address given by DHCP,
+// kept in RTC memory through deep sleep. With fast connect, the station
+// associates directly with this access point, without scanning the channels.
+
+struct WifiCache {
+  uint32_t             magic;
+  uint8_t              ssid[32];
+  uint8_t              bssid[6];
+  uint8_t              channel;
+  esp_netif_ip_info_t  lease;
+  esp_netif_dns_info_t dns;
+};
+
+static const uint32_t WIFI_CACHE_MAGIC = 0x57494649;
+
+static RTC_DATA_ATTR WifiCache wifi_cache;
+
+static bool fast_connect = false;
+static bool reuse_lease  = false;
+static bool fast_attempt = false;   // Connecting with the cached access point
+static bool lease_reused = false;
+
+static bool                 static_ip = false;
+static esp_netif_ip_info_t  static_ip_info;
+static esp_netif_dns_info_t static_dns;
+
+static wifi_config_t wifi_config;
+static esp_netif_t * sta_netif = nullptr;
+
+static void set_address(const esp_netif_ip_info_t * ip_info, esp_netif_dns_info_t * dns)
+{
+  esp_netif_dhcpc_stop(sta_netif);
+  esp_netif_set_ip_info(sta_netif, ip_info);
+  if (dns->ip.u_addr.ip4.addr != 0) esp_netif_set_dns_info(sta_netif, ESP_NETIF_DNS_MAIN, dns);
+}
+
 static void sta_event_handler(void            * arg, 
                               esp_event_base_t  event_base,
                               int32_t           event_id, 
                               void            * event_data)
 {
-  ESP_LOGI(TAG, "STA Event, Base: %08x, Event: %" PRIi32 ".", (unsigned int) event_base, event_id);
+  ESP_LOGI(TAG, "STA Event, Base: %s, Event: %" PRIi32 ".", event_base, event_id);
 
   if (event_base == WIFI_EVENT) {
     if (event_id == WIFI_EVENT_STA_START) {
       esp_wifi_connect();
     } 
+    else if (event_id == WIFI_EVENT_STA_CONNECTED) {
+      wifi_event_sta_connected_t * event = (wifi_event_sta_connected_t *) event_data;
+      memcpy(wifi_cache.bssid, event->bssid, sizeof(wifi_cache.bssid));
+      wifi_cache.channel = event->channel;
+    }
     else if (event_id == WIFI_EVENT_STA_DISCONNECTED) {
-      if (wifi_first_start) {
+      if (fast_attempt) {
+        // The access point moved or is gone: back to a scan, without delay
+        ESP_LOGI(TAG, "direct association failed, scanning for the AP");
+        fast_attempt     = false;
+        wifi_cache.magic = 0;
+        wifi_config.sta.bssid_set = false;
+        wifi_config.sta.channel   = 0;
+        esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+        if (lease_reused) {
+          lease_reused = false;
+          esp_netif_dhcpc_start(sta_netif);
+        }
+        esp_wifi_connect();
+      }
+      else if (wifi_first_start) {
         if (s_retry_num < ESP_MAXIMUM_RETRY) {
-          vTaskDelay(pdMS_TO_TICKS(10000)); // wait 10 sec
+          vTaskDelay(pdMS_TO_TICKS(next_retry_delay()));
           ESP_LOGI(TAG, "retry to connect to the AP");
-          esp_wifi_connect();
           s_retry_num++;
+          esp_wifi_connect();
         } 
         else {
           xEventGroupSetBits(wifi_event_group, WIFI_FAIL_BIT);
@@ -81,7 +155,7 @@ static void sta_event_handler(void            * arg,
       }
       else {
         ESP_LOGI(TAG, "Wifi Disconnected.");
-        vTaskDelay(pdMS_TO_TICKS(10000)); // wait 10 sec
+        vTaskDelay(pdMS_TO_TICKS(next_retry_delay()));
         ESP_LOGI(TAG, "retry to connect to the AP");
         esp_wifi_connect();
       }
@@ -91,13 +165,58 @@ static void sta_event_handler(void            * arg,
     if (event_id == IP_EVENT_STA_GOT_IP) {
       ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
       ESP_LOGI(TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
-      s_retry_num = 0;
+      s_retry_num    = 0;
+      retry_delay_ms = retry_first_ms;
+      fast_attempt   = false;
+
+      memcpy(wifi_cache.ssid, wifi_config.sta.ssid, sizeof(wifi_cache.ssid));
+      if (!static_ip && !lease_reused) {
+        wifi_cache.lease = event->ip_info;
+        esp_netif_get_dns_info(event->esp_netif, ESP_NETIF_DNS_MAIN, &wifi_cache.dns);
+      }
+      wifi_cache.magic = WIFI_CACHE_MAGIC;
+
       xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT);
       wifi_first_start = false;
     }
   }
 }
 
+void
+NetworkClient::setFastConnect(bool enable, bool reuseLease)
+{
+  fast_connect = enable;
+  reuse_lease  = reuseLease;
+}
+
+bool
+NetworkClient::setStaticIP(const char * ip, const char * netmask, const char * gateway, const char * dns)
+{
+  static_ip = false;
+  if (ip == nullptr) return true;
+
+  memset(&static_ip_info, 0, sizeof(static_ip_info));
+  memset(&static_dns,     0, sizeof(static_dns));
+
+  if ((esp_netif_str_to_ip4(ip,      &static_ip_info.ip     ) != ESP_OK) ||
+      (esp_netif_str_to_ip4(netmask, &static_ip_info.netmask) != ESP_OK) ||
+      (esp_netif_str_to_ip4(gateway, &static_ip_info.gw     ) != ESP_OK) ||
+      ((dns != nullptr) && (esp_netif_str_to_ip4(dns, &static_dns.ip.u_addr.ip4) != ESP_OK))) {
+    ESP_LOGE(TAG, "Invalid static address");
+    return false;
+  }
+  static_dns.ip.type = ESP_IPADDR_TYPE_V4;
+  static_ip = true;
+  return true;
+}
+
+void
+NetworkClient::setRetryDelays(uint32_t firstMs, uint32_t maxMs)
+{
+  retry_first_ms = std::max<uint32_t>(firstMs, 1);
+  retry_max_ms   = std::max(maxMs, retry_first_ms);
+}
+
 bool 
 NetworkClient::joinAP(const char * ssid, const char * pass)
 {
@@ -108,7 +227,7 @@ NetworkClient::joinAP(const char * ssid, const char * pass)
   ESP_ERROR_CHECK(esp_netif_init());
 
   ESP_ERROR_CHECK(esp_event_loop_create_default());
-  esp_netif_create_default_wifi_sta();
+  sta_netif = esp_netif_create_default_wifi_sta();
 
   wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
   ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -121,8 +240,6 @@ NetworkClient::joinAP(const char * ssid, const char * pass)
                                              IP_EVENT_STA_GOT_IP,
                                              &sta_event_handler,
                                              NULL));
-  wifi_config_t wifi_config;
-
   memset(&wifi_config, 0, sizeof(wifi_config));
 
   wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
@@ -135,6 +252,34 @@ NetworkClient::joinAP(const char * ssid, const char * pass)
   wifi_config.sta.ssid[sizeof(wifi_config.sta.ssid) - 1] = 0;
   wifi_config.sta.password[sizeof(wifi_config.sta.password) - 1] = 0;
 
+  wifi_first_start = true;
+  s_retry_num      = 0;
+  retry_delay_ms   = retry_first_ms;
+
+  // Fast connect: straight to the access point of the last connection
+
+  fast_attempt = fast_connect && (wifi_cache.magic == WIFI_CACHE_MAGIC) &&
+                 (memcmp(wifi_cache.ssid, wifi_config.sta.ssid, sizeof(wifi_cache.ssid)) == 0);
+  if (fast_attempt) {
+    wifi_config.sta.bssid_set = true;
+    memcpy(wifi_config.sta.bssid, wifi_cache.bssid, sizeof(wifi_config.sta.bssid));
+    wifi_config.sta.channel   = wifi_cache.channel;
+  }
+
+  // The address: static, the last DHCP lease, or a new one
+
+  lease_reused = !static_ip && fast_attempt && reuse_lease && (wifi_cache.lease.ip.addr != 0);
+  if (static_ip) {
+    set_address(&static_ip_info, &static_dns);
+  }
+  else if (lease_reused) {
+    ESP_LOGI(TAG, "reusing address " IPSTR, IP2STR(&wifi_cache.lease.ip));
+    set_address(&wifi_cache.lease, &wifi_cache.dns);
+  }
+  else {
+    esp_netif_dhcpc_start(sta_netif);
+  }
+
   ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
   ESP_ERROR_CHECK(esp_wifi_set_config((wifi_interface_t)ESP_IF_WIFI_STA, &wifi_config));
   ESP_ERROR_CHECK(esp_wifi_start());
@@ -185,104 +330,334 @@ NetworkClient::disconnect()
 
     vEventGroupDelete(wifi_event_group);
 
+    closeSession();
     esp_wifi_disconnect();
 
     connected = false;
   }
 }
 
-static uint8_t * buffer;
-static uint8_t * buffer_ptr;
-static int32_t   buffer_size;
-
-static esp_err_t http_event_handler(esp_http_client_event_t * evt)
+uint8_t *
+NetworkClient::downloadFile(const char * url, int32_t * defaultLen)
 {
-  switch(evt->event_id) {
-    case HTTP_EVENT_ERROR:
-      ESP_LOGI(TAG, "HTTP_EVENT_ERROR");
-      break;
-    case HTTP_EVENT_ON_CONNECTED:
-      ESP_LOGI(TAG, "HTTP_EVENT_ON_CONNECTED");
-      break;
-    case HTTP_EVENT_HEADER_SENT:
-      ESP_LOGI(TAG, "HTTP_EVENT_HEADER_SENT");
-      break;
-    case HTTP_EVENT_ON_HEADER:
-      ESP_LOGI(TAG, "HTTP_EVENT_ON_HEADER");
-      //ESP_LOGI(TAG, "key = %s, value = %s", evt->header_key, evt->header_value);
-      if (strcmp("Content-Length", evt->header_key) == 0) {
-        buffer_size = atoi(evt->header_value);
-        ESP_LOGI(TAG, "Donwload file size: %" PRIi32, buffer_size);
-      }
-      break;
-    case HTTP_EVENT_ON_DATA:
-      ESP_LOGI(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-      if (!esp_http_client_is_chunked_response(evt->client)) {
-        //ESP_LOGI(TAG, "len = %d, %.*s", evt->data_len, evt->data_len, (char*)evt->data);
-        if ((buffer == nullptr) && (buffer_size > 0)) {
-          buffer_ptr = buffer = (uint8_t *) malloc(buffer_size);
-        }
-        if (buffer_ptr != nullptr) {
-          if ((buffer_ptr + evt->data_len) <= (buffer + buffer_size)) {
-            memcpy(buffer_ptr, evt->data, evt->data_len);
-            buffer_ptr += evt->data_len;
-          }
-          else {
-            int size = (buffer + buffer_size) - buffer_ptr;
-            if ((size > 0) && (size <= evt->data_len)) {
-              memcpy(buffer_ptr, evt->data, size);
-              buffer_ptr += size;
-            }
-          }
-        }
+  int32_t length;
+
+  if (!openStream(url, &length)) return nullptr;
+
+  ESP_LOGI(TAG, "Downloading file from URL: %s", url);
+
+  // Unknown length: the buffer is doubled when full
+
+  int32_t   size   = (length >= 0) ? length : std::max<int32_t>(*defaultLen, 1024);
+  int32_t   used   = 0;
+  uint8_t * buffer = (uint8_t *) malloc(std::max<int32_t>(size, 1));
+
+  while (buffer != nullptr) {
+    if ((used == size) && (length < 0)) {
+      uint8_t * bigger = (uint8_t *) realloc(buffer, size * 2);
+      if (bigger == nullptr) {
+        ESP_LOGE(TAG, "Not enough memory for %s", url);
+        free(buffer);
+        buffer = nullptr;
+        break;
       }
+      buffer = bigger;
+      size  *= 2;
+    }
+    int32_t len = readStream(buffer + used, size - used);
+    if (len < 0) {
+      free(buffer);
+      buffer = nullptr;
+    }
+    else if ((len == 0) || ((used += len) == length)) {
       break;
-    case HTTP_EVENT_ON_FINISH:
-      ESP_LOGI(TAG, "HTTP_EVENT_ON_FINISH");
-      break;
-    case HTTP_EVENT_DISCONNECTED:
-      ESP_LOGI(TAG, "HTTP_EVENT_DISCONNECTED");
-      break;
-    case HTTP_EVENT_REDIRECT:
-      ESP_LOGI(TAG, "HTTP_EVENT_REDIRECT");
+    }
+  }
+
+  closeStream();
+
+  if ((buffer != nullptr) && (length >= 0) && (used != length)) {
+    ESP_LOGE(TAG, "Truncated file: %" PRIi32 " bytes of %" PRIi32, used, length);
+    free(buffer);
+    buffer = nullptr;
+  }
+
+  *defaultLen = used;
+  return buffer;
+}
+
+bool
+NetworkClient::download(const char * url, DataCallback onData, int32_t chunkSize)
+{
+  int32_t length;
+
+  if (!openStream(url, &length)) return false;
+
+  uint8_t * chunk = (uint8_t *) malloc(chunkSize);
+  int32_t   total = 0;
+  bool      ok    = chunk != nullptr;
+
+  // One network read per chunk: the data is handed over as soon as it arrives
+
+  while (ok) {
+    int32_t size = readSome(chunk, chunkSize);
+    if (size <= 0) {
+      ok = (size == 0) && ((length < 0) || (total == length));
       break;
+    }
+    total += size;
+    ok     = onData(chunk, size);
+  }
+
+  free(chunk);
+  closeStream();
+  return ok;
+}
+
+// Response headers kept for the cache
+
+static esp_err_t stream_event_handler(esp_http_client_event_t * evt)
+{
+  NetworkClient * client = (NetworkClient *) evt->user_data;
+
+  if ((evt->event_id == HTTP_EVENT_ON_HEADER) && (client != nullptr)) {
+    client->onHeader(evt->header_key, evt->header_value);
   }
   return ESP_OK;
 }
 
+void
+NetworkClient::onHeader(const char * key, const char * value)
+{
+  if      (strcasecmp(key, "ETag"         ) == 0) etag         = value;
+  else if (strcasecmp(key, "Last-Modified") == 0) lastModified = value;
+}
 
-uint8_t *
-NetworkClient::downloadFile(const char * url, int32_t * defaultLen)
+bool
+NetworkClient::setCache(const char * dir)
 {
-  if (!connected) return nullptr;
+  closeStream();
+  return cache.setup(dir);
+}
 
-  ESP_LOGI(TAG, "Downloading file from URL: %s", url);
-  
-  buffer = buffer_ptr = nullptr;
-  buffer_size = *defaultLen;
-
-  esp_http_client_config_t config;
-
-  memset(&config, 0, sizeof(config));
-  
-  config.url = url;
-  config.event_handler = http_event_handler;
-
-  #if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
-  config.crt_bundle_attach = esp_crt_bundle_attach;
-  #endif
-  
-  esp_http_client_handle_t client = esp_http_client_init(&config);
-  esp_err_t err = esp_http_client_perform(client);
-
-  if (err == ESP_OK) {
-    ESP_LOGI(TAG, "Status = %d, content_length = %" PRIi64,
-            esp_http_client_get_status_code(client),
-            esp_http_client_get_content_length(client));
+// The scheme, host and port part of an URL
+
+static std::string
+url_origin(const char * url)
+{
+  const char * host = strstr(url, "://");
+  if (host == nullptr) return std::string();
+
+  const char * path = strchr(host + 3, '/');
+  return (path == nullptr) ? std::string(url) : std::string(url, path - url);
+}
+
+// With the cache, the request carries the validators of the cached copy. On a
+// 304 answer, the body is read from the cache instead. On a 200 answer with
+// validators, the body is written to the cache as it is read.
+
+bool
+NetworkClient::openStream(const char * url, int32_t * contentLength)
+{
+  notModified = false;
+
+  if (!connected) return false;
+  closeStream();
+
+  ESP_LOGI(TAG, "Streaming file from URL: %s", url);
+
+  std::string cachedEtag, cachedLastModified;
+  bool        cached = cache.validators(url, cachedEtag, cachedLastModified);
+
+  // The session of the previous request is reused when on the same server
+
+  bool reused = (session != nullptr) && (origin == url_origin(url));
+
+  if (reused) {
+    esp_http_client_set_url(session, url);
+    esp_http_client_delete_header(session, "If-None-Match");
+    esp_http_client_delete_header(session, "If-Modified-Since");
   }
-  esp_http_client_cleanup(client);
+  else {
+    closeSession();
 
-  *defaultLen = buffer_size;
+    esp_http_client_config_t config;
 
-  return buffer;
+    memset(&config, 0, sizeof(config));
+
+    config.url               = url;
+    config.event_handler     = stream_event_handler;
+    config.user_data         = this;
+    config.keep_alive_enable = true;
+
+    #if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+    config.crt_bundle_attach = esp_crt_bundle_attach;
+    #endif
+
+    #if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    config.save_client_session = true;
+    #endif
+
+    session = esp_http_client_init(&config);
+    if (session == nullptr) return false;
+    origin = url_origin(url);
+  }
+
+  if (cached) {
+    if (!cachedEtag.empty()) esp_http_client_set_header(session, "If-None-Match", cachedEtag.c_str());
+    if (!cachedLastModified.empty()) esp_http_client_set_header(session, "If-Modified-Since", cachedLastModified.c_str());
+  }
+
+  // Redirections are followed, as esp_http_client_perform() does, up to
+  // MAX_REDIRECTS hops. The server may have closed an idle connection: one
+  // more try on a new one.
+
+  int64_t length = ESP_FAIL;
+  int     status = 0;
+  for (int hops = 0; ; hops++) {
+    etag.clear();
+    lastModified.clear();
+
+    for (int attempt = (reused || (hops > 0)) ? 2 : 1; attempt > 0; attempt--) {
+      if ((esp_http_client_open(session, 0) == ESP_OK) && ((length = esp_http_client_fetch_headers(session)) >= 0)) break;
+      esp_http_client_close(session);
+      length = ESP_FAIL;
+    }
+    if (length < 0) break;
+
+    status = esp_http_client_get_status_code(session);
+    if (((status != 301) && (status != 302) && (status != 303) && (status != 307) && (status != 308)) ||
+        (hops == MAX_REDIRECTS)) {
+      break;
+    }
+
+    esp_http_client_flush_response(session, nullptr);
+    if (esp_http_client_set_redirection(session) != ESP_OK) break;
+    ESP_LOGI(TAG, "Status = %d, redirected", status);
+  }
+
+  if (length < 0) {
+    ESP_LOGE(TAG, "Unable to connect to %s", url);
+    closeSession();
+    return false;
+  }
+
+  // Chunked: length unknown. Otherwise, the Content-Length, 0 included
+
+  streaming    = true;
+  streamLength = esp_http_client_is_chunked_response(session) ? -1 : (int32_t) length;
+  streamRead   = 0;
+
+  ESP_LOGI(TAG, "Status = %d, content_length = %" PRIi64 ", %s connection", status, length, reused ? "reused" : "new");
+
+  if (status != 200) {
+    esp_http_client_flush_response(session, nullptr);
+    closeStream();
+  }
+
+  if ((status == 304) && cached) {
+    notModified = true;
+    if (skipNotModified) return false;
+
+    // Body lost (e.g. removed from the card): asked again, without validators
+
+    int32_t size;
+    if ((cachedFile = cache.open(url, &size)) == nullptr) {
+      ESP_LOGE(TAG, "Cached copy of %s missing, downloading it again", url);
+      cache.remove(url);
+      return openStream(url, contentLength);
+    }
+
+    ESP_LOGI(TAG, "Not modified, %" PRIi32 " bytes read from the cache", size);
+    if (contentLength != nullptr) *contentLength = size;
+    return true;
+  }
+
+  if (status != 200) return false;
+
+  caching      = (!etag.empty() || !lastModified.empty()) && cache.begin(url);
+
+  if (cached && !caching) cache.remove(url);
+
+  if (contentLength != nullptr) *contentLength = streamLength;
+
+  return true;
+}
+
+int32_t
+NetworkClient::readSome(uint8_t * buf, int32_t len)
+{
+  if (cachedFile != nullptr) {
+    size_t size = fread(buf, 1, len, cachedFile);
+    return ((size == 0) && ferror(cachedFile)) ? -1 : size;
+  }
+
+  if (!streaming) return -1;
+
+  int size = esp_http_client_read(session, (char *) buf, len);
+  if (size > 0) {
+    streamRead += size;
+    if (caching && !cache.write(buf, size)) caching = false;
+  }
+  return size;
+}
+
+int32_t
+NetworkClient::readStream(uint8_t * buf, int32_t len)
+{
+  int32_t total = 0;
+
+  while (total < len) {
+    int32_t size = readSome(buf + total, len - total);
+    if (size < 0) return -1;
+    if (size == 0) break;
+    total += size;
+  }
+
+  return total;
+}
+
+// A body being cached is read up to its end, even if the caller stopped
+// before: the next requests can then be answered with a 304. Otherwise, a
+// short known remainder is skipped to keep the connection for the next
+// request.
+
+void
+NetworkClient::closeStream()
+{
+  if (cachedFile != nullptr) {
+    fclose(cachedFile);
+    cachedFile = nullptr;
+  }
+
+  if (streaming) {
+    uint8_t buf[512];
+    int32_t size;
+
+    if (caching) {
+      while ((size = readSome(buf, sizeof(buf))) > 0) {}
+      caching = false;
+      if ((size == 0) && ((streamLength < 0) || (streamRead == streamLength))) cache.commit(etag, lastModified);
+      else cache.abort();
+    }
+    else if ((streamLength >= 0) && (streamLength - streamRead <= DRAIN_LIMIT)) {
+      while ((streamRead < streamLength) && (readSome(buf, sizeof(buf)) > 0)) {}
+    }
+    streaming = false;
+
+    if (!esp_http_client_is_complete_data_received(session)) esp_http_client_close(session);
+  }
+}
+
+void
+NetworkClient::closeSession()
+{
+  closeStream();
+
+  if (session != nullptr) {
+    esp_http_client_close(session);
+    esp_http_client_cleanup(session);
+    session = nullptr;
+    origin.clear();
+  }
 }
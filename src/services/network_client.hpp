@@ -18,21 +18,167 @@ Distributed as-is; no warranty is given.
 #pragma once
 
 #include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+#include "esp_http_client.h"
+#include "http_cache.hpp"
 
 class NetworkClient
 {
   public:
-    NetworkClient() : connected(false) {}
+    NetworkClient() : connected(false), session(nullptr) {}
 
     bool joinAP(const char * ssid, const char * pass);
     void disconnect();
 
     inline bool isConnected() { return connected; }
 
+    /**
+     * @brief Connect faster after a deep sleep
+     *
+     * The channel and BSSID of the last access point are kept in RTC memory.
+     * joinAP() then associates with it directly, without a scan, and falls
+     * back to a scan if that fails.
+     *
+     * @param reuseLease Also reuse the last DHCP address, as a static one,
+     *                   skipping DHCP. Only for networks where the address
+     *                   is reserved for the device.
+     */
+    void setFastConnect(bool enable, bool reuseLease = false);
+
+    /**
+     * @brief Use a static address instead of DHCP
+     *
+     * @param ip Dotted address, nullptr to go back to DHCP.
+     * @param dns DNS server, optional.
+     * @return false if an address is invalid.
+     */
+    bool setStaticIP(const char * ip, const char * netmask, const char * gateway, const char * dns = nullptr);
+
+    /**
+     * @brief Delays between the connection retries
+     *
+     * The first retry waits firstMs, each following one twice the previous
+     * delay, up to maxMs. Default: 500 ms up to 10 s.
+     */
+    void setRetryDelays(uint32_t firstMs, uint32_t maxMs);
+
+    /**
+     * @brief Download a file in memory
+     *
+     * The buffer is allocated with the body length given by the server. When
+     * the length is unknown (chunked response), it starts at *defaultLen
+     * bytes and grows as needed.
+     *
+     * @param url The file to download
+     * @param defaultLen In: initial size when the length is unknown. Out: the
+     *                   file size.
+     * @return The file content, to be freed by the caller, nullptr on error.
+     */
     uint8_t * downloadFile(const char * url, int32_t * defaultLen);
 
+    typedef std::function<bool(const uint8_t * data, int32_t len)> DataCallback;
+
+    /**
+     * @brief Download a file, a chunk at a time
+     *
+     * onData() receives the body as it arrives, in pieces of up to chunkSize
+     * bytes, and returns false to stop the download. Only chunkSize bytes of
+     * memory are used, whatever the file size.
+     *
+     * @return true if the whole body was received and accepted.
+     */
+    bool download(const char * url, DataCallback onData, int32_t chunkSize = 2048);
+
+    /**
+     * @brief Streamed download
+     *
+     * openStream() sends the request and gets the response headers. The body is
+     * then pulled with readStream() as it arrives, without being buffered in
+     * memory. Only one stream can be opened at a time.
+     *
+     * The HTTP connection is kept open after the stream is closed and reused
+     * by the next requests to the same server (HTTP/1.1 keep-alive), avoiding
+     * a new TCP connection and TLS handshake for each file. Redirections
+     * (301, 302, 303, 307 and 308) are followed, up to MAX_REDIRECTS hops.
+     *
+     * @param url The file to download
+     * @param contentLength If not null, receives the body length, -1 if unknown (chunked).
+     * @return true if the server answered with a 200 status.
+     */
+    bool openStream(const char * url, int32_t * contentLength = nullptr);
+
+    /**
+     * @brief Read the next bytes of the opened stream
+     *
+     * Waits for len bytes, unless the end of the body is reached first.
+     *
+     * @return The number of bytes read, 0 at the end of the body, -1 on error.
+     */
+    int32_t readStream(uint8_t * buf, int32_t len);
+
+    void closeStream();
+
+    /**
+     * @brief Close the connection kept for the next requests
+     *
+     * Done by disconnect(), or when a request goes to another server.
+     */
+    void closeSession();
+
+    /**
+     * @brief Keep the downloaded files in a cache directory
+     *
+     * Files sent with an ETag or Last-Modified header are kept in the cache
+     * (see http_cache.hpp) when completely received. They are then asked for
+     * with If-None-Match / If-Modified-Since: when the server answers 304
+     * (not modified), the cached copy is read instead, without downloading
+     * it again.
+     *
+     * @param dir Cache directory, e.g. "/sdcard/cache", nullptr to disable.
+     */
+    bool setCache(const char * dir);
+
+    /**
+     * @brief Fail instead of reading the cached copy of unmodified files
+     *
+     * When set, openStream() returns false on a 304 answer, with
+     * isNotModified() true: the file doesn't need to be processed again.
+     */
+    inline void setSkipNotModified(bool skip) { skipNotModified = skip; }
+
+    // The server answered 304 to the last openStream()
+
+    inline bool isNotModified() { return notModified; }
+    inline void clearNotModified() { notModified = false; }
+
+    void onHeader(const char * key, const char * value);
+
   private:
     bool connected;
+    esp_http_client_handle_t session;  // Kept between requests to the same server
+    std::string              origin;   // Scheme, host and port of the session
+    bool                     streaming{false};
+
+    // Largest rest of a body skipped by closeStream() to keep the connection
+
+    static constexpr int32_t DRAIN_LIMIT = 4096;
+
+    // Redirections followed by openStream()
+
+    static constexpr int MAX_REDIRECTS = 5;
+
+    HttpCache   cache;
+    FILE *      cachedFile{nullptr};  // Body of an unmodified file
+    bool        caching{false};       // The body is written to the cache
+    bool        notModified{false};
+    bool        skipNotModified{false};
+    int32_t     streamLength{-1}, streamRead{0};
+    std::string etag, lastModified;   // Validators of the last answer
+
+    int32_t readSome(uint8_t * buf, int32_t len);
 };
 
 #if __NETWORK_CLIENT__
@@ -0,0 +1,214 @@
+/*
+raw_image.hpp
+Inkplate 6 ESP-IDF
+
+Raw pictures: frame buffer images, ready to be loaded as they are.
+
+This code is released under the GNU Lesser General Public License v3.0: https://www.gnu.org/licenses/lgpl-3.0.en.html
+*/
+
+#ifndef __RAW_IMAGE_HPP__
+#define __RAW_IMAGE_HPP__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * @brief Raw picture header
+ *
+ * A raw picture is the content of a FrameBuffer1Bit or FrameBuffer3Bit for a
+ * given panel, preceded by a 16 bytes header (numbers are little-endian):
+ *
+ *   0  'I', 'P', 'R', 'W'
+ *   4  uint16_t  width, in panel pixels (rotation 0)
+ *   6  uint16_t  height
+ *   8  uint8_t   bits per pixel: 1 or 3
+ *   9  uint8_t   compression: 0 (none) or 1 (RLE)
+ *  10  uint16_t  0
+ *  12  uint32_t  data size, in bytes, following the header
+ *
+ * 1 bit: width / 8 bytes per row, bit k of a byte being pixel 8n + k, 1 for
+ * black. 3 bit: width / 2 bytes per row, even pixels in the high nibble, 0
+ * for black to 7 for white.
+ *
+ * RLE: a control byte c below 128 is followed by c + 1 bytes to copy; from
+ * 128, by a single byte to repeat c - 125 times (3 to 130).
+ *
+ * tools/png2raw builds raw pictures from PNG files. EInk::save_state() and
+ * Graphics::saveRawToFile() save the panel state and the frame buffer as raw
+ * pictures.
+ */
+struct RawImageHeader
+{
+  static constexpr int     SIZE = 16;
+  static constexpr uint8_t NONE = 0, RLE = 1;
+
+  uint16_t width, height;
+  uint8_t  bits;
+  uint8_t  compression;
+  uint32_t size;
+
+  static int32_t data_size(uint16_t w, uint16_t h, uint8_t bits) {
+    return (int32_t) ((bits == 1) ? ((w + 7) >> 3) : ((w + 1) >> 1)) * h;
+  }
+
+  // false when buf doesn't hold a supported raw picture header
+
+  bool parse(const uint8_t * buf) {
+    if ((buf[0] != 'I') || (buf[1] != 'P') || (buf[2] != 'R') || (buf[3] != 'W')) return false;
+    width       = buf[4] | (buf[5] << 8);
+    height      = buf[6] | (buf[7] << 8);
+    bits        = buf[8];
+    compression = buf[9];
+    size        = buf[12] | (buf[13] << 8) | (buf[14] << 16) | ((uint32_t) buf[15] << 24);
+    return ((bits == 1) || (bits == 3)) && (compression <= RLE) && (width > 0) && (height > 0);
+  }
+
+  void write(uint8_t * buf) const {
+    const uint8_t values[SIZE] = {
+      'I', 'P', 'R', 'W', (uint8_t) width, (uint8_t) (width >> 8), (uint8_t) height, (uint8_t) (height >> 8),
+      bits, compression, 0, 0, (uint8_t) size, (uint8_t) (size >> 8), (uint8_t) (size >> 16), (uint8_t) (size >> 24)
+    };
+    for (int i = 0; i < SIZE; i++) buf[i] = values[i];
+  }
+};
+
+/**
+ * @brief Streaming RLE decoder
+ *
+ * The compressed data can be given in pieces of any size, control bytes,
+ * runs and literal sequences being split between them.
+ */
+struct RawRleDecoder
+{
+  int32_t literal{0};  // Bytes still to copy
+  int32_t run{0};      // Times to repeat the next byte
+
+  // Expands len compressed bytes into dst, without going past dst_end.
+  // Returns the new end of the expanded data.
+
+  uint8_t * expand(const uint8_t * src, int32_t len, uint8_t * dst, uint8_t * dst_end) {
+    for (const uint8_t * end = src + len; (src < end) && (dst < dst_end);) {
+      if (literal > 0) {
+        int32_t n = std::min<int32_t>(std::min<int32_t>(literal, end - src), dst_end - dst);
+        memcpy(dst, src, n);
+        src += n, dst += n, literal -= n;
+      }
+      else if (run > 0) {
+        int32_t n = std::min<int32_t>(run, dst_end - dst);
+        memset(dst, *src++, n);
+        dst += n, run = 0;
+      }
+      else if (*src < 128) literal = *src++ + 1;
+      else                 run     = *src++ - 125;
+    }
+    return dst;
+  }
+};
+
+/**
+ * @brief RLE encoder
+ *
+ * The compressed data is given to write(const uint8_t * buf, int32_t len),
+ * returning false to stop the encoding, in pieces of up to 512 bytes.
+ *
+ * @return false if write() failed.
+ */
+template <typename Writer>
+bool raw_rle_encode(const uint8_t * data, int32_t size, Writer write)
+{
+  uint8_t out[512];
+  int32_t len = 0, i = 0, literal = 0;  // The literal bytes start at i - literal
+
+  auto emit = [&](const uint8_t * p, int32_t n) {
+    if ((len + n) > (int32_t) sizeof(out)) {
+      if (!write(out, len)) return false;
+      len = 0;
+    }
+    memcpy(out + len, p, n);
+    len += n;
+    return true;
+  };
+
+  auto flush_literal = [&]() {
+    for (int32_t start = i - literal; literal > 0;) {
+      int32_t n = std::min<int32_t>(literal, 128);
+      uint8_t c = n - 1;
+      if (!emit(&c, 1) || !emit(data + start, n)) return false;
+      start += n, literal -= n;
+    }
+    return true;
+  };
+
+  while (i < size) {
+    int32_t run = 1;
+    while (((i + run) < size) && (run < 130) && (data[i + run] == data[i])) run++;
+    if (run >= 3) {
+      uint8_t r[2] = { (uint8_t) (run + 125), data[i] };
+      if (!flush_literal() || !emit(r, 2)) return false;
+      i += run;
+    }
+    else {
+      i++;
+      literal++;
+    }
+  }
+  return flush_literal() && ((len == 0) || write(out, len));
+}
+
+/**
+ * @brief Save data as an RLE compressed raw picture
+ *
+ * The header is written last, once the compressed size is known: the file
+ * must be seekable. It is left open, positioned after the picture.
+ */
+inline bool raw_save(FILE * f, const RawImageHeader & header, const uint8_t * data)
+{
+  RawImageHeader h = header;
+  uint8_t        head[RawImageHeader::SIZE] = { 0 };
+
+  h.compression = RawImageHeader::RLE;
+  h.size        = 0;
+  if (fwrite(head, 1, sizeof(head), f) != sizeof(head)) return false;
+
+  bool ok = raw_rle_encode(data, RawImageHeader::data_size(h.width, h.height, h.bits),
+    [f, &h](const uint8_t * buf, int32_t len) {
+      h.size += len;
+      return fwrite(buf, 1, len, f) == (size_t) len;
+    });
+
+  h.write(head);
+  return ok && (fseek(f, -(long) (h.size + sizeof(head)), SEEK_CUR) == 0) &&
+         (fwrite(head, 1, sizeof(head), f) == sizeof(head)) && (fseek(f, h.size, SEEK_CUR) == 0);
+}
+
+/**
+ * @brief Same, in memory
+ *
+ * @return The size of the raw picture, 0 if it doesn't fit in size bytes.
+ */
+inline int32_t raw_save(uint8_t * buf, int32_t size, const RawImageHeader & header, const uint8_t * data)
+{
+  RawImageHeader h    = header;
+  int32_t        used = RawImageHeader::SIZE;
+
+  if (size < used) return 0;
+
+  bool ok = raw_rle_encode(data, RawImageHeader::data_size(h.width, h.height, h.bits),
+    [buf, size, &used](const uint8_t * src, int32_t len) {
+      if ((used + len) > size) return false;
+      memcpy(buf + used, src, len);
+      used += len;
+      return true;
+    });
+  if (!ok) return 0;
+
+  h.compression = RawImageHeader::RLE;
+  h.size        = used - RawImageHeader::SIZE;
+  h.write(buf);
+  return used;
+}
+
+#endif
@@ -0,0 +1,109 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host timings of the EInk driver update methods, with the bus activity
+// recorded by the simulation layer.
+//
+// The host time gives the relative cost of the code run between the bus
+// accesses; the counts give what the hardware would have to go through.
+
+#include "graphics.hpp"
+#include "inkplate_platform.hpp"
+#include "wire.hpp"
+
+#include "sim_bus.hpp"
+#include "sim_panel.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+static void
+bench(const char * name, int count, std::function<void()> op)
+{
+  SimBus::reset_stats();
+  SimPanel::get_singleton().reset_stats();
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; i++) op();
+  auto stop  = std::chrono::steady_clock::now();
+
+  double ms = std::chrono::duration<double, std::milli>(stop - start).count() / count;
+
+  SimBus::Stats   & bus   = SimBus::get_stats();
+  SimPanel::Stats & panel = SimPanel::get_singleton().get_stats();
+
+  printf("%-22s %9.3f ms  gpio: %9llu  i2s lines: %6llu  irq: %6llu  i2c: %5llu  phases: %3llu  rows: %7llu\n",
+         name, ms,
+         (unsigned long long) (bus.gpio_writes      / count),
+         (unsigned long long) (bus.i2s_lines        / count),
+         (unsigned long long) (bus.i2s_interrupts   / count),
+         (unsigned long long) (bus.i2c_transactions / count),
+         (unsigned long long) (panel.frames         / count),
+         (unsigned long long) (panel.rows_latched   / count));
+}
+
+int
+main(int argc, char ** argv)
+{
+  int count = (argc > 1) ? atoi(argv[1]) : 3;
+  if (count < 1) count = 1;
+
+  wire.setup();
+
+  if (!e_ink.setup()) {
+    printf("e_ink.setup() failed\n");
+    return 1;
+  }
+
+  Graphics graphics(e_ink.get_width(), e_ink.get_height());
+  graphics.setDisplayMode(DisplayMode::INKPLATE_1BIT);
+  graphics.setRotation(0);
+
+  printf("Panel %dx%d, %d iterations per operation\n", e_ink.get_width(), e_ink.get_height(), count);
+
+  graphics.clearDisplay();
+  graphics.fillRect(0, 0, graphics.width() / 2, graphics.height() / 2, BLACK);
+
+  bench("update(1bit)", count, [&] { graphics.display(); });
+
+  int toggle = 0;
+  bench("partial_update(small)", count, [&] {
+    graphics.fillRect(graphics.width() / 2 + 20, 20, 64, 32, (toggle++ & 1) ? WHITE : BLACK);
+    graphics.partialUpdate();
+  });
+
+  bench("partial_update(none)", count, [&] { graphics.partialUpdate(); });
+
+  bench("partial_update(rect)", count, [&] {
+    graphics.fillRect(graphics.width() / 2 + 20, 20, 64, 32, (toggle++ & 1) ? WHITE : BLACK);
+    graphics.partialUpdate(graphics.width() / 2 + 20, 20, 64, 32);
+  });
+
+  graphics.selectDisplayMode(DisplayMode::INKPLATE_3BIT);
+  for (int level = 0; level < 8; level++) {
+    graphics.fillRect(level * graphics.width() / 8, 0, graphics.width() / 8, graphics.height(), level);
+  }
+
+  bench("update(3bit)", count, [&] { graphics.display(); });
+
+  // Same updates with the precomputed phase images
+
+  if (!e_ink.set_phase_tables(true)) {
+    printf("set_phase_tables() failed\n");
+    return 1;
+  }
+
+  bench("update(3bit, tables)", count, [&] { graphics.display(); });
+
+  graphics.selectDisplayMode(DisplayMode::INKPLATE_1BIT);
+  graphics.fillRect(0, 0, graphics.width() / 2, graphics.height() / 2, BLACK);
+
+  bench("update(1bit, tables)", count, [&] { graphics.display(); });
+
+  e_ink.set_phase_tables(false);
+
+  return 0;
+}
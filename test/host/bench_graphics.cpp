@@ -0,0 +1,194 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host timings of the Graphics drawing primitives, the pixel by pixel
+// path (drawPixel(), as used before the span fast paths, and the
+// Adafruit_GFX drawChar()) against the span and glyph blitter ones.
+
+#include "graphics.hpp"
+#include "inkplate_platform.hpp"
+#include "wire.hpp"
+
+#ifndef PROGMEM
+  #define PROGMEM
+#endif
+#include "FreeSerif12pt7b.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+static double
+bench(int count, std::function<void()> op)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; i++) op();
+  auto stop  = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::milli>(stop - start).count() / count;
+}
+
+static void
+compare(const char * name, int count, std::function<void()> pixels, std::function<void()> spans)
+{
+  double old_ms = bench(count, pixels);
+  double new_ms = bench(count, spans);
+
+  printf("%-28s old: %9.3f ms  new: %9.3f ms  x%.1f\n", name, old_ms, new_ms, old_ms / new_ms);
+}
+
+// A page of text, as drawn by print().
+
+static void
+text_page(Graphics & graphics, const GFXfont * font)
+{
+  graphics.setFont(font);
+  graphics.setTextSize(1);
+  graphics.setTextColor(BLACK);
+  graphics.setTextWrap(true);
+  graphics.setCursor(0, font ? 20 : 0);
+
+  while (graphics.getCursorY() < graphics.height() - 20) {
+    graphics.print("The quick brown fox jumps over the lazy dog 0123456789. ");
+  }
+  graphics.setFont(nullptr);
+}
+
+// A full page of glyphs laid out directly, drawn by the glyph blitter or by
+// the Adafruit_GFX pixel by pixel drawChar().
+
+static void
+glyph_page(Graphics & graphics, const GFXfont * font, bool blit)
+{
+  const char * text = "The quick brown fox jumps over the lazy dog 0123456789. ";
+  int          n    = 0;
+
+  graphics.setFont(font);
+  for (int16_t y = font->yAdvance; y < graphics.height(); y += font->yAdvance) {
+    int16_t x = 0;
+    for (;;) {
+      char       c     = text[n++ % 56];
+      GFXglyph * glyph = &font->glyph[c - font->first];
+      if ((x + glyph->xAdvance) > graphics.width()) break;
+      if (blit) graphics.drawChar(x, y, c, BLACK, BLACK, 1, 1);
+      else      graphics.Adafruit_GFX::drawChar(x, y, c, BLACK, BLACK, 1, 1);
+      x += glyph->xAdvance;
+    }
+  }
+  graphics.setFont(nullptr);
+}
+
+static void
+pixel_fill(Graphics & graphics, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  for (int16_t j = y; j < y + h; j++) {
+    for (int16_t i = x; i < x + w; i++) graphics.drawPixel(i, j, color);
+  }
+}
+
+int
+main(int argc, char ** argv)
+{
+  int count = (argc > 1) ? atoi(argv[1]) : 20;
+  if (count < 1) count = 1;
+
+  wire.setup();
+
+  Graphics graphics(e_ink.get_width(), e_ink.get_height());
+  graphics.setDisplayMode(DisplayMode::INKPLATE_1BIT);
+
+  printf("Panel %dx%d, %d iterations per operation\n", e_ink.get_width(), e_ink.get_height(), count);
+
+  static const DisplayMode modes[2] = { DisplayMode::INKPLATE_1BIT, DisplayMode::INKPLATE_3BIT };
+
+  for (DisplayMode mode : modes) {
+    graphics.selectDisplayMode(mode);
+
+    for (uint8_t rotation = 0; rotation < 4; rotation += 1) {
+      graphics.setRotation(rotation);
+
+      int16_t w = graphics.width();
+      int16_t h = graphics.height();
+      char    name[40];
+
+      const char * m = (mode == DisplayMode::INKPLATE_1BIT) ? "1bit" : "3bit";
+
+      snprintf(name, sizeof(name), "fillScreen(%s, rot %d)", m, rotation);
+      compare(name, count, [&] { pixel_fill(graphics, 0, 0, w, h, 1); },
+                           [&] { graphics.fillScreen(1); });
+
+      snprintf(name, sizeof(name), "fillRect(%s, rot %d)", m, rotation);
+      compare(name, count, [&] { pixel_fill(graphics, 13, 7, w / 3, h / 3, 0); },
+                           [&] { graphics.fillRect(13, 7, w / 3, h / 3, 0); });
+
+      snprintf(name, sizeof(name), "drawFastHLine(%s, rot %d)", m, rotation);
+      compare(name, count, [&] { for (int16_t y = 0; y < h; y += 4) pixel_fill(graphics, 3, y, w - 6, 1, 0); },
+                           [&] { for (int16_t y = 0; y < h; y += 4) graphics.drawFastHLine(3, y, w - 6, 0); });
+
+      snprintf(name, sizeof(name), "drawFastVLine(%s, rot %d)", m, rotation);
+      compare(name, count, [&] { for (int16_t x = 0; x < w; x += 4) pixel_fill(graphics, x, 3, 1, h - 6, 0); },
+                           [&] { for (int16_t x = 0; x < w; x += 4) graphics.drawFastVLine(x, 3, h - 6, 0); });
+    }
+  }
+
+  for (DisplayMode mode : modes) {
+    graphics.selectDisplayMode(mode);
+
+    for (uint8_t rotation = 0; rotation < 4; rotation += 1) {
+      graphics.setRotation(rotation);
+
+      const char * m = (mode == DisplayMode::INKPLATE_1BIT) ? "1bit" : "3bit";
+      char         name[40];
+
+      snprintf(name, sizeof(name), "page serif12(%s, rot %d)", m, rotation);
+      compare(name, count, [&] { glyph_page(graphics, &FreeSerif12pt7b, false); },
+                           [&] { glyph_page(graphics, &FreeSerif12pt7b, true);  });
+
+      snprintf(name, sizeof(name), "print(%s, rot %d)", m, rotation);
+      printf("%-28s %9.3f ms\n", name, bench(count, [&] { text_page(graphics, nullptr); }));
+
+      snprintf(name, sizeof(name), "print(serif12, %s, rot %d)", m, rotation);
+      printf("%-28s %9.3f ms\n", name, bench(count, [&] { text_page(graphics, &FreeSerif12pt7b); }));
+
+      snprintf(name, sizeof(name), "drawCircle(%s, rot %d)", m, rotation);
+      printf("%-28s %9.3f ms\n", name, bench(count, [&] {
+        for (int16_t r = 4; r < graphics.height() / 2; r += 4) {
+          graphics.drawCircle(graphics.width() / 2, graphics.height() / 2, r, 0);
+        }
+      }));
+    }
+  }
+
+  // Glyph cache
+
+  if (!graphics.setGlyphCache(64 * 1024)) {
+    printf("setGlyphCache() failed\n");
+    return 1;
+  }
+
+  for (DisplayMode mode : modes) {
+    graphics.selectDisplayMode(mode);
+
+    for (uint8_t rotation = 0; rotation < 4; rotation += 1) {
+      graphics.setRotation(rotation);
+
+      const char * m = (mode == DisplayMode::INKPLATE_1BIT) ? "1bit" : "3bit";
+      char         name[40];
+
+      snprintf(name, sizeof(name), "cached serif12(%s, rot %d)", m, rotation);
+      compare(name, count, [&] { glyph_page(graphics, &FreeSerif12pt7b, false); },
+                           [&] { glyph_page(graphics, &FreeSerif12pt7b, true);  });
+    }
+  }
+
+  GlyphCache::Stats stats = graphics.getGlyphCacheStats();
+  printf("glyph cache: %u entries, %u bytes, %u hits, %u misses, %u evictions\n",
+         (unsigned) stats.entries, (unsigned) stats.bytes, 
+         (unsigned) stats.hits, (unsigned) stats.misses, (unsigned) stats.evictions);
+
+  graphics.setGlyphCache(0);
+
+  return 0;
+}
@@ -0,0 +1,310 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host timings of the image decoders, on a reference 800x600 photo-like
+// JPEG picture. "old" is the RGB565 decoding with a pixel by pixel
+// conversion (as drawJpegChunk() used to do it), "new" the current decoder
+// path (luminance only decoding, whole block conversion).
+
+#include "graphics.hpp"
+#include "inkplate_platform.hpp"
+#include "tjpg_decoder.hpp"
+#include "wire.hpp"
+
+#include "jpeg_writer.hpp"
+#include "pictures.hpp"
+#include "png_writer.hpp"
+#include "bmp_writer.hpp"
+#include "raw_image.hpp"
+#include "pngle.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+static double
+bench(int count, std::function<void()> op)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; i++) op();
+  auto stop  = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::milli>(stop - start).count() / count;
+}
+
+static void
+compare(const char * name, int count, std::function<void()> old_op, std::function<void()> new_op)
+{
+  double old_ms = bench(count, old_op);
+  double new_ms = bench(count, new_op);
+
+  printf("%-28s old: %9.3f ms  new: %9.3f ms  x%.1f\n", name, old_ms, new_ms, old_ms / new_ms);
+}
+
+static void
+single(const char * name, int count, std::function<void()> op)
+{
+  printf("%-28s      %9.3f ms\n", name, bench(count, op));
+}
+
+static Graphics * graphics_ptr;
+
+static bool
+pixel_chunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t * bitmap, bool dither, bool invert)
+{
+  Graphics & graphics = *graphics_ptr;
+
+  for (int j = 0; j < h; j++) {
+    for (int i = 0; i < w; i++) {
+      uint16_t rgb = bitmap[j * w + i];
+      uint8_t  val = Image::rgb3Bit(Image::red(rgb), Image::green(rgb), Image::blue(rgb));
+      if (invert) val = 7 - val;
+      if (graphics.getDisplayMode() == DisplayMode::INKPLATE_1BIT) val = (~val >> 2) & 1;
+      graphics.drawPixel(x + i, y + j, val);
+    }
+  }
+  return true;
+}
+
+static bool
+null_chunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t * bitmap, bool dither, bool invert)
+{
+  return true;
+}
+
+static bool
+null_gray_chunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t * bitmap, bool dither, bool invert)
+{
+  return true;
+}
+
+// PNG pixels, as pngle_on_draw() used to draw all of them
+
+static void
+pixel_png(pngle_t * pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t rgba[4])
+{
+  Graphics & graphics = *graphics_ptr;
+
+  if (!rgba[3]) return;
+  uint8_t val = Image::rgb3Bit(rgba[0], rgba[1], rgba[2]);
+  if (graphics.getDisplayMode() == DisplayMode::INKPLATE_1BIT) val = (~val >> 2) & 1;
+  graphics.drawPixel(x, y, val);
+}
+
+static void
+png_old(const std::vector<uint8_t> & png)
+{
+  pngle_t * pngle = pngle_new();
+  pngle_set_draw_callback(pngle, pixel_png);
+  pngle_feed(pngle, png.data(), png.size());
+  pngle_destroy(pngle);
+}
+
+// Decoding alone, the scanlines being dropped
+
+static void
+png_inflate(const std::vector<uint8_t> & png)
+{
+  pngle_t * pngle = pngle_new();
+  pngle_set_row_callback(pngle, [](pngle_t *, uint32_t, const uint8_t *, size_t) {});
+  pngle_feed(pngle, png.data(), png.size());
+  pngle_destroy(pngle);
+}
+
+static void
+png_new(Graphics & graphics, const std::vector<uint8_t> & png)
+{
+  FILE * f = fmemopen((void *) png.data(), png.size(), "r");
+  graphics.drawPngFromFile(f, 0, 0, false, false);
+}
+
+// BMP rows, as drawBitmapFromFile() used to read and draw them: one fread()
+// per row, pixels drawn one by one
+
+static void
+bmp_old(Graphics & graphics, const std::vector<uint8_t> & bmp, int w, int h, int bpp)
+{
+  FILE *               f        = fmemopen((void *) bmp.data(), bmp.size(), "r");
+  int                  row_size = ((bpp * w + 31) / 32) * 4;
+  std::vector<uint8_t> row(row_size);
+  bool                 one_bit  = graphics.getDisplayMode() == DisplayMode::INKPLATE_1BIT;
+
+  fseek(f, bmp[10] | (bmp[11] << 8), SEEK_SET);
+  for (int i = 0; i < h; i++) {
+    fread(row.data(), row_size, 1, f);
+    for (int x = 0; x < w; x++) {
+      uint8_t val;
+      if (bpp == 1) val = ((row[x >> 3] >> (7 - (x & 7))) & 1) ? 7 : 0;
+      else          val = Image::rgb3Bit(row[x * 3 + 2], row[x * 3 + 1], row[x * 3]);
+      if (one_bit) val = (~val >> 2) & 1;
+      graphics.drawPixel(x, h - 1 - i, val);
+    }
+  }
+  fclose(f);
+}
+
+static void
+bmp_new(Graphics & graphics, const std::vector<uint8_t> & bmp)
+{
+  FILE * f = fmemopen((void *) bmp.data(), bmp.size(), "r");
+  graphics.drawBitmapFromFile(f, 0, 0, false, false);
+}
+
+// Decoded blocks, kept to time their conversion without the decoding
+
+template <typename T>
+struct Block {
+  int16_t        x, y;
+  uint16_t       w, h;
+  std::vector<T> pixels;
+};
+
+static std::vector<Block<uint16_t>> rgb_blocks;
+static std::vector<Block<uint8_t>>  gray_blocks;
+
+static bool
+keep_chunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t * bitmap, bool dither, bool invert)
+{
+  rgb_blocks.push_back({ x, y, w, h, std::vector<uint16_t>(bitmap, bitmap + w * h) });
+  return true;
+}
+
+static bool
+keep_gray_chunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t * bitmap, bool dither, bool invert)
+{
+  gray_blocks.push_back({ x, y, w, h, std::vector<uint8_t>(bitmap, bitmap + w * h) });
+  return true;
+}
+
+template <typename T, typename C>
+static void
+replay(std::vector<Block<T>> & blocks, C chunk)
+{
+  for (Block<T> & b : blocks) chunk(b.x, b.y, b.w, b.h, b.pixels.data(), false, false);
+}
+
+int
+main(int argc, char ** argv)
+{
+  int count = (argc > 1) ? atoi(argv[1]) : 10;
+  if (count < 1) count = 1;
+
+  wire.setup();
+
+  Graphics graphics(e_ink.get_width(), e_ink.get_height());
+  graphics.setDisplayMode(DisplayMode::INKPLATE_1BIT);
+  graphics_ptr = &graphics;
+
+  std::vector<uint8_t> rgb  = picture(800, 600);
+  std::vector<uint8_t> jpeg = JpegWriter::encode(rgb.data(), 800, 600);
+
+  std::vector<uint16_t> rgb_samples(rgb.begin(), rgb.end()), gray_samples, bw_samples;
+  for (size_t i = 0; i < rgb.size(); i += 3) gray_samples.push_back(rgb[i + 1] >> 4);
+  for (size_t i = 0; i < rgb.size(); i += 3) bw_samples.push_back(rgb[i + 1] >> 7);
+  std::vector<uint8_t> png_rgb  = PngWriter::encode(rgb_samples,  800, 600, 2, 8);
+  std::vector<uint8_t> png_gray = PngWriter::encode(gray_samples, 800, 600, 0, 4);
+  std::vector<uint8_t> png_bw   = PngWriter::encode(bw_samples,   800, 600, 0, 1);
+
+  std::vector<uint32_t> rgb_pixels, bw_pixels(bw_samples.begin(), bw_samples.end());
+  for (size_t i = 0; i < rgb.size(); i += 3) rgb_pixels.push_back((rgb[i] << 16) | (rgb[i + 1] << 8) | rgb[i + 2]);
+  std::vector<uint8_t> bmp_rgb = BmpWriter::encode(rgb_pixels, 800, 600, 24);
+  std::vector<uint8_t> bmp_bw  = BmpWriter::encode(bw_pixels,  800, 600, 1, { 0, 0, 0, 255, 255, 255 });
+
+  printf("Panel %dx%d, 800x600 JPEG (%zu bytes), %d iterations per operation\n",
+         e_ink.get_width(), e_ink.get_height(), jpeg.size(), count);
+
+  TJpgDec.setJpgScale(1);
+  compare("jpeg decode only", count,
+          [&] { TJpgDec.setCallback(null_chunk);
+                TJpgDec.drawJpg(0, 0, jpeg.data(), jpeg.size(), false, false); },
+          [&] { TJpgDec.setGrayCallback(null_gray_chunk);
+                TJpgDec.drawJpg(0, 0, jpeg.data(), jpeg.size(), false, false); });
+
+  TJpgDec.setCallback(keep_chunk);
+  TJpgDec.drawJpg(0, 0, jpeg.data(), jpeg.size(), false, false);
+  TJpgDec.setGrayCallback(keep_gray_chunk);
+  TJpgDec.drawJpg(0, 0, jpeg.data(), jpeg.size(), false, false);
+
+  // The library block converter is the callback left by drawJpegFromBuffer()
+
+  graphics.drawJpegFromBuffer(jpeg.data(), jpeg.size(), 0, 0, false, false);
+  GrayCallback block_chunk = TJpgDec.gray_output;
+
+  static const DisplayMode modes[2] = { DisplayMode::INKPLATE_1BIT, DisplayMode::INKPLATE_3BIT };
+
+  for (DisplayMode mode : modes) {
+    graphics.selectDisplayMode(mode);
+
+    const char * m = (mode == DisplayMode::INKPLATE_1BIT) ? "1bit" : "3bit";
+    char         name[40];
+
+    snprintf(name, sizeof(name), "blocks 800x600(%s)", m);
+    compare(name, count, [&] { replay(rgb_blocks, pixel_chunk); }, [&] { replay(gray_blocks, block_chunk); });
+
+    snprintf(name, sizeof(name), "jpeg 800x600(%s)", m);
+    compare(name, count,
+            [&] { TJpgDec.setJpgScale(1);
+                  TJpgDec.setCallback(pixel_chunk);
+                  TJpgDec.drawJpg(0, 0, jpeg.data(), jpeg.size(), false, false); },
+            [&] { graphics.drawJpegFromBuffer(jpeg.data(), jpeg.size(), 0, 0, false, false); });
+
+    // Dithering: "old" is error diffusion, "new" the ordered Bayer dither
+
+    auto dithered = [&](Image::Dither d, std::function<void()> op) {
+      return [&graphics, d, op] { graphics.setDither(d); op(); graphics.setDither(Image::FloydSteinberg); };
+    };
+    auto jpeg_dither = [&] { graphics.drawJpegFromBuffer(jpeg.data(), jpeg.size(), 0, 0, true, false); };
+    auto bmp_dither  = [&] { graphics.drawBitmapFromBuffer(bmp_rgb.data(), 0, 0, true, false); };
+
+    snprintf(name, sizeof(name), "jpeg 800x600 dither(%s)", m);
+    compare(name, count, dithered(Image::FloydSteinberg, jpeg_dither), dithered(Image::Bayer, jpeg_dither));
+
+    snprintf(name, sizeof(name), "bmp 24 800x600 dither(%s)", m);
+    compare(name, count, dithered(Image::FloydSteinberg, bmp_dither), dithered(Image::Bayer, bmp_dither));
+
+    snprintf(name, sizeof(name), "png rgb 800x600(%s)", m);
+    compare(name, count, [&] { png_old(png_rgb); }, [&] { png_new(graphics, png_rgb); });
+
+    snprintf(name, sizeof(name), "png gray4 800x600(%s)", m);
+    compare(name, count, [&] { png_old(png_gray); }, [&] { png_new(graphics, png_gray); });
+
+    snprintf(name, sizeof(name), "png gray1 800x600(%s)", m);
+    compare(name, count, [&] { png_old(png_bw); }, [&] { png_new(graphics, png_bw); });
+
+    // Full screen: the frame buffer, saved as an uncompressed raw picture
+
+    std::vector<uint16_t> screen_samples(size_t(e_ink.get_width()) * e_ink.get_height(), 0);
+    for (size_t i = 0; i < screen_samples.size(); i++) screen_samples[i] = (i * 7 / e_ink.get_width()) & 0x0F;
+    std::vector<uint8_t> png_screen = PngWriter::encode(screen_samples, e_ink.get_width(), e_ink.get_height(), 0, 4);
+
+    graphics.setRotation(0);
+    png_new(graphics, png_screen);
+    FrameBuffer * fb = (mode == DisplayMode::INKPLATE_1BIT) ? (FrameBuffer *) graphics._partial : graphics.DMemory4Bit;
+
+    RawImageHeader header = { (uint16_t) e_ink.get_width(), (uint16_t) e_ink.get_height(),
+                              (uint8_t)((mode == DisplayMode::INKPLATE_1BIT) ? 1 : 3), RawImageHeader::NONE,
+                              (uint32_t) fb->get_data_size() };
+    std::vector<uint8_t> raw(RawImageHeader::SIZE);
+    header.write(raw.data());
+    raw.insert(raw.end(), fb->get_data(), fb->get_data() + fb->get_data_size());
+
+    snprintf(name, sizeof(name), "screen png gray4(%s)", m);
+    single(name, count, [&] { png_new(graphics, png_screen); });
+
+    snprintf(name, sizeof(name), "screen raw(%s)", m);
+    single(name, count, [&] { graphics.drawRawFromFile(fmemopen((void *) raw.data(), raw.size(), "r")); });
+
+    snprintf(name, sizeof(name), "bmp 24 800x600(%s)", m);
+    compare(name, count, [&] { bmp_old(graphics, bmp_rgb, 800, 600, 24); }, [&] { bmp_new(graphics, bmp_rgb); });
+
+    snprintf(name, sizeof(name), "bmp 1 800x600(%s)", m);
+    compare(name, count, [&] { bmp_old(graphics, bmp_bw, 800, 600, 1); }, [&] { bmp_new(graphics, bmp_bw); });
+  }
+
+  single("png gray4 inflate only", count, [&] { png_inflate(png_gray); });
+  single("png gray1 inflate only", count, [&] { png_inflate(png_bw); });
+
+  return 0;
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#pragma once
+
+// Minimal BMP encoder (BITMAPINFOHEADER, uncompressed), used to build the
+// pictures decoded by the host checks and benchmarks.
+
+#include <cstdint>
+#include <vector>
+
+class BmpWriter
+{
+  public:
+    // samples: w * h values, row-major, top row first. 1, 4 and 8 bits:
+    // palette indices (palette: 3 bytes per entry, red, green, blue); 16 bits:
+    // 0RRRRRGGGGGBBBBB; 24 and 32 bits: 0xRRGGBB. The rows are stored
+    // bottom-up, unless top_down is set.
+
+    static std::vector<uint8_t> encode(const std::vector<uint32_t> & samples, int w, int h, uint16_t bpp,
+                                       const std::vector<uint8_t> & palette = {}, bool top_down = false)
+    {
+      std::vector<uint8_t> out;
+
+      uint32_t colors   = (bpp <= 8) ? palette.size() / 3 : 0;
+      uint32_t start    = 14 + 40 + colors * 4;
+      uint32_t row_size = ((bpp * w + 31) / 32) * 4;
+
+      auto word16 = [&](uint16_t v) { out.push_back(v); out.push_back(v >> 8); };
+      auto word32 = [&](uint32_t v) { word16(v); word16(v >> 16); };
+
+      word16(0x4D42); word32(start + row_size * h); word32(0); word32(start);
+      word32(40); word32(w); word32(top_down ? -h : h); word16(1); word16(bpp);
+      word32(0); word32(row_size * h); word32(2835); word32(2835); word32(colors); word32(0);
+
+      for (uint32_t i = 0; i < colors; i++) {
+        out.insert(out.end(), { palette[i * 3 + 2], palette[i * 3 + 1], palette[i * 3], 0 });
+      }
+
+      for (int r = 0; r < h; r++) {
+        const uint32_t *     src = &samples[size_t(top_down ? r : h - 1 - r) * w];
+        std::vector<uint8_t> row(row_size, 0);
+        for (int x = 0; x < w; x++) {
+          uint32_t v = src[x];
+          switch (bpp) {
+            case 1:  row[x >> 3] |= v << (7 - (x & 7));        break;
+            case 4:  row[x >> 1] |= v << ((x & 1) ? 0 : 4);    break;
+            case 8:  row[x] = v;                               break;
+            case 16: row[x * 2] = v; row[x * 2 + 1] = v >> 8;  break;
+            default:
+              for (int k = 0; k < 3; k++) row[x * (bpp / 8) + k] = v >> (8 * k);
+              break;
+          }
+        }
+        out.insert(out.end(), row.begin(), row.end());
+      }
+      return out;
+    }
+};
@@ -0,0 +1,13 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP-IDF adc_oneshot.h header (types only).
+
+#pragma once
+
+#include "esp_err.h"
+
+typedef struct SimAdcUnit * adc_oneshot_unit_handle_t;
+typedef struct { int unit_id; int clk_src; int ulp_mode; } adc_oneshot_unit_init_cfg_t;
+typedef struct { int atten; int bitwidth; } adc_oneshot_chan_cfg_t;
@@ -0,0 +1,30 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP-IDF esp_event.h header. Events are dispatched
+// synchronously to the registered handlers.
+
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+typedef const char * esp_event_base_t;
+typedef void (* esp_event_handler_t)(void * arg, esp_event_base_t event_base, int32_t event_id, void * event_data);
+
+#define ESP_EVENT_ANY_BASE  nullptr
+#define ESP_EVENT_ANY_ID    -1
+
+extern esp_event_base_t const WIFI_EVENT;
+extern esp_event_base_t const IP_EVENT;
+
+esp_err_t esp_event_loop_create_default();
+esp_err_t esp_event_loop_delete_default();
+esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+                                     esp_event_handler_t event_handler, void * event_handler_arg);
+esp_err_t esp_event_handler_unregister(esp_event_base_t event_base, int32_t event_id,
+                                       esp_event_handler_t event_handler);
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id, void * event_data,
+                         size_t event_data_size, uint32_t ticks_to_wait);
@@ -0,0 +1,30 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP-IDF esp_heap_caps.h header.
+//
+// MALLOC_CAP_DMA allocations are served from a 1MB aligned arena located in the
+// lower 4GB of the address space (the host targets are linked as non-PIE
+// executables) so that, as on the ESP32, the DMA engine can be handed the
+// 20 low-order bits of a descriptor address.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define MALLOC_CAP_EXEC      (1 << 0)
+#define MALLOC_CAP_32BIT     (1 << 1)
+#define MALLOC_CAP_8BIT      (1 << 2)
+#define MALLOC_CAP_DMA       (1 << 3)
+#define MALLOC_CAP_SPIRAM    (1 << 10)
+#define MALLOC_CAP_INTERNAL  (1 << 11)
+#define MALLOC_CAP_DEFAULT   (1 << 12)
+
+void * heap_caps_malloc(size_t size, uint32_t caps);
+void * heap_caps_calloc(size_t n, size_t size, uint32_t caps);
+void   heap_caps_free(void * ptr);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_total_size(uint32_t caps);
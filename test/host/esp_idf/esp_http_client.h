@@ -0,0 +1,77 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP-IDF esp_http_client.h header. Requests are served
+// from the in-memory web of test/host/sim/sim_network.hpp.
+
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+typedef struct SimHttpClient * esp_http_client_handle_t;
+
+typedef enum {
+  HTTP_EVENT_ERROR = 0,
+  HTTP_EVENT_ON_CONNECTED,
+  HTTP_EVENT_HEADERS_SENT,
+  HTTP_EVENT_HEADER_SENT = HTTP_EVENT_HEADERS_SENT,
+  HTTP_EVENT_ON_HEADER,
+  HTTP_EVENT_ON_DATA,
+  HTTP_EVENT_ON_FINISH,
+  HTTP_EVENT_DISCONNECTED,
+  HTTP_EVENT_REDIRECT
+} esp_http_client_event_id_t;
+
+typedef struct esp_http_client_event {
+  esp_http_client_event_id_t event_id;
+  esp_http_client_handle_t   client;
+  void *                     data;
+  int                        data_len;
+  void *                     user_data;
+  char *                     header_key;
+  char *                     header_value;
+} esp_http_client_event_t;
+
+typedef esp_err_t (* http_event_handle_cb)(esp_http_client_event_t * evt);
+
+typedef enum { HTTP_METHOD_GET = 0, HTTP_METHOD_POST, HTTP_METHOD_HEAD } esp_http_client_method_t;
+
+typedef struct {
+  const char *             url;
+  const char *             host;
+  int                      port;
+  const char *             path;
+  esp_http_client_method_t method;
+  int                      timeout_ms;
+  bool                     disable_auto_redirect;
+  int                      max_redirection_count;
+  http_event_handle_cb     event_handler;
+  int                      buffer_size;
+  int                      buffer_size_tx;
+  void *                   user_data;
+  bool                     is_async;
+  bool                     keep_alive_enable;
+  esp_err_t             (* crt_bundle_attach)(void * conf);
+} esp_http_client_config_t;
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t * config);
+esp_err_t                esp_http_client_perform(esp_http_client_handle_t client);
+esp_err_t                esp_http_client_cleanup(esp_http_client_handle_t client);
+int                      esp_http_client_get_status_code(esp_http_client_handle_t client);
+int64_t                  esp_http_client_get_content_length(esp_http_client_handle_t client);
+bool                     esp_http_client_is_chunked_response(esp_http_client_handle_t client);
+
+esp_err_t                esp_http_client_set_url(esp_http_client_handle_t client, const char * url);
+esp_err_t                esp_http_client_set_header(esp_http_client_handle_t client, const char * key, const char * value);
+esp_err_t                esp_http_client_delete_header(esp_http_client_handle_t client, const char * key);
+esp_err_t                esp_http_client_set_redirection(esp_http_client_handle_t client);
+
+esp_err_t                esp_http_client_open(esp_http_client_handle_t client, int write_len);
+int64_t                  esp_http_client_fetch_headers(esp_http_client_handle_t client);
+int                      esp_http_client_read(esp_http_client_handle_t client, char * buffer, int len);
+esp_err_t                esp_http_client_flush_response(esp_http_client_handle_t client, int * len);
+bool                     esp_http_client_is_complete_data_received(esp_http_client_handle_t client);
+esp_err_t                esp_http_client_close(esp_http_client_handle_t client);
@@ -0,0 +1,23 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP-IDF esp_intr_alloc.h header.
+//
+// Only the I2S1 interrupt source is simulated: its handler is called by the
+// simulated DMA engine when an enabled int_raw bit is raised (see
+// test/host/sim/sim_bus.cpp).
+
+#pragma once
+
+#include "esp_err.h"
+
+#define ESP_INTR_FLAG_LEVEL1  (1 << 1)
+#define ESP_INTR_FLAG_SHARED  (1 << 8)
+#define ESP_INTR_FLAG_IRAM    (1 << 10)
+
+typedef void (*intr_handler_t)(void * arg);
+typedef struct SimIntr * intr_handle_t;
+
+esp_err_t esp_intr_alloc(int source, int flags, intr_handler_t handler, void * arg, intr_handle_t * ret_handle);
+esp_err_t esp_intr_free(intr_handle_t handle);
@@ -0,0 +1,12 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP-IDF esp_private/periph_ctrl.h header.
+
+#pragma once
+
+#include "soc/periph_defs.h"
+
+inline void periph_module_enable(periph_module_t) {}
+inline void periph_module_reset(periph_module_t)  {}
@@ -0,0 +1,11 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP-IDF esp_system.h header.
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "esp_bit_defs.h"
@@ -0,0 +1,11 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP-IDF esp_task_wdt.h header.
+
+#pragma once
+
+#include "esp_err.h"
+
+inline esp_err_t esp_task_wdt_reset() { return ESP_OK; }
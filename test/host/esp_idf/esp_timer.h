@@ -0,0 +1,15 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP-IDF esp_timer.h header. Time is simulated: every
+// read of the timer advances the clock by one microsecond and vTaskDelay()
+// moves it forward by the requested amount.
+
+#pragma once
+
+#include <cstdint>
+
+#include "esp_attr.h"
+
+int64_t esp_timer_get_time();
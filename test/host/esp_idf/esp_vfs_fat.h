@@ -0,0 +1,10 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP-IDF esp_vfs_fat.h header (types only).
+
+#pragma once
+
+#include "esp_err.h"
+#include "driver/gpio.h"
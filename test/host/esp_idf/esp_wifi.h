@@ -0,0 +1,98 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP-IDF esp_wifi.h header. The station connects at
+// once unless the simulated access point has been made unreachable (see
+// test/host/sim/sim_network.hpp).
+
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+
+typedef enum { WIFI_MODE_NULL = 0, WIFI_MODE_STA, WIFI_MODE_AP, WIFI_MODE_APSTA } wifi_mode_t;
+typedef enum { WIFI_IF_STA = 0, WIFI_IF_AP } wifi_interface_t;
+
+#define ESP_IF_WIFI_STA WIFI_IF_STA
+
+typedef enum {
+  WIFI_AUTH_OPEN = 0,
+  WIFI_AUTH_WEP,
+  WIFI_AUTH_WPA_PSK,
+  WIFI_AUTH_WPA2_PSK,
+  WIFI_AUTH_WPA_WPA2_PSK
+} wifi_auth_mode_t;
+
+typedef enum {
+  WIFI_EVENT_WIFI_READY = 0,
+  WIFI_EVENT_SCAN_DONE,
+  WIFI_EVENT_STA_START,
+  WIFI_EVENT_STA_STOP,
+  WIFI_EVENT_STA_CONNECTED,
+  WIFI_EVENT_STA_DISCONNECTED
+} wifi_event_t;
+
+typedef enum {
+  IP_EVENT_STA_GOT_IP = 0,
+  IP_EVENT_STA_LOST_IP
+} ip_event_t;
+
+typedef struct {
+  esp_netif_t *       esp_netif;
+  esp_netif_ip_info_t ip_info;
+  bool                ip_changed;
+} ip_event_got_ip_t;
+
+typedef struct {
+  uint8_t          ssid[32];
+  uint8_t          ssid_len;
+  uint8_t          bssid[6];
+  uint8_t          channel;
+  wifi_auth_mode_t authmode;
+  uint16_t         aid;
+} wifi_event_sta_connected_t;
+
+typedef enum { WIFI_FAST_SCAN = 0, WIFI_ALL_CHANNEL_SCAN } wifi_scan_method_t;
+
+typedef struct { int dummy; } wifi_init_config_t;
+
+#define WIFI_INIT_CONFIG_DEFAULT() wifi_init_config_t{ 0 }
+
+typedef struct {
+  bool capable;
+  bool required;
+} wifi_pmf_config_t;
+
+typedef struct {
+  int8_t           rssi;
+  wifi_auth_mode_t authmode;
+} wifi_scan_threshold_t;
+
+typedef struct {
+  uint8_t               ssid[32];
+  uint8_t               password[64];
+  wifi_scan_method_t    scan_method;
+  bool                  bssid_set;
+  uint8_t               bssid[6];
+  uint8_t               channel;
+  uint16_t              listen_interval;
+  int                   sort_method;
+  wifi_scan_threshold_t threshold;
+  wifi_pmf_config_t     pmf_cfg;
+} wifi_sta_config_t;
+
+typedef union {
+  wifi_sta_config_t sta;
+} wifi_config_t;
+
+esp_err_t esp_wifi_init(const wifi_init_config_t * config);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t * conf);
+esp_err_t esp_wifi_start();
+esp_err_t esp_wifi_stop();
+esp_err_t esp_wifi_connect();
+esp_err_t esp_wifi_disconnect();
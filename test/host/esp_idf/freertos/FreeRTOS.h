@@ -0,0 +1,32 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the FreeRTOS.h header. Tasks are std::thread instances,
+// semaphores and event groups are built on std::mutex/std::condition_variable.
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include "esp_attr.h"
+#include "esp_bit_defs.h"
+#include "esp_heap_caps.h"
+
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define portMAX_DELAY       ((TickType_t) 0xffffffffUL)
+#define portTICK_PERIOD_MS  ((TickType_t) 1)
+#define pdMS_TO_TICKS(ms)   ((TickType_t) (ms))
+
+#define pdFALSE   ((BaseType_t) 0)
+#define pdTRUE    ((BaseType_t) 1)
+#define pdFAIL    pdFALSE
+#define pdPASS    pdTRUE
+
+#define configASSERT(x) assert(x)
+
+#define portYIELD_FROM_ISR(...) do {} while (0)
@@ -0,0 +1,26 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the FreeRTOS semphr.h header.
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct SimSemaphore * SemaphoreHandle_t;
+typedef struct { uint8_t dummy[80]; } StaticSemaphore_t;
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t sem);
+void              vSemaphoreDelete(SemaphoreHandle_t sem);
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex()  { return xSemaphoreCreateCounting(1, 1); }
+inline SemaphoreHandle_t xSemaphoreCreateBinary() { return xSemaphoreCreateCounting(1, 0); }
+inline SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *) { return xSemaphoreCreateMutex(); }
+inline SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *) { return xSemaphoreCreateBinary(); }
+inline BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t * woken) {
+  if (woken != nullptr) *woken = pdFALSE;
+  return xSemaphoreGive(sem);
+}
@@ -0,0 +1,29 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the FreeRTOS task.h header.
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct SimTask * TaskHandle_t;
+typedef void (* TaskFunction_t)(void *);
+
+#define tskIDLE_PRIORITY  ((UBaseType_t) 0)
+#define tskNO_AFFINITY    0x7FFFFFFF
+
+BaseType_t   xTaskCreatePinnedToCore(TaskFunction_t func, const char * name, uint32_t stack_depth,
+                                     void * param, UBaseType_t priority, TaskHandle_t * handle,
+                                     BaseType_t core_id);
+inline BaseType_t xTaskCreate(TaskFunction_t func, const char * name, uint32_t stack_depth,
+                              void * param, UBaseType_t priority, TaskHandle_t * handle) {
+  return xTaskCreatePinnedToCore(func, name, stack_depth, param, priority, handle, tskNO_AFFINITY);
+}
+void         vTaskDelete(TaskHandle_t task);
+void         vTaskDelay(TickType_t ticks);
+TickType_t   xTaskGetTickCount();
+char *       pcTaskGetName(TaskHandle_t task);
+UBaseType_t  uxTaskGetStackHighWaterMark(TaskHandle_t task);
+void         taskYIELD();
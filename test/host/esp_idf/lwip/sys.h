@@ -0,0 +1,9 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the lwIP sys.h header.
+
+#pragma once
+
+#include <cstdint>
@@ -0,0 +1,12 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP-IDF nvs_flash.h header.
+
+#pragma once
+
+#include "esp_err.h"
+
+inline esp_err_t nvs_flash_init()  { return ESP_OK; }
+inline esp_err_t nvs_flash_erase() { return ESP_OK; }
@@ -0,0 +1,23 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP32 ROM lldesc.h header.
+
+#pragma once
+
+#include <cstdint>
+
+typedef struct lldesc_s {
+  volatile uint32_t size   : 12,
+                    length : 12,
+                    offset :  5,
+                    sosf   :  1,
+                    eof    :  1,
+                    owner  :  1;
+  volatile const uint8_t * buf;
+  union {
+    volatile uint32_t empty;
+    struct { struct lldesc_s * stqe_next; } qe;
+  };
+} lldesc_t;
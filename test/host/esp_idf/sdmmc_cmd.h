@@ -0,0 +1,11 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP-IDF sdmmc_cmd.h header (types only).
+
+#pragma once
+
+#include "esp_err.h"
+
+typedef struct sdmmc_card_s { int dummy; } sdmmc_card_t;
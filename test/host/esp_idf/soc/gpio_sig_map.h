@@ -0,0 +1,17 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP32 gpio_sig_map.h header (I2S1 signals only).
+
+#pragma once
+
+#define I2S1O_BCK_OUT_IDX     169
+#define I2S1O_DATA_OUT0_IDX   172
+#define I2S1O_DATA_OUT1_IDX   173
+#define I2S1O_DATA_OUT2_IDX   174
+#define I2S1O_DATA_OUT3_IDX   175
+#define I2S1O_DATA_OUT4_IDX   176
+#define I2S1O_DATA_OUT5_IDX   177
+#define I2S1O_DATA_OUT6_IDX   178
+#define I2S1O_DATA_OUT7_IDX   179
@@ -0,0 +1,54 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP32 GPIO register block.
+//
+// The registers used by the e-Ink drivers are SimGpioReg proxies: every write
+// to out, out_w1ts, out_w1tc, out1_w1ts and out1_w1tc is counted and forwarded
+// to the simulated panel (see test/host/sim/sim_bus.hpp), which decodes the
+// CL/LE/CKV/SPH edges and the data bus the same way the real panel does.
+
+#pragma once
+
+#include <cstdint>
+
+enum class SimGpioRegId : uint8_t {
+  OUT, OUT_W1TS, OUT_W1TC, OUT1, OUT1_W1TS, OUT1_W1TC, ENABLE, ENABLE_W1TS, ENABLE1_W1TS
+};
+
+void     sim_gpio_write(SimGpioRegId id, uint32_t value);
+uint32_t sim_gpio_read(SimGpioRegId id);
+
+template<SimGpioRegId ID>
+class SimGpioReg
+{
+  public:
+    inline SimGpioReg & operator=(uint32_t value) { sim_gpio_write(ID, value); return *this; }
+    inline SimGpioReg & operator&=(uint32_t value) { sim_gpio_write(ID, sim_gpio_read(ID) & value); return *this; }
+    inline SimGpioReg & operator|=(uint32_t value) { sim_gpio_write(ID, sim_gpio_read(ID) | value); return *this; }
+    inline operator uint32_t() const { return sim_gpio_read(ID); }
+};
+
+typedef struct {
+  uint32_t func_sel : 9;
+  uint32_t inv_sel  : 1;
+  uint32_t oen_sel  : 1;
+  uint32_t oen_inv_sel : 1;
+  uint32_t reserved : 20;
+} sim_gpio_func_out_sel_cfg_t;
+
+typedef struct gpio_dev_s {
+  SimGpioReg<SimGpioRegId::OUT>          out;
+  SimGpioReg<SimGpioRegId::OUT_W1TS>     out_w1ts;
+  SimGpioReg<SimGpioRegId::OUT_W1TC>     out_w1tc;
+  struct { SimGpioReg<SimGpioRegId::OUT1>         val;  } out1;
+  struct { SimGpioReg<SimGpioRegId::OUT1_W1TS>    val;  } out1_w1ts;
+  struct { SimGpioReg<SimGpioRegId::OUT1_W1TC>    val;  } out1_w1tc;
+  SimGpioReg<SimGpioRegId::ENABLE>       enable;
+  SimGpioReg<SimGpioRegId::ENABLE_W1TS>  enable_w1ts;
+  struct { SimGpioReg<SimGpioRegId::ENABLE1_W1TS> data; } enable1_w1ts;
+  sim_gpio_func_out_sel_cfg_t            func_out_sel_cfg[40];
+} gpio_dev_t;
+
+extern gpio_dev_t GPIO;
@@ -0,0 +1,15 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP32 i2s_reg.h header.
+
+#pragma once
+
+#define I2S_OUT_DATA_BURST_EN  (1 << 11)
+#define I2S_OUTDSCR_BURST_EN   (1 << 9)
+
+#define I2S_OUT_EOF_INT_ENA        (1 << 12)
+#define I2S_OUT_EOF_INT_CLR        (1 << 12)
+#define I2S_OUT_TOTAL_EOF_INT_ENA  (1 << 17)
+#define I2S_OUT_TOTAL_EOF_INT_CLR  (1 << 17)
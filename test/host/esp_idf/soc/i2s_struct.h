@@ -0,0 +1,116 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP32 I2S register block.
+//
+// Only the registers that have a side effect are proxies: writing 1 to
+// out_link.start arms the DMA engine, writing 1 to conf.tx_start walks the
+// descriptor chain found at out_link.addr and pushes every byte to the
+// simulated panel (see test/host/sim/sim_bus.hpp), and writing int_clr.val
+// acknowledges the matching int_raw bits.
+
+#pragma once
+
+#include <cstdint>
+
+enum class SimI2SRegId : uint8_t { CONF_TX_START, OUT_LINK_START, INT_CLR };
+
+// Only I2S1 is simulated.
+void     sim_i2s_write(SimI2SRegId id, uint32_t value);
+uint32_t sim_i2s_read(SimI2SRegId id);
+
+template<SimI2SRegId ID>
+class SimI2SReg
+{
+  public:
+    inline SimI2SReg & operator=(uint32_t value) { sim_i2s_write(ID, value); return *this; }
+    inline operator uint32_t() const { return sim_i2s_read(ID); }
+};
+
+typedef union {
+  struct {
+    uint32_t rx_take_data  : 1;
+    uint32_t tx_put_data   : 1;
+    uint32_t rx_wfull      : 1;
+    uint32_t rx_rempty     : 1;
+    uint32_t tx_wfull      : 1;
+    uint32_t tx_rempty     : 1;
+    uint32_t rx_hung       : 1;
+    uint32_t tx_hung       : 1;
+    uint32_t in_done       : 1;
+    uint32_t in_suc_eof    : 1;
+    uint32_t in_err_eof    : 1;
+    uint32_t out_done      : 1;
+    uint32_t out_eof       : 1;
+    uint32_t in_dscr_err   : 1;
+    uint32_t out_dscr_err  : 1;
+    uint32_t in_dscr_empty : 1;
+    uint32_t in_link_dscr_empty : 1;
+    uint32_t out_total_eof : 1;
+    uint32_t reserved      : 14;
+  };
+  uint32_t val;
+} sim_i2s_int_t;
+
+#define SIM_I2S_REG(name, ...) typedef union { struct { __VA_ARGS__ }; uint32_t val; } name
+
+SIM_I2S_REG(sim_i2s_conf2_t,   uint32_t camera_en : 1; uint32_t lcd_tx_wrx2_en : 1; uint32_t lcd_tx_sdx2_en : 1;
+                               uint32_t data_enable_test_en : 1; uint32_t data_enable : 1; uint32_t lcd_en : 1;
+                               uint32_t ext_adc_start_en : 1; uint32_t inter_valid_en : 1; uint32_t reserved : 24;);
+SIM_I2S_REG(sim_i2s_lc_conf_t, uint32_t in_rst : 1; uint32_t out_rst : 1; uint32_t ahbm_fifo_rst : 1;
+                               uint32_t ahbm_rst : 1; uint32_t out_loop_test : 1; uint32_t in_loop_test : 1;
+                               uint32_t out_auto_wrback : 1; uint32_t out_no_restart_clr : 1;
+                               uint32_t out_eof_mode : 1; uint32_t outdscr_burst_en : 1;
+                               uint32_t indscr_burst_en : 1; uint32_t out_data_burst_en : 1;
+                               uint32_t check_owner : 1; uint32_t mem_trans_en : 1; uint32_t reserved : 18;);
+SIM_I2S_REG(sim_i2s_sample_rate_conf_t, uint32_t tx_bck_div_num : 6; uint32_t rx_bck_div_num : 6;
+                               uint32_t tx_bits_mod : 6; uint32_t rx_bits_mod : 6; uint32_t reserved : 8;);
+SIM_I2S_REG(sim_i2s_clkm_conf_t, uint32_t clkm_div_num : 8; uint32_t clkm_div_b : 6; uint32_t clkm_div_a : 6;
+                               uint32_t clk_en : 1; uint32_t clka_en : 1; uint32_t reserved : 10;);
+SIM_I2S_REG(sim_i2s_fifo_conf_t, uint32_t rx_data_num : 6; uint32_t tx_data_num : 6; uint32_t dscr_en : 1;
+                               uint32_t tx_fifo_mod : 3; uint32_t rx_fifo_mod : 3; uint32_t tx_fifo_mod_force_en : 1;
+                               uint32_t rx_fifo_mod_force_en : 1; uint32_t reserved : 11;);
+SIM_I2S_REG(sim_i2s_conf1_t,   uint32_t tx_pcm_conf : 3; uint32_t tx_pcm_bypass : 1; uint32_t rx_pcm_conf : 3;
+                               uint32_t rx_pcm_bypass : 1; uint32_t tx_stop_en : 1; uint32_t tx_zeros_rm_en : 1;
+                               uint32_t reserved : 22;);
+SIM_I2S_REG(sim_i2s_conf_chan_t, uint32_t tx_chan_mod : 3; uint32_t rx_chan_mod : 2; uint32_t reserved : 27;);
+SIM_I2S_REG(sim_i2s_timing_t,  uint32_t reserved : 32;);
+
+#undef SIM_I2S_REG
+
+typedef struct i2s_dev_s {
+  struct {
+    uint32_t tx_reset;
+    uint32_t rx_reset;
+    uint32_t tx_fifo_reset;
+    uint32_t rx_fifo_reset;
+    uint32_t tx_right_first;
+    uint32_t rx_right_first;
+    uint32_t rx_start;
+    SimI2SReg<SimI2SRegId::CONF_TX_START> tx_start;
+  } conf;
+  sim_i2s_int_t              int_raw;
+  sim_i2s_int_t              int_st;
+  sim_i2s_int_t              int_ena;
+  struct { SimI2SReg<SimI2SRegId::INT_CLR> val; } int_clr;
+  sim_i2s_timing_t           timing;
+  sim_i2s_fifo_conf_t        fifo_conf;
+  sim_i2s_conf_chan_t        conf_chan;
+  struct {
+    uint32_t addr;
+    uint32_t stop;
+    SimI2SReg<SimI2SRegId::OUT_LINK_START> start;
+    uint32_t restart;
+    uint32_t park;
+  } out_link;
+  uint32_t                   out_eof_des_addr;
+  sim_i2s_lc_conf_t          lc_conf;
+  sim_i2s_conf1_t            conf1;
+  sim_i2s_conf2_t            conf2;
+  sim_i2s_clkm_conf_t        clkm_conf;
+  sim_i2s_sample_rate_conf_t sample_rate_conf;
+} i2s_dev_t;
+
+extern i2s_dev_t I2S0;
+extern i2s_dev_t I2S1;
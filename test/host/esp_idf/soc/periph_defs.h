@@ -0,0 +1,17 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP32 periph_defs.h header.
+
+#pragma once
+
+typedef enum {
+  PERIPH_I2S0_MODULE,
+  PERIPH_I2S1_MODULE
+} periph_module_t;
+
+typedef enum {
+  ETS_I2S0_INTR_SOURCE = 32,
+  ETS_I2S1_INTR_SOURCE = 33
+} periph_interrupt_t;
@@ -0,0 +1,60 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host stand-in for the ESP32 soc.h header.
+//
+// The IO_MUX registers are backed by a static array. The host targets being
+// linked as non-PIE executables, their addresses fit in the 32 bits values
+// the drivers are using.
+
+#pragma once
+
+#include <cstdint>
+
+#include "esp_attr.h"
+#include "esp_bit_defs.h"
+
+extern volatile uint32_t sim_io_mux[40];
+
+#define SIM_IO_MUX_REG(n) ((uint32_t) (uintptr_t) &sim_io_mux[n])
+
+#define IO_MUX_GPIO0_REG  SIM_IO_MUX_REG(0)
+#define IO_MUX_GPIO1_REG  SIM_IO_MUX_REG(1)
+#define IO_MUX_GPIO2_REG  SIM_IO_MUX_REG(2)
+#define IO_MUX_GPIO3_REG  SIM_IO_MUX_REG(3)
+#define IO_MUX_GPIO4_REG  SIM_IO_MUX_REG(4)
+#define IO_MUX_GPIO5_REG  SIM_IO_MUX_REG(5)
+#define IO_MUX_GPIO6_REG  SIM_IO_MUX_REG(6)
+#define IO_MUX_GPIO7_REG  SIM_IO_MUX_REG(7)
+#define IO_MUX_GPIO8_REG  SIM_IO_MUX_REG(8)
+#define IO_MUX_GPIO9_REG  SIM_IO_MUX_REG(9)
+#define IO_MUX_GPIO10_REG SIM_IO_MUX_REG(10)
+#define IO_MUX_GPIO11_REG SIM_IO_MUX_REG(11)
+#define IO_MUX_GPIO12_REG SIM_IO_MUX_REG(12)
+#define IO_MUX_GPIO13_REG SIM_IO_MUX_REG(13)
+#define IO_MUX_GPIO14_REG SIM_IO_MUX_REG(14)
+#define IO_MUX_GPIO15_REG SIM_IO_MUX_REG(15)
+#define IO_MUX_GPIO16_REG SIM_IO_MUX_REG(16)
+#define IO_MUX_GPIO17_REG SIM_IO_MUX_REG(17)
+#define IO_MUX_GPIO18_REG SIM_IO_MUX_REG(18)
+#define IO_MUX_GPIO19_REG SIM_IO_MUX_REG(19)
+#define IO_MUX_GPIO20_REG SIM_IO_MUX_REG(20)
+#define IO_MUX_GPIO21_REG SIM_IO_MUX_REG(21)
+#define IO_MUX_GPIO22_REG SIM_IO_MUX_REG(22)
+#define IO_MUX_GPIO23_REG SIM_IO_MUX_REG(23)
+#define IO_MUX_GPIO24_REG SIM_IO_MUX_REG(24)
+#define IO_MUX_GPIO25_REG SIM_IO_MUX_REG(25)
+#define IO_MUX_GPIO26_REG SIM_IO_MUX_REG(26)
+#define IO_MUX_GPIO27_REG SIM_IO_MUX_REG(27)
+#define IO_MUX_GPIO32_REG SIM_IO_MUX_REG(32)
+#define IO_MUX_GPIO33_REG SIM_IO_MUX_REG(33)
+#define IO_MUX_GPIO34_REG SIM_IO_MUX_REG(34)
+#define IO_MUX_GPIO35_REG SIM_IO_MUX_REG(35)
+#define IO_MUX_GPIO36_REG SIM_IO_MUX_REG(36)
+#define IO_MUX_GPIO37_REG SIM_IO_MUX_REG(37)
+#define IO_MUX_GPIO38_REG SIM_IO_MUX_REG(38)
+#define IO_MUX_GPIO39_REG SIM_IO_MUX_REG(39)
+
+#define FUN_DRV_S   10
+#define MCU_SEL_S   12
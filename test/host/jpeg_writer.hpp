@@ -0,0 +1,268 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#pragma once
+
+// Minimal baseline JPEG encoder, used to build the pictures decoded by the
+// host checks and benchmarks: Y/Cb/Cr with 4:4:4 or 4:2:0 sampling, or Y
+// only (the formats supported by tjpgd), standard quantization and Huffman
+// tables.
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+class JpegWriter
+{
+  public:
+    enum class Sampling { YUV444, YUV420, GRAY };
+
+    // rgb: w * h pixels, 3 bytes each.
+
+    static std::vector<uint8_t> encode(const uint8_t * rgb, int w, int h, int quality = 85,
+                                       Sampling sampling = Sampling::YUV420)
+    {
+      JpegWriter writer;
+      writer.write(rgb, w, h, quality, sampling);
+      return writer.out;
+    }
+
+  private:
+    std::vector<uint8_t> out;
+    uint32_t             bit_buffer = 0;
+    int                  bit_count  = 0;
+    uint8_t              qt[2][64];          // Natural order
+    uint16_t             codes[4][256];      // DC0, AC0, DC1, AC1
+    uint8_t              sizes[4][256];
+    float                cos_table[8][8];
+
+    static constexpr uint8_t ZIGZAG[64] = {
+       0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+      12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+      35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+      58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63 };
+
+    static constexpr uint8_t QT_LUMINANCE[64] = {
+      16, 11, 10, 16,  24,  40,  51,  61,   12, 12, 14, 19,  26,  58,  60,  55,
+      14, 13, 16, 24,  40,  57,  69,  56,   14, 17, 22, 29,  51,  87,  80,  62,
+      18, 22, 37, 56,  68, 109, 103,  77,   24, 35, 55, 64,  81, 104, 113,  92,
+      49, 64, 78, 87, 103, 121, 120, 101,   72, 92, 95, 98, 112, 100, 103,  99 };
+
+    static constexpr uint8_t QT_CHROMINANCE[64] = {
+      17, 18, 24, 47, 99, 99, 99, 99,   18, 21, 26, 66, 99, 99, 99, 99,
+      24, 26, 56, 99, 99, 99, 99, 99,   47, 66, 99, 99, 99, 99, 99, 99,
+      99, 99, 99, 99, 99, 99, 99, 99,   99, 99, 99, 99, 99, 99, 99, 99,
+      99, 99, 99, 99, 99, 99, 99, 99,   99, 99, 99, 99, 99, 99, 99, 99 };
+
+    static constexpr uint8_t DC_LUMINANCE_BITS[16]   = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+    static constexpr uint8_t DC_CHROMINANCE_BITS[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+    static constexpr uint8_t DC_VALUES[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+    static constexpr uint8_t AC_LUMINANCE_BITS[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D };
+    static constexpr uint8_t AC_LUMINANCE_VALUES[162] = {
+      0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+      0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+      0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+      0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+      0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+      0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+      0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+      0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+      0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+      0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+      0xF9, 0xFA };
+
+    static constexpr uint8_t AC_CHROMINANCE_BITS[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+    static constexpr uint8_t AC_CHROMINANCE_VALUES[162] = {
+      0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+      0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+      0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+      0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+      0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+      0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+      0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+      0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+      0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+      0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+      0xF9, 0xFA };
+
+    void byte(uint8_t b)   { out.push_back(b); }
+    void word(uint16_t w)  { byte(w >> 8); byte(w & 0xFF); }
+
+    void bits(uint32_t code, int size) {
+      bit_buffer = (bit_buffer << size) | (code & ((1u << size) - 1));
+      bit_count += size;
+      while (bit_count >= 8) {
+        uint8_t b = bit_buffer >> (bit_count - 8);
+        byte(b);
+        if (b == 0xFF) byte(0);
+        bit_count -= 8;
+      }
+    }
+
+    void flush() { if (bit_count > 0) bits(0x7F, 8 - bit_count); }
+
+    void huffman_table(int id, const uint8_t * counts, const uint8_t * values, int table) {
+      int n = 0;
+      for (int i = 0; i < 16; i++) n += counts[i];
+
+      word(0xFFC4); word(2 + 1 + 16 + n);
+      byte(id);
+      for (int i = 0; i < 16; i++) byte(counts[i]);
+      for (int i = 0; i < n; i++)  byte(values[i]);
+
+      uint16_t code = 0;
+      int      k    = 0;
+      for (int len = 1; len <= 16; len++) {
+        for (int i = 0; i < counts[len - 1]; i++, k++) {
+          codes[table][values[k]] = code++;
+          sizes[table][values[k]] = len;
+        }
+        code <<= 1;
+      }
+    }
+
+    static int category(int v) {
+      int c = 0;
+      for (v = std::abs(v); v; v >>= 1) c++;
+      return c;
+    }
+
+    void value(int v, int size) { bits((v < 0) ? (v - 1) : v, size); }
+
+    // block: 64 samples, natural order, level shifted.
+
+    void encode_block(const float * block, int q, int & dc_pred) {
+      int coef[64];
+
+      float rows[64];
+
+      for (int y = 0; y < 8; y++) {            // Separable DCT: rows, then columns
+        for (int u = 0; u < 8; u++) {
+          float sum = 0;
+          for (int x = 0; x < 8; x++) sum += block[y * 8 + x] * cos_table[x][u];
+          rows[y * 8 + u] = sum;
+        }
+      }
+      for (int v = 0; v < 8; v++) {
+        for (int u = 0; u < 8; u++) {
+          float sum = 0;
+          for (int y = 0; y < 8; y++) sum += rows[y * 8 + u] * cos_table[y][v];
+          float cu = u ? 1.0f : M_SQRT1_2, cv = v ? 1.0f : M_SQRT1_2;
+          coef[v * 8 + u] = (int) std::lround(0.25f * cu * cv * sum / qt[q][v * 8 + u]);
+        }
+      }
+
+      int dc_table = q * 2, ac_table = q * 2 + 1;
+
+      int diff = coef[0] - dc_pred;
+      dc_pred  = coef[0];
+      int size = category(diff);
+      bits(codes[dc_table][size], sizes[dc_table][size]);
+      if (size) value(diff, size);
+
+      int run = 0;
+      for (int k = 1; k < 64; k++) {
+        int c = coef[ZIGZAG[k]];
+        if (c == 0) { run++; continue; }
+        while (run > 15) { bits(codes[ac_table][0xF0], sizes[ac_table][0xF0]); run -= 16; }
+        size = category(c);
+        uint8_t symbol = (run << 4) | size;
+        bits(codes[ac_table][symbol], sizes[ac_table][symbol]);
+        value(c, size);
+        run = 0;
+      }
+      if (run) bits(codes[ac_table][0x00], sizes[ac_table][0x00]);
+    }
+
+    void write(const uint8_t * rgb, int w, int h, int quality, Sampling sampling) {
+      int scale = (quality < 50) ? (5000 / quality) : (200 - quality * 2);
+      for (int i = 0; i < 64; i++) {
+        qt[0][i] = std::min(255, std::max(1, (QT_LUMINANCE[i]   * scale + 50) / 100));
+        qt[1][i] = std::min(255, std::max(1, (QT_CHROMINANCE[i] * scale + 50) / 100));
+      }
+      for (int x = 0; x < 8; x++) {
+        for (int u = 0; u < 8; u++) cos_table[x][u] = std::cos((2 * x + 1) * u * M_PI / 16);
+      }
+
+      // Planes, the chroma ones at full resolution
+
+      std::vector<float> planes[3];
+      for (auto & p : planes) p.resize(w * h);
+      for (int i = 0; i < w * h; i++) {
+        float r = rgb[i * 3], g = rgb[i * 3 + 1], b = rgb[i * 3 + 2];
+        planes[0][i] =  0.299f   * r + 0.587f   * g + 0.114f   * b - 128;
+        planes[1][i] = -0.16874f * r - 0.33126f * g + 0.5f     * b;
+        planes[2][i] =  0.5f     * r - 0.41869f * g - 0.08131f * b;
+      }
+
+      int mcu   = (sampling == Sampling::YUV420) ? 16 : 8;
+      int comps = (sampling == Sampling::GRAY) ? 1 : 3;
+
+      word(0xFFD8);
+
+      word(0xFFDB); word(2 + ((comps == 3) ? 2 : 1) * 65);
+      for (int q = 0; q < ((comps == 3) ? 2 : 1); q++) {
+        byte(q);
+        for (int k = 0; k < 64; k++) byte(qt[q][ZIGZAG[k]]);
+      }
+
+      word(0xFFC0); word(2 + 6 + comps * 3);
+      byte(8); word(h); word(w); byte(comps);
+      byte(1); byte((mcu == 16) ? 0x22 : 0x11); byte(0);
+      if (comps == 3) {
+        byte(2); byte(0x11); byte(1);
+        byte(3); byte(0x11); byte(1);
+      }
+
+      huffman_table(0x00, DC_LUMINANCE_BITS,   DC_VALUES,             0);
+      huffman_table(0x10, AC_LUMINANCE_BITS,   AC_LUMINANCE_VALUES,   1);
+      if (comps == 3) {
+        huffman_table(0x01, DC_CHROMINANCE_BITS, DC_VALUES,             2);
+        huffman_table(0x11, AC_CHROMINANCE_BITS, AC_CHROMINANCE_VALUES, 3);
+      }
+
+      word(0xFFDA); word(2 + 1 + comps * 2 + 3);
+      byte(comps);
+      byte(1); byte(0x00);
+      if (comps == 3) {
+        byte(2); byte(0x11);
+        byte(3); byte(0x11);
+      }
+      byte(0); byte(63); byte(0);
+
+      auto sample = [&](int c, int x, int y) {
+        return planes[c][std::min(y, h - 1) * w + std::min(x, w - 1)];
+      };
+
+      int   dc[3] = { 0, 0, 0 };
+      float block[64];
+
+      for (int my = 0; my < h; my += mcu) {
+        for (int mx = 0; mx < w; mx += mcu) {
+          for (int by = 0; by < mcu; by += 8) {
+            for (int bx = 0; bx < mcu; bx += 8) {
+              for (int i = 0; i < 64; i++) block[i] = sample(0, mx + bx + (i & 7), my + by + (i >> 3));
+              encode_block(block, 0, dc[0]);
+            }
+          }
+          for (int c = 1; c < comps; c++) {
+            for (int i = 0; i < 64; i++) {
+              if (mcu == 8) {
+                block[i] = sample(c, mx + (i & 7), my + (i >> 3));
+              }
+              else {
+                int x = mx + (i & 7) * 2, y = my + (i >> 3) * 2;
+                block[i] = (sample(c, x, y) + sample(c, x + 1, y) + sample(c, x, y + 1) + sample(c, x + 1, y + 1)) / 4;
+              }
+            }
+            encode_block(block, 1, dc[c]);
+          }
+        }
+      }
+
+      flush();
+      word(0xFFD9);
+    }
+};
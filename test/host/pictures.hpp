@@ -0,0 +1,40 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#pragma once
+
+// Pictures drawn by the host image checks and benchmarks.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// A photo-like picture: smooth gradients, a few hard edges and some noise.
+
+static inline std::vector<uint8_t>
+picture(int w, int h)
+{
+  std::vector<uint8_t> rgb(w * h * 3);
+
+  srand(1234);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      float dx = x - w * 0.6f, dy = y - h * 0.4f;
+      bool  in = (dx * dx + dy * dy) < (h * h / 9.0f);
+      int   n  = (rand() % 17) - 8;
+
+      int r = (x * 255) / w + n;
+      int g = in ? 230 + n : (y * 255) / h + n;
+      int b = 128 + (int)(100 * std::sin(x * 0.05f + y * 0.03f)) + n;
+
+      uint8_t * p = &rgb[(y * w + x) * 3];
+      p[0] = std::min(255, std::max(0, r));
+      p[1] = std::min(255, std::max(0, g));
+      p[2] = std::min(255, std::max(0, b));
+    }
+  }
+  return rgb;
+}
@@ -0,0 +1,172 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#pragma once
+
+// Minimal PNG encoder, used to build the pictures decoded by the host checks
+// and benchmarks. The image data is not compressed (stored deflate blocks);
+// the rows cycle through the 5 filter types, and the data is split in
+// several IDAT chunks. Pictures can be Adam7 interlaced.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+class PngWriter
+{
+  public:
+    // samples: w * h pixels, one value per channel (0 .. 2^depth - 1, or a
+    // palette index). Color types: 0 (gray), 2 (RGB), 3 (palette), 4 (gray
+    // + alpha), 6 (RGBA). palette: 3 bytes per entry, trns: the tRNS chunk.
+
+    static std::vector<uint8_t> encode(const std::vector<uint16_t> & samples, int w, int h,
+                                       uint8_t color_type, uint8_t depth,
+                                       const std::vector<uint8_t> & palette = {},
+                                       const std::vector<uint8_t> & trns = {},
+                                       bool interlaced = false)
+    {
+      PngWriter writer;
+      writer.write(samples, w, h, color_type, depth, palette, trns, interlaced);
+      return writer.out;
+    }
+
+    static int channels(uint8_t color_type)
+    {
+      switch (color_type) {
+        case 2:  return 3;
+        case 4:  return 2;
+        case 6:  return 4;
+        default: return 1;
+      }
+    }
+
+  private:
+    std::vector<uint8_t> out;
+    uint32_t             crc_table[256];
+
+    void word(std::vector<uint8_t> & v, uint32_t w) {
+      v.push_back(w >> 24); v.push_back(w >> 16); v.push_back(w >> 8); v.push_back(w);
+    }
+
+    uint32_t crc(const uint8_t * p, size_t len) {
+      uint32_t c = 0xFFFFFFFF;
+      while (len--) c = crc_table[(c ^ *p++) & 0xFF] ^ (c >> 8);
+      return c ^ 0xFFFFFFFF;
+    }
+
+    void chunk(const char * type, const std::vector<uint8_t> & data) {
+      std::vector<uint8_t> body(type, type + 4);
+      body.insert(body.end(), data.begin(), data.end());
+      word(out, data.size());
+      out.insert(out.end(), body.begin(), body.end());
+      word(out, crc(body.data(), body.size()));
+    }
+
+    static uint8_t paeth(int a, int b, int c) {
+      int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+      if ((pa <= pb) && (pa <= pc)) return a;
+      return (pb <= pc) ? b : c;
+    }
+
+    // Packed and filtered rows of the pixels at (x0 + i * dx, y0 + j * dy)
+
+    static void rows(std::vector<uint8_t> & raw, const std::vector<uint16_t> & samples, int w, int h,
+                     int ch, uint8_t depth, int x0, int y0, int dx, int dy) {
+      int pw = (w - x0 + dx - 1) / dx;
+      int ph = (h - y0 + dy - 1) / dy;
+      if ((pw <= 0) || (ph <= 0)) return;
+
+      size_t stride = (size_t(pw) * ch * depth + 7) / 8;
+      size_t bpp    = std::max<size_t>(1, ch * depth / 8);
+
+      std::vector<uint8_t> prev(stride, 0), row(stride);
+      for (int y = 0; y < ph; y++) {
+        std::fill(row.begin(), row.end(), 0);
+        size_t bit = 0;
+        for (int x = 0; x < pw; x++) {
+          const uint16_t * pixel = &samples[(size_t(y0 + y * dy) * w + x0 + x * dx) * ch];
+          for (int c = 0; c < ch; c++, bit += depth) {
+            uint16_t v = pixel[c];
+            if (depth == 16) { row[bit >> 3] = v >> 8; row[(bit >> 3) + 1] = v; }
+            else row[bit >> 3] |= v << (8 - depth - (bit & 7));
+          }
+        }
+
+        uint8_t filter = y % 5;
+        raw.push_back(filter);
+        for (size_t i = 0; i < stride; i++) {
+          int a = (i >= bpp) ? row[i - bpp] : 0, b = prev[i], c = (i >= bpp) ? prev[i - bpp] : 0;
+          int p = 0;
+          switch (filter) {
+            case 1: p = a;               break;
+            case 2: p = b;               break;
+            case 3: p = (a + b) >> 1;    break;
+            case 4: p = paeth(a, b, c);  break;
+          }
+          raw.push_back(row[i] - p);
+        }
+        prev = row;
+      }
+    }
+
+    void write(const std::vector<uint16_t> & samples, int w, int h, uint8_t color_type, uint8_t depth,
+               const std::vector<uint8_t> & palette, const std::vector<uint8_t> & trns, bool interlaced) {
+      for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+        crc_table[n] = c;
+      }
+
+      int ch = channels(color_type);
+
+      // Adam7 passes: x0, y0, dx, dy
+
+      static const int adam7[7][4] = {
+        { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 },
+        { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 },
+      };
+
+      std::vector<uint8_t> raw;
+      if (interlaced) {
+        for (auto & pass : adam7) rows(raw, samples, w, h, ch, depth, pass[0], pass[1], pass[2], pass[3]);
+      }
+      else {
+        rows(raw, samples, w, h, ch, depth, 0, 0, 1, 1);
+      }
+
+      // zlib stream of stored blocks
+
+      std::vector<uint8_t> z = { 0x78, 0x01 };
+      for (size_t pos = 0; pos < raw.size() || pos == 0;) {
+        size_t len = std::min<size_t>(65535, raw.size() - pos);
+        z.push_back((pos + len) >= raw.size());
+        z.push_back(len); z.push_back(len >> 8);
+        z.push_back(~len); z.push_back(~len >> 8);
+        z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + len);
+        pos += len;
+        if (len == 0) break;
+      }
+      uint32_t s1 = 1, s2 = 0;
+      for (uint8_t b : raw) { s1 = (s1 + b) % 65521; s2 = (s2 + s1) % 65521; }
+      word(z, (s2 << 16) | s1);
+
+      static const uint8_t signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+      out.assign(signature, signature + 8);
+
+      std::vector<uint8_t> ihdr;
+      word(ihdr, w); word(ihdr, h);
+      ihdr.push_back(depth); ihdr.push_back(color_type);
+      ihdr.push_back(0); ihdr.push_back(0); ihdr.push_back(interlaced ? 1 : 0);
+      chunk("IHDR", ihdr);
+
+      if (!palette.empty()) chunk("PLTE", palette);
+      if (!trns.empty())    chunk("tRNS", trns);
+
+      for (size_t pos = 0; pos < z.size(); pos += 8192) {
+        chunk("IDAT", std::vector<uint8_t>(z.begin() + pos, z.begin() + std::min(z.size(), pos + 8192)));
+      }
+      chunk("IEND", {});
+    }
+};
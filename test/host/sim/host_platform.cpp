@@ -0,0 +1,51 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host counterpart of inkplate_platform.cpp: instantiates the IO expanders
+// and the e-Ink driver of the board, and wires the simulated panel to the
+// board's main IO expander. The other devices (battery, SD card, keys, touch
+// screen, front light, RTC) are not part of the host build.
+
+#include "inkplate_platform.hpp"
+
+#include "sim_bus.hpp"
+#include "sim_panel.hpp"
+
+IOExpander io_expander_int(0x20);
+
+#if INKPLATE_6
+  EInk6       e_ink(io_expander_int);
+#elif INKPLATE_10
+  IOExpander  io_expander_ext(0x22);
+  EInk10      e_ink(io_expander_int, io_expander_ext);
+#elif INKPLATE_6PLUS
+  IOExpander  io_expander_ext(0x22);
+  EInk6PLUS   e_ink(io_expander_int, io_expander_ext);
+#elif INKPLATE_6PLUS_V2
+  IOExpander  io_expander_ext(0x21);
+  EInk6PLUSV2 e_ink(io_expander_int, io_expander_ext);
+#elif INKPLATE_6FLICK
+  IOExpander  io_expander_ext(0x21);
+  EInk6FLICK  e_ink(io_expander_int, io_expander_ext);
+#endif
+
+namespace {
+
+  #if PCAL6416
+    constexpr uint8_t IO_OUTPUT_REG = 0x02; // OUTA
+  #else
+    constexpr uint8_t IO_OUTPUT_REG = 0x12; // GPIOA
+  #endif
+
+  constexpr uint8_t SPV_BIT   = 2;
+  constexpr uint8_t PWRUP_BIT = 4;
+
+  struct HostPlatformInit {
+    HostPlatformInit() {
+      SimPanel::get_singleton().configure(e_ink.WIDTH, e_ink.HEIGHT, 0x20, IO_OUTPUT_REG, SPV_BIT);
+      SimBus::set_pwrup_signal(0x20, IO_OUTPUT_REG, PWRUP_BIT);
+    }
+  } host_platform_init;
+
+}
@@ -0,0 +1,359 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#include "sim_bus.hpp"
+#include "sim_panel.hpp"
+
+#include "soc/gpio_struct.h"
+#include "soc/i2s_struct.h"
+#include "soc/soc.h"
+#include "rom/lldesc.h"
+#include "driver/i2c_master.h"
+#include "esp_intr_alloc.h"
+#include "soc/periph_defs.h"
+
+#include <map>
+#include <mutex>
+#include <set>
+
+gpio_dev_t GPIO;
+i2s_dev_t  I2S0;
+i2s_dev_t  I2S1;
+
+volatile uint32_t sim_io_mux[40];
+
+SimBus::Stats    SimBus::stats{};
+SimBus::GpioHook SimBus::gpio_hook;
+SimBus::I2SHook  SimBus::i2s_hook;
+uint32_t         SimBus::out     = 0;
+uint32_t         SimBus::out1    = 0;
+uint32_t         SimBus::enable  = 0;
+uint32_t         SimBus::enable1 = 0;
+
+void
+SimBus::reset_stats()
+{
+  stats = Stats{};
+}
+
+// ----- GPIO -----
+
+void
+sim_gpio_write(SimGpioRegId id, uint32_t value)
+{
+  uint32_t out_before  = SimBus::out;
+  uint32_t out1_before = SimBus::out1;
+
+  switch (id) {
+    case SimGpioRegId::OUT:          SimBus::out       = value; break;
+    case SimGpioRegId::OUT_W1TS:     SimBus::out      |= value; break;
+    case SimGpioRegId::OUT_W1TC:     SimBus::out      &= ~value; break;
+    case SimGpioRegId::OUT1:         SimBus::out1      = value; break;
+    case SimGpioRegId::OUT1_W1TS:    SimBus::out1     |= value; break;
+    case SimGpioRegId::OUT1_W1TC:    SimBus::out1     &= ~value; break;
+    case SimGpioRegId::ENABLE:       SimBus::enable    = value; return;
+    case SimGpioRegId::ENABLE_W1TS:  SimBus::enable   |= value; return;
+    case SimGpioRegId::ENABLE1_W1TS: SimBus::enable1  |= value; return;
+  }
+
+  SimBus::stats.gpio_writes++;
+  if (SimBus::gpio_hook) SimBus::gpio_hook(id, value);
+
+  SimPanel::get_singleton().gpio_changed(out_before, SimBus::out, out1_before, SimBus::out1);
+}
+
+uint32_t
+sim_gpio_read(SimGpioRegId id)
+{
+  switch (id) {
+    case SimGpioRegId::OUT:
+    case SimGpioRegId::OUT_W1TS:
+    case SimGpioRegId::OUT_W1TC:     return SimBus::out;
+    case SimGpioRegId::OUT1:
+    case SimGpioRegId::OUT1_W1TS:
+    case SimGpioRegId::OUT1_W1TC:    return SimBus::out1;
+    case SimGpioRegId::ENABLE:
+    case SimGpioRegId::ENABLE_W1TS:  return SimBus::enable;
+    case SimGpioRegId::ENABLE1_W1TS: return SimBus::enable1;
+  }
+  return 0;
+}
+
+// ----- I2S1 -----
+
+static constexpr size_t DMA_ARENA_SIZE = 1 << 20;
+
+alignas(DMA_ARENA_SIZE) static uint8_t dma_arena[DMA_ARENA_SIZE];
+
+uint8_t *
+sim_dma_arena()
+{
+  return dma_arena;
+}
+
+struct SimIntr {
+  intr_handler_t handler;
+  void         * arg;
+};
+
+static SimIntr i2s_intr{ nullptr, nullptr };
+
+esp_err_t
+esp_intr_alloc(int source, int flags, intr_handler_t handler, void * arg, intr_handle_t * ret_handle)
+{
+  if ((source != ETS_I2S1_INTR_SOURCE) || (i2s_intr.handler != nullptr)) return ESP_ERR_NOT_FOUND;
+
+  i2s_intr = SimIntr{ handler, arg };
+  if (ret_handle != nullptr) *ret_handle = &i2s_intr;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_intr_free(intr_handle_t handle)
+{
+  if (handle != &i2s_intr) return ESP_ERR_INVALID_ARG;
+
+  i2s_intr = SimIntr{ nullptr, nullptr };
+  return ESP_OK;
+}
+
+static bool     i2s_armed    = false;
+static uint32_t i2s_tx_start = 0;
+
+void
+sim_i2s_push(const uint8_t * line, size_t size)
+{
+  SimBus::stats.i2s_lines++;
+  SimBus::stats.i2s_bytes += size;
+  if (SimBus::i2s_hook) SimBus::i2s_hook(line, size);
+
+  SimPanel & panel = SimPanel::get_singleton();
+  for (size_t i = 0; i < size; i++) panel.shift_byte(line[i]);
+}
+
+// Walks the descriptor chain the way the ESP32 DMA engine does. In LCD mode,
+// with tx_fifo_mod 1, the two 16 bits halves of each 32 bits word are swapped
+// on the way out.
+
+static void
+i2s_run_dma()
+{
+  static uint8_t line[4096];
+
+  lldesc_t * first = (lldesc_t *) (dma_arena + (I2S1.out_link.addr & 0x000FFFFF));
+  lldesc_t * desc  = first;
+  size_t     count = 0;
+
+  while (desc != nullptr) {
+    const uint8_t * buf  = (const uint8_t *) desc->buf + desc->offset;
+    size_t          size = desc->length - desc->offset;
+
+    if (size > sizeof(line)) size = sizeof(line);
+
+    if (I2S1.fifo_conf.tx_fifo_mod == 1) {
+      size_t i = 0;
+      for (; i + 4 <= size; i += 4) {
+        line[i    ] = buf[i + 2];
+        line[i + 1] = buf[i + 3];
+        line[i + 2] = buf[i    ];
+        line[i + 3] = buf[i + 1];
+      }
+      for (; i < size; i++) line[i] = buf[i];
+    }
+    else {
+      for (size_t i = 0; i < size; i++) line[i] = buf[i];
+    }
+
+    sim_i2s_push(line, size);
+
+    if (desc->eof) {
+      I2S1.int_raw.out_eof = 1;
+      I2S1.out_eof_des_addr = (uint32_t) ((uint8_t *) desc - dma_arena);
+    }
+
+    desc = desc->qe.stqe_next;
+    if ((desc == first) || (++count >= 4096)) break;
+  }
+
+  I2S1.int_raw.out_done      = 1;
+  I2S1.int_raw.out_total_eof = 1;
+
+  // The transfer being instantaneous, the interrupt is raised before
+  // conf.tx_start returns.
+
+  I2S1.int_st.val = I2S1.int_raw.val & I2S1.int_ena.val;
+  if ((I2S1.int_st.val != 0) && (i2s_intr.handler != nullptr)) {
+    SimBus::get_stats().i2s_interrupts++;
+    i2s_intr.handler(i2s_intr.arg);
+  }
+}
+
+void
+sim_i2s_write(SimI2SRegId id, uint32_t value)
+{
+  switch (id) {
+    case SimI2SRegId::OUT_LINK_START:
+      i2s_armed = value != 0;
+      break;
+    case SimI2SRegId::CONF_TX_START:
+      i2s_tx_start = value;
+      if (value && i2s_armed) {
+        i2s_armed = false;
+        i2s_run_dma();
+      }
+      break;
+    case SimI2SRegId::INT_CLR:
+      I2S1.int_raw.val &= ~value;
+      I2S1.int_st.val  &= ~value;
+      break;
+  }
+}
+
+uint32_t
+sim_i2s_read(SimI2SRegId id)
+{
+  switch (id) {
+    case SimI2SRegId::OUT_LINK_START: return i2s_armed ? 1 : 0;
+    case SimI2SRegId::CONF_TX_START:  return i2s_tx_start;
+    case SimI2SRegId::INT_CLR:        return 0;
+  }
+  return 0;
+}
+
+// ----- I2C -----
+
+struct SimI2CDevice {
+  uint8_t address;
+  uint8_t pointer;
+  uint8_t registers[256];
+};
+
+struct SimI2CBus {
+  int dummy;
+};
+
+static std::mutex                        i2c_mutex;
+static std::map<uint8_t, SimI2CDevice *> i2c_devices;
+static std::set<uint8_t>                 i2c_present = { 0x20, 0x21, 0x22, SimBus::PWRMGR_ADDRESS, 0x51 };
+static SimI2CBus                         i2c_bus;
+
+static uint8_t pwrup_address = 0x20;
+static uint8_t pwrup_reg     = 0x12;
+static uint8_t pwrup_bit     = 4;
+
+static SimI2CDevice *
+i2c_device(uint8_t address)
+{
+  auto it = i2c_devices.find(address);
+  if (it != i2c_devices.end()) return it->second;
+
+  SimI2CDevice * dev = new SimI2CDevice{ address, 0, {} };
+  i2c_devices[address] = dev;
+  return dev;
+}
+
+static uint8_t
+i2c_read_register(SimI2CDevice * dev, uint8_t reg)
+{
+  if (dev->address == SimBus::PWRMGR_ADDRESS) {
+    if (reg == 0x0F) {
+      // Power good on all rails as soon as PWRUP is set
+      return (i2c_device(pwrup_address)->registers[pwrup_reg] & (1 << pwrup_bit)) ? 0b11111010 : 0;
+    }
+    if (reg == 0x00) return 23; // Temperature
+  }
+  return dev->registers[reg];
+}
+
+void
+SimBus::set_pwrup_signal(uint8_t address, uint8_t reg, uint8_t bit)
+{
+  pwrup_address = address;
+  pwrup_reg     = reg;
+  pwrup_bit     = bit;
+}
+
+void
+SimBus::add_i2c_device(uint8_t address)
+{
+  std::lock_guard<std::mutex> lock(i2c_mutex);
+  i2c_present.insert(address);
+}
+
+uint8_t
+SimBus::i2c_register(uint8_t address, uint8_t reg)
+{
+  return i2c_device(address)->registers[reg];
+}
+
+esp_err_t
+i2c_new_master_bus(const i2c_master_bus_config_t * bus_config, i2c_master_bus_handle_t * ret_bus_handle)
+{
+  *ret_bus_handle = &i2c_bus;
+  return ESP_OK;
+}
+
+esp_err_t
+i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle, const i2c_device_config_t * dev_config,
+                          i2c_master_dev_handle_t * ret_handle)
+{
+  std::lock_guard<std::mutex> lock(i2c_mutex);
+  *ret_handle = i2c_device(dev_config->device_address);
+  return ESP_OK;
+}
+
+esp_err_t
+i2c_master_probe(i2c_master_bus_handle_t bus_handle, uint16_t address, int xfer_timeout_ms)
+{
+  std::lock_guard<std::mutex> lock(i2c_mutex);
+  return i2c_present.count(address) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t
+i2c_master_bus_wait_all_done(i2c_master_bus_handle_t bus_handle, int timeout_ms)
+{
+  return ESP_OK;
+}
+
+esp_err_t
+i2c_master_transmit(i2c_master_dev_handle_t dev, const uint8_t * write_buffer, size_t write_size,
+                    int xfer_timeout_ms)
+{
+  std::lock_guard<std::mutex> lock(i2c_mutex);
+  SimBus::get_stats().i2c_transactions++;
+
+  if (write_size == 0) return ESP_OK;
+
+  dev->pointer = write_buffer[0];
+  for (size_t i = 1; i < write_size; i++) dev->registers[dev->pointer++] = write_buffer[i];
+
+  return ESP_OK;
+}
+
+esp_err_t
+i2c_master_receive(i2c_master_dev_handle_t dev, uint8_t * read_buffer, size_t read_size, int xfer_timeout_ms)
+{
+  std::lock_guard<std::mutex> lock(i2c_mutex);
+  SimBus::get_stats().i2c_transactions++;
+
+  for (size_t i = 0; i < read_size; i++) read_buffer[i] = i2c_read_register(dev, dev->pointer++);
+
+  return ESP_OK;
+}
+
+esp_err_t
+i2c_master_transmit_receive(i2c_master_dev_handle_t dev, const uint8_t * write_buffer, size_t write_size,
+                            uint8_t * read_buffer, size_t read_size, int xfer_timeout_ms)
+{
+  std::lock_guard<std::mutex> lock(i2c_mutex);
+  SimBus::get_stats().i2c_transactions++;
+
+  if (write_size > 0) {
+    dev->pointer = write_buffer[0];
+    for (size_t i = 1; i < write_size; i++) dev->registers[dev->pointer++] = write_buffer[i];
+  }
+  for (size_t i = 0; i < read_size; i++) read_buffer[i] = i2c_read_register(dev, dev->pointer++);
+
+  return ESP_OK;
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#pragma once
+
+// Recording layer behind the GPIO, I2S1 and I2C stand-ins found in
+// test/host/esp_idf.
+//
+// Every write to the GPIO output registers and every line pushed by the I2S
+// DMA engine is counted, forwarded to the simulated panel and, if a hook is
+// installed, reported to the test/benchmark code. I2S1 interrupts are raised
+// at the end of each DMA transfer. I2C devices are simple
+// register files with an auto-incremented register pointer. The TPS65186
+// power manager reports power good as soon as PWRUP is high on the main
+// IO expander.
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "soc/gpio_struct.h"
+
+class SimBus
+{
+  public:
+    struct Stats {
+      uint64_t gpio_writes;      ///< Writes to GPIO.out, out_w1ts, out_w1tc, out1_w1ts, out1_w1tc
+      uint64_t i2s_lines;        ///< DMA transfers started through I2S1.conf.tx_start
+      uint64_t i2s_bytes;        ///< Bytes pushed by these transfers
+      uint64_t i2s_interrupts;   ///< I2S1 interrupt handler calls
+      uint64_t i2c_transactions; ///< Transmit, receive and transmit/receive calls
+    };
+
+    typedef std::function<void(SimGpioRegId reg, uint32_t value)> GpioHook;
+    typedef std::function<void(const uint8_t * line, size_t size)> I2SHook;
+
+    static constexpr uint8_t PWRMGR_ADDRESS = 0x48;
+
+    static inline Stats & get_stats() { return stats; }
+    static void reset_stats();
+
+    static void set_gpio_hook(GpioHook hook) { gpio_hook = hook; }
+    static void  set_i2s_hook(I2SHook  hook) {  i2s_hook = hook; }
+
+    /// Tells the power manager model where the PWRUP signal can be found
+    /// (IO expander output register and bit).
+    static void set_pwrup_signal(uint8_t address, uint8_t reg, uint8_t bit);
+
+    /// Makes a device answer to i2c_master_probe().
+    static void add_i2c_device(uint8_t address);
+
+    static uint8_t i2c_register(uint8_t address, uint8_t reg);
+
+    static inline uint32_t get_out()  { return out;  }
+    static inline uint32_t get_out1() { return out1; }
+
+  private:
+    friend void     sim_gpio_write(SimGpioRegId id, uint32_t value);
+    friend uint32_t sim_gpio_read(SimGpioRegId id);
+    friend void     sim_i2s_push(const uint8_t * line, size_t size);
+
+    static Stats    stats;
+    static GpioHook gpio_hook;
+    static I2SHook  i2s_hook;
+    static uint32_t out, out1, enable, enable1;
+};
+
+/// Base of the DMA capable memory arena (see esp_heap_caps.h).
+uint8_t * sim_dma_arena();
@@ -0,0 +1,591 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#include "sim_network.hpp"
+
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+#include "esp_http_client.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+
+struct SimContent {
+  std::vector<uint8_t> body;
+  std::string          etag, last_modified;
+  int64_t              length;   // Announced body length, -1 for the body size
+  int                  status;   // 200, or the 3xx status of a redirection to location
+  std::string          location;
+};
+
+static std::mutex                                   web_mutex;
+static std::map<std::string, SimContent>            web;
+static uint32_t                                     server_generation = 0;
+static bool                                         ap_reachable = true;
+static bool                                         chunked      = false;
+static SimNetwork::Stats                            stats{};
+
+void
+SimNetwork::serve(const std::string & url, const std::vector<uint8_t> & content)
+{
+  serve(url, content, "", "");
+}
+
+void
+SimNetwork::serve(const std::string & url, const std::vector<uint8_t> & content,
+                  const std::string & etag, const std::string & last_modified)
+{
+  std::lock_guard<std::mutex> lock(web_mutex);
+  web[url] = { content, etag, last_modified, -1, 200, "" };
+}
+
+void
+SimNetwork::serve_truncated(const std::string & url, const std::vector<uint8_t> & content, size_t length)
+{
+  std::lock_guard<std::mutex> lock(web_mutex);
+  web[url] = { content, "", "", (int64_t) length, 200, "" };
+}
+
+void
+SimNetwork::redirect(const std::string & url, const std::string & location, int status)
+{
+  std::lock_guard<std::mutex> lock(web_mutex);
+  web[url] = { std::vector<uint8_t>(), "", "", -1, status, location };
+}
+
+void
+SimNetwork::serve(const std::string & url, const void * content, size_t size)
+{
+  const uint8_t * p = (const uint8_t *) content;
+  serve(url, std::vector<uint8_t>(p, p + size));
+}
+
+void
+SimNetwork::unserve(const std::string & url)
+{
+  std::lock_guard<std::mutex> lock(web_mutex);
+  web.erase(url);
+}
+
+void
+SimNetwork::clear()
+{
+  std::lock_guard<std::mutex> lock(web_mutex);
+  web.clear();
+}
+
+void SimNetwork::set_chunked(bool c)              { chunked = c;              }
+void SimNetwork::drop_connections()               { server_generation++;      }
+void SimNetwork::set_ap_reachable(bool reachable) { ap_reachable = reachable; }
+bool SimNetwork::is_ap_reachable()                { return ap_reachable;      }
+
+SimNetwork::Stats & SimNetwork::get_stats()       { return stats;             }
+void                SimNetwork::reset_stats()     { stats = Stats{};          }
+
+// ----- Event loop -----
+
+esp_event_base_t const WIFI_EVENT = "WIFI_EVENT";
+esp_event_base_t const IP_EVENT   = "IP_EVENT";
+
+struct EventHandler {
+  esp_event_base_t    base;
+  int32_t             id;
+  esp_event_handler_t handler;
+  void *              arg;
+};
+
+static std::vector<EventHandler> event_handlers;
+static bool                      event_loop_created = false;
+
+esp_err_t
+esp_event_loop_create_default()
+{
+  if (event_loop_created) return ESP_ERR_INVALID_STATE;
+  event_loop_created = true;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_event_loop_delete_default()
+{
+  event_loop_created = false;
+  event_handlers.clear();
+  return ESP_OK;
+}
+
+esp_err_t
+esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+                           esp_event_handler_t event_handler, void * event_handler_arg)
+{
+  event_handlers.push_back({ event_base, event_id, event_handler, event_handler_arg });
+  return ESP_OK;
+}
+
+esp_err_t
+esp_event_handler_unregister(esp_event_base_t event_base, int32_t event_id,
+                             esp_event_handler_t event_handler)
+{
+  for (auto it = event_handlers.begin(); it != event_handlers.end(); ) {
+    if ((it->handler == event_handler) &&
+        ((event_base == ESP_EVENT_ANY_BASE) || (it->base == event_base)) &&
+        ((event_id   == ESP_EVENT_ANY_ID  ) || (it->id   == event_id  ))) {
+      it = event_handlers.erase(it);
+    }
+    else {
+      it++;
+    }
+  }
+  return ESP_OK;
+}
+
+esp_err_t
+esp_event_post(esp_event_base_t event_base, int32_t event_id, void * event_data,
+               size_t event_data_size, uint32_t ticks_to_wait)
+{
+  // A copy, as handlers may register or unregister handlers.
+  std::vector<EventHandler> handlers = event_handlers;
+
+  for (auto & h : handlers) {
+    if (((h.base == ESP_EVENT_ANY_BASE) || (h.base == event_base)) &&
+        ((h.id   == ESP_EVENT_ANY_ID  ) || (h.id   == event_id  ))) {
+      h.handler(h.arg, event_base, event_id, event_data);
+    }
+  }
+  return ESP_OK;
+}
+
+// ----- Netif -----
+
+struct SimNetif {
+  bool                 dhcp;     // Else the address given by esp_netif_set_ip_info()
+  esp_netif_ip_info_t  ip_info;
+  esp_netif_dns_info_t dns;
+};
+
+static SimNetif sta_netif{ true, {}, {} };
+
+esp_err_t     esp_netif_init()                    { return ESP_OK;      }
+esp_netif_t * esp_netif_create_default_wifi_sta() { return &sta_netif;  }
+
+esp_err_t esp_netif_dhcpc_start(esp_netif_t * netif) { netif->dhcp = true;  return ESP_OK; }
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t * netif)  { netif->dhcp = false; return ESP_OK; }
+
+esp_err_t
+esp_netif_set_ip_info(esp_netif_t * netif, const esp_netif_ip_info_t * ip_info)
+{
+  if (netif->dhcp) return ESP_ERR_INVALID_STATE;
+  netif->ip_info = *ip_info;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_netif_set_dns_info(esp_netif_t * netif, esp_netif_dns_type_t type, esp_netif_dns_info_t * dns)
+{
+  if (type == ESP_NETIF_DNS_MAIN) netif->dns = *dns;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_netif_get_dns_info(esp_netif_t * netif, esp_netif_dns_type_t type, esp_netif_dns_info_t * dns)
+{
+  *dns = netif->dns;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_netif_str_to_ip4(const char * src, esp_ip4_addr_t * dst)
+{
+  unsigned a, b, c, d;
+  char     end;
+  if ((src == nullptr) || (sscanf(src, "%u.%u.%u.%u%c", &a, &b, &c, &d, &end) != 4) ||
+      (a > 255) || (b > 255) || (c > 255) || (d > 255)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  dst->addr = a | (b << 8) | (c << 16) | (d << 24);
+  return ESP_OK;
+}
+
+// ----- Wi-Fi -----
+
+static bool          wifi_started = false;
+static wifi_config_t sta_config{};
+
+static const uint8_t ap_bssid[6] = { 0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56 };
+static uint8_t       ap_channel  = 6;
+
+void SimNetwork::set_ap_channel(uint8_t channel) { ap_channel = channel; }
+
+esp_err_t esp_wifi_init(const wifi_init_config_t * config)               { return ESP_OK; }
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)                            { return ESP_OK; }
+
+esp_err_t
+esp_wifi_set_config(wifi_interface_t interface, wifi_config_t * conf)
+{
+  if (interface == WIFI_IF_STA) sta_config = *conf;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_wifi_start()
+{
+  wifi_started = true;
+  return esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, nullptr, 0, 0);
+}
+
+esp_err_t
+esp_wifi_stop()
+{
+  wifi_started = false;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_wifi_connect()
+{
+  if (!wifi_started) return ESP_ERR_INVALID_STATE;
+
+  stats.connect_attempts++;
+
+  // A channel given: only that one is probed, else every channel is scanned
+
+  const wifi_sta_config_t & sta = sta_config.sta;
+  if (sta.channel == 0) stats.scans++;
+
+  bool found = ((sta.channel == 0) || (sta.channel == ap_channel)) &&
+               (!sta.bssid_set || (memcmp(sta.bssid, ap_bssid, 6) == 0));
+
+  if (ap_reachable && found) {
+    wifi_event_sta_connected_t connected;
+    memset(&connected, 0, sizeof(connected));
+    memcpy(connected.ssid, sta.ssid, sizeof(connected.ssid));
+    connected.ssid_len = strnlen((const char *) sta.ssid, sizeof(sta.ssid));
+    memcpy(connected.bssid, ap_bssid, 6);
+    connected.channel  = ap_channel;
+    connected.authmode = WIFI_AUTH_WPA2_PSK;
+
+    ip_event_got_ip_t event;
+    memset(&event, 0, sizeof(event));
+    event.esp_netif = &sta_netif;
+    if (sta_netif.dhcp) {
+      stats.dhcp_leases++;
+      sta_netif.ip_info.ip.addr      = 0x6401A8C0; // 192.168.1.100
+      sta_netif.ip_info.netmask.addr = 0x00FFFFFF;
+      sta_netif.ip_info.gw.addr      = 0x0101A8C0;
+      sta_netif.dns.ip.u_addr.ip4.addr = 0x0101A8C0;
+    }
+    event.ip_info = sta_netif.ip_info;
+    stats.ip    = sta_netif.ip_info.ip.addr;
+
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &connected, sizeof(connected), 0);
+    esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &event, sizeof(event), 0);
+  }
+  else {
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, nullptr, 0, 0);
+  }
+  return ESP_OK;
+}
+
+esp_err_t
+esp_wifi_disconnect()
+{
+  return ESP_OK;
+}
+
+// ----- HTTP client -----
+
+struct SimHttpClient {
+  esp_http_client_config_t           config;
+  std::string                        url;
+  std::map<std::string, std::string> headers;  // Request headers
+  std::string                        etag, last_modified;
+  std::string                        location;  // Of a 3xx answer
+  int                      status;        // Of the content found
+  int                      status_code;
+  int64_t                  content_length;
+  int64_t                  announced;     // Content-Length of the body, -1 for its size
+  bool                     opened;
+  bool                     connected;   // Kept alive between requests
+  uint32_t                 generation;  // server_generation when connected
+  bool                     found;
+  std::vector<uint8_t>     body;
+  size_t                   read_pos;
+};
+
+esp_http_client_handle_t
+esp_http_client_init(const esp_http_client_config_t * config)
+{
+  if ((config == nullptr) || (config->url == nullptr)) return nullptr;
+
+  SimHttpClient * client = new SimHttpClient;
+  client->config         = *config;
+  client->url            = config->url;
+  client->status         = 200;
+  client->status_code    = 0;
+  client->content_length = -1;
+  client->announced      = -1;
+  client->opened         = false;
+  client->connected      = false;
+  client->generation     = 0;
+  client->found          = false;
+  client->read_pos       = 0;
+  return client;
+}
+
+static void
+http_event(SimHttpClient * client, esp_http_client_event_id_t id,
+           const void * data = nullptr, int data_len = 0,
+           const char * key = nullptr, const char * value = nullptr)
+{
+  if (client->config.event_handler == nullptr) return;
+
+  esp_http_client_event_t evt;
+  evt.event_id     = id;
+  evt.client       = client;
+  evt.data         = (void *) data;
+  evt.data_len     = data_len;
+  evt.user_data    = client->config.user_data;
+  evt.header_key   = (char *) key;
+  evt.header_value = (char *) value;
+
+  client->config.event_handler(&evt);
+}
+
+esp_err_t
+esp_http_client_perform(esp_http_client_handle_t client)
+{
+  if (client == nullptr) return ESP_ERR_INVALID_ARG;
+
+  stats.http_requests++;
+
+  std::vector<uint8_t> body;
+  bool                 found;
+  {
+    std::lock_guard<std::mutex> lock(web_mutex);
+    auto it = web.find(client->url);
+    found = it != web.end();
+    if (found) body = it->second.body;
+  }
+
+  http_event(client, HTTP_EVENT_ON_CONNECTED);
+  http_event(client, HTTP_EVENT_HEADER_SENT);
+
+  client->status_code    = found ? 200 : 404;
+  client->content_length = chunked ? -1 : body.size();
+
+  std::string length = std::to_string(body.size());
+  if (!chunked) http_event(client, HTTP_EVENT_ON_HEADER, nullptr, 0, "Content-Length", length.c_str());
+
+  for (size_t pos = 0; pos < body.size(); pos += SimNetwork::CHUNK_SIZE) {
+    size_t size = std::min(SimNetwork::CHUNK_SIZE, body.size() - pos);
+    http_event(client, HTTP_EVENT_ON_DATA, body.data() + pos, (int) size);
+    stats.http_bytes += size;
+  }
+
+  http_event(client, HTTP_EVENT_ON_FINISH);
+  http_event(client, HTTP_EVENT_DISCONNECTED);
+
+  return ESP_OK;
+}
+
+// Scheme, host and port of an URL
+
+static std::string
+origin(const std::string & url)
+{
+  size_t host = url.find("://");
+  return (host == std::string::npos) ? url : url.substr(0, url.find('/', host + 3));
+}
+
+esp_err_t
+esp_http_client_set_url(esp_http_client_handle_t client, const char * url)
+{
+  if ((client == nullptr) || (url == nullptr)) return ESP_ERR_INVALID_ARG;
+
+  if (origin(url) != origin(client->url)) esp_http_client_close(client);
+  client->url = url;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_http_client_set_header(esp_http_client_handle_t client, const char * key, const char * value)
+{
+  if ((client == nullptr) || (key == nullptr) || (value == nullptr)) return ESP_ERR_INVALID_ARG;
+
+  client->headers[key] = value;
+  return ESP_OK;
+}
+
+esp_err_t
+esp_http_client_delete_header(esp_http_client_handle_t client, const char * key)
+{
+  if ((client == nullptr) || (key == nullptr)) return ESP_ERR_INVALID_ARG;
+
+  client->headers.erase(key);
+  return ESP_OK;
+}
+
+esp_err_t
+esp_http_client_open(esp_http_client_handle_t client, int write_len)
+{
+  if (client == nullptr) return ESP_ERR_INVALID_ARG;
+
+  // A kept connection closed by the server, or still carrying the unread end
+  // of the previous response, can't take a new request
+
+  if (client->connected) {
+    bool unread = client->opened && (client->read_pos < client->body.size());
+    if ((client->generation != server_generation) || unread) {
+      esp_http_client_close(client);
+      return ESP_FAIL;
+    }
+  }
+  else {
+    client->connected  = true;
+    client->generation = server_generation;
+    stats.connections++;
+  }
+
+  stats.http_requests++;
+
+  {
+    std::lock_guard<std::mutex> lock(web_mutex);
+    auto it = web.find(client->url);
+    client->found         = it != web.end();
+    client->body          = client->found ? it->second.body : std::vector<uint8_t>();
+    client->etag          = client->found ? it->second.etag : "";
+    client->last_modified = client->found ? it->second.last_modified : "";
+    client->announced     = client->found ? it->second.length : -1;
+    client->status        = client->found ? it->second.status : 404;
+    client->location      = client->found ? it->second.location : "";
+  }
+  client->opened   = true;
+  client->read_pos = 0;
+
+  http_event(client, HTTP_EVENT_ON_CONNECTED);
+  http_event(client, HTTP_EVENT_HEADER_SENT);
+
+  return ESP_OK;
+}
+
+int64_t
+esp_http_client_fetch_headers(esp_http_client_handle_t client)
+{
+  if ((client == nullptr) || !client->opened) return ESP_FAIL;
+
+  auto matches = [client](const char * key, const std::string & value) {
+    auto it = client->headers.find(key);
+    return !value.empty() && (it != client->headers.end()) && (it->second == value);
+  };
+
+  client->status_code = client->status;
+  if (!client->location.empty()) http_event(client, HTTP_EVENT_ON_HEADER, nullptr, 0, "Location", client->location.c_str());
+  if ((client->status == 200) && (matches("If-None-Match", client->etag) || matches("If-Modified-Since", client->last_modified))) {
+    client->status_code = 304;
+    client->body.clear();
+    client->announced = -1;
+    stats.not_modified++;
+  }
+
+  if (!client->etag.empty()) http_event(client, HTTP_EVENT_ON_HEADER, nullptr, 0, "ETag", client->etag.c_str());
+  if (!client->last_modified.empty()) {
+    http_event(client, HTTP_EVENT_ON_HEADER, nullptr, 0, "Last-Modified", client->last_modified.c_str());
+  }
+
+  client->content_length = chunked ? -1 : (client->announced >= 0) ? client->announced : (int64_t) client->body.size();
+
+  if (chunked) return 0;
+
+  std::string length = std::to_string(client->content_length);
+  http_event(client, HTTP_EVENT_ON_HEADER, nullptr, 0, "Content-Length", length.c_str());
+
+  return client->content_length;
+}
+
+esp_err_t
+esp_http_client_set_redirection(esp_http_client_handle_t client)
+{
+  if ((client == nullptr) || client->location.empty()) return ESP_ERR_INVALID_ARG;
+
+  return esp_http_client_set_url(client, client->location.c_str());
+}
+
+int
+esp_http_client_read(esp_http_client_handle_t client, char * buffer, int len)
+{
+  if ((client == nullptr) || !client->opened || (len < 0)) return -1;
+
+  size_t size = std::min({ (size_t) len, SimNetwork::CHUNK_SIZE, client->body.size() - client->read_pos });
+
+  memcpy(buffer, client->body.data() + client->read_pos, size);
+  client->read_pos += size;
+  stats.http_bytes += size;
+
+  return (int) size;
+}
+
+esp_err_t
+esp_http_client_flush_response(esp_http_client_handle_t client, int * len)
+{
+  if ((client == nullptr) || !client->opened) return ESP_FAIL;
+
+  size_t size = client->body.size() - client->read_pos;
+  client->read_pos  = client->body.size();
+  stats.http_bytes += size;
+
+  if (len != nullptr) *len = (int) size;
+  return ESP_OK;
+}
+
+bool
+esp_http_client_is_complete_data_received(esp_http_client_handle_t client)
+{
+  return (client != nullptr) && client->opened && (client->read_pos == client->body.size()) &&
+         ((client->announced < 0) || (client->announced == (int64_t) client->body.size()));
+}
+
+esp_err_t
+esp_http_client_close(esp_http_client_handle_t client)
+{
+  if (client == nullptr) return ESP_FAIL;
+
+  bool was_connected = client->connected;
+
+  client->opened    = false;
+  client->connected = false;
+  client->body.clear();
+  client->read_pos  = 0;
+  if (was_connected) http_event(client, HTTP_EVENT_DISCONNECTED);
+
+  return ESP_OK;
+}
+
+esp_err_t
+esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+  delete client;
+  return ESP_OK;
+}
+
+int
+esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+  return client->status_code;
+}
+
+int64_t
+esp_http_client_get_content_length(esp_http_client_handle_t client)
+{
+  return client->content_length;
+}
+
+bool
+esp_http_client_is_chunked_response(esp_http_client_handle_t client)
+{
+  return chunked;
+}
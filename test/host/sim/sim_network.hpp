@@ -0,0 +1,78 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#pragma once
+
+// Simulated network: a Wi-Fi access point and an in-memory web.
+//
+// The station gets its IP address as soon as esp_wifi_connect() is called,
+// unless the access point has been made unreachable, in which case a
+// WIFI_EVENT_STA_DISCONNECTED event is posted. The same happens when the
+// station config names another BSSID or channel than the access point ones
+// (see set_ap_channel()). The address comes from DHCP, unless stopped with
+// esp_netif_dhcpc_stop(): esp_netif_set_ip_info() gives it then. Events are dispatched
+// synchronously to the handlers registered through esp_event.h.
+//
+// esp_http_client_perform() looks up the requested URL in the web content
+// registered with serve() and sends it back through the usual
+// HTTP_EVENT_ON_HEADER / HTTP_EVENT_ON_DATA events, in chunks of at most
+// CHUNK_SIZE bytes. Unknown URLs get a 404 answer. With the streaming calls
+// (esp_http_client_open() / fetch_headers() / read()), a read returns at most
+// CHUNK_SIZE bytes, as a network read would. With set_chunked(), the answers
+// have no Content-Length, as chunked responses.
+//
+// Content served with an ETag or a Last-Modified value gets a 304 answer,
+// without body, when the request has a matching If-None-Match or
+// If-Modified-Since header.
+//
+// URLs registered with redirect() get a 3xx answer, without body, with the
+// Location header given: esp_http_client_set_redirection() moves the client
+// to that location.
+//
+// The streaming calls keep their connection between requests to the same
+// server, as HTTP/1.1 keep-alive, once a response is completely read.
+// drop_connections() closes the idle ones, as a server would after a timeout.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class SimNetwork
+{
+  public:
+    static constexpr size_t CHUNK_SIZE = 2048;
+
+    struct Stats {
+      uint32_t connect_attempts; ///< esp_wifi_connect() calls
+      uint32_t scans;            ///< esp_wifi_connect() calls without a channel
+      uint32_t dhcp_leases;      ///< Addresses given by DHCP
+      uint32_t ip;               ///< Last address of the station
+      uint32_t http_requests;    ///< esp_http_client_perform() and esp_http_client_open() calls
+      uint64_t http_bytes;       ///< Body bytes sent back to the clients
+      uint32_t not_modified;     ///< 304 answers
+      uint32_t connections;      ///< Connections opened by esp_http_client_open()
+    };
+
+    static void serve(const std::string & url, const std::vector<uint8_t> & content);
+    static void serve(const std::string & url, const void * content, size_t size);
+    static void serve(const std::string & url, const std::vector<uint8_t> & content,
+                      const std::string & etag, const std::string & last_modified = "");
+    // Content-Length says length bytes, only content is sent: a transfer cut
+    // by the server
+    static void serve_truncated(const std::string & url, const std::vector<uint8_t> & content, size_t length);
+    static void redirect(const std::string & url, const std::string & location, int status = 302);
+    static void unserve(const std::string & url);
+    static void clear();
+
+    static void set_chunked(bool chunked);
+    static void drop_connections();
+
+    static void set_ap_reachable(bool reachable);
+    static void set_ap_channel(uint8_t channel);
+    static bool is_ap_reachable();
+
+    static Stats & get_stats();
+    static void  reset_stats();
+};
@@ -0,0 +1,96 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#include "sim_panel.hpp"
+#include "sim_bus.hpp"
+
+#include <algorithm>
+
+void
+SimPanel::configure(int16_t w, int16_t h, uint8_t address, uint8_t reg, uint8_t bit)
+{
+  width       = w;
+  height      = h;
+  spv_address = address;
+  spv_reg     = reg;
+  spv_bit     = bit;
+
+  reset();
+}
+
+void
+SimPanel::reset()
+{
+  pixels.assign((size_t) width * height, 0);
+  line.assign(width / 4, 0);
+  column        = 0;
+  gate_position = -1;
+  reset_stats();
+}
+
+// Inverse of the EInk::PIN_LUT table.
+uint8_t
+SimPanel::decode_data_bus(uint32_t out)
+{
+  return  ((out >>  4) & 0x03)       |
+         (((out >> 18) & 0x03) << 2) |
+         (((out >> 23) & 0x01) << 4) |
+         (((out >> 25) & 0x07) << 5);
+}
+
+void
+SimPanel::shift_byte(uint8_t value)
+{
+  stats.bytes_shifted++;
+  if (recording != nullptr) recording->push_back(value);
+  if (column < line.size()) line[column] = value;
+  column++;
+}
+
+void
+SimPanel::latch()
+{
+  int row = gate_position - GATE_DUMMY_ROWS;
+  if ((row < 0) || (row >= height)) return;
+
+  stats.rows_latched++;
+
+  uint8_t * p = &pixels[(size_t) (height - 1 - row) * width];
+  size_t    count = std::min(column, line.size());
+
+  for (size_t k = 0; k < count; k++) {
+    uint8_t   value = line[k];
+    uint8_t * pix   = &p[width - 4 - (4 * k)];
+    for (int j = 0; j < 4; j++, value >>= 2) {
+      switch (value & 0x03) {
+        case 0x01: if (pix[j] < SATURATION) pix[j]++; break;
+        case 0x02: if (pix[j] > 0)          pix[j]--; break;
+        default:   break;
+      }
+    }
+  }
+}
+
+void
+SimPanel::gpio_changed(uint32_t out_before, uint32_t out, uint32_t out1_before, uint32_t out1)
+{
+  if (pixels.empty()) return;
+
+  if ((out1_before & SPH) && !(out1 & SPH)) column = 0;
+
+  if (!(out1_before & CKV) && (out1 & CKV)) {
+    stats.gate_clocks++;
+    if ((SimBus::i2c_register(spv_address, spv_reg) & (1 << spv_bit)) == 0) {
+      gate_position = 0;
+      stats.frames++;
+    }
+    else if (gate_position >= 0) {
+      gate_position++;
+    }
+  }
+
+  if (!(out_before & CL) && (out & CL)) shift_byte(decode_data_bus(out));
+
+  if (!(out_before & LE) && (out & LE)) latch();
+}
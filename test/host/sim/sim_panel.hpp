@@ -0,0 +1,95 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+#pragma once
+
+// Simulated e-Ink panel.
+//
+// The panel decodes the signals produced by the EInk drivers:
+//
+// - SPH falling edge: start of a source line (column pointer reset)
+// - CL rising edge: one byte (4 pixels, 2 bits each) sampled from the
+//   GPIO data bus (bit-banged drivers)
+// - I2S DMA bytes: same as CL edges, for the I2S based drivers
+// - CKV rising edge: gate shift register clock. SPV (on the main IO expander)
+//   sampled low loads the start token. The first GATE_DUMMY_ROWS
+//   positions of the shift register are not connected to any row.
+// - LE rising edge: the source line is applied to the row selected by the
+//   gate shift register.
+//
+// Each pixel holds an ink level between 0 (white) and SATURATION (black):
+// a 01 code moves it one step toward black, 10 one step toward white, 00
+// and 11 leave it unchanged. The rows and bytes are shifted in reverse
+// order, the panel being mounted upside down, so that a frame buffer sent by
+// the drivers maps one to one to the panel coordinates.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class SimPanel
+{
+  public:
+    static constexpr uint8_t SATURATION      = 4;
+    static constexpr int     GATE_DUMMY_ROWS = 3;
+
+    struct Stats {
+      uint64_t frames;         ///< Gate start pulses (one per driving phase)
+      uint64_t rows_latched;   ///< LE pulses applied to a visible row
+      uint64_t gate_clocks;    ///< CKV rising edges
+      uint64_t bytes_shifted;  ///< Source bytes received (CL edges or I2S bytes)
+    };
+
+    static SimPanel & get_singleton() noexcept {
+      static SimPanel singleton;
+      return singleton;
+    }
+
+    /// Sets the panel geometry and where the SPV signal is found
+    /// (IO expander address, output register and bit).
+    void configure(int16_t w, int16_t h, uint8_t spv_address, uint8_t spv_reg, uint8_t spv_bit);
+
+    /// All pixels back to white, statistics cleared.
+    void reset();
+
+    inline int16_t  get_width() const { return width;  }
+    inline int16_t get_height() const { return height; }
+
+    inline uint8_t ink(int16_t x, int16_t y) const { return pixels[y * width + x]; }
+    inline bool is_black(int16_t x, int16_t y) const { return ink(x, y) == SATURATION; }
+    inline bool is_white(int16_t x, int16_t y) const { return ink(x, y) == 0; }
+
+    inline Stats & get_stats() { return stats; }
+    inline void  reset_stats() { stats = Stats{}; }
+
+    /// Appends every source byte received to *bytes, until called with nullptr.
+    inline void record(std::vector<uint8_t> * bytes) { recording = bytes; }
+
+    // Bus events, called by the recording layer.
+
+    void gpio_changed(uint32_t out_before, uint32_t out, uint32_t out1_before, uint32_t out1);
+    void shift_byte(uint8_t value);
+
+  private:
+    SimPanel() {}
+
+    static constexpr uint32_t CL   = 0x01; // GPIO0  (out)
+    static constexpr uint32_t LE   = 0x04; // GPIO2  (out)
+    static constexpr uint32_t CKV  = 0x01; // GPIO32 (out1)
+    static constexpr uint32_t SPH  = 0x02; // GPIO33 (out1)
+
+    int16_t width{0}, height{0};
+    uint8_t spv_address{0}, spv_reg{0}, spv_bit{0};
+
+    std::vector<uint8_t> pixels;
+    std::vector<uint8_t> line;
+    size_t               column{0};
+    int                  gate_position{-1};
+
+    Stats stats{};
+    std::vector<uint8_t> * recording{nullptr};
+
+    void latch();
+    static uint8_t decode_data_bus(uint32_t out);
+};
@@ -0,0 +1,367 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Host implementation of the ESP-IDF and FreeRTOS services used by the
+// library: logging, timer, heap capabilities, tasks, semaphores, event
+// groups and GPIO configuration.
+//
+// Time is virtual: every esp_timer_get_time() call advances the clock by one
+// microsecond and vTaskDelay() advances it by the requested amount of ticks,
+// so that busy-wait delays in the drivers cost nothing on the host while
+// keeping their relative order.
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "driver/gpio.h"
+
+#include "sim_bus.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// ----- Logging -----
+
+static esp_log_level_t log_level = ESP_LOG_WARN;
+
+void
+esp_log_level_set(const char * tag, esp_log_level_t level)
+{
+  log_level = level;
+}
+
+void
+esp_log_write(esp_log_level_t level, const char * tag, const char * format, ...)
+{
+  if (level > log_level) return;
+
+  static const char letters[] = "NEWIDV";
+
+  va_list args;
+  va_start(args, format);
+  fprintf(stderr, "%c (%s) ", letters[level], tag);
+  vfprintf(stderr, format, args);
+  fputc('\n', stderr);
+  va_end(args);
+}
+
+const char *
+esp_err_to_name(esp_err_t code)
+{
+  switch (code) {
+    case ESP_OK:                  return "ESP_OK";
+    case ESP_FAIL:                return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:          return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:     return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:   return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:    return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:       return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:   return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:         return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_HTTP_CONNECT:    return "ESP_ERR_HTTP_CONNECT";
+    default:                      return "UNKNOWN ERROR";
+  }
+}
+
+// ----- Virtual clock -----
+
+static std::atomic<int64_t> clock_us(0);
+
+int64_t
+esp_timer_get_time()
+{
+  return clock_us.fetch_add(1) + 1;
+}
+
+// ----- Heap capabilities -----
+
+static constexpr size_t DMA_ARENA_SIZE = 1 << 20;
+static size_t           dma_arena_used = 0;
+static std::mutex       dma_mutex;
+
+static inline bool
+in_dma_arena(void * ptr)
+{
+  uint8_t * p = (uint8_t *) ptr;
+  return (p >= sim_dma_arena()) && (p < (sim_dma_arena() + DMA_ARENA_SIZE));
+}
+
+void *
+heap_caps_malloc(size_t size, uint32_t caps)
+{
+  if (caps & MALLOC_CAP_DMA) {
+    std::lock_guard<std::mutex> lock(dma_mutex);
+    size_t start = (dma_arena_used + 15) & ~((size_t) 15);
+    if ((start + size) > DMA_ARENA_SIZE) return nullptr;
+    dma_arena_used = start + size;
+    return sim_dma_arena() + start;
+  }
+  return malloc(size);
+}
+
+void *
+heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+  void * ptr = heap_caps_malloc(n * size, caps);
+  if (ptr != nullptr) memset(ptr, 0, n * size);
+  return ptr;
+}
+
+void
+heap_caps_free(void * ptr)
+{
+  if (!in_dma_arena(ptr)) free(ptr);
+}
+
+size_t
+heap_caps_get_largest_free_block(uint32_t caps)
+{
+  return (caps & MALLOC_CAP_DMA) ? DMA_ARENA_SIZE - dma_arena_used : 4 * 1024 * 1024;
+}
+
+size_t
+heap_caps_get_free_size(uint32_t caps)
+{
+  return heap_caps_get_largest_free_block(caps);
+}
+
+size_t
+heap_caps_get_total_size(uint32_t caps)
+{
+  return (caps & MALLOC_CAP_DMA) ? DMA_ARENA_SIZE : 4 * 1024 * 1024;
+}
+
+// ----- Tasks -----
+
+struct SimTask {
+  std::string name;
+};
+
+struct SimTaskExit {};
+
+static thread_local SimTask * current_task = nullptr;
+static SimTask                main_task{ "main" };
+
+BaseType_t
+xTaskCreatePinnedToCore(TaskFunction_t func, const char * name, uint32_t stack_depth,
+                        void * param, UBaseType_t priority, TaskHandle_t * handle,
+                        BaseType_t core_id)
+{
+  SimTask * task = new SimTask{ name != nullptr ? name : "" };
+
+  if (handle != nullptr) *handle = task;
+
+  std::thread([func, param, task]() {
+    current_task = task;
+    try {
+      func(param);
+    }
+    catch (SimTaskExit &) {
+    }
+  }).detach();
+
+  return pdPASS;
+}
+
+void
+vTaskDelete(TaskHandle_t task)
+{
+  // Only self-deletion can be honored, a std::thread cannot be killed.
+  if ((task == nullptr) || (task == current_task)) throw SimTaskExit();
+}
+
+void
+vTaskDelay(TickType_t ticks)
+{
+  clock_us.fetch_add((int64_t) ticks * portTICK_PERIOD_MS * 1000);
+  std::this_thread::yield();
+}
+
+TickType_t
+xTaskGetTickCount()
+{
+  return (TickType_t) (clock_us.load() / (portTICK_PERIOD_MS * 1000));
+}
+
+char *
+pcTaskGetName(TaskHandle_t task)
+{
+  if (task == nullptr) task = (current_task != nullptr) ? current_task : &main_task;
+  return (char *) task->name.c_str();
+}
+
+UBaseType_t
+uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+  return 4096;
+}
+
+void
+taskYIELD()
+{
+  std::this_thread::yield();
+}
+
+// Waits on a condition variable for the given amount of ticks. As time is
+// virtual, a timeout is a real time wait of the same duration, after which
+// the virtual clock is advanced accordingly.
+
+template<typename Pred>
+static bool
+wait_ticks(std::unique_lock<std::mutex> & lock, std::condition_variable & cv, TickType_t ticks, Pred pred)
+{
+  if (ticks == portMAX_DELAY) {
+    cv.wait(lock, pred);
+    return true;
+  }
+  if (cv.wait_for(lock, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), pred)) return true;
+  clock_us.fetch_add((int64_t) ticks * portTICK_PERIOD_MS * 1000);
+  return false;
+}
+
+// ----- Semaphores -----
+
+struct SimSemaphore {
+  std::mutex              mutex;
+  std::condition_variable cv;
+  UBaseType_t             max_count;
+  UBaseType_t             count;
+};
+
+SemaphoreHandle_t
+xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+  SimSemaphore * sem = new SimSemaphore;
+  sem->max_count = max_count;
+  sem->count     = initial_count;
+  return sem;
+}
+
+BaseType_t
+xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+  std::unique_lock<std::mutex> lock(sem->mutex);
+  if (!wait_ticks(lock, sem->cv, ticks, [sem] { return sem->count > 0; })) return pdFALSE;
+  sem->count--;
+  return pdTRUE;
+}
+
+BaseType_t
+xSemaphoreGive(SemaphoreHandle_t sem)
+{
+  std::lock_guard<std::mutex> lock(sem->mutex);
+  if (sem->count >= sem->max_count) return pdFALSE;
+  sem->count++;
+  sem->cv.notify_one();
+  return pdTRUE;
+}
+
+void
+vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+  delete sem;
+}
+
+// ----- Event groups -----
+
+struct SimEventGroup {
+  std::mutex              mutex;
+  std::condition_variable cv;
+  EventBits_t             bits;
+};
+
+EventGroupHandle_t
+xEventGroupCreate()
+{
+  SimEventGroup * group = new SimEventGroup;
+  group->bits = 0;
+  return group;
+}
+
+void
+vEventGroupDelete(EventGroupHandle_t group)
+{
+  delete group;
+}
+
+EventBits_t
+xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+  std::lock_guard<std::mutex> lock(group->mutex);
+  group->bits |= bits;
+  group->cv.notify_all();
+  return group->bits;
+}
+
+EventBits_t
+xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+  std::lock_guard<std::mutex> lock(group->mutex);
+  EventBits_t before = group->bits;
+  group->bits &= ~bits;
+  return before;
+}
+
+EventBits_t
+xEventGroupGetBits(EventGroupHandle_t group)
+{
+  std::lock_guard<std::mutex> lock(group->mutex);
+  return group->bits;
+}
+
+EventBits_t
+xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                    BaseType_t wait_for_all, TickType_t ticks)
+{
+  std::unique_lock<std::mutex> lock(group->mutex);
+
+  auto satisfied = [group, bits, wait_for_all] {
+    return wait_for_all ? ((group->bits & bits) == bits) : ((group->bits & bits) != 0);
+  };
+
+  bool ok = wait_ticks(lock, group->cv, ticks, satisfied);
+
+  EventBits_t result = group->bits;
+  if (ok && clear_on_exit) group->bits &= ~bits;
+  return result;
+}
+
+// ----- GPIO configuration -----
+
+static int gpio_levels[GPIO_NUM_MAX];
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)    { return ESP_OK; }
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, gpio_pull_mode_t p)  { return ESP_OK; }
+esp_err_t gpio_config(const gpio_config_t * config)                    { return ESP_OK; }
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)               { return ESP_OK; }
+esp_err_t gpio_isr_handler_add(gpio_num_t n, gpio_isr_t h, void * a)   { return ESP_OK; }
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)                 { return ESP_OK; }
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num)                        { return ESP_OK; }
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num)                       { return ESP_OK; }
+
+esp_err_t
+gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+  if ((gpio_num < 0) || (gpio_num >= GPIO_NUM_MAX)) return ESP_ERR_INVALID_ARG;
+  gpio_levels[gpio_num] = level ? 1 : 0;
+  return ESP_OK;
+}
+
+int
+gpio_get_level(gpio_num_t gpio_num)
+{
+  if ((gpio_num < 0) || (gpio_num >= GPIO_NUM_MAX)) return 0;
+  return gpio_levels[gpio_num];
+}
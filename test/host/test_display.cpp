@@ -0,0 +1,360 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Pixel exact checks of the EInk driver update methods, through the
+// simulated panel.
+
+#include "graphics.hpp"
+#include "inkplate_platform.hpp"
+#include "wire.hpp"
+
+#include "sim_panel.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <unistd.h>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                           \
+    if (!(cond)) {                                      \
+      failures++;                                       \
+      printf("FAILED %s:%d: ", __FILE__, __LINE__);     \
+      printf(__VA_ARGS__);                              \
+      printf("\n");                                     \
+    }                                                   \
+  } while (0)
+
+// Every panel pixel must be fully black or fully white, as set in the 1 bit
+// frame buffer.
+
+static int
+compare_1bit(FrameBuffer1Bit & fb)
+{
+  SimPanel & panel = SimPanel::get_singleton();
+  int        diffs = 0;
+
+  for (int16_t y = 0; y < fb.get_height(); y++) {
+    const uint8_t * line = &fb.get_data()[y * fb.get_line_size()];
+    for (int16_t x = 0; x < fb.get_width(); x++) {
+      bool black = line[x >> 3] & (1 << (x & 7));
+      if (black ? !panel.is_black(x, y) : !panel.is_white(x, y)) {
+        if (diffs++ < 5) printf("  pixel [%d, %d]: expected %s, ink level %d\n",
+                                x, y, black ? "black" : "white", panel.ink(x, y));
+      }
+    }
+  }
+  return diffs;
+}
+
+static void
+draw_pattern(Graphics & graphics)
+{
+  int16_t w = graphics.width();
+  int16_t h = graphics.height();
+
+  graphics.fillRect(10, 10, w / 3, h / 4, BLACK);
+  graphics.drawRect(w / 2, 20, w / 4, h / 3, BLACK);
+  graphics.drawLine(0, h - 1, w - 1, 0, BLACK);
+  graphics.fillCircle(w / 2, h / 2, h / 6, BLACK);
+  graphics.fillTriangle(w - 50, h - 10, w - 10, h - 90, w - 90, h - 60, BLACK);
+
+  // Odd alignments, to exercise every position inside the bytes
+  for (int16_t i = 0; i < 64; i++) graphics.drawPixel(3 + i * 3, h - 20 - (i & 7), BLACK);
+
+  graphics.setTextColor(BLACK);
+  graphics.setCursor(20, h - 40);
+  graphics.setTextSize(2);
+  graphics.print("Host 0123456789");
+}
+
+static void
+test_update_1bit(Graphics & graphics, FrameBuffer1Bit & fb)
+{
+  SimPanel & panel = SimPanel::get_singleton();
+
+  panel.reset();
+  graphics.selectDisplayMode(DisplayMode::INKPLATE_1BIT);
+  graphics.clearDisplay();
+  draw_pattern(graphics);
+  graphics.display();
+
+  CHECK(panel.get_stats().frames > 0, "No frame sent to the panel");
+  int diffs = compare_1bit(fb);
+  CHECK(diffs == 0, "update(1bit): %d pixels differ", diffs);
+}
+
+static void
+test_partial_update(Graphics & graphics, FrameBuffer1Bit & fb)
+{
+  SimPanel & panel = SimPanel::get_singleton();
+
+  // Starting from the state left by test_update_1bit()
+
+  int16_t w = graphics.width();
+  int16_t h = graphics.height();
+
+  graphics.fillRect(10, 10, w / 6, h / 8, WHITE);        // Remove part of a black area
+  graphics.fillRect(w - 120, 30, 100, 40, BLACK);        // New black area
+  graphics.drawCircle(w / 4, h * 3 / 4, 30, BLACK);
+  graphics.partialUpdate();
+
+  int diffs = compare_1bit(fb);
+  CHECK(diffs == 0, "partial_update(): %d pixels differ", diffs);
+
+  // An unchanged frame buffer must not modify the panel
+
+  panel.reset_stats();
+  graphics.partialUpdate();
+  diffs = compare_1bit(fb);
+  CHECK(diffs == 0, "partial_update() without changes: %d pixels differ", diffs);
+  CHECK(panel.get_stats().frames == 0, "partial_update() without changes: panel driven");
+
+  // Only the area drawn through Graphics is compared: a byte changed
+  // directly in the frame buffer, outside of it, must not be sent.
+
+  uint8_t * byte = &fb.get_data()[fb.get_data_size() - 1];
+  uint8_t   old  = *byte;
+  *byte ^= 0xFF;
+  graphics.drawPixel(10, 10, BLACK);
+  graphics.partialUpdate();
+  *byte = old;
+  diffs = compare_1bit(fb);
+  CHECK(diffs == 0, "partial_update() outside of the drawn area: %d pixels differ", diffs);
+}
+
+// A region limited partial update must only refresh the given rectangle and
+// drive the rows that changed only. Checked in every rotation.
+
+static void
+test_partial_region(Graphics & graphics, FrameBuffer1Bit & fb)
+{
+  SimPanel & panel = SimPanel::get_singleton();
+
+  for (uint8_t rotation = 0; rotation < 4; rotation++) {
+    graphics.setRotation(rotation);
+
+    int16_t w = graphics.width();
+    int16_t h = graphics.height();
+
+    graphics.fillRect(0, 0, w, h, WHITE);
+    graphics.partialUpdate(true);
+
+    graphics.fillRect(13, 17, 37, 21, BLACK);            // In the region
+    graphics.fillRect(w - 40, h - 40, 20, 20, BLACK);    // Outside of it
+
+    panel.reset_stats();
+    graphics.partialUpdate(5, 10, 60, 40);
+
+    uint64_t full = (uint64_t) e_ink.get_height() * (e_ink.get_width() / 4);
+    CHECK(panel.get_stats().bytes_shifted < full, 
+          "partial_update(region), rotation %d: %llu bytes shifted", 
+          rotation, (unsigned long long) panel.get_stats().bytes_shifted);
+
+    // The panel must show the frame buffer, without the area outside of the region
+
+    std::vector<uint8_t> saved(fb.get_data(), fb.get_data() + fb.get_data_size());
+    graphics.fillRect(w - 40, h - 40, 20, 20, WHITE);
+    int diffs = compare_1bit(fb);
+    CHECK(diffs == 0, "partial_update(region), rotation %d: %d pixels differ", rotation, diffs);
+    memcpy(fb.get_data(), saved.data(), saved.size());
+
+    graphics.partialUpdate();
+    diffs = compare_1bit(fb);
+    CHECK(diffs == 0, "partial_update() after region, rotation %d: %d pixels differ", rotation, diffs);
+  }
+
+  graphics.setRotation(0);
+}
+
+// The panel state and the frame buffer saved before a deep sleep must allow
+// a partial update after waking up, instead of a full one.
+
+static void
+test_state(Graphics & graphics, FrameBuffer1Bit & fb)
+{
+  SimPanel & panel = SimPanel::get_singleton();
+
+  // Every test_display_* binary may run at the same time: a unique file
+
+  char file[] = P_tmpdir "/test_display_XXXXXX";
+  int  fd     = mkstemp(file);
+  if (fd >= 0) close(fd);
+
+  panel.reset_stats();
+  graphics.display();
+  uint64_t full_frames = panel.get_stats().frames;
+
+  std::vector<uint8_t> saved(fb.get_data(), fb.get_data() + fb.get_data_size());
+  std::vector<uint8_t> state(fb.get_data_size());
+  std::vector<uint8_t> picture(fb.get_data_size());
+
+  int32_t state_size   = e_ink.save_state(state.data(), state.size());
+  int32_t picture_size = graphics.saveRawToBuffer(picture.data(), picture.size());
+  CHECK((state_size > 0) && (state_size < (int32_t) fb.get_data_size() / 4), "save_state(): %d bytes", (int) state_size);
+  CHECK(picture_size == state_size, "saveRawToBuffer(): %d bytes", (int) picture_size);
+  CHECK(e_ink.save_state(state.data(), 64) == 0, "save_state() in a too small buffer");
+
+  FILE * f = fopen(file, "w");
+  CHECK(e_ink.save_state(f) && graphics.saveRawToFile(f), "save to file failed");
+
+  for (int from_file = 0; from_file < 2; from_file++) {
+
+    // Waking up: both images lost
+
+    memset(fb.get_data(), 0xAA, fb.get_data_size());
+    CHECK(!e_ink.restore_state(state.data(), state_size / 2), "truncated state accepted");
+
+    if (from_file) {
+      f = fopen(file, "r");
+      CHECK(e_ink.restore_state(f), "restore_state(file) failed");
+      CHECK(graphics.drawRawFromFile(f), "drawRawFromFile() failed");
+    }
+    else {
+      CHECK(e_ink.restore_state(state.data(), state_size), "restore_state() failed");
+      CHECK(graphics.drawRawFromBuffer(picture.data(), picture_size), "drawRawFromBuffer() failed");
+    }
+    CHECK(memcmp(fb.get_data(), saved.data(), saved.size()) == 0, "frame buffer not restored");
+
+    panel.reset_stats();
+    graphics.fillRect(30, 40, 50, 20, BLACK);
+    graphics.partialUpdate();
+    int diffs = compare_1bit(fb);
+    CHECK(diffs == 0, "partial_update() after restore: %d pixels differ", diffs);
+    CHECK(panel.get_stats().frames < full_frames, "partial_update() after restore: full update done");
+
+    // Back to the saved screen for the next round
+
+    graphics.drawRawFromBuffer(picture.data(), picture_size);
+    graphics.partialUpdate();
+  }
+  remove(file);
+}
+
+// In 3 bit mode, the gray levels are not fully defined by the simple ink model
+// of the simulated panel, but every pixel of a same level must end up with the
+// same ink level, level 0 being the darkest and level 7 white. Some waveforms
+// (6FLICK) do not push level 0 up to the saturation of the simulated ink.
+
+static void
+test_update_3bit(Graphics & graphics)
+{
+  SimPanel & panel = SimPanel::get_singleton();
+
+  panel.reset();
+  graphics.selectDisplayMode(DisplayMode::INKPLATE_3BIT);
+  graphics.clearDisplay();
+
+  int16_t w = graphics.width();
+  int16_t h = graphics.height();
+  int16_t band = w / 8;
+
+  for (int level = 0; level < 8; level++) {
+    graphics.fillRect(level * band, 0, band, h, level);
+  }
+  graphics.display();
+
+  for (int level = 0; level < 8; level++) {
+    uint8_t ink   = panel.ink(level * band, 0);
+    int     diffs = 0;
+    for (int16_t y = 0; y < h; y++) {
+      for (int16_t x = level * band; x < (level + 1) * band; x++) {
+        if (panel.ink(x, y) != ink) diffs++;
+      }
+    }
+    CHECK(diffs == 0, "update(3bit): gray level %d not uniform (%d pixels differ)", level, diffs);
+  }
+
+  for (int level = 1; level < 8; level++) {
+    CHECK(panel.ink(0, 0) >= panel.ink(level * band, 0), "update(3bit): level %d darker than level 0", level);
+  }
+  CHECK(panel.ink(0, 0) > 0,          "update(3bit): level 0 is white");
+  CHECK(panel.is_white(w - 1, h - 1), "update(3bit): level 7 is not white");
+
+  graphics.selectDisplayMode(DisplayMode::INKPLATE_1BIT);
+}
+
+// The precomputed phase images must put on the bus exactly the bytes computed
+// on the fly. The levels change at every pixel, so each byte sent carries four
+// different levels and any ordering mistake in the tables shows up.
+
+static void
+test_phase_tables_3bit(Graphics & graphics)
+{
+  SimPanel & panel = SimPanel::get_singleton();
+
+  graphics.selectDisplayMode(DisplayMode::INKPLATE_3BIT);
+
+  int16_t w = graphics.width();
+  int16_t h = graphics.height();
+
+  for (int16_t y = 0; y < h; y++) {
+    for (int16_t x = 0; x < w; x++) {
+      graphics.drawPixel(x, y, (x * 3 + y) & 7);
+    }
+  }
+
+  std::vector<uint8_t> computed, tables;
+
+  panel.reset();
+  panel.record(&computed);
+  graphics.display();
+  panel.record(nullptr);
+
+  CHECK(e_ink.set_phase_tables(true), "set_phase_tables(): allocation failed");
+
+  panel.reset();
+  panel.record(&tables);
+  graphics.display();
+  panel.record(nullptr);
+
+  e_ink.set_phase_tables(false);
+
+  size_t first = 0;
+  while ((first < computed.size()) && (first < tables.size()) && (computed[first] == tables[first])) first++;
+
+  CHECK(!computed.empty(), "update(3bit): no byte sent to the panel");
+  CHECK(computed.size() == tables.size(),
+        "update(3bit): %zu bytes sent with phase tables, %zu without", tables.size(), computed.size());
+  CHECK(first == computed.size(), "update(3bit): phase tables differ at bus byte %zu", first);
+
+  graphics.selectDisplayMode(DisplayMode::INKPLATE_1BIT);
+}
+
+int
+main()
+{
+  wire.setup();
+
+  if (!e_ink.setup()) {
+    printf("FAILED: e_ink.setup()\n");
+    return 1;
+  }
+
+  Graphics graphics(e_ink.get_width(), e_ink.get_height());
+  graphics.setDisplayMode(DisplayMode::INKPLATE_1BIT);
+  graphics.setRotation(0);
+
+  test_update_1bit(graphics, *graphics._partial);
+  test_partial_update(graphics, *graphics._partial);
+  test_partial_region(graphics, *graphics._partial);
+  test_state(graphics, *graphics._partial);
+  test_update_3bit(graphics);
+  test_phase_tables_3bit(graphics);
+
+  // Same checks with the precomputed phase images
+
+  CHECK(e_ink.set_phase_tables(true), "set_phase_tables(): allocation failed");
+
+  test_update_1bit(graphics, *graphics._partial);
+  test_partial_update(graphics, *graphics._partial);
+  test_update_3bit(graphics);
+
+  e_ink.set_phase_tables(false);
+
+  printf("%dx%d panel: %s\n", e_ink.get_width(), e_ink.get_height(), failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,327 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Checks of the Graphics drawing fast paths against the pixel by pixel
+// reference (drawPixel()), in every rotation and display mode.
+
+#include "graphics.hpp"
+#include "inkplate_platform.hpp"
+#include "wire.hpp"
+
+#ifndef PROGMEM
+  #define PROGMEM
+#endif
+#include "FreeSerif12pt7b.h"
+#include "FreeSerifBold24pt7b.h"
+#include "FreeSerif12ptGray2.h"     // Built by tools/fontconvert_gray
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                           \
+    if (!(cond)) {                                      \
+      failures++;                                       \
+      printf("FAILED %s:%d: ", __FILE__, __LINE__);     \
+      printf(__VA_ARGS__);                              \
+      printf("\n");                                     \
+    }                                                   \
+  } while (0)
+
+static FrameBuffer &
+frame_buffer(Graphics & graphics)
+{
+  if (graphics.getDisplayMode() == DisplayMode::INKPLATE_1BIT) return *graphics._partial;
+  return *graphics.DMemory4Bit;
+}
+
+static std::vector<uint8_t>
+snapshot(Graphics & graphics)
+{
+  FrameBuffer & fb = frame_buffer(graphics);
+  return std::vector<uint8_t>(fb.get_data(), fb.get_data() + fb.get_data_size());
+}
+
+static void
+reference_fill(Graphics & graphics, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  for (int16_t j = y; j < y + h; j++) {
+    for (int16_t i = x; i < x + w; i++) graphics.drawPixel(i, j, color);
+  }
+}
+
+static void
+test_fills(Graphics & graphics, DisplayMode mode, uint8_t rotation)
+{
+  graphics.selectDisplayMode(mode);
+  graphics.setRotation(rotation);
+
+  int16_t  w      = graphics.width();
+  int16_t  h      = graphics.height();
+  uint16_t colors = (mode == DisplayMode::INKPLATE_1BIT) ? 2 : 8;
+
+  srand(1234 + rotation);
+
+  for (int i = 0; i < 200; i++) {
+    int16_t  rx    = (rand() % (w + 40)) - 20;
+    int16_t  ry    = (rand() % (h + 40)) - 20;
+    int16_t  rw    = rand() % ((i & 1) ? 20 : w / 2);
+    int16_t  rh    = rand() % ((i & 2) ? 20 : h / 2);
+    uint16_t color = rand() % colors;
+
+    graphics.fillScreen(colors - 1 - color);
+    switch (i % 3) {
+      case 0: graphics.fillRect(rx, ry, rw, rh, color);      break;
+      case 1: graphics.drawFastHLine(rx, ry, rw, color); rh = 1; break;
+      case 2: graphics.drawFastVLine(rx, ry, rh, color); rw = 1; break;
+    }
+    std::vector<uint8_t> fast = snapshot(graphics);
+
+    graphics.fillScreen(colors - 1 - color);
+    reference_fill(graphics, rx, ry, rw, rh, color);
+
+    CHECK(fast == snapshot(graphics), "mode %d, rotation %d: [%d, %d, %d, %d] differs",
+          (int) mode, rotation, rx, ry, rw, rh);
+  }
+
+  graphics.fillScreen(colors - 1);
+  std::vector<uint8_t> filled = snapshot(graphics);
+  reference_fill(graphics, 0, 0, w, h, colors - 1);
+  CHECK(filled == snapshot(graphics), "mode %d: fillScreen() differs", (int) mode);
+}
+
+// Circles and bitmaps against the Adafruit_GFX pixel by pixel versions,
+// including shapes clipped by the screen edges.
+
+static void
+test_shapes(Graphics & graphics, DisplayMode mode, uint8_t rotation)
+{
+  graphics.selectDisplayMode(mode);
+  graphics.setRotation(rotation);
+
+  int16_t  w      = graphics.width();
+  int16_t  h      = graphics.height();
+  uint16_t colors = (mode == DisplayMode::INKPLATE_1BIT) ? 2 : 8;
+
+  uint8_t bitmap[5 * 37];
+  for (size_t i = 0; i < sizeof(bitmap); i++) bitmap[i] = (i * 73) ^ (i >> 2);
+
+  srand(4321 + rotation);
+
+  for (int i = 0; i < 120; i++) {
+    int16_t  x     = (rand() % (w + 80)) - 40;
+    int16_t  y     = (rand() % (h + 80)) - 40;
+    int16_t  r     = 1 + rand() % 60;
+    uint16_t color = rand() % colors;
+    uint16_t bg    = colors - 1 - color;
+    uint8_t  kind  = i % 6;
+
+    // Half of the screen of each color, for the bitmap background to show
+
+    Adafruit_GFX & gfx = graphics;
+    graphics.fillScreen(bg);
+    graphics.fillRect(0, 0, w / 2, h, color);
+    switch (kind) {
+      case 0: gfx.Adafruit_GFX::drawCircle(x, y, r, color);                       break;
+      case 1: gfx.Adafruit_GFX::drawCircleHelper(x, y, r, i & 0xF, color);        break;
+      case 2: gfx.Adafruit_GFX::drawRoundRect(x, y, r * 2, r + 20, r / 2, color); break;
+      case 3: gfx.Adafruit_GFX::drawBitmap(x, y, bitmap, 37, 37, color);          break;
+      case 4: gfx.Adafruit_GFX::drawBitmap(x, y, bitmap, 37, 37, color, bg);      break;
+      case 5: gfx.Adafruit_GFX::drawXBitmap(x, y, bitmap, 37, 37, color);         break;
+    }
+    std::vector<uint8_t> reference = snapshot(graphics);
+
+    graphics.fillScreen(bg);
+    graphics.fillRect(0, 0, w / 2, h, color);
+    switch (kind) {
+      case 0: graphics.drawCircle(x, y, r, color);                       break;
+      case 1: graphics.drawCircleHelper(x, y, r, i & 0xF, color);        break;
+      case 2: graphics.drawRoundRect(x, y, r * 2, r + 20, r / 2, color); break;
+      case 3: graphics.drawBitmap(x, y, bitmap, 37, 37, color);          break;
+      case 4: graphics.drawBitmap(x, y, bitmap, 37, 37, color, bg);      break;
+      case 5: graphics.drawXBitmap(x, y, bitmap, 37, 37, color);         break;
+    }
+    CHECK(snapshot(graphics) == reference, "mode %d, rotation %d: shape %d at [%d, %d], r %d differs",
+          (int) mode, rotation, kind, x, y, r);
+  }
+}
+
+// The glyph blitter against the Adafruit_GFX pixel by pixel drawChar(),
+// including glyphs clipped by the screen edges.
+
+static void
+test_glyphs(Graphics & graphics, DisplayMode mode, uint8_t rotation, const GFXfont * font, uint8_t size = 1)
+{
+  graphics.selectDisplayMode(mode);
+  graphics.setRotation(rotation);
+  graphics.setFont(font);
+
+  int16_t  w      = graphics.width();
+  int16_t  h      = graphics.height();
+  uint16_t colors = (mode == DisplayMode::INKPLATE_1BIT) ? 2 : 8;
+
+  srand(4321 + rotation);
+
+  for (int pass = 0; pass < 2; pass++) {
+    uint16_t background = pass ? colors - 1 : 0;
+
+    graphics.fillScreen(background);
+    srand(99 + rotation);
+    for (int i = 0; i < 400; i++) {
+      int16_t  x     = (rand() % (w + 60)) - 30;
+      int16_t  y     = (rand() % (h + 60)) - 30;
+      uint16_t color = rand() % colors;
+      graphics.drawChar(x, y, ' ' + 1 + (i % 94), color, color, size, size);
+    }
+    std::vector<uint8_t> fast = snapshot(graphics);
+
+    graphics.fillScreen(background);
+    srand(99 + rotation);
+    for (int i = 0; i < 400; i++) {
+      int16_t  x     = (rand() % (w + 60)) - 30;
+      int16_t  y     = (rand() % (h + 60)) - 30;
+      uint16_t color = rand() % colors;
+      graphics.Adafruit_GFX::drawChar(x, y, ' ' + 1 + (i % 94), color, color, size, size);
+    }
+
+    CHECK(fast == snapshot(graphics), "mode %d, rotation %d, size %d, pass %d: glyphs differ", 
+          (int) mode, rotation, size, pass);
+  }
+
+  graphics.setFont(nullptr);
+}
+
+// Anti-aliased glyphs against a pixel by pixel composition done in user
+// coordinates. In the 1 bit mode, the coverage is thresholded.
+
+static void
+test_gray_glyphs(Graphics & graphics, DisplayMode mode, uint8_t rotation, const GFXfontGray * font, uint8_t size = 1)
+{
+  graphics.selectDisplayMode(mode);
+  graphics.setRotation(rotation);
+  graphics.setGrayFont(font);
+
+  int16_t  w      = graphics.width();
+  int16_t  h      = graphics.height();
+  uint16_t colors = (mode == DisplayMode::INKPLATE_1BIT) ? 2 : 8;
+  int      full   = (1 << font->bpp) - 1;
+
+  for (int pass = 0; pass < 2; pass++) {
+    uint16_t background = pass ? colors - 1 : 0;
+
+    graphics.fillScreen(background);
+    srand(77 + rotation);
+    for (int i = 0; i < 300; i++) {
+      int16_t  x     = (rand() % (w + 60)) - 30;
+      int16_t  y     = (rand() % (h + 60)) - 30;
+      uint16_t color = rand() % colors;
+      graphics.drawChar(x, y, ' ' + 1 + (i % 94), color, color, size, size);
+    }
+    std::vector<uint8_t> fast = snapshot(graphics);
+
+    std::vector<uint8_t> levels(w * h, background);
+    bool                 partial = false;
+
+    srand(77 + rotation);
+    for (int i = 0; i < 300; i++) {
+      int16_t  x     = (rand() % (w + 60)) - 30;
+      int16_t  y     = (rand() % (h + 60)) - 30;
+      uint16_t color = rand() % colors;
+
+      const GFXglyph * g      = &font->font.glyph[' ' + 1 + (i % 94) - font->font.first];
+      const uint8_t  * bitmap = &font->font.bitmap[g->bitmapOffset];
+
+      for (int yy = 0; yy < g->height * size; yy++) {
+        for (int xx = 0; xx < g->width * size; xx++) {
+          int px = x + g->xOffset * size + xx;
+          int py = y + g->yOffset * size + yy;
+          if ((px < 0) || (py < 0) || (px >= w) || (py >= h)) continue;
+
+          int cov = 0;
+          for (int k = 0; k < font->bpp; k++) {
+            uint32_t bit = ((yy / size) * g->width + (xx / size)) * font->bpp + k;
+            cov = (cov << 1) | ((bitmap[bit >> 3] >> (7 - (bit & 7))) & 1);
+          }
+          if (cov == 0) continue;
+
+          uint8_t & level = levels[py * w + px];
+          if (mode == DisplayMode::INKPLATE_1BIT) {
+            if (cov > (full >> 1)) level = color;
+          }
+          else {
+            level = (level * (full - cov) + color * cov + (full >> 1)) / full;
+            if ((cov < full) && (level != color) && (level != background)) partial = true;
+          }
+        }
+      }
+    }
+
+    for (int16_t j = 0; j < h; j++) {
+      for (int16_t i = 0; i < w; i++) graphics.drawPixel(i, j, levels[j * w + i]);
+    }
+
+    CHECK(fast == snapshot(graphics), "gray font, mode %d, rotation %d, size %d, pass %d: glyphs differ",
+          (int) mode, rotation, size, pass);
+    if (mode == DisplayMode::INKPLATE_3BIT) {
+      CHECK(partial, "gray font, rotation %d: no intermediate level", rotation);
+    }
+  }
+
+  graphics.setGrayFont(nullptr);
+}
+
+int
+main()
+{
+  wire.setup();
+
+  Graphics graphics(e_ink.get_width(), e_ink.get_height());
+  graphics.setDisplayMode(DisplayMode::INKPLATE_1BIT);
+
+  for (uint8_t rotation = 0; rotation < 4; rotation++) {
+    test_fills(graphics, DisplayMode::INKPLATE_1BIT, rotation);
+    test_fills(graphics, DisplayMode::INKPLATE_3BIT, rotation);
+    test_shapes(graphics, DisplayMode::INKPLATE_1BIT, rotation);
+    test_shapes(graphics, DisplayMode::INKPLATE_3BIT, rotation);
+    test_glyphs(graphics, DisplayMode::INKPLATE_1BIT, rotation, &FreeSerif12pt7b);
+    test_glyphs(graphics, DisplayMode::INKPLATE_3BIT, rotation, &FreeSerif12pt7b);
+    test_glyphs(graphics, DisplayMode::INKPLATE_1BIT, rotation, &FreeSerifBold24pt7b);
+  }
+
+  // Same checks through the glyph cache, small enough to go through evictions
+
+  CHECK(graphics.setGlyphCache(16 * 1024), "setGlyphCache(): allocation failed");
+
+  for (uint8_t rotation = 0; rotation < 4; rotation++) {
+    test_glyphs(graphics, DisplayMode::INKPLATE_1BIT, rotation, &FreeSerif12pt7b);
+    test_glyphs(graphics, DisplayMode::INKPLATE_3BIT, rotation, &FreeSerif12pt7b);
+    test_glyphs(graphics, DisplayMode::INKPLATE_1BIT, rotation, &FreeSerif12pt7b, 2);
+    test_glyphs(graphics, DisplayMode::INKPLATE_1BIT, rotation, &FreeSerifBold24pt7b);
+
+    // Narrow glyphs over 255 pixels high
+    test_glyphs(graphics, DisplayMode::INKPLATE_1BIT, rotation, &FreeSerifBold24pt7b, 8);
+  }
+
+  // Anti-aliased font, with the glyph cache still enabled: it must be bypassed
+
+  for (uint8_t rotation = 0; rotation < 4; rotation++) {
+    test_gray_glyphs(graphics, DisplayMode::INKPLATE_3BIT, rotation, &FreeSerif12ptGray2);
+    test_gray_glyphs(graphics, DisplayMode::INKPLATE_3BIT, rotation, &FreeSerif12ptGray2, 2);
+    test_gray_glyphs(graphics, DisplayMode::INKPLATE_1BIT, rotation, &FreeSerif12ptGray2);
+  }
+
+  GlyphCache::Stats stats = graphics.getGlyphCacheStats();
+  CHECK(stats.hits > 0,                 "glyph cache: no hit");
+  CHECK(stats.evictions > 0,            "glyph cache: no eviction");
+  CHECK(stats.bytes <= stats.max_bytes, "glyph cache: %u bytes over the %u limit",
+        (unsigned) stats.bytes, (unsigned) stats.max_bytes);
+
+  graphics.setGlyphCache(0);
+
+  printf("Graphics %dx%d: %s\n", e_ink.get_width(), e_ink.get_height(), failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
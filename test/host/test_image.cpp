@@ -0,0 +1,1096 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// Image decoders checks. The pictures are built by the test itself and drawn
+// through every input path (memory buffer, file, web); all paths must give
+// the same frame buffer content.
+
+#include "graphics.hpp"
+#include "inkplate_platform.hpp"
+#include "network_client.hpp"
+#include "wire.hpp"
+
+#include "jpeg_writer.hpp"
+#include "pictures.hpp"
+#include "png_writer.hpp"
+#include "bmp_writer.hpp"
+#include "raw_image.hpp"
+#include "sim_network.hpp"
+#include "tjpg_decoder.hpp"
+
+#include "freertos/semphr.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <unistd.h>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                           \
+    if (!(cond)) {                                      \
+      failures++;                                       \
+      printf("FAILED %s:%d: ", __FILE__, __LINE__);     \
+      printf(__VA_ARGS__);                              \
+      printf("\n");                                     \
+    }                                                   \
+  } while (0)
+
+static FrameBuffer &
+frame_buffer(Graphics & graphics)
+{
+  if (graphics.getDisplayMode() == DisplayMode::INKPLATE_1BIT) return *graphics._partial;
+  return *graphics.DMemory4Bit;
+}
+
+static std::vector<uint8_t>
+snapshot(Graphics & graphics)
+{
+  FrameBuffer & fb = frame_buffer(graphics);
+  return std::vector<uint8_t>(fb.get_data(), fb.get_data() + fb.get_data_size());
+}
+
+static std::vector<uint8_t>
+jpeg_picture(int w, int h, JpegWriter::Sampling sampling = JpegWriter::Sampling::YUV420)
+{
+  static std::map<std::tuple<int, int, JpegWriter::Sampling>, std::vector<uint8_t>> pictures;
+
+  auto key = std::make_tuple(w, h, sampling);
+  if (pictures.find(key) == pictures.end()) {
+    std::vector<uint8_t> rgb = picture(w, h);
+    pictures[key] = JpegWriter::encode(rgb.data(), w, h, 85, sampling);
+  }
+  return pictures[key];
+}
+
+static FILE *
+temp_file(const std::vector<uint8_t> & data)
+{
+  FILE * f = tmpfile();
+  fwrite(data.data(), 1, data.size(), f);
+  rewind(f);
+  return f;
+}
+
+// Every test_image_* binary may run at the same time: files opened by name
+// are given a unique name, keeping the extension telling their format.
+
+static std::string
+temp_name(const char * suffix)
+{
+  std::string name = std::string(P_tmpdir "/test_image_XXXXXX") + suffix;
+  int         fd   = mkstemps(&name[0], strlen(suffix));
+  if (fd >= 0) close(fd);
+  return name;
+}
+
+static std::string
+temp_name(const std::vector<uint8_t> & data, const char * suffix)
+{
+  std::string name = temp_name(suffix);
+  FILE *      f    = fopen(name.c_str(), "wb");
+  fwrite(data.data(), 1, data.size(), f);
+  fclose(f);
+  return name;
+}
+
+static void
+test_jpeg_sources(Graphics & graphics, DisplayMode mode, JpegWriter::Sampling sampling)
+{
+  graphics.selectDisplayMode(mode);
+  graphics.setRotation(0);
+
+  int16_t pw = 600, ph = 400;
+  std::vector<uint8_t> jpeg = jpeg_picture(pw, ph, sampling);
+  const char *         url  = "http://server/photo.jpg";
+
+  SimNetwork::serve(url, jpeg);
+
+  for (int dither = 0; dither < 2; dither++) {
+    graphics.fillScreen(0);
+    CHECK(graphics.drawJpegFromBuffer(jpeg.data(), jpeg.size(), 37, 21, dither, false), "drawJpegFromBuffer() failed");
+    std::vector<uint8_t> reference = snapshot(graphics);
+    CHECK(reference != std::vector<uint8_t>(reference.size(), 0), "mode %d: nothing drawn", (int) mode);
+
+    graphics.fillScreen(0);
+    CHECK(graphics.drawJpegFromFile(temp_file(jpeg), 37, 21, dither, false), "drawJpegFromFile() failed");
+    CHECK(snapshot(graphics) == reference, "mode %d, dither %d: file and buffer decoding differ", (int) mode, dither);
+
+    SimNetwork::reset_stats();
+    graphics.fillScreen(0);
+    CHECK(graphics.drawJpegFromWeb(url, 37, 21, dither, false), "drawJpegFromWeb() failed");
+    CHECK(snapshot(graphics) == reference, "mode %d, dither %d: web and file decoding differ", (int) mode, dither);
+    CHECK(SimNetwork::get_stats().http_requests == 1,          "web: %u requests", SimNetwork::get_stats().http_requests);
+    CHECK(SimNetwork::get_stats().http_bytes <= jpeg.size(),   "web: more bytes than the file size");
+  }
+
+  // Positioned from the size found in the streamed header
+
+  graphics.fillScreen(0);
+  graphics.drawJpegFromBuffer(jpeg.data(), jpeg.size(), (graphics.width() - pw) >> 1, (graphics.height() - ph) >> 1, false, false);
+  std::vector<uint8_t> centered = snapshot(graphics);
+
+  graphics.fillScreen(0);
+  CHECK(graphics.drawImage(url, Image::JPG, Image::Center, false, false), "drawImage(Center) failed");
+  CHECK(snapshot(graphics) == centered, "mode %d: centered web picture misplaced", (int) mode);
+
+  // Truncated data must fail cleanly
+
+  std::vector<uint8_t> truncated(jpeg.begin(), jpeg.begin() + jpeg.size() / 2);
+  SimNetwork::serve(url, truncated);
+  CHECK(!graphics.drawJpegFromWeb(url, 0, 0, false, false),                "truncated web picture accepted");
+  CHECK(!graphics.drawJpegFromFile(temp_file(truncated), 0, 0, false, false), "truncated file accepted");
+
+  SimNetwork::unserve(url);
+  CHECK(!graphics.drawJpegFromWeb(url, 0, 0, false, false), "missing web picture accepted");
+}
+
+// The block converter against a pixel by pixel conversion, in all rotations
+// and with clipping.
+
+static Graphics * reference_graphics;
+
+static bool
+reference_chunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t * bitmap, bool dither, bool invert)
+{
+  for (int j = 0; j < h; j++) {
+    for (int i = 0; i < w; i++) {
+      uint8_t val = bitmap[j * w + i] >> 5;
+      if (invert) val = 7 - val;
+      if (reference_graphics->getDisplayMode() == DisplayMode::INKPLATE_1BIT) val = (~val >> 2) & 1;
+      reference_graphics->drawPixel(x + i, y + j, val);
+    }
+  }
+  return true;
+}
+
+static void
+test_jpeg_blocks(Graphics & graphics, DisplayMode mode, uint8_t rotation)
+{
+  graphics.selectDisplayMode(mode);
+  graphics.setRotation(rotation);
+  reference_graphics = &graphics;
+
+  std::vector<uint8_t> jpeg = jpeg_picture(600, 400);
+
+  int16_t positions[3][2] = { { 37, 21 }, { -45, -13 }, { (int16_t)(graphics.width() - 301), (int16_t)(graphics.height() - 203) } };
+
+  for (auto & pos : positions) {
+    for (int invert = 0; invert < 2; invert++) {
+      graphics.fillScreen(0);
+      TJpgDec.setJpgScale(1);
+      TJpgDec.setGrayCallback(reference_chunk);
+      TJpgDec.drawJpg(pos[0], pos[1], jpeg.data(), jpeg.size(), false, invert);
+      std::vector<uint8_t> reference = snapshot(graphics);
+
+      graphics.fillScreen(0);
+      CHECK(graphics.drawJpegFromBuffer(jpeg.data(), jpeg.size(), pos[0], pos[1], false, invert), "drawJpegFromBuffer() failed");
+      CHECK(snapshot(graphics) == reference, "mode %d, rotation %d, at [%d, %d], invert %d: blocks differ",
+            (int) mode, rotation, pos[0], pos[1], invert);
+    }
+  }
+
+  graphics.setRotation(0);
+}
+
+// drawImageToFit() against a box filter of the picture decoded by tjpgd at
+// the expected scale.
+
+static std::vector<uint8_t> decoded;
+static int                  decoded_w;
+
+static bool
+capture(int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t * bitmap, bool dither, bool invert)
+{
+  for (int j = 0; j < h; j++) {
+    for (int i = 0; i < w; i++) decoded[(y + j) * decoded_w + x + i] = bitmap[j * w + i];
+  }
+  return true;
+}
+
+static bool
+capture_rgb(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t * bitmap, bool dither, bool invert)
+{
+  for (int j = 0; j < h; j++) {
+    for (int i = 0; i < w; i++) {
+      uint16_t rgb = bitmap[j * w + i];
+      decoded[(y + j) * decoded_w + x + i] = (77 * Image::red(rgb) + 150 * Image::green(rgb) + 29 * Image::blue(rgb)) >> 8;
+    }
+  }
+  return true;
+}
+
+static std::vector<uint8_t>
+decode(const std::vector<uint8_t> & jpeg, int w, int h, int scale, bool gray)
+{
+  decoded.assign((w >> scale) * (h >> scale), 0);
+  decoded_w = w >> scale;
+  if (gray) TJpgDec.setGrayCallback(capture);
+  else      TJpgDec.setCallback(capture_rgb);
+  TJpgDec.setJpgScale(1 << scale);
+  CHECK(TJpgDec.drawJpg(0, 0, jpeg.data(), jpeg.size(), false, false) == JDR_OK, "tjpgd scale %d failed", scale);
+  TJpgDec.setJpgScale(1);
+  return decoded;
+}
+
+// The luminance only decoding against the luminance (JPEG Y, ITU-R BT.601
+// weights) of the RGB565 decoding, at all scales. A Y only picture gives the
+// same gray levels as a colour one.
+
+static void
+test_jpeg_gray(JpegWriter::Sampling sampling)
+{
+  int w = 333, h = 251;
+  std::vector<uint8_t> jpeg = jpeg_picture(w, h, sampling);
+  std::vector<uint8_t> gray_jpeg = jpeg_picture(w, h, JpegWriter::Sampling::GRAY);
+
+  for (int scale = 0; scale < 4; scale++) {
+    std::vector<uint8_t> gray = decode(jpeg, w, h, scale, true);
+    std::vector<uint8_t> rgb  = decode(jpeg, w, h, scale, false);
+
+    // Apart from the RGB clipping of saturated colours, the luminance is the same
+
+    size_t far = 0;
+    for (size_t i = 0; i < gray.size(); i++) far += std::abs(gray[i] - rgb[i]) > 6;
+    CHECK(far * 100 <= gray.size(), "sampling %d, scale %d: %zu gray pixels far from the RGB luminance", (int) sampling, scale, far);
+
+    std::vector<uint8_t> y_only = decode(gray_jpeg, w, h, scale, true);
+    if (sampling == JpegWriter::Sampling::YUV444) {
+      CHECK(y_only == gray, "scale %d: Y only picture and colour picture luminance differ", scale);
+    }
+
+    // Through RGB565, a Y only picture only loses the low bits
+
+    std::vector<uint8_t> y_rgb = decode(gray_jpeg, w, h, scale, false);
+    int worst = 0;
+    for (size_t i = 0; i < y_only.size(); i++) worst = std::max(worst, std::abs(y_only[i] - y_rgb[i]));
+    CHECK(worst <= 6, "scale %d: Y only picture through RGB differs by %d", scale, worst);
+  }
+}
+
+static void
+test_jpeg_fit(Graphics & graphics, DisplayMode mode, int pw, int ph, int bx, int by, int bw, int bh, int scale)
+{
+  graphics.selectDisplayMode(mode);
+  graphics.setRotation(0);
+
+  std::vector<uint8_t> jpeg = jpeg_picture(pw, ph);
+  std::string          file = temp_name(jpeg, ".jpg");
+
+  int box_w = bw ? bw : graphics.width()  - bx;
+  int box_h = bh ? bh : graphics.height() - by;
+
+  // Expected output size and position
+
+  int tw, th;
+  if (pw * box_h <= ph * box_w) { th = std::min(ph, box_h); tw = std::max(1, pw * th / ph); }
+  else                          { tw = std::min(pw, box_w); th = std::max(1, ph * tw / pw); }
+  int ox = bx + ((box_w - tw) >> 1);
+  int oy = by + ((box_h - th) >> 1);
+
+  int sw = pw >> scale, sh = ph >> scale;
+  decode(jpeg, pw, ph, scale, true);
+
+  std::vector<uint32_t> sums(tw * th, 0), counts(tw * th, 0);
+  for (int y = 0; y < sh; y++) {
+    for (int x = 0; x < sw; x++) {
+      int k = (y * th / sh) * tw + (x * tw / sw);
+      sums[k] += decoded[y * sw + x];
+      counts[k]++;
+    }
+  }
+
+  graphics.fillScreen(0);
+  for (int y = 0; y < th; y++) {
+    for (int x = 0; x < tw; x++) {
+      int     k   = y * tw + x;
+      uint8_t val = ((sums[k] + (counts[k] >> 1)) / counts[k]) >> 5;
+      if (mode == DisplayMode::INKPLATE_1BIT) val = (~val >> 2) & 1;
+      graphics.drawPixel(ox + x, oy + y, val);
+    }
+  }
+  std::vector<uint8_t> reference = snapshot(graphics);
+
+  graphics.fillScreen(0);
+  CHECK(graphics.drawImageToFit(file.c_str(), bx, by, bw, bh, false, false), "drawImageToFit() failed");
+  CHECK(snapshot(graphics) == reference, "mode %d, %dx%d in %dx%d: fitted picture differs",
+        (int) mode, pw, ph, box_w, box_h);
+
+  const char * url = "http://server/big.jpg";
+  SimNetwork::serve(url, jpeg);
+  graphics.fillScreen(0);
+  CHECK(graphics.drawImageToFit(url, bx, by, bw, bh, false, false), "drawImageToFit(url) failed");
+  CHECK(snapshot(graphics) == reference, "mode %d, %dx%d in %dx%d: fitted web picture differs",
+        (int) mode, pw, ph, box_w, box_h);
+  SimNetwork::unserve(url);
+
+  // Dithering stays in the box
+
+  graphics.fillScreen(0);
+  CHECK(graphics.drawImageToFit(file.c_str(), bx, by, bw, bh, true, false), "drawImageToFit(dither) failed");
+  std::vector<uint8_t> dithered = snapshot(graphics);
+  graphics.fillRect(ox, oy, tw, th, 0);
+  CHECK(snapshot(graphics) == std::vector<uint8_t>(dithered.size(), 0), "dithered picture out of its box");
+  CHECK(dithered != snapshot(graphics), "dithered picture not drawn");
+
+  remove(file.c_str());
+}
+
+// PNG pictures of every color type, with the expected RGBA value of each pixel
+
+struct PngPicture {
+  const char *         name;
+  std::vector<uint8_t> png;
+  std::vector<uint8_t> rgba;
+};
+
+static PngPicture
+png_picture(const char * name, int w, int h, uint8_t color_type, uint8_t depth, bool opaque = false,
+            bool interlaced = false)
+{
+  std::vector<uint8_t>  rgb = picture(w, h);
+  std::vector<uint16_t> samples;
+  std::vector<uint8_t>  palette, trns, rgba;
+
+  uint16_t maxval = (1 << depth) - 1;
+
+  if (color_type == 3) {
+    for (int i = 0; i <= maxval; i++) {      // Entries of increasing luminance
+      int v = i * 255 / maxval;
+      palette.insert(palette.end(), { (uint8_t) v, (uint8_t)(255 - v / 2), (uint8_t)(v / 3) });
+    }
+    if (!opaque) {
+      trns = { 0, 0 };                       // Entries 0 and 1 transparent
+      palette[0] = palette[1] = palette[2] = 255;
+    }
+  }
+  if ((color_type == 0) && (depth == 8)) trns = { 0, 128 };
+
+  for (int i = 0; i < w * h; i++) {
+    uint8_t r = rgb[i * 3], g = rgb[i * 3 + 1], b = rgb[i * 3 + 2];
+    uint8_t gray  = (r + g + b) / 3;
+    uint8_t alpha = ((i % w) / 7 + (i / w) / 5) % 4 ? 64 + (i % 192) : 0;
+
+    switch (color_type) {
+      case 0:
+        if (depth == 16) {
+          uint16_t v = gray * 257 + (i & 0xFF);
+          samples.push_back(v);
+          uint8_t e = (v * 255 + 32767) / 65535;
+          rgba.insert(rgba.end(), { e, e, e, 255 });
+        }
+        else {
+          uint16_t v = gray >> (8 - depth);
+          uint8_t  e = (v * 255 + maxval / 2) / maxval;
+          samples.push_back(v);
+          rgba.insert(rgba.end(), { e, e, e, (uint8_t)((trns.size() && v == 128) ? 0 : 255) });
+        }
+        break;
+      case 2:
+        samples.insert(samples.end(), { r, g, b });
+        rgba.insert(rgba.end(), { r, g, b, 255 });
+        break;
+      case 3: {
+        uint16_t v = gray >> (8 - depth);
+        samples.push_back(v);
+        rgba.insert(rgba.end(), { palette[v * 3], palette[v * 3 + 1], palette[v * 3 + 2], (uint8_t)((v < 2 && trns.size()) ? 0 : 255) });
+        break;
+      }
+      case 4:
+        samples.insert(samples.end(), { gray, alpha });
+        rgba.insert(rgba.end(), { gray, gray, gray, alpha });
+        break;
+      case 6:
+        if (!alpha) r = g = b = 255;
+        samples.insert(samples.end(), { r, g, b, alpha });
+        rgba.insert(rgba.end(), { r, g, b, alpha });
+        break;
+    }
+  }
+
+  return { name, PngWriter::encode(samples, w, h, color_type, depth, palette, trns, interlaced), rgba };
+}
+
+// Frame buffer after drawing the expected pixels of a picture pixel by pixel
+
+static std::vector<uint8_t>
+picture_reference(Graphics & graphics, const std::vector<uint8_t> & rgba, int pw, int ph, int16_t px, int16_t py,
+                  bool invert, uint8_t background)
+{
+  graphics.fillScreen(background);
+  for (int y = 0; y < ph; y++) {
+    for (int x = 0; x < pw; x++) {
+      const uint8_t * p = &rgba[(y * pw + x) * 4];
+      if (!p[3]) continue;
+      uint8_t val = Image::rgb3Bit(p[0], p[1], p[2]);
+      if (invert) val = 7 - val;
+      if (graphics.getDisplayMode() == DisplayMode::INKPLATE_1BIT) val = (~val >> 2) & 1;
+      graphics.drawPixel(px + x, py + y, val);
+    }
+  }
+  return snapshot(graphics);
+}
+
+// The row decoder against the pixel by pixel drawing of the picture, from a
+// file and streamed from the web, with clipping.
+
+static void
+test_png_sources(Graphics & graphics, DisplayMode mode)
+{
+  graphics.selectDisplayMode(mode);
+  graphics.setRotation(0);
+
+  int pw = 300, ph = 200;
+  uint8_t background = (mode == DisplayMode::INKPLATE_1BIT) ? 1 : 0;
+  const char * url = "http://server/chart.png";
+
+  static const struct { const char * name; uint8_t color_type, depth; } formats[] = {
+    { "rgb",       2,  8 }, { "rgba",     6, 8 }, { "gray",     0, 8 }, { "gray 16",  0, 16 },
+    { "gray 4",    0,  4 }, { "gray 2",   0, 2 }, { "gray 1",   0, 1 }, { "gray+a",   4, 8 },
+    { "palette 8", 3,  8 }, { "palette 4", 3, 4 }, { "palette 1", 3, 1 },
+  };
+
+  int16_t positions[3][2] = { { 37, 21 }, { -45, -13 }, { (int16_t)(graphics.width() - 201), (int16_t)(graphics.height() - 103) } };
+
+  for (auto & format : formats) {
+    PngPicture pic = png_picture(format.name, pw, ph, format.color_type, format.depth);
+    SimNetwork::serve(url, pic.png);
+
+    for (auto & pos : positions) {
+      for (int invert = 0; invert < 2; invert++) {
+        std::vector<uint8_t> reference = picture_reference(graphics, pic.rgba, pw, ph, pos[0], pos[1], invert, background);
+
+        graphics.fillScreen(background);
+        CHECK(graphics.drawPngFromFile(temp_file(pic.png), pos[0], pos[1], false, invert), "%s: drawPngFromFile() failed", pic.name);
+        CHECK(snapshot(graphics) == reference, "mode %d, %s at [%d, %d], invert %d: file picture differs",
+              (int) mode, pic.name, pos[0], pos[1], invert);
+
+        SimNetwork::reset_stats();
+        graphics.fillScreen(background);
+        CHECK(graphics.drawPngFromWeb(url, pos[0], pos[1], false, invert), "%s: drawPngFromWeb() failed", pic.name);
+        CHECK(snapshot(graphics) == reference, "mode %d, %s at [%d, %d], invert %d: web picture differs",
+              (int) mode, pic.name, pos[0], pos[1], invert);
+        CHECK(SimNetwork::get_stats().http_requests == 1,           "web: %u requests", SimNetwork::get_stats().http_requests);
+        CHECK(SimNetwork::get_stats().http_bytes <= pic.png.size(), "web: more bytes than the file size");
+      }
+    }
+  }
+
+  // Interlaced pictures, drawn a block at a time by drawPngBlock(). They are
+  // opaque: the last pass leaves every pixel as in the reference.
+
+  static const struct { const char * name; uint8_t color_type, depth; } interlaced[] = {
+    { "interlaced rgb", 2, 8 }, { "interlaced palette 4", 3, 4 },
+  };
+
+  for (auto & format : interlaced) {
+    PngPicture pic = png_picture(format.name, pw - 3, ph - 5, format.color_type, format.depth, true, true);
+
+    for (auto & pos : positions) {
+      std::vector<uint8_t> reference = picture_reference(graphics, pic.rgba, pw - 3, ph - 5, pos[0], pos[1], false, background);
+
+      graphics.fillScreen(background);
+      CHECK(graphics.drawPngFromFile(temp_file(pic.png), pos[0], pos[1], false, false), "%s: drawPngFromFile() failed", pic.name);
+      CHECK(snapshot(graphics) == reference, "mode %d, %s at [%d, %d]: picture differs", (int) mode, pic.name, pos[0], pos[1]);
+    }
+  }
+
+  // Dithering: same result from both sources, and only in the picture box
+
+  PngPicture pic = png_picture("rgb", pw, ph, 2, 8);
+  SimNetwork::serve(url, pic.png);
+
+  graphics.fillScreen(0);
+  CHECK(graphics.drawPngFromFile(temp_file(pic.png), 37, 21, true, false), "drawPngFromFile(dither) failed");
+  std::vector<uint8_t> dithered = snapshot(graphics);
+
+  graphics.fillScreen(0);
+  CHECK(graphics.drawPngFromWeb(url, 37, 21, true, false), "drawPngFromWeb(dither) failed");
+  CHECK(snapshot(graphics) == dithered, "mode %d: dithered web and file pictures differ", (int) mode);
+
+  graphics.fillRect(37, 21, pw, ph, 0);
+  CHECK(snapshot(graphics) == std::vector<uint8_t>(dithered.size(), 0), "dithered picture out of its box");
+
+  // Truncated or corrupted data must fail cleanly
+
+  std::vector<uint8_t> truncated(pic.png.begin(), pic.png.begin() + pic.png.size() / 2);
+  SimNetwork::serve(url, truncated);
+  CHECK(!graphics.drawPngFromWeb(url, 0, 0, false, false),                "truncated web picture accepted");
+  CHECK(!graphics.drawPngFromFile(temp_file(truncated), 0, 0, false, false), "truncated file accepted");
+
+  std::vector<uint8_t> corrupted = pic.png;
+  corrupted[corrupted.size() / 2] ^= 0x55;
+  CHECK(!graphics.drawPngFromFile(temp_file(corrupted), 0, 0, false, false), "corrupted file accepted");
+
+  SimNetwork::unserve(url);
+  CHECK(!graphics.drawPngFromWeb(url, 0, 0, false, false), "missing web picture accepted");
+}
+
+// Opaque 1, 2 and 4 bit gray and palette pictures, their scanlines written
+// without RGBA conversion, at positions not aligned on the frame buffer bytes
+// and with clipping on both sides, in all rotations.
+
+static void
+test_png_packed(Graphics & graphics, DisplayMode mode, uint8_t rotation)
+{
+  graphics.selectDisplayMode(mode);
+  graphics.setRotation(rotation);
+
+  int     pw = 203, ph = 37;
+  int16_t w  = graphics.width(), h = graphics.height();
+  uint8_t background = (mode == DisplayMode::INKPLATE_1BIT) ? 1 : 0;
+
+  static const struct { const char * name; uint8_t color_type, depth; } formats[] = {
+    { "gray 1", 0, 1 }, { "gray 2", 0, 2 }, { "gray 4", 0, 4 },
+    { "palette 1", 3, 1 }, { "palette 2", 3, 2 }, { "palette 4", 3, 4 },
+  };
+
+  int16_t positions[][2] = {
+    { 0, 0 }, { 8, 3 }, { 1, 5 }, { 3, 7 }, { -5, 11 }, { -18, -3 }, { (int16_t)(w - 150), (int16_t)(h - 20) },
+    { (int16_t)(w - 149), 9 }, { -300, 0 }
+  };
+
+  for (auto & format : formats) {
+    PngPicture pic = png_picture(format.name, pw, ph, format.color_type, format.depth, true);
+
+    for (auto & pos : positions) {
+      for (int invert = 0; invert < 2; invert++) {
+        std::vector<uint8_t> reference = picture_reference(graphics, pic.rgba, pw, ph, pos[0], pos[1], invert, background);
+
+        graphics.fillScreen(background);
+        CHECK(graphics.drawPngFromFile(temp_file(pic.png), pos[0], pos[1], false, invert), "%s: drawPngFromFile() failed", pic.name);
+        CHECK(snapshot(graphics) == reference, "mode %d, rotation %d, %s at [%d, %d], invert %d: packed rows differ",
+              (int) mode, rotation, pic.name, pos[0], pos[1], invert);
+      }
+    }
+  }
+
+  graphics.setRotation(0);
+}
+
+// BMP pictures of every depth, with the expected RGBA value of each pixel
+
+struct BmpPicture {
+  const char *         name;
+  std::vector<uint8_t> bmp;
+  std::vector<uint8_t> rgba;
+};
+
+static BmpPicture
+bmp_picture(const char * name, int w, int h, uint16_t bpp, bool top_down)
+{
+  std::vector<uint8_t>  rgb = picture(w, h);
+  std::vector<uint32_t> samples;
+  std::vector<uint8_t>  palette, rgba;
+
+  if (bpp <= 8) {
+    int maxval = (1 << bpp) - 1;
+    for (int i = 0; i <= maxval; i++) {      // Entries of increasing luminance
+      int v = i * 255 / maxval;
+      palette.insert(palette.end(), { (uint8_t) v, (uint8_t)(255 - v / 2), (uint8_t)(v / 3) });
+    }
+  }
+
+  for (int i = 0; i < w * h; i++) {
+    uint8_t r = rgb[i * 3], g = rgb[i * 3 + 1], b = rgb[i * 3 + 2];
+
+    if (bpp <= 8) {
+      uint32_t v = ((r + g + b) / 3) >> (8 - bpp);
+      samples.push_back(v);
+      rgba.insert(rgba.end(), { palette[v * 3], palette[v * 3 + 1], palette[v * 3 + 2], 255 });
+    }
+    else if (bpp == 16) {
+      samples.push_back(((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3));
+      rgba.insert(rgba.end(), { (uint8_t)(r & 0xF8), (uint8_t)(g & 0xF8), (uint8_t)(b & 0xF8), 255 });
+    }
+    else {
+      samples.push_back((r << 16) | (g << 8) | b);
+      rgba.insert(rgba.end(), { r, g, b, 255 });
+    }
+  }
+
+  return { name, BmpWriter::encode(samples, w, h, bpp, palette, top_down), rgba };
+}
+
+// The row-batched BMP reader, from a file (rows read by batches, clipped rows
+// skipped), from memory and from the web, against the expected pixels.
+
+static void
+test_bmp_sources(Graphics & graphics, DisplayMode mode)
+{
+  graphics.selectDisplayMode(mode);
+  graphics.setRotation(0);
+
+  int     pw = 301, ph = 203;
+  int16_t w  = graphics.width(), h = graphics.height();
+  uint8_t background = (mode == DisplayMode::INKPLATE_1BIT) ? 1 : 0;
+  const char * url = "http://server/chart.bmp";
+
+  static const struct { const char * name; uint16_t bpp; bool top_down; } formats[] = {
+    { "bmp 1", 1, false }, { "bmp 4", 4, false }, { "bmp 8", 8, false }, { "bmp 16", 16, false },
+    { "bmp 24", 24, false }, { "bmp 32", 32, false }, { "bmp 4 top-down", 4, true }, { "bmp 24 top-down", 24, true },
+  };
+
+  int16_t positions[][2] = {
+    { 37, 21 }, { -45, -13 }, { 3, (int16_t)(h - 150) }, { (int16_t)(w - 201), (int16_t)(h - 103) }, { 0, (int16_t) -250 }
+  };
+
+  for (auto & format : formats) {
+    BmpPicture pic = bmp_picture(format.name, pw, ph, format.bpp, format.top_down);
+    SimNetwork::serve(url, pic.bmp);
+
+    for (auto & pos : positions) {
+      for (int invert = 0; invert < 2; invert++) {
+        std::vector<uint8_t> reference = picture_reference(graphics, pic.rgba, pw, ph, pos[0], pos[1], invert, background);
+
+        graphics.fillScreen(background);
+        CHECK(graphics.drawBitmapFromFile(temp_file(pic.bmp), pos[0], pos[1], false, invert), "%s: drawBitmapFromFile() failed", pic.name);
+        CHECK(snapshot(graphics) == reference, "mode %d, %s at [%d, %d], invert %d: file picture differs",
+              (int) mode, pic.name, pos[0], pos[1], invert);
+
+        graphics.fillScreen(background);
+        CHECK(graphics.drawBitmapFromBuffer(pic.bmp.data(), pos[0], pos[1], false, invert), "%s: drawBitmapFromBuffer() failed", pic.name);
+        CHECK(snapshot(graphics) == reference, "mode %d, %s at [%d, %d], invert %d: buffer picture differs",
+              (int) mode, pic.name, pos[0], pos[1], invert);
+
+        graphics.fillScreen(background);
+        CHECK(graphics.drawBitmapFromWeb(url, pos[0], pos[1], false, invert), "%s: drawBitmapFromWeb() failed", pic.name);
+        CHECK(snapshot(graphics) == reference, "mode %d, %s at [%d, %d], invert %d: web picture differs",
+              (int) mode, pic.name, pos[0], pos[1], invert);
+      }
+    }
+  }
+
+  // Dithering: same result from a file and from memory, and only in the picture box
+
+  for (uint16_t bpp : { 8, 24 }) {
+    BmpPicture pic = bmp_picture("dither", pw, ph, bpp, false);
+
+    graphics.fillScreen(0);
+    CHECK(graphics.drawBitmapFromFile(temp_file(pic.bmp), 37, 21, true, false), "drawBitmapFromFile(dither) failed");
+    std::vector<uint8_t> dithered = snapshot(graphics);
+
+    graphics.fillScreen(0);
+    CHECK(graphics.drawBitmapFromBuffer(pic.bmp.data(), 37, 21, true, false), "drawBitmapFromBuffer(dither) failed");
+    CHECK(snapshot(graphics) == dithered, "mode %d, %d bits: dithered buffer and file pictures differ", (int) mode, bpp);
+
+    graphics.fillRect(37, 21, pw, ph, 0);
+    CHECK(snapshot(graphics) == std::vector<uint8_t>(dithered.size(), 0), "dithered picture out of its box");
+  }
+
+  // Truncated or invalid files must fail
+
+  BmpPicture pic = bmp_picture("bmp 24", pw, ph, 24, false);
+  std::vector<uint8_t> truncated(pic.bmp.begin(), pic.bmp.begin() + pic.bmp.size() / 2);
+  CHECK(!graphics.drawBitmapFromFile(temp_file(truncated), 0, 0, false, false), "truncated file accepted");
+
+  std::vector<uint8_t> invalid = pic.bmp;
+  invalid[0] = 'X';
+  CHECK(!graphics.drawBitmapFromFile(temp_file(invalid), 0, 0, false, false), "invalid file accepted");
+  CHECK(!graphics.drawBitmapFromFile(temp_file(std::vector<uint8_t>(pic.bmp.begin(), pic.bmp.begin() + 20)), 0, 0, false, false),
+        "header only file accepted");
+
+  SimNetwork::unserve(url);
+}
+
+// Ordered dithering against the Bayer thresholds computed here, for every
+// decoder, with clipping: a pixel only depends on its value and position.
+// Blue noise pictures must be the same whatever the decoder.
+
+static uint8_t
+bayer_level(uint8_t gray, int16_t x, int16_t y, bool one_bit)
+{
+  int rank = 0;
+  for (int bit = 0; bit < 3; bit++) {
+    int xb = (x >> bit) & 1, yb = (y >> bit) & 1;
+    rank |= (((xb ^ yb) << 1) | yb) << (4 - 2 * bit);
+  }
+  int levels = one_bit ? 1 : 7;
+  int val    = (gray * levels + rank * 4 + 2) / 255;
+  return one_bit ? (val ? 0 : 1) : val;
+}
+
+static bool
+reference_bayer_chunk(int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t * bitmap, bool dither, bool invert)
+{
+  bool one_bit = reference_graphics->getDisplayMode() == DisplayMode::INKPLATE_1BIT;
+  for (int j = 0; j < h; j++) {
+    for (int i = 0; i < w; i++) {
+      reference_graphics->drawPixel(x + i, y + j, bayer_level(bitmap[j * w + i], x + i, y + j, one_bit));
+    }
+  }
+  return true;
+}
+
+static void
+test_ordered_dither(Graphics & graphics, DisplayMode mode, uint8_t rotation)
+{
+  graphics.selectDisplayMode(mode);
+  graphics.setRotation(rotation);
+  reference_graphics = &graphics;
+
+  int  pw = 301, ph = 203;
+  bool one_bit = mode == DisplayMode::INKPLATE_1BIT;
+
+  BmpPicture           bmp  = bmp_picture("bmp 24", pw, ph, 24, false);
+  PngPicture           png  = png_picture("rgb", pw, ph, 2, 8);
+  std::vector<uint8_t> jpeg = jpeg_picture(pw, ph);
+
+  int16_t positions[][2] = { { 37, 21 }, { -45, -13 }, { (int16_t)(graphics.width() - 201), (int16_t)(graphics.height() - 103) } };
+
+  for (auto & pos : positions) {
+    graphics.setDither(Image::Bayer);
+
+    graphics.fillScreen(0);
+    for (int y = 0; y < ph; y++) {
+      for (int x = 0; x < pw; x++) {
+        const uint8_t * p = &bmp.rgba[(y * pw + x) * 4];
+        graphics.drawPixel(pos[0] + x, pos[1] + y, bayer_level(Image::rgb8Bit(p[0], p[1], p[2]), pos[0] + x, pos[1] + y, one_bit));
+      }
+    }
+    std::vector<uint8_t> reference = snapshot(graphics);
+
+    graphics.fillScreen(0);
+    CHECK(graphics.drawBitmapFromBuffer(bmp.bmp.data(), pos[0], pos[1], true, false), "drawBitmapFromBuffer(Bayer) failed");
+    CHECK(snapshot(graphics) == reference, "mode %d, rotation %d, at [%d, %d]: Bayer BMP differs", (int) mode, rotation, pos[0], pos[1]);
+
+    graphics.fillScreen(0);
+    CHECK(graphics.drawPngFromFile(temp_file(png.png), pos[0], pos[1], true, false), "drawPngFromFile(Bayer) failed");
+    CHECK(snapshot(graphics) == reference, "mode %d, rotation %d, at [%d, %d]: Bayer PNG differs", (int) mode, rotation, pos[0], pos[1]);
+
+    graphics.fillScreen(0);
+    TJpgDec.setJpgScale(1);
+    TJpgDec.setGrayCallback(reference_bayer_chunk);
+    TJpgDec.drawJpg(pos[0], pos[1], jpeg.data(), jpeg.size(), true, false);
+    reference = snapshot(graphics);
+
+    graphics.fillScreen(0);
+    CHECK(graphics.drawJpegFromBuffer(jpeg.data(), jpeg.size(), pos[0], pos[1], true, false), "drawJpegFromBuffer(Bayer) failed");
+    CHECK(snapshot(graphics) == reference, "mode %d, rotation %d, at [%d, %d]: Bayer JPEG differs", (int) mode, rotation, pos[0], pos[1]);
+
+    graphics.setDither(Image::BlueNoise);
+
+    graphics.fillScreen(0);
+    CHECK(graphics.drawBitmapFromBuffer(bmp.bmp.data(), pos[0], pos[1], true, false), "drawBitmapFromBuffer(BlueNoise) failed");
+    std::vector<uint8_t> dithered = snapshot(graphics);
+
+    graphics.fillScreen(0);
+    CHECK(graphics.drawPngFromFile(temp_file(png.png), pos[0], pos[1], true, false), "drawPngFromFile(BlueNoise) failed");
+    CHECK(snapshot(graphics) == dithered, "mode %d, rotation %d, at [%d, %d]: blue noise PNG differs", (int) mode, rotation, pos[0], pos[1]);
+
+    graphics.fillRect(pos[0], pos[1], pw, ph, 0);
+    CHECK(snapshot(graphics) == std::vector<uint8_t>(dithered.size(), 0), "dithered picture out of its box");
+  }
+
+  graphics.setDither(Image::FloydSteinberg);
+  graphics.setRotation(0);
+}
+
+// Raw pictures built by png2raw from a panel sized PNG, against the PNG
+// drawn by the library, loaded whatever the rotation.
+
+static std::vector<uint8_t>
+read_file(const char * filename)
+{
+  std::vector<uint8_t> data;
+  FILE *               f = fopen(filename, "rb");
+  if (f == nullptr) return data;
+  uint8_t buf[4096];
+  size_t  len;
+  while ((len = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + len);
+  fclose(f);
+  return data;
+}
+
+static std::vector<uint8_t>
+png2raw(const char * options, const char * png_file)
+{
+  std::string raw_file = temp_name(".raw");
+  char        command[512];
+  snprintf(command, sizeof(command), "%s %s %s %s > /dev/null", PNG2RAW, options, png_file, raw_file.c_str());
+  CHECK(system(command) == 0, "%s failed", command);
+  std::vector<uint8_t> raw = read_file(raw_file.c_str());
+  remove(raw_file.c_str());
+  return raw;
+}
+
+static void
+test_raw(Graphics & graphics, DisplayMode mode)
+{
+  graphics.selectDisplayMode(mode);
+  graphics.setRotation(0);
+
+  int          pw = e_ink.get_width(), ph = e_ink.get_height();
+  bool         one_bit = mode == DisplayMode::INKPLATE_1BIT;
+  const char * url     = "http://server/screen.raw";
+
+  // Flat areas, for long runs, and details, for long literal sequences
+
+  std::vector<uint8_t>  rgb = picture(pw, ph);
+  std::vector<uint16_t> samples;
+  for (int i = 0; i < pw * ph; i++) {
+    samples.push_back(((i / pw) < 100) || ((i % pw) > pw - 50) ? 255 : (rgb[i * 3] + rgb[i * 3 + 1] + rgb[i * 3 + 2]) / 3);
+  }
+  std::vector<uint8_t> png      = PngWriter::encode(samples, pw, ph, 0, 8);
+  std::string          png_file = temp_name(png, ".png");
+
+  for (int invert = 0; invert < 2; invert++) {
+    graphics.fillScreen(one_bit ? 0 : 7);
+    CHECK(graphics.drawPngFromFile(temp_file(png), 0, 0, false, invert), "drawPngFromFile() failed");
+    std::vector<uint8_t> reference = snapshot(graphics);
+
+    for (int compress = 0; compress < 2; compress++) {
+      char options[16];
+      snprintf(options, sizeof(options), "%s%s%s", one_bit ? "-1" : "-3", invert ? " -i" : "", compress ? " -r" : "");
+      std::vector<uint8_t> raw = png2raw(options, png_file.c_str());
+      CHECK(raw.size() > RawImageHeader::SIZE, "png2raw %s: no output", options);
+      if (compress) CHECK(raw.size() < reference.size() / 2, "png2raw %s: %zu bytes", options, raw.size());
+      else          CHECK(raw.size() == reference.size() + RawImageHeader::SIZE, "png2raw %s: %zu bytes", options, raw.size());
+
+      for (uint8_t rotation = 0; rotation < 4; rotation += 3) {
+        graphics.setRotation(rotation);
+
+        graphics.fillScreen(3);
+        CHECK(graphics.drawRawFromFile(temp_file(raw)), "mode %d, png2raw %s: drawRawFromFile() failed", (int) mode, options);
+        CHECK(snapshot(graphics) == reference, "mode %d, png2raw %s, rotation %d: file raw picture differs",
+              (int) mode, options, rotation);
+
+        SimNetwork::serve(url, raw);
+        SimNetwork::reset_stats();
+        graphics.fillScreen(3);
+        CHECK(graphics.drawImage(url, 0, 0), "mode %d, png2raw %s: drawImage(url) failed", (int) mode, options);
+        CHECK(snapshot(graphics) == reference, "mode %d, png2raw %s, rotation %d: web raw picture differs",
+              (int) mode, options, rotation);
+        CHECK(SimNetwork::get_stats().http_bytes == raw.size(), "web: %u bytes read", (unsigned) SimNetwork::get_stats().http_bytes);
+      }
+      graphics.setRotation(0);
+
+      // Truncated data: failure
+
+      std::vector<uint8_t> truncated(raw.begin(), raw.end() - 100);
+      CHECK(!graphics.drawRawFromFile(temp_file(truncated)), "png2raw %s: truncated raw picture accepted", options);
+    }
+  }
+
+  // Dithered, only checked to load
+
+  std::vector<uint8_t> dithered = png2raw(one_bit ? "-1 -d" : "-3 -d", png_file.c_str());
+  CHECK(graphics.drawRawFromFile(temp_file(dithered)), "mode %d: dithered raw picture not loaded", (int) mode);
+
+  // Pictures not matching the frame buffer are not loaded
+
+  graphics.fillScreen(3);
+  std::vector<uint8_t> before = snapshot(graphics);
+
+  std::vector<uint8_t> other_mode = png2raw(one_bit ? "-3" : "-1", png_file.c_str());
+  CHECK(!graphics.drawRawFromFile(temp_file(other_mode)), "mode %d: raw picture of the other mode accepted", (int) mode);
+
+  std::vector<uint8_t> small      = PngWriter::encode(std::vector<uint16_t>(64 * 32, 0), 64, 32, 0, 8);
+  std::string          small_file = temp_name(small, ".png");
+  std::vector<uint8_t> small_raw  = png2raw(one_bit ? "-1" : "-3", small_file.c_str());
+  remove(small_file.c_str());
+  CHECK(!graphics.drawRawFromFile(temp_file(small_raw)), "mode %d: raw picture of another size accepted", (int) mode);
+  CHECK(!graphics.drawRawFromFile(temp_file(png)), "mode %d: PNG file accepted as a raw picture", (int) mode);
+  CHECK(snapshot(graphics) == before, "mode %d: frame buffer changed by rejected raw pictures", (int) mode);
+
+  SimNetwork::unserve(url);
+  remove(png_file.c_str());
+}
+
+// drawImagesAsync(): the screen of the pictures drawn one after the other,
+// whatever the memory budget, as long as each picture fits in it
+
+static void
+test_async(Graphics & graphics, DisplayMode mode)
+{
+  graphics.selectDisplayMode(mode);
+  graphics.setRotation(0);
+
+  uint8_t background = (mode == DisplayMode::INKPLATE_1BIT) ? 1 : 0;
+
+  PngPicture png = png_picture("rgb", 300, 200, 2, 8);
+  BmpPicture bmp = bmp_picture("bmp 24", 301, 203, 24, false);
+  SimNetwork::serve("http://server/a.png", png.png);
+  SimNetwork::serve("http://server/b.bmp", bmp.bmp);
+  SimNetwork::serve("http://server/c.jpg", jpeg_picture(320, 240));
+
+  std::string file = temp_name(png.png, ".png");
+
+  std::vector<Image::ImageRequest> list = {
+    { "http://server/a.png",        10,  10 },
+    { "http://server/b.bmp",       350,  20, false },
+    { "http://server/c.jpg",        20, 250 },
+    { file,                        400, 300, false, true },
+    { "http://server/missing.png",   0,   0 },
+    { "http://server/a.png",       -50, 500, true, true },
+  };
+  std::vector<bool> expected = { true, true, true, true, false, true };
+
+  graphics.fillScreen(background);
+  for (auto & request : list) graphics.drawImage(request.path.c_str(), request.x, request.y, request.dither, request.invert);
+  std::vector<uint8_t> reference = snapshot(graphics);
+
+  SemaphoreHandle_t done = xSemaphoreCreateBinary();
+
+  int32_t largest = std::max({ png.png.size(), bmp.bmp.size(), jpeg_picture(320, 240).size() });
+
+  for (bool chunked : { false, true }) {
+    SimNetwork::set_chunked(chunked);
+
+    for (int32_t budget : { largest, largest + 20000, 1 << 20 }) {
+      std::vector<bool> drawn;
+
+      graphics.fillScreen(background);
+      CHECK(graphics.drawImagesAsync(list, [&](const std::vector<bool> & d) {
+        drawn = d;
+        xSemaphoreGive(done);
+      }, budget), "mode %d, budget %d: drawImagesAsync() failed", (int) mode, (int) budget);
+
+      xSemaphoreTake(done, portMAX_DELAY);
+      CHECK(drawn == expected, "mode %d, chunked %d, budget %d: wrong results", (int) mode, chunked, (int) budget);
+      CHECK(snapshot(graphics) == reference, "mode %d, chunked %d, budget %d: screen differs", (int) mode, chunked,
+            (int) budget);
+    }
+
+    // Pictures larger than the budget are not drawn, the others are
+
+    int32_t budget = jpeg_picture(320, 240).size() + 1000;
+    std::vector<bool> drawn;
+    CHECK(graphics.drawImagesAsync(list, [&](const std::vector<bool> & d) {
+      drawn = d;
+      xSemaphoreGive(done);
+    }, budget), "mode %d, budget %d: drawImagesAsync() failed", (int) mode, (int) budget);
+
+    xSemaphoreTake(done, portMAX_DELAY);
+    CHECK(drawn == std::vector<bool>({ false, false, true, true, false, false }), "mode %d, chunked %d, small budget: wrong results",
+          (int) mode, chunked);
+  }
+  SimNetwork::set_chunked(false);
+
+  // The pictures are dithered as selected when drawImagesAsync() is called,
+  // whatever setDither() is called with before they are drawn
+
+  graphics.setDither(Image::Bayer);
+  graphics.fillScreen(background);
+  for (auto & request : list) graphics.drawImage(request.path.c_str(), request.x, request.y, request.dither, request.invert);
+  std::vector<uint8_t> ordered = snapshot(graphics);
+
+  graphics.fillScreen(background);
+  CHECK(graphics.drawImagesAsync(list, [&](const std::vector<bool> & d) {
+    xSemaphoreGive(done);
+  }), "mode %d, Bayer: drawImagesAsync() failed", (int) mode);
+  graphics.setDither(Image::FloydSteinberg);
+
+  xSemaphoreTake(done, portMAX_DELAY);
+  CHECK(snapshot(graphics) == ordered, "mode %d: setDither() changed the pictures being drawn", (int) mode);
+  CHECK(ordered != reference,          "mode %d: Bayer and Floyd-Steinberg pictures are the same", (int) mode);
+
+  // A truncated download fails alone: its memory is not counted in the budget
+
+  std::vector<uint8_t> jpeg = jpeg_picture(320, 240);
+  SimNetwork::serve_truncated("http://server/cut.jpg", std::vector<uint8_t>(jpeg.begin(), jpeg.begin() + jpeg.size() / 2),
+                              jpeg.size());
+
+  std::vector<Image::ImageRequest> cut = {
+    { "http://server/cut.jpg",  20, 250 },
+    { "http://server/cut.jpg",  20, 250 },
+    { "http://server/a.png",    10,  10 },
+    { "http://server/b.bmp",   350,  20, false },
+  };
+  for (int32_t budget : { largest, largest + 20000 }) {
+    std::vector<bool> drawn;
+
+    CHECK(graphics.drawImagesAsync(cut, [&](const std::vector<bool> & d) {
+      drawn = d;
+      xSemaphoreGive(done);
+    }, budget), "truncated, budget %d: drawImagesAsync() failed", (int) budget);
+
+    xSemaphoreTake(done, portMAX_DELAY);
+    CHECK(drawn == std::vector<bool>({ false, false, true, true }), "truncated, budget %d: wrong results", (int) budget);
+  }
+
+  // Nothing to draw
+
+  bool called = false;
+  CHECK(graphics.drawImagesAsync({}, [&](const std::vector<bool> & d) {
+    called = d.empty();
+    xSemaphoreGive(done);
+  }), "empty list: drawImagesAsync() failed");
+  xSemaphoreTake(done, portMAX_DELAY);
+  CHECK(called, "empty list: done() not called");
+
+  vSemaphoreDelete(done);
+  SimNetwork::clear();
+  remove(file.c_str());
+}
+
+int
+main()
+{
+  wire.setup();
+
+  Graphics graphics(e_ink.get_width(), e_ink.get_height());
+  graphics.setDisplayMode(DisplayMode::INKPLATE_3BIT);
+
+  CHECK(network_client.joinAP("ssid", "password"), "joinAP() failed");
+
+  for (auto sampling : { JpegWriter::Sampling::YUV420, JpegWriter::Sampling::YUV444 }) {
+    test_jpeg_sources(graphics, DisplayMode::INKPLATE_3BIT, sampling);
+    test_jpeg_sources(graphics, DisplayMode::INKPLATE_1BIT, sampling);
+  }
+
+  for (auto sampling : { JpegWriter::Sampling::YUV420, JpegWriter::Sampling::YUV444 }) test_jpeg_gray(sampling);
+
+  // Y only pictures, drawn the same way
+
+  test_jpeg_sources(graphics, DisplayMode::INKPLATE_3BIT, JpegWriter::Sampling::GRAY);
+
+  for (uint8_t rotation = 0; rotation < 4; rotation++) {
+    test_jpeg_blocks(graphics, DisplayMode::INKPLATE_3BIT, rotation);
+    test_jpeg_blocks(graphics, DisplayMode::INKPLATE_1BIT, rotation);
+  }
+
+  test_png_sources(graphics, DisplayMode::INKPLATE_3BIT);
+  test_png_sources(graphics, DisplayMode::INKPLATE_1BIT);
+
+  for (uint8_t rotation = 0; rotation < 4; rotation++) {
+    test_png_packed(graphics, DisplayMode::INKPLATE_3BIT, rotation);
+    test_png_packed(graphics, DisplayMode::INKPLATE_1BIT, rotation);
+  }
+
+  test_bmp_sources(graphics, DisplayMode::INKPLATE_3BIT);
+  test_bmp_sources(graphics, DisplayMode::INKPLATE_1BIT);
+
+  for (uint8_t rotation = 0; rotation < 2; rotation++) {
+    test_ordered_dither(graphics, DisplayMode::INKPLATE_3BIT, rotation);
+    test_ordered_dither(graphics, DisplayMode::INKPLATE_1BIT, rotation);
+  }
+
+  test_raw(graphics, DisplayMode::INKPLATE_3BIT);
+  test_raw(graphics, DisplayMode::INKPLATE_1BIT);
+
+  test_async(graphics, DisplayMode::INKPLATE_3BIT);
+  test_async(graphics, DisplayMode::INKPLATE_1BIT);
+
+  // Picture size, box (0: up to the screen edge), expected decoding scale
+
+  int16_t w = graphics.width(), h = graphics.height();
+
+  for (DisplayMode mode : { DisplayMode::INKPLATE_3BIT, DisplayMode::INKPLATE_1BIT }) {
+    test_jpeg_fit(graphics, mode, 2 * w + 16, 2 * h + 8, 0,  0,   0,   0, 1);
+    test_jpeg_fit(graphics, mode, 1600, 1200, 10, 20, 300, 200, 2);
+    test_jpeg_fit(graphics, mode, 1000,  500, 50, 40, 100, 300, 3);
+    test_jpeg_fit(graphics, mode,  480,  320, 30, 30, 500, 500, 0);
+    test_jpeg_fit(graphics, mode,  333,  251,  0,  0, 250, 250, 0);
+  }
+
+  printf("Image %dx%d: %s\n", e_ink.get_width(), e_ink.get_height(), failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
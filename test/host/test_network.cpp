@@ -0,0 +1,473 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+
+// NetworkClient checks, against the simulated access point and web of
+// test/host/sim/sim_network.hpp.
+
+#include "network_client.hpp"
+
+#include "sim_network.hpp"
+
+#include "esp_timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                           \
+    if (!(cond)) {                                      \
+      failures++;                                       \
+      printf("FAILED %s:%d: ", __FILE__, __LINE__);     \
+      printf(__VA_ARGS__);                              \
+      printf("\n");                                     \
+    }                                                   \
+  } while (0)
+
+static std::vector<uint8_t>
+content(size_t size)
+{
+  std::vector<uint8_t> data(size);
+  for (size_t i = 0; i < size; i++) data[i] = (i * 31 + (i >> 8)) & 0xFF;
+  return data;
+}
+
+// The whole body, in memory, with and without a Content-Length
+
+static void
+test_download_file(bool chunked)
+{
+  const char * url = "http://server/file.bin";
+
+  SimNetwork::set_chunked(chunked);
+
+  for (size_t size : { 0, 1, 1000, 2048, 70001 }) {
+    std::vector<uint8_t> data = content(size);
+    SimNetwork::serve(url, data);
+
+    int32_t   len = 100;
+    uint8_t * buf = network_client.downloadFile(url, &len);
+    CHECK(buf != nullptr, "chunked %d, %zu bytes: downloadFile() failed", chunked, size);
+    CHECK(len == (int32_t) size, "chunked %d, %zu bytes: downloadFile() length %d", chunked, size, (int) len);
+    if (buf != nullptr) {
+      CHECK((len != (int32_t) size) || (memcmp(buf, data.data(), size) == 0), "chunked %d, %zu bytes: content differs", chunked, size);
+      free(buf);
+    }
+  }
+
+  int32_t len = 100;
+  CHECK(network_client.downloadFile("http://server/missing", &len) == nullptr, "chunked %d: missing file downloaded", chunked);
+
+  SimNetwork::unserve(url);
+  SimNetwork::set_chunked(false);
+}
+
+// The chunks are handed over as they arrive, never larger than asked, and
+// the download stops when the callback says so.
+
+static void
+test_download_chunks(bool chunked)
+{
+  const char * url = "http://server/stream.bin";
+
+  SimNetwork::set_chunked(chunked);
+
+  std::vector<uint8_t> data = content(100000);
+  SimNetwork::serve(url, data);
+
+  for (int32_t chunk_size : { 1, 100, 2048, 5000 }) {
+    std::vector<uint8_t> received;
+    int32_t              largest = 0, smallest = chunk_size;
+
+    bool ok = network_client.download(url, [&](const uint8_t * buf, int32_t len) {
+      received.insert(received.end(), buf, buf + len);
+      largest  = std::max(largest, len);
+      smallest = std::min(smallest, len);
+      return true;
+    }, chunk_size);
+
+    CHECK(ok, "chunked %d, chunks of %d: download() failed", chunked, (int) chunk_size);
+    CHECK(received == data, "chunked %d, chunks of %d: content differs", chunked, (int) chunk_size);
+    CHECK(largest <= chunk_size, "chunked %d: %d bytes chunk, %d asked", chunked, (int) largest, (int) chunk_size);
+    CHECK(smallest > 0, "chunked %d: empty chunk", chunked);
+  }
+
+  SimNetwork::reset_stats();
+  int  calls = 0;
+  bool ok    = network_client.download(url, [&](const uint8_t * buf, int32_t len) { return ++calls < 3; }, 1000);
+  CHECK(!ok && (calls == 3), "chunked %d: download() not stopped (%d calls)", chunked, calls);
+  CHECK(SimNetwork::get_stats().http_bytes == 3000, "chunked %d: %llu bytes received after the stop", chunked,
+        (unsigned long long) SimNetwork::get_stats().http_bytes);
+
+  CHECK(!network_client.download("http://server/missing", [](const uint8_t *, int32_t) { return true; }),
+        "chunked %d: missing file downloaded", chunked);
+
+  SimNetwork::unserve(url);
+  SimNetwork::set_chunked(false);
+}
+
+static void
+test_stream(bool chunked)
+{
+  const char * url = "http://server/stream.bin";
+
+  SimNetwork::set_chunked(chunked);
+
+  std::vector<uint8_t> data = content(10000);
+  SimNetwork::serve(url, data);
+
+  int32_t length = 0;
+  CHECK(network_client.openStream(url, &length), "chunked %d: openStream() failed", chunked);
+  CHECK(length == (chunked ? -1 : 10000), "chunked %d: length %d", chunked, (int) length);
+
+  std::vector<uint8_t> received(12000);
+  CHECK(network_client.readStream(received.data(), 3000) == 3000, "chunked %d: readStream() short", chunked);
+  CHECK(network_client.readStream(received.data() + 3000, 9000) == 7000, "chunked %d: readStream() at the end", chunked);
+  CHECK(network_client.readStream(received.data(), 100) == 0, "chunked %d: readStream() past the end", chunked);
+  received.resize(10000);
+  CHECK(received == data, "chunked %d: content differs", chunked);
+  network_client.closeStream();
+
+  CHECK(network_client.readStream(received.data(), 100) < 0, "chunked %d: readStream() on a closed stream", chunked);
+
+  // An empty body is not a body of unknown length
+
+  SimNetwork::serve(url, std::vector<uint8_t>());
+  CHECK(network_client.openStream(url, &length), "chunked %d: empty openStream() failed", chunked);
+  CHECK(length == (chunked ? -1 : 0), "chunked %d: empty body length %d", chunked, (int) length);
+  CHECK(network_client.readStream(received.data(), 100) == 0, "chunked %d: data in an empty body", chunked);
+  network_client.closeStream();
+
+  SimNetwork::unserve(url);
+  SimNetwork::set_chunked(false);
+}
+
+static int
+file_count(const char * dir)
+{
+  int    count = 0;
+  DIR  * d     = opendir(dir);
+  if (d == nullptr) return -1;
+  while (struct dirent * e = readdir(d)) {
+    if (e->d_name[0] != '.') count++;
+  }
+  closedir(d);
+  return count;
+}
+
+// Files with validators are kept in the cache and read from there while the
+// server answers 304.
+
+static void
+test_cache(bool chunked)
+{
+  const char * url   = "http://server/cached.bin";
+  const char * plain = "http://server/plain.bin";
+
+  char dir[] = "/tmp/inkplate_cacheXXXXXX";
+  CHECK(mkdtemp(dir) != nullptr, "mkdtemp() failed");
+  CHECK(network_client.setCache(dir), "chunked %d: setCache() failed", chunked);
+
+  SimNetwork::set_chunked(chunked);
+
+  std::vector<uint8_t> data = content(5000);
+  SimNetwork::serve(url, data, "\"v1\"");
+  SimNetwork::serve(plain, data);
+
+  auto fetch = [](const char * u, std::vector<uint8_t> & received) {
+    received.clear();
+    return network_client.download(u, [&](const uint8_t * buf, int32_t len) {
+      received.insert(received.end(), buf, buf + len);
+      return true;
+    });
+  };
+
+  std::vector<uint8_t> received;
+  SimNetwork::reset_stats();
+  CHECK(fetch(url, received) && (received == data), "chunked %d: first download failed", chunked);
+  CHECK(!network_client.isNotModified(), "chunked %d: first download not modified", chunked);
+  CHECK(file_count(dir) == 2, "chunked %d: %d files in the cache", chunked, file_count(dir));
+
+  // Unmodified: no body sent, the cached copy is read
+
+  SimNetwork::reset_stats();
+  CHECK(fetch(url, received) && (received == data), "chunked %d: cached download failed", chunked);
+  CHECK(network_client.isNotModified(), "chunked %d: not a 304", chunked);
+  CHECK(SimNetwork::get_stats().http_bytes == 0, "chunked %d: %llu bytes sent for an unmodified file", chunked,
+        (unsigned long long) SimNetwork::get_stats().http_bytes);
+
+  network_client.setSkipNotModified(true);
+  CHECK(!network_client.openStream(url) && network_client.isNotModified(), "chunked %d: unmodified file opened", chunked);
+  network_client.setSkipNotModified(false);
+
+  // Offline: the 304 of the previous request is not reported again
+
+  network_client.disconnect();
+  CHECK(!network_client.openStream(url) && !network_client.isNotModified(), "chunked %d: stale 304 while offline", chunked);
+  CHECK(network_client.joinAP("ssid", "password"), "joinAP() failed");
+  CHECK(network_client.setCache(dir), "chunked %d: setCache() failed", chunked);
+
+  // Cached body lost: downloaded again, then cached again
+
+  DIR * d = opendir(dir);
+  while (struct dirent * e = (d != nullptr) ? readdir(d) : nullptr) {
+    if (strstr(e->d_name, ".BIN") != nullptr) remove((std::string(dir) + "/" + e->d_name).c_str());
+  }
+  if (d != nullptr) closedir(d);
+
+  SimNetwork::reset_stats();
+  CHECK(fetch(url, received) && (received == data), "chunked %d: lost body not downloaded again", chunked);
+  CHECK(!network_client.isNotModified() && (SimNetwork::get_stats().http_bytes == data.size()),
+        "chunked %d: lost body not downloaded again", chunked);
+  CHECK(fetch(url, received) && (received == data) && network_client.isNotModified(),
+        "chunked %d: lost body not cached again", chunked);
+
+  // Modified: downloaded again, the cache updated. The first read stops
+  // early, the rest of the body still goes to the cache.
+
+  std::vector<uint8_t> data2 = content(7000);
+  for (auto & b : data2) b ^= 0x55;
+  SimNetwork::serve(url, data2, "\"v2\"");
+
+  SimNetwork::reset_stats();
+  CHECK(!network_client.download(url, [](const uint8_t *, int32_t) { return false; }), "chunked %d: download() not stopped", chunked);
+  CHECK(!network_client.isNotModified(), "chunked %d: modified file not downloaded", chunked);
+  CHECK(SimNetwork::get_stats().http_bytes == data2.size(), "chunked %d: body not drained", chunked);
+
+  SimNetwork::reset_stats();
+  CHECK(fetch(url, received) && (received == data2), "chunked %d: updated file differs", chunked);
+  CHECK(network_client.isNotModified() && (SimNetwork::get_stats().not_modified == 1), "chunked %d: update not cached", chunked);
+
+  // No validators: never cached
+
+  CHECK(fetch(plain, received) && (received == data), "chunked %d: plain download failed", chunked);
+  CHECK(file_count(dir) == 2, "chunked %d: file without validators cached", chunked);
+
+  // The server drops the validators: the cached copy is forgotten
+
+  SimNetwork::serve(url, data2);
+  CHECK(fetch(url, received) && (received == data2), "chunked %d: download without validators failed", chunked);
+  CHECK(file_count(dir) == 0, "chunked %d: stale copy kept", chunked);
+
+  CHECK(network_client.setCache(nullptr), "setCache(nullptr) failed");
+  rmdir(dir);
+
+  SimNetwork::unserve(url);
+  SimNetwork::unserve(plain);
+  SimNetwork::set_chunked(false);
+}
+
+// Consecutive requests to a server share one connection
+
+static void
+test_session(bool chunked)
+{
+  const char * urls[] = { "http://server/a.bin", "http://server/b.bin", "http://server/c.bin" };
+  const char * other  = "http://other:8080/d.bin";
+
+  SimNetwork::set_chunked(chunked);
+
+  std::vector<uint8_t> data = content(5000);
+  for (const char * url : urls) SimNetwork::serve(url, data);
+  SimNetwork::serve(other, data);
+
+  auto fetch = [](const char * url) {
+    int32_t   len = 100;
+    uint8_t * buf = network_client.downloadFile(url, &len);
+    free(buf);
+    return buf != nullptr;
+  };
+  auto connections = []() { return SimNetwork::get_stats().connections; };
+
+  network_client.closeSession();
+  SimNetwork::reset_stats();
+
+  for (const char * url : urls) CHECK(fetch(url), "chunked %d: %s not downloaded", chunked, url);
+  CHECK(connections() == 1, "chunked %d: %u connections for one server", chunked, connections());
+
+  CHECK(!fetch("http://server/missing"), "chunked %d: missing file downloaded", chunked);
+  CHECK(fetch(urls[0]) && (connections() == 1), "chunked %d: connection not kept after a 404", chunked);
+
+  CHECK(fetch(other) && fetch(urls[0]) && (connections() == 3), "chunked %d: %u connections for two servers", chunked,
+        connections());
+
+  // Closed by the server while idle: a new connection is made
+
+  SimNetwork::drop_connections();
+  CHECK(fetch(urls[1]) && (connections() == 4), "chunked %d: dropped connection not replaced", chunked);
+
+  // A short rest of an unfinished body is skipped, a long one closes the connection
+
+  CHECK(network_client.openStream(urls[2]), "chunked %d: openStream() failed", chunked);
+  uint8_t buf[1000];
+  CHECK(network_client.readStream(buf, sizeof(buf)) == sizeof(buf), "chunked %d: readStream() short", chunked);
+  network_client.closeStream();
+  CHECK(fetch(urls[0]) && (connections() == (chunked ? 5u : 4u)), "chunked %d: %u connections after a short rest",
+        chunked, connections());
+
+  std::vector<uint8_t> large = content(100000);
+  SimNetwork::serve(urls[2], large);
+  CHECK(network_client.openStream(urls[2]) && (network_client.readStream(buf, sizeof(buf)) == sizeof(buf)),
+        "chunked %d: openStream() failed", chunked);
+  network_client.closeStream();
+  CHECK(SimNetwork::get_stats().http_bytes < 50000, "chunked %d: large body read by closeStream()", chunked);
+  CHECK(fetch(urls[0]), "chunked %d: no download after a long rest", chunked);
+
+  network_client.closeSession();
+  for (const char * url : urls) SimNetwork::unserve(url);
+  SimNetwork::unserve(other);
+  SimNetwork::set_chunked(false);
+}
+
+// Redirections are followed, up to NetworkClient::MAX_REDIRECTS hops
+
+static void
+test_redirect(bool chunked)
+{
+  const char * url = "http://server/pictures/today.bin";
+
+  SimNetwork::set_chunked(chunked);
+
+  std::vector<uint8_t> data = content(5000);
+  SimNetwork::serve("http://cdn:8080/p/1234.bin", data);
+  SimNetwork::redirect("http://server/pictures/current.bin", "http://cdn:8080/p/1234.bin", 307);
+
+  for (int status : { 301, 302, 303, 307, 308 }) {
+    SimNetwork::redirect(url, "http://server/pictures/current.bin", status);
+
+    int32_t   len = 100;
+    uint8_t * buf = network_client.downloadFile(url, &len);
+    CHECK((buf != nullptr) && (len == 5000) && (memcmp(buf, data.data(), len) == 0),
+          "chunked %d, status %d: redirected file not downloaded", chunked, status);
+    free(buf);
+
+    std::vector<uint8_t> received;
+    CHECK(network_client.download(url, [&](const uint8_t * d, int32_t size) {
+      received.insert(received.end(), d, d + size);
+      return true;
+    }) && (received == data), "chunked %d, status %d: redirected download() failed", chunked, status);
+  }
+
+  // Endless redirections: failure
+
+  SimNetwork::redirect("http://server/loop.bin", "http://server/loop.bin");
+  int32_t len = 100;
+  CHECK(network_client.downloadFile("http://server/loop.bin", &len) == nullptr, "chunked %d: redirection loop followed",
+        chunked);
+
+  network_client.closeSession();
+  SimNetwork::clear();
+  SimNetwork::set_chunked(false);
+}
+
+// Connection time, on the simulated clock
+
+static int64_t
+join_time(bool * ok)
+{
+  int64_t start = esp_timer_get_time();
+  *ok = network_client.joinAP("ssid", "password");
+  return esp_timer_get_time() - start;
+}
+
+static void
+test_wifi()
+{
+  bool ok;
+
+  // A scan without fast connect, none with it
+
+  network_client.disconnect();
+  SimNetwork::reset_stats();
+  join_time(&ok);
+  CHECK(ok && (SimNetwork::get_stats().scans == 1), "connect: %u scans", SimNetwork::get_stats().scans);
+
+  network_client.setFastConnect(true);
+  network_client.disconnect();
+  SimNetwork::reset_stats();
+  join_time(&ok);
+  CHECK(ok && (SimNetwork::get_stats().scans == 0) && (SimNetwork::get_stats().connect_attempts == 1),
+        "fast connect: %u scans, %u attempts", SimNetwork::get_stats().scans, SimNetwork::get_stats().connect_attempts);
+  CHECK(SimNetwork::get_stats().dhcp_leases == 1, "fast connect: no DHCP");
+
+  // The access point moved: scanned for at once
+
+  SimNetwork::set_ap_channel(11);
+  network_client.disconnect();
+  SimNetwork::reset_stats();
+  int64_t elapsed = join_time(&ok);
+  CHECK(ok && (SimNetwork::get_stats().scans == 1) && (elapsed < 1000), "moved AP: %u scans, %lld us",
+        SimNetwork::get_stats().scans, (long long) elapsed);
+
+  // Last lease reused: no DHCP
+
+  network_client.setFastConnect(true, true);
+  network_client.disconnect();
+  SimNetwork::reset_stats();
+  join_time(&ok);
+  CHECK(ok && (SimNetwork::get_stats().dhcp_leases == 0) && (SimNetwork::get_stats().ip == 0x6401A8C0),
+        "lease reuse: %u DHCP leases", SimNetwork::get_stats().dhcp_leases);
+  network_client.setFastConnect(false);
+
+  // Static address
+
+  CHECK(!network_client.setStaticIP("192.168.1.300", "255.255.255.0", "192.168.1.1"), "invalid address accepted");
+  CHECK(network_client.setStaticIP("192.168.1.50", "255.255.255.0", "192.168.1.1", "192.168.1.1"), "setStaticIP() failed");
+  network_client.disconnect();
+  SimNetwork::reset_stats();
+  join_time(&ok);
+  CHECK(ok && (SimNetwork::get_stats().dhcp_leases == 0) && (SimNetwork::get_stats().ip == 0x3201A8C0),
+        "static address: %u DHCP leases, address %08X", SimNetwork::get_stats().dhcp_leases, SimNetwork::get_stats().ip);
+
+  network_client.setStaticIP(nullptr, nullptr, nullptr);
+  network_client.disconnect();
+  SimNetwork::reset_stats();
+  join_time(&ok);
+  CHECK(ok && (SimNetwork::get_stats().dhcp_leases == 1), "back to DHCP: %u leases", SimNetwork::get_stats().dhcp_leases);
+
+  // Unreachable: retries with growing delays, up to the cap
+
+  network_client.setRetryDelays(100, 400);
+  network_client.disconnect();
+  SimNetwork::set_ap_reachable(false);
+  SimNetwork::reset_stats();
+  elapsed = join_time(&ok);
+  CHECK(!ok && (SimNetwork::get_stats().connect_attempts == 7), "unreachable AP: %u attempts",
+        SimNetwork::get_stats().connect_attempts);
+  CHECK((elapsed / 1000) == 100 + 200 + 400 * 4, "unreachable AP: %lld us of retries", (long long) elapsed);
+
+  SimNetwork::set_ap_reachable(true);
+  SimNetwork::set_ap_channel(6);
+  network_client.setRetryDelays(500, 10000);
+  CHECK(network_client.joinAP("ssid", "password"), "joinAP() failed");
+}
+
+int
+main()
+{
+  CHECK(network_client.joinAP("ssid", "password"), "joinAP() failed");
+
+  for (bool chunked : { false, true }) {
+    test_download_file(chunked);
+    test_download_chunks(chunked);
+    test_stream(chunked);
+    test_cache(chunked);
+    test_session(chunked);
+    test_redirect(chunked);
+  }
+
+  test_wifi();
+
+  network_client.disconnect();
+  CHECK(!network_client.download("http://server/file.bin", [](const uint8_t *, int32_t) { return true; }),
+        "download() while disconnected");
+
+  printf("Network: %s\n", failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,342 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// Builds an anti-aliased font (GFXfontGray, see src/graphical/gfx_font.hpp)
+// for the 3 bit display mode. The C header is written on stdout.
+//
+//   fontconvert_gray <GFXfont header> <factor> <bpp> [name]
+//
+//     Downsamples a 1 bit Adafruit GFXfont header (src/fonts/*.h) by an
+//     integer factor, the coverage of each pixel being the proportion of set
+//     pixels in the factor x factor source cell. FreeSerif24pt7b.h with a
+//     factor of 2 gives an anti-aliased 12 points FreeSerif.
+//
+//   fontconvert_gray --ttf <font file> <points> <bpp> [first last] [name]
+//
+//     Renders a TrueType/OpenType font with FreeType (when available at
+//     build time), at the same resolution as the Adafruit fontconvert tool.
+//
+// bpp is 2 or 3.
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if HAVE_FREETYPE
+  #include <ft2build.h>
+  #include FT_FREETYPE_H
+#endif
+
+struct Glyph {
+  int width, height, x_advance, x_offset, y_offset;
+  std::vector<uint8_t> coverage;   // width * height values, 0..(1 << bpp) - 1
+};
+
+struct Font {
+  std::string        name;
+  int                first, last, y_advance;
+  std::vector<Glyph> glyphs;
+};
+
+// ----- Adafruit GFXfont header input -----
+
+struct SourceFont {
+  std::string          name;
+  std::vector<uint8_t> bitmap;
+  std::vector<int>     glyphs;     // 6 values per glyph
+  int                  first, last, y_advance;
+};
+
+static std::vector<long>
+numbers(const std::string & text)
+{
+  std::vector<long> values;
+  const char *      p = text.c_str();
+
+  while (*p) {
+    if (*p == '/' && p[1] == '/') {                    // Comment up to the end of line
+      while (*p && *p != '\n') p++;
+    }
+    else if (isdigit((unsigned char) *p) || ((*p == '-') && isdigit((unsigned char) p[1]))) {
+      char * end;
+      values.push_back(strtol(p, &end, 0));
+      p = end;
+    }
+    else if (isalpha((unsigned char) *p) || (*p == '_')) {  // Skip identifiers (uint8_t, ...)
+      while (isalnum((unsigned char) *p) || (*p == '_')) p++;
+    }
+    else p++;
+  }
+  return values;
+}
+
+static std::string
+section(const std::string & text, const std::string & marker)
+{
+  size_t pos = text.find(marker);
+  if (pos == std::string::npos) return "";
+  size_t start = text.find('{', pos);
+  size_t end   = text.find("};", start);
+  if ((start == std::string::npos) || (end == std::string::npos)) return "";
+  return text.substr(start + 1, end - start - 1);
+}
+
+static bool
+read_gfx_header(const char * filename, SourceFont & font)
+{
+  std::ifstream file(filename);
+  if (!file) return false;
+
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  std::string text = buffer.str();
+
+  size_t pos = text.find("const GFXfont ");
+  if (pos == std::string::npos) return false;
+  pos += strlen("const GFXfont ");
+  size_t end = pos;
+  while (isalnum((unsigned char) text[end]) || (text[end] == '_')) end++;
+  font.name = text.substr(pos, end - pos);
+
+  for (long v : numbers(section(text, "Bitmaps[]"))) font.bitmap.push_back((uint8_t) v);
+  for (long v : numbers(section(text, "Glyphs[]" ))) font.glyphs.push_back((int) v);
+
+  std::vector<long> header = numbers(section(text, "const GFXfont "));
+  if ((header.size() < 3) || (font.glyphs.size() % 6) != 0) return false;
+
+  font.first     = header[header.size() - 3];
+  font.last      = header[header.size() - 2];
+  font.y_advance = header[header.size() - 1];
+
+  return (int) font.glyphs.size() == (font.last - font.first + 1) * 6;
+}
+
+static inline int
+div_floor(int a, int b) { return (a >= 0) ? (a / b) : -((-a + b - 1) / b); }
+
+static bool
+downsample(const SourceFont & src, int factor, int bpp, Font & font)
+{
+  int full = (1 << bpp) - 1;
+  int area = factor * factor;
+
+  font.first     = src.first;
+  font.last      = src.last;
+  font.y_advance = (src.y_advance + factor / 2) / factor;
+
+  for (size_t g = 0; g < src.glyphs.size(); g += 6) {
+    int offset = src.glyphs[g],     w  = src.glyphs[g + 1], h  = src.glyphs[g + 2];
+    int adv    = src.glyphs[g + 3], xo = src.glyphs[g + 4], yo = src.glyphs[g + 5];
+
+    Glyph glyph;
+    glyph.x_advance = (adv + factor / 2) / factor;
+
+    if ((w == 0) || (h == 0)) {
+      glyph.width = glyph.height = glyph.x_offset = glyph.y_offset = 0;
+      font.glyphs.push_back(glyph);
+      continue;
+    }
+
+    // Target cells covering the source glyph box, aligned on the origin
+
+    int x0 = div_floor(xo, factor), x1 = div_floor(xo + w - 1, factor);
+    int y0 = div_floor(yo, factor), y1 = div_floor(yo + h - 1, factor);
+
+    glyph.width    = x1 - x0 + 1;
+    glyph.height   = y1 - y0 + 1;
+    glyph.x_offset = x0;
+    glyph.y_offset = y0;
+    glyph.coverage.assign(glyph.width * glyph.height, 0);
+
+    std::vector<int> counts(glyph.coverage.size(), 0);
+
+    for (int yy = 0; yy < h; yy++) {
+      for (int xx = 0; xx < w; xx++) {
+        int bit = yy * w + xx;
+        if (src.bitmap[offset + (bit >> 3)] & (0x80 >> (bit & 7))) {
+          int cx = div_floor(xo + xx, factor) - x0;
+          int cy = div_floor(yo + yy, factor) - y0;
+          counts[cy * glyph.width + cx]++;
+        }
+      }
+    }
+
+    for (size_t i = 0; i < counts.size(); i++) {
+      glyph.coverage[i] = (counts[i] * full + area / 2) / area;
+    }
+
+    font.glyphs.push_back(glyph);
+  }
+
+  return true;
+}
+
+// ----- TrueType input -----
+
+#if HAVE_FREETYPE
+static bool
+render_ttf(const char * filename, int points, int bpp, int first, int last, Font & font)
+{
+  const int DPI  = 141;   // Same as the Adafruit fontconvert tool
+  int       full = (1 << bpp) - 1;
+
+  FT_Library library;
+  FT_Face    face;
+
+  if (FT_Init_FreeType(&library)) return false;
+  if (FT_New_Face(library, filename, 0, &face)) return false;
+  if (FT_Set_Char_Size(face, points << 6, 0, DPI, 0)) return false;
+
+  font.first     = first;
+  font.last      = last;
+  font.y_advance = face->size->metrics.height >> 6;
+
+  for (int c = first; c <= last; c++) {
+    Glyph glyph = {};
+
+    if (!FT_Load_Char(face, c, FT_LOAD_RENDER | FT_LOAD_TARGET_NORMAL)) {
+      FT_Bitmap & bitmap = face->glyph->bitmap;
+
+      glyph.width     = bitmap.width;
+      glyph.height    = bitmap.rows;
+      glyph.x_advance = face->glyph->advance.x >> 6;
+      glyph.x_offset  = face->glyph->bitmap_left;
+      glyph.y_offset  = 1 - face->glyph->bitmap_top;
+
+      for (unsigned y = 0; y < bitmap.rows; y++) {
+        for (unsigned x = 0; x < bitmap.width; x++) {
+          int level = bitmap.buffer[y * bitmap.pitch + x];
+          glyph.coverage.push_back((level * full + 127) / 255);
+        }
+      }
+    }
+    font.glyphs.push_back(glyph);
+  }
+
+  FT_Done_Face(face);
+  FT_Done_FreeType(library);
+  return true;
+}
+#endif
+
+// ----- Output -----
+
+static bool
+write_header(const Font & font, int bpp)
+{
+  std::vector<uint8_t>  bitmap;
+  std::vector<uint32_t> offsets;
+
+  for (const Glyph & glyph : font.glyphs) {
+    offsets.push_back(bitmap.size());
+
+    uint32_t acc = 0;
+    int      bits = 0;
+    for (uint8_t c : glyph.coverage) {
+      acc   = (acc << bpp) | c;
+      bits += bpp;
+      if (bits >= 8) {
+        bitmap.push_back(acc >> (bits - 8));
+        bits -= 8;
+      }
+    }
+    if (bits > 0) bitmap.push_back(acc << (8 - bits));
+  }
+  bitmap.push_back(0);   // The blitter reads 16 bits at a time
+
+  if (bitmap.size() > 65535) {
+    fprintf(stderr, "Bitmap too large for the glyph offsets (%zu bytes)\n", bitmap.size());
+    return false;
+  }
+
+  printf("// Anti-aliased font, %d bits per pixel, built by fontconvert_gray\n\n", bpp);
+
+  printf("const uint8_t %sBitmaps[] PROGMEM = {", font.name.c_str());
+  for (size_t i = 0; i < bitmap.size(); i++) {
+    printf("%s0x%02X%s", (i % 12) ? " " : "\n  ", bitmap[i], (i + 1 < bitmap.size()) ? "," : "");
+  }
+  printf(" };\n\n");
+
+  printf("const GFXglyph %sGlyphs[] PROGMEM = {\n", font.name.c_str());
+  for (size_t i = 0; i < font.glyphs.size(); i++) {
+    const Glyph & g = font.glyphs[i];
+    int           c = font.first + i;
+    printf("  { %5u, %3d, %3d, %3d, %4d, %4d }%s   // 0x%02X", offsets[i], g.width, g.height,
+           g.x_advance, g.x_offset, g.y_offset, (i + 1 < font.glyphs.size()) ? ", " : " };", c);
+    if ((c >= 0x20) && (c < 0x7F)) printf(" '%c'", c);
+    printf("\n");
+  }
+
+  printf("\nconst GFXfontGray %s PROGMEM = {\n", font.name.c_str());
+  printf("  { (uint8_t  *)%sBitmaps,\n", font.name.c_str());
+  printf("    (GFXglyph *)%sGlyphs,\n", font.name.c_str());
+  printf("    0x%02X, 0x%02X, %d },\n", font.first, font.last, font.y_advance);
+  printf("  %d };\n\n", bpp);
+
+  printf("// Approx. %zu bytes\n", bitmap.size() + font.glyphs.size() * 7 + 12);
+  return true;
+}
+
+static int
+usage()
+{
+  fprintf(stderr,
+    "Usage: fontconvert_gray <GFXfont header> <factor> <bpp> [name]\n"
+    "       fontconvert_gray --ttf <font file> <points> <bpp> [first last] [name]\n");
+  return 1;
+}
+
+int
+main(int argc, char ** argv)
+{
+  Font font;
+  int  bpp;
+
+  if ((argc >= 5) && (strcmp(argv[1], "--ttf") == 0)) {
+    #if HAVE_FREETYPE
+      int points = atoi(argv[3]);
+      int first  = (argc >= 7) ? strtol(argv[5], nullptr, 0) : 0x20;
+      int last   = (argc >= 7) ? strtol(argv[6], nullptr, 0) : 0x7E;
+      bpp        = atoi(argv[4]);
+      if ((bpp < 2) || (bpp > 3) || (points <= 0) || (first > last)) return usage();
+
+      std::string base = argv[2];
+      base = base.substr(base.find_last_of('/') + 1);
+      base = base.substr(0, base.find('.'));
+      for (char & ch : base) if (!isalnum((unsigned char) ch)) ch = '_';
+      font.name = (argc == 8) ? argv[7] : (argc == 6) ? argv[5] :
+                  base + std::to_string(points) + "ptGray" + std::to_string(bpp);
+
+      if (!render_ttf(argv[2], points, bpp, first, last, font)) {
+        fprintf(stderr, "Unable to render %s\n", argv[2]);
+        return 1;
+      }
+    #else
+      fprintf(stderr, "Built without FreeType: --ttf is not available\n");
+      return 1;
+    #endif
+  }
+  else if ((argc == 4) || (argc == 5)) {
+    SourceFont src;
+    int        factor = atoi(argv[2]);
+    bpp               = atoi(argv[3]);
+    if ((bpp < 2) || (bpp > 3) || (factor < 1)) return usage();
+
+    if (!read_gfx_header(argv[1], src)) {
+      fprintf(stderr, "Unable to read the GFXfont header %s\n", argv[1]);
+      return 1;
+    }
+    font.name = (argc == 5) ? argv[4] : src.name + "Div" + std::to_string(factor) + "Gray" + std::to_string(bpp);
+    downsample(src, factor, bpp, font);
+  }
+  else return usage();
+
+  return write_header(font, bpp) ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+// Copyright (c) 2026 Guy Turcotte
+//
+// MIT License. Look at file licenses.txt for details.
+//
+// Builds a raw picture (see src/tools/raw_image.hpp) from a PNG file,
+// to be loaded with Image::drawRawFromFile() or drawRawFromWeb().
+//
+//   png2raw [-1 | -3] [-d] [-i] [-r] <PNG file> <raw file>
+//
+//     -1, -3  1 bit or 3 bit (default) display mode
+//     -d      Floyd-Steinberg dithering
+//     -i      inverted picture
+//     -r      RLE compression
+//
+// The PNG picture must have the panel size, in the panel orientation
+// (rotation 0). Pixels are converted as Image::drawPngFromFile() does,
+// transparent ones being blended over white.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "pngle.hpp"
+#include "raw_image.hpp"
+
+struct Picture {
+  uint32_t             width = 0, height = 0;
+  std::vector<uint8_t> gray;   // 8 bit luminance, as Image::rgb8Bit()
+};
+
+static void
+on_init(pngle_t * pngle, uint32_t w, uint32_t h)
+{
+  Picture * picture = (Picture *) pngle_get_user_data(pngle);
+  picture->width  = w;
+  picture->height = h;
+  picture->gray.assign(size_t(w) * h, 255);
+}
+
+static void
+on_draw(pngle_t * pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t rgba[4])
+{
+  Picture * picture = (Picture *) pngle_get_user_data(pngle);
+
+  uint32_t c[3];
+  for (int k = 0; k < 3; k++) c[k] = (rgba[k] * rgba[3] + 255 * (255 - rgba[3])) / 255;
+  uint8_t gray = (54UL * c[0] + 183UL * c[1] + 19UL * c[2]) >> 8;
+
+  for (uint32_t j = y; (j < y + h) && (j < picture->height); j++) {
+    for (uint32_t i = x; (i < x + w) && (i < picture->width); i++) picture->gray[j * picture->width + i] = gray;
+  }
+}
+
+static bool
+read_png(const char * filename, Picture & picture)
+{
+  FILE * f = fopen(filename, "rb");
+  if (f == nullptr) return false;
+
+  std::vector<uint8_t> data;
+  uint8_t              buf[4096];
+  size_t               len;
+  while ((len = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + len);
+  fclose(f);
+
+  pngle_t * pngle = pngle_new();
+  pngle_set_user_data(pngle, &picture);
+  pngle_set_init_callback(pngle, on_init);
+  pngle_set_draw_callback(pngle, on_draw);
+  bool ok = pngle_feed(pngle, data.data(), data.size()) == (int) data.size();
+  pngle_destroy(pngle);
+
+  return ok && (picture.width > 0);
+}
+
+// Pixel values (0..7, 0/1 in 1 bit mode), quantized as the library does
+
+static std::vector<uint8_t>
+levels(const Picture & picture, int bits, bool dither, bool invert)
+{
+  std::vector<uint8_t> values(picture.gray.size());
+  int                  w = picture.width;
+  std::vector<int>     error(2 * (w + 2), 0);
+
+  for (uint32_t y = 0; y < picture.height; y++) {
+    int * cur  = &error[(y & 1) ? (w + 2) : 0] + 1;
+    int * next = &error[(y & 1) ? 0 : (w + 2)] + 1;
+    for (int x = -1; x <= w; x++) next[x] = 0;
+
+    for (int x = 0; x < w; x++) {
+      int     gray = picture.gray[y * w + x];
+      uint8_t val;
+
+      if (dither) {
+        int     old   = std::min(255, std::max(0, gray + cur[x]));
+        uint8_t level = (bits == 1) ? ((old >= 128) ? 7 : 0) : (old >> 5);
+        int     err   = old - ((bits == 1) ? ((level == 7) ? 255 : 0) : (level * 255 / 7));
+        cur[x + 1]  += err * 7 / 16;
+        next[x - 1] += err * 3 / 16;
+        next[x]     += err * 5 / 16;
+        next[x + 1] += err * 1 / 16;
+        val = level;
+      }
+      else val = gray >> 5;
+
+      if (invert) val = 7 - val;
+      values[y * w + x] = (bits == 1) ? ((~val >> 2) & 1) : val;
+    }
+  }
+  return values;
+}
+
+// Frame buffer layout, see raw_image.hpp
+
+static std::vector<uint8_t>
+pack(const std::vector<uint8_t> & values, int w, int h, int bits)
+{
+  std::vector<uint8_t> data(RawImageHeader::data_size(w, h, bits), 0);
+  int                  line_size = data.size() / h;
+
+  for (int y = 0; y < h; y++) {
+    uint8_t * line = &data[y * line_size];
+    for (int x = 0; x < w; x++) {
+      uint8_t v = values[y * w + x];
+      if (bits == 1) line[x >> 3] |= v << (x & 7);
+      else           line[x >> 1] |= v << ((x & 1) ? 0 : 4);
+    }
+  }
+  return data;
+}
+
+static int
+usage()
+{
+  fprintf(stderr, "Usage: png2raw [-1 | -3] [-d] [-i] [-r] <PNG file> <raw file>\n");
+  return 1;
+}
+
+int
+main(int argc, char ** argv)
+{
+  int  bits = 3;
+  bool dither = false, invert = false, compress = false;
+  int  arg = 1;
+
+  for (; (arg < argc) && (argv[arg][0] == '-'); arg++) {
+    if      (strcmp(argv[arg], "-1") == 0) bits     = 1;
+    else if (strcmp(argv[arg], "-3") == 0) bits     = 3;
+    else if (strcmp(argv[arg], "-d") == 0) dither   = true;
+    else if (strcmp(argv[arg], "-i") == 0) invert   = true;
+    else if (strcmp(argv[arg], "-r") == 0) compress = true;
+    else return usage();
+  }
+  if (argc - arg != 2) return usage();
+
+  Picture picture;
+  if (!read_png(argv[arg], picture)) {
+    fprintf(stderr, "Unable to read the PNG file %s\n", argv[arg]);
+    return 1;
+  }
+  if ((picture.width > 0xFFFF) || (picture.height > 0xFFFF)) {
+    fprintf(stderr, "Picture too large: %ux%u\n", picture.width, picture.height);
+    return 1;
+  }
+
+  std::vector<uint8_t> data = pack(levels(picture, bits, dither, invert), picture.width, picture.height, bits);
+  if (compress) {
+    std::vector<uint8_t> packed;
+    raw_rle_encode(data.data(), data.size(), [&](const uint8_t * buf, int32_t len) {
+      packed.insert(packed.end(), buf, buf + len);
+      return true;
+    });
+    data = packed;
+  }
+
+  RawImageHeader header;
+  header.width       = picture.width;
+  header.height      = picture.height;
+  header.bits        = bits;
+  header.compression = compress ? RawImageHeader::RLE : RawImageHeader::NONE;
+  header.size        = data.size();
+
+  uint8_t head[RawImageHeader::SIZE];
+  header.write(head);
+
+  FILE * f = fopen(argv[arg + 1], "wb");
+  if ((f == nullptr) || (fwrite(head, 1, sizeof(head), f) != sizeof(head)) ||
+      (fwrite(data.data(), 1, data.size(), f) != data.size())) {
+    fprintf(stderr, "Unable to write %s\n", argv[arg + 1]);
+    if (f != nullptr) fclose(f);
+    return 1;
+  }
+  fclose(f);
+
+  printf("%s: %ux%u, %d bits, %zu data bytes\n", argv[arg + 1], picture.width, picture.height, bits, data.size());
+  return 0;
+}